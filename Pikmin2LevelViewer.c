@@ -5,11 +5,21 @@
 */
 #include <Windows.h>
 #include <commctrl.h>
+#include <mmsystem.h>
 
 #pragma comment(linker, "/DEFAULTLIB:comctl32.lib")
+#pragma comment(linker, "/DEFAULTLIB:winmm.lib")
+
+#include <intrin.h>
 
 #include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
 
 //c23 compatibility stuff:
 #include <stdbool.h>
@@ -73,13 +83,248 @@ inline void THROW_ON_FAIL_IMPL(HRESULT hr, int line)
 						unsigned long long: _byteswap_uint64 \
 						)(x)
 
+static inline float IntAsFloat(uint32_t x)
+{
+	float f;
+	memcpy(&f, &x, sizeof(f));
+	return f;
+}
+
+static inline uint32_t FloatAsInt(float x)
+{
+	uint32_t i;
+	memcpy(&i, &x, sizeof(i));
+	return i;
+}
+
 #define SwapEndianFloat(x) IntAsFloat(_byteswap_ulong(FloatAsInt(x)))
 
 #define OffsetPointer(x, offset) ((typeof(x))((char*)x + (offset)))
 
 #define countof(x) (sizeof(x) / sizeof(x[0]))
 
+//true if [offset, offset + size) lies inside available bytes, none of it can overflow
+static inline bool isRangeInside(uint64_t offset, uint64_t size, uint64_t available)
+{
+	return offset <= available && size <= available - offset;
+}
+
+//WriteFile takes 32 bit sizes and can stop short, so large writes go in pieces and every count is checked
+static bool writeFileData(HANDLE file, const void* data, uint64_t size)
+{
+	while (size > 0)
+	{
+		DWORD pieceSize = (DWORD)min(size, 1u << 30);
+		DWORD written = 0;
+		if (!WriteFile(file, data, pieceSize, &written, nullptr) || written != pieceSize)
+			return false;
+		data = OffsetPointer(data, pieceSize);
+		size -= pieceSize;
+	}
+	return true;
+}
+
+/*
+* memory accounting: the large buffers (the file index, yaz0 output, decoded pixels, text and message indices, model
+* workspaces) are allocated with a tag. a header in front of each block keeps its size and tag, so trackedRealloc and
+* trackedFree take the pointer the caller got and every tag's current and peak bytes stay exact across threads.
+* -memory prints them
+*/
+#define MEMORY_FILE_INDEX 0
+#define MEMORY_YAZ0 1
+#define MEMORY_PIXELS 2
+#define MEMORY_TEXT 3
+#define MEMORY_MODELS 4
+#define MEMORY_TAG_COUNT 5
+
+static const char* memoryTagNames[MEMORY_TAG_COUNT] = { "file index", "yaz0 output", "decoded pixels", "text indices", "model workspaces" };
+
+struct memoryTagUsage
+{
+	volatile LONG64 currentBytes;
+	volatile LONG64 peakBytes;
+	volatile LONG64 allocationCount;
+};
+
+static struct memoryTagUsage memoryUsage[MEMORY_TAG_COUNT];
+
+//16 bytes, so the block after it keeps malloc's alignment
+struct trackedBlockHeader
+{
+	uint64_t size;
+	uint32_t tag;
+	uint32_t padding;
+};
+
+static void recordMemoryUsage(uint32_t tag, int64_t delta)
+{
+	struct memoryTagUsage* usage = &memoryUsage[tag];
+	LONG64 current = InterlockedExchangeAdd64(&usage->currentBytes, delta) + delta;
+	for (LONG64 peak = usage->peakBytes; current > peak;)
+	{
+		LONG64 seen = InterlockedCompareExchange64(&usage->peakBytes, current, peak);
+		if (seen == peak)
+			break;
+		peak = seen;
+	}
+}
+
+void* trackedAlloc(uint32_t tag, size_t size)
+{
+	struct trackedBlockHeader* header = malloc(sizeof(struct trackedBlockHeader) + size);
+	if (header == nullptr)
+		return nullptr;
+	header->size = size;
+	header->tag = tag;
+	recordMemoryUsage(tag, (int64_t)size);
+	InterlockedExchangeAdd64(&memoryUsage[tag].allocationCount, 1);
+	return header + 1;
+}
+
+//like realloc, a block keeps the tag it was allocated with
+void* trackedRealloc(uint32_t tag, void* block, size_t size)
+{
+	if (block == nullptr)
+		return trackedAlloc(tag, size);
+
+	struct trackedBlockHeader* header = realloc((struct trackedBlockHeader*)block - 1, sizeof(struct trackedBlockHeader) + size);
+	if (header == nullptr)
+		return nullptr;
+	recordMemoryUsage(header->tag, (int64_t)size - (int64_t)header->size);
+	header->size = size;
+	return header + 1;
+}
+
+void trackedFree(void* block)
+{
+	if (block == nullptr)
+		return;
+	struct trackedBlockHeader* header = (struct trackedBlockHeader*)block - 1;
+	recordMemoryUsage(header->tag, -(int64_t)header->size);
+	free(header);
+}
+
+/*
+* tracing: scoped spans and counters recorded into a ring buffer per thread, written out as Chrome trace json by -trace.
+* only the owning thread writes to a ring, so recording is a timestamp and a store. with ENABLE_TRACING 0 the macros
+* compile to nothing. span and counter names must be string literals (or otherwise outlive the trace)
+*/
+#ifndef ENABLE_TRACING
+#define ENABLE_TRACING 1
+#endif
+
+#define TRACE_RING_SIZE (1024 * 64)//events per thread, the oldest are overwritten
+#define TRACE_MAX_THREADS 256
+
+#define TRACE_EVENT_SPAN 0
+#define TRACE_EVENT_COUNTER 1
+
+struct traceEvent
+{
+	const char* name;
+	int64_t start;//performance counter ticks
+	int64_t value;//duration in ticks for spans
+	uint32_t type;
+};
+
+/*
+* runParallel starts new threads on every call, so a ring isn't tied to a thread: a worker hands its ring back when it
+* exits and the next thread without one takes it over. the rings are the trace's thread lanes
+*/
+struct traceRing
+{
+	uint32_t threadIndex;
+	volatile LONG owned;//1 while a thread records into it
+	volatile uint64_t eventCount;//events ever written, only the owning thread changes it
+	struct traceEvent events[TRACE_RING_SIZE];
+};
+
+bool tracingEnabled = false;
+struct traceRing* volatile traceRings[TRACE_MAX_THREADS];
+volatile LONG traceRingCount = 0;
+volatile LONG64 droppedTraceEvents = 0;//recorded while TRACE_MAX_THREADS threads held a ring
+static _Thread_local struct traceRing* threadTraceRing = nullptr;
+
+static inline int64_t getTraceTimestamp()
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
+
+//a ring no thread owns, or a new one. nullptr once TRACE_MAX_THREADS threads hold one, or if a new one can't be allocated
+static struct traceRing* acquireTraceRing()
+{
+	LONG ringCount = min(traceRingCount, TRACE_MAX_THREADS);
+	for (LONG i = 0; i < ringCount; i++)
+	{
+		struct traceRing* ring = traceRings[i];
+		if (ring != nullptr && InterlockedCompareExchange(&ring->owned, 1, 0) == 0)
+			return ring;
+	}
+
+	if (traceRingCount >= TRACE_MAX_THREADS)
+		return nullptr;
+	LONG index = InterlockedIncrement(&traceRingCount) - 1;
+	if (index >= TRACE_MAX_THREADS)
+		return nullptr;
+	//without memory the slot stays empty, the writer skips it and the events count as dropped
+	struct traceRing* ring = calloc(1, sizeof(struct traceRing));
+	if (ring == nullptr)
+		return nullptr;
+	ring->threadIndex = index;
+	ring->owned = 1;
+	traceRings[index] = ring;
+	return ring;
+}
+
+//called by threads that are about to exit, their events stay in the ring
+void releaseTraceRing()
+{
+	if (threadTraceRing == nullptr)
+		return;
+	//the exchange is a full barrier, the next owner sees every event
+	InterlockedExchange(&threadTraceRing->owned, 0);
+	threadTraceRing = nullptr;
+}
+
+void recordTraceEvent(uint32_t type, const char* name, int64_t start, int64_t value)
+{
+	struct traceRing* ring = threadTraceRing;
+	if (ring == nullptr)
+	{
+		ring = acquireTraceRing();
+		if (ring == nullptr)
+		{
+			InterlockedIncrement64(&droppedTraceEvents);
+			return;
+		}
+		threadTraceRing = ring;
+	}
+
+	struct traceEvent* event = &ring->events[ring->eventCount & (TRACE_RING_SIZE - 1)];
+	event->name = name;
+	event->start = start;
+	event->value = value;
+	event->type = type;
+	//the event has to be complete before the count says so
+	_ReadWriteBarrier();
+	ring->eventCount++;
+}
+
+#if ENABLE_TRACING
+#define TRACE_BEGIN(span) const int64_t span = tracingEnabled ? getTraceTimestamp() : 0
+#define TRACE_END(span, name) do { if (tracingEnabled) recordTraceEvent(TRACE_EVENT_SPAN, (name), (span), getTraceTimestamp() - (span)); } while (0)
+#define TRACE_COUNTER(name, value) do { if (tracingEnabled) recordTraceEvent(TRACE_EVENT_COUNTER, (name), getTraceTimestamp(), (int64_t)(value)); } while (0)
+#else
+#define TRACE_BEGIN(span)
+#define TRACE_END(span, name) do { } while (0)
+#define TRACE_COUNTER(name, value) do { } while (0)
+#endif
+
 void* GameImageAddress;
+uint64_t GameImageSize;
+const char* GameImagePath = "";
 
 
 struct gameFileInTree
@@ -87,10 +332,16 @@ struct gameFileInTree
 	HTREEITEM treeItem;
 	void* filePtr;
 	uint32_t fileSize;
+	const char* fileName;//points into the FST string table
+	uint32_t directoryIndex;//FST index of the containing directory
 };
 
 
+//sized by indexGameFiles for the FST it walks
 struct gameFileInTree* gameFileList;
+uint32_t gameFileCapacity = 0;
+int gameFileCount = 0;
+#define MAX_GAME_FILES ((1024 * 1024 * 24) / sizeof(struct gameFileInTree))
 
 /*
 * file types:
@@ -106,11 +357,20 @@ struct decodedAsset
 };
 const uint32_t ASSET_TYPE_TEXT = 0;
 const uint32_t ASSET_TYPE_TEXTURE = 1;
+const uint32_t ASSET_TYPE_MODEL = 2;
 
 struct decodedAsset* decodedAssetTable;
 int decodedAssetCount = 0;
+#define DECODED_ASSET_TABLE_SIZE 32
+#define DECODED_ASSET_DATA_SIZE (1024 * 1024 * 24)
 void* decodedAssetData;
 
+//the selected .szs decompressed, kept until the next one because the displayed model points into it
+uint8_t* selectedArchive = nullptr;
+
+#define MODEL_WORKSPACE_SIZE (1024 * 1024 * 32)
+void* modelWorkspace;
+
 struct decodedImage
 {
 	uint32_t width;
@@ -144,273 +404,285 @@ int Unpack565(const uint8_t* const _In_ packed, uint8_t* _Out_ color)
 	return value;
 }
 
-void DecompressColorGCN(const uint32_t _In_ texWidth, uint8_t* _Out_writes_bytes_all_(texWidth * 32) rgba, const void* const _In_ block)
-{
-	// get the block bytes
-	const uint8_t* bytes = block;
+/*
+* GX texture decoding
+* every format is a tile converter and a DEFINE_TILE_DECODER line, the walker goes over the tiles in the order they are stored.
+* a converter writes one tile of rgba texels at out, rows pitch texels apart: whole tiles go straight into the image,
+* tiles over the right or bottom edge into a scratch tile whose visible part is copied.
+*/
+#define DEFINE_TILE_DECODER(name, tileWidth, tileHeight, tileBytes, convertTile) \
+static void name(uint32_t width, uint32_t height, const uint8_t* in, uint32_t* out) \
+{ \
+	alignas(16) uint32_t edgeTile[(tileWidth) * (tileHeight)]; \
+	for (uint32_t y = 0; y < height; y += (tileHeight)) \
+	{ \
+		uint32_t rows = min((tileHeight), height - y); \
+		uint32_t* rowOut = out + (size_t)y * width; \
+		for (uint32_t x = 0; x < width; x += (tileWidth), in += (tileBytes)) \
+		{ \
+			if (rows == (tileHeight) && x + (tileWidth) <= width) \
+			{ \
+				convertTile(in, rowOut + x, width); \
+				continue; \
+			} \
+			convertTile(in, edgeTile, (tileWidth)); \
+			for (uint32_t row = 0; row < rows; row++) \
+				memcpy(rowOut + (size_t)row * width + x, edgeTile + row * (tileWidth), min((tileWidth), width - x) * 4); \
+		} \
+	} \
+}
 
-	// unpack the endpoints
-	uint8_t codes[16];
-	const int a = Unpack565(bytes, codes);
-	const int b = Unpack565(bytes + 2, codes + 4);
+//16 intensity and 16 alpha bytes as 16 rgba texels
+static inline void expandIntensityAlpha(__m128i intensity, __m128i alpha, __m128i* _Out_ texels)
+{
+	__m128i intensityPairs = _mm_unpacklo_epi8(intensity, intensity);
+	__m128i intensityAlpha = _mm_unpacklo_epi8(intensity, alpha);
+	texels[0] = _mm_unpacklo_epi16(intensityPairs, intensityAlpha);
+	texels[1] = _mm_unpackhi_epi16(intensityPairs, intensityAlpha);
+	intensityPairs = _mm_unpackhi_epi8(intensity, intensity);
+	intensityAlpha = _mm_unpackhi_epi8(intensity, alpha);
+	texels[2] = _mm_unpacklo_epi16(intensityPairs, intensityAlpha);
+	texels[3] = _mm_unpackhi_epi16(intensityPairs, intensityAlpha);
+}
 
-	// generate the midpoints
-	for (int i = 0; i < 3; ++i)
-	{
-		const int c = codes[i];
-		const int d = codes[4 + i];
+//16 texels as two rows of an 8 texel wide tile
+static inline void storeTileRows8(const __m128i* texels, uint32_t* out, size_t pitch)
+{
+	_mm_storeu_si128((__m128i*)out, texels[0]);
+	_mm_storeu_si128((__m128i*)(out + 4), texels[1]);
+	_mm_storeu_si128((__m128i*)(out + pitch), texels[2]);
+	_mm_storeu_si128((__m128i*)(out + pitch + 4), texels[3]);
+}
 
-		if (a <= b)
-		{
-			codes[8 + i] = (uint8_t)((c + d) / 2);
-			// GCN: Use midpoint RGB rather than black
-			codes[12 + i] = codes[8 + i];
-		}
-		else
-		{
-			// GCN: 3/8 blend rather than 1/3
-			codes[8 + i] = (uint8_t)((c * 5 + d * 3) >> 3);
-			codes[12 + i] = (uint8_t)((c * 3 + d * 5) >> 3);
-		}
-	}
+//4 bit values in the bytes of v to 8 bits
+static inline __m128i widenNibbles(__m128i v)
+{
+	return _mm_or_si128(v, _mm_slli_epi16(v, 4));
+}
 
-	// fill in alpha for the intermediate values
-	codes[8 + 3] = 255;
-	codes[12 + 3] = (a <= b) ? 0 : 255;
+//8 big endian words as 32 bit lanes
+static inline void loadBigEndian16(const uint8_t* in, __m128i* _Out_ low, __m128i* _Out_ high)
+{
+	__m128i words = _mm_loadu_si128((const __m128i*)in);
+	words = _mm_or_si128(_mm_slli_epi16(words, 8), _mm_srli_epi16(words, 8));
+	*low = _mm_unpacklo_epi16(words, _mm_setzero_si128());
+	*high = _mm_unpackhi_epi16(words, _mm_setzero_si128());
+}
 
-	// unpack the indices
-	uint8_t indices[16];
-	for (int i = 0; i < 4; ++i)
+static inline void convertI4Tile(const uint8_t* in, uint32_t* out, size_t pitch)
+{
+	for (int half = 0; half < 2; half++, in += 16, out += pitch * 4)
 	{
-		uint8_t* ind = indices + 4 * i;
-		uint8_t packed = bytes[4 + i];
-
-		// GCN: indices reversed
-		ind[3] = packed & 0x3;
-		ind[2] = (packed >> 2) & 0x3;
-		ind[1] = (packed >> 4) & 0x3;
-		ind[0] = (packed >> 6) & 0x3;
+		//the first texel of a byte is its high nibble
+		__m128i bytes = _mm_loadu_si128((const __m128i*)in);
+		__m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0F));
+		__m128i low = _mm_and_si128(bytes, _mm_set1_epi8(0x0F));
+		__m128i texels[4];
+		expandIntensityAlpha(widenNibbles(_mm_unpacklo_epi8(high, low)), _mm_set1_epi8(-1), texels);
+		storeTileRows8(texels, out, pitch);
+		expandIntensityAlpha(widenNibbles(_mm_unpackhi_epi8(high, low)), _mm_set1_epi8(-1), texels);
+		storeTileRows8(texels, out + pitch * 2, pitch);
 	}
+}
 
-	// store out the colors
-	for (int y = 0; y < 4; y++)
-		for (int x = 0; x < 4; x++)
-		{
-			uint8_t offset = 4 * indices[y * 4 + x];
-			for (int j = 0; j < 4; j++)
-			{
-				rgba[4 * ((y * texWidth + x)) + (j)] = codes[offset + j];//+ (i - 8 < 0 ? 0 : 128)
-			}// - i % 4
-		}
+static inline void convertI8Tile(const uint8_t* in, uint32_t* out, size_t pitch)
+{
+	for (int half = 0; half < 2; half++, in += 16, out += pitch * 2)
+	{
+		__m128i texels[4];
+		expandIntensityAlpha(_mm_loadu_si128((const __m128i*)in), _mm_set1_epi8(-1), texels);
+		storeTileRows8(texels, out, pitch);
+	}
 }
 
-void decodeTexture(uint32_t width, uint32_t height, uint32_t pixelCount, const uint8_t* _In_ pixelsIn, uint8_t* _Out_ pixelsOut, const uint8_t format)
+//alpha in the high nibble, intensity in the low one
+static inline void convertIA4Tile(const uint8_t* in, uint32_t* out, size_t pitch)
 {
-	switch (format)
+	for (int half = 0; half < 2; half++, in += 16, out += pitch * 2)
 	{
-	case 0xE://cmpr
+		__m128i bytes = _mm_loadu_si128((const __m128i*)in);
+		__m128i alpha = widenNibbles(_mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0F)));
+		__m128i intensity = widenNibbles(_mm_and_si128(bytes, _mm_set1_epi8(0x0F)));
+		__m128i texels[4];
+		expandIntensityAlpha(intensity, alpha, texels);
+		storeTileRows8(texels, out, pitch);
+	}
+}
+
+//alpha in the first byte, intensity in the second
+static inline void convertIA8Tile(const uint8_t* in, uint32_t* out, size_t pitch)
+{
+	for (int half = 0; half < 2; half++, in += 16, out += pitch * 2)
 	{
+		__m128i words = _mm_loadu_si128((const __m128i*)in);
+		__m128i alpha = _mm_and_si128(words, _mm_set1_epi16(0xFF));
+		__m128i intensity = _mm_srli_epi16(words, 8);
+		__m128i texels[4];
+		expandIntensityAlpha(_mm_packus_epi16(intensity, intensity), _mm_packus_epi16(alpha, alpha), texels);
+		_mm_storeu_si128((__m128i*)out, texels[0]);
+		_mm_storeu_si128((__m128i*)(out + pitch), texels[1]);
+	}
+}
+
+//5 and 6 bit channels widened by repeating their top bits, like Unpack565
+static inline __m128i convertRGB565Texels(__m128i v)
+{
+	__m128i red = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 8), _mm_set1_epi32(0xF8)), _mm_and_si128(_mm_srli_epi32(v, 13), _mm_set1_epi32(0x07)));
+	__m128i green = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 3), _mm_set1_epi32(0xFC)), _mm_and_si128(_mm_srli_epi32(v, 9), _mm_set1_epi32(0x03)));
+	__m128i blue = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(v, 3), _mm_set1_epi32(0xF8)), _mm_and_si128(_mm_srli_epi32(v, 2), _mm_set1_epi32(0x07)));
+	return _mm_or_si128(_mm_or_si128(red, _mm_slli_epi32(green, 8)), _mm_or_si128(_mm_slli_epi32(blue, 16), _mm_set1_epi32(0xFF000000)));
+}
 
-		uint32_t ByteInBlock = 0;
+//the top bit picks 5 bit colors or 3 bit alpha and 4 bit colors
+static inline __m128i convertRGB5A3Texels(__m128i v)
+{
+	__m128i red = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 7), _mm_set1_epi32(0xF8)), _mm_and_si128(_mm_srli_epi32(v, 12), _mm_set1_epi32(0x07)));
+	__m128i green = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 2), _mm_set1_epi32(0xF8)), _mm_and_si128(_mm_srli_epi32(v, 7), _mm_set1_epi32(0x07)));
+	__m128i blue = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(v, 3), _mm_set1_epi32(0xF8)), _mm_and_si128(_mm_srli_epi32(v, 2), _mm_set1_epi32(0x07)));
+	__m128i opaque = _mm_or_si128(_mm_or_si128(red, _mm_slli_epi32(green, 8)), _mm_or_si128(_mm_slli_epi32(blue, 16), _mm_set1_epi32(0xFF000000)));
+
+	//the 4 bit channels go to the bytes they end up in, then every nibble is repeated
+	__m128i channels4 = _mm_or_si128(
+		_mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 8), _mm_set1_epi32(0x0F)), _mm_and_si128(v, _mm_set1_epi32(0x0F0))),
+		_mm_and_si128(_mm_slli_epi32(v, 16), _mm_set1_epi32(0x0F0000)));
+	channels4 = _mm_or_si128(_mm_and_si128(channels4, _mm_set1_epi32(0x0F000F)), _mm_slli_epi32(_mm_and_si128(channels4, _mm_set1_epi32(0x0F0)), 4));
+	channels4 = widenNibbles(channels4);
+	__m128i alpha3 = _mm_and_si128(_mm_srli_epi32(v, 12), _mm_set1_epi32(0x7));
+	__m128i alpha = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(alpha3, 5), _mm_slli_epi32(alpha3, 2)), _mm_srli_epi32(alpha3, 1));
+	__m128i translucent = _mm_or_si128(channels4, _mm_slli_epi32(alpha, 24));
+
+	__m128i isOpaque = _mm_srai_epi32(_mm_slli_epi32(v, 16), 31);
+	return _mm_or_si128(_mm_and_si128(isOpaque, opaque), _mm_andnot_si128(isOpaque, translucent));
+}
 
-		for (int y = 0; y < height; y += 8)
-		{
-			for (int x = 0; x < width; x += 8)
-			{
-				//decode full dxt1 block, (4 sub blocks)
-				DecompressColorGCN(width, OffsetPointer(pixelsOut, 4 * (y * width + x)), &pixelsIn[ByteInBlock]);
-				ByteInBlock += 8;
-				DecompressColorGCN(width, OffsetPointer(pixelsOut, 4 * ((y)*width + (x + 4))), &pixelsIn[ByteInBlock]);
-				ByteInBlock += 8;
-				DecompressColorGCN(width, OffsetPointer(pixelsOut, 4 * ((y + 4) * width + (x))), &pixelsIn[ByteInBlock]);
-				ByteInBlock += 8;
-				DecompressColorGCN(width, OffsetPointer(pixelsOut, 4 * ((y + 4) * width + (x + 4))), &pixelsIn[ByteInBlock]);
-				ByteInBlock += 8;
-			}
-		}
-		break;
+static inline void convertRGB565Tile(const uint8_t* in, uint32_t* out, size_t pitch)
+{
+	for (int half = 0; half < 2; half++, in += 16, out += pitch * 2)
+	{
+		__m128i low, high;
+		loadBigEndian16(in, &low, &high);
+		_mm_storeu_si128((__m128i*)out, convertRGB565Texels(low));
+		_mm_storeu_si128((__m128i*)(out + pitch), convertRGB565Texels(high));
 	}
-	case 0x5://RGB5A3
+}
+
+static inline void convertRGB5A3Tile(const uint8_t* in, uint32_t* out, size_t pitch)
+{
+	for (int half = 0; half < 2; half++, in += 16, out += pitch * 2)
 	{
-		int inputPixelIndex = 0;
-		for (int y = 0; y < height; y += 4)
-		{
-			for (int x = 0; x < width; x += 4)
-			{
-				for (int j = 0; j < 4; j++)
-				{
-					for (int k = 0; k < 4; k++)
-					{
-						uint16_t pixel = SwapEndian(*OffsetPointer((uint16_t*)pixelsIn, inputPixelIndex * sizeof(uint16_t)));
+		__m128i low, high;
+		loadBigEndian16(in, &low, &high);
+		_mm_storeu_si128((__m128i*)out, convertRGB5A3Texels(low));
+		_mm_storeu_si128((__m128i*)(out + pitch), convertRGB5A3Texels(high));
+	}
+}
 
-						uint32_t outputPixel = 0;
-						if (pixel & 0b1000000000000000)
-						{
-							//no alpha
-							uint8_t pixelB = ((pixel & 0b0000000000011111) >> 0) * 0x8;
-							uint8_t pixelG = ((pixel & 0b0000001111100000) >> 5) * 0x8;
-							uint8_t pixelR = ((pixel & 0b0111110000000000) >> 10) * 0x8;
-
-							*OffsetPointer((uint8_t*)&outputPixel, 0) = pixelR;
-							*OffsetPointer((uint8_t*)&outputPixel, 1) = pixelG;
-							*OffsetPointer((uint8_t*)&outputPixel, 2) = pixelB;
-							*OffsetPointer((uint8_t*)&outputPixel, 3) = 255;
-						}
-						else
-						{
-							//3 bit alpha
-							uint8_t pixelB = ((pixel & 0b0000000000001111) >> 0) * 0x11;
-							uint8_t pixelG = ((pixel & 0b0000000011110000) >> 4) * 0x11;
-							uint8_t pixelR = ((pixel & 0b0000111100000000) >> 8) * 0x11;
-							uint8_t pixelA = ((pixel & 0b0111000000000000) >> 12) * 0x20;
-
-							*OffsetPointer((uint8_t*)&outputPixel, 0) = pixelR;
-							*OffsetPointer((uint8_t*)&outputPixel, 1) = pixelG;
-							*OffsetPointer((uint8_t*)&outputPixel, 2) = pixelB;
-							*OffsetPointer((uint8_t*)&outputPixel, 3) = pixelA;
-						}
-						*((uint32_t*)OffsetPointer(pixelsOut, 4 * (((y + j) * width + x) + k))) = outputPixel;
-						inputPixelIndex++;
-					}
-				}
-			}
-		}
-		break;
+//alpha/red pairs for the 16 texels, then green/blue pairs
+static inline void convertRGBA8Tile(const uint8_t* in, uint32_t* out, size_t pitch)
+{
+	for (int half = 0; half < 2; half++, in += 16, out += pitch * 2)
+	{
+		__m128i alphaRed = _mm_loadu_si128((const __m128i*)in);
+		__m128i greenBlue = _mm_loadu_si128((const __m128i*)(in + 32));
+		__m128i redGreen = _mm_or_si128(_mm_srli_epi16(alphaRed, 8), _mm_slli_epi16(greenBlue, 8));
+		__m128i blueAlpha = _mm_or_si128(_mm_srli_epi16(greenBlue, 8), _mm_slli_epi16(alphaRed, 8));
+		_mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi16(redGreen, blueAlpha));
+		_mm_storeu_si128((__m128i*)(out + pitch), _mm_unpackhi_epi16(redGreen, blueAlpha));
 	}
-	case 0x3://IA8
+}
+
+//one DXT1 style block with big endian endpoints and the first texel of a row in the top bits of its index byte
+static inline void decodeCMPRBlock(const uint8_t* block, uint32_t* out, size_t pitch)
+{
+	uint32_t palette[4];
+	uint8_t* codes = (uint8_t*)palette;
+	const int a = Unpack565(block, codes);
+	const int b = Unpack565(block + 2, codes + 4);
+	for (int i = 0; i < 3; ++i)
 	{
-		int inputPixelIndex = 0;
-		for (int y = 0; y < height; y += 4)
+		const int c = codes[i];
+		const int d = codes[4 + i];
+		if (a <= b)
 		{
-			for (int x = 0; x < width; x += 4)
-			{
-				for (int j = 0; j < 4; j++)
-				{
-					for (int k = 0; k < 4; k++)
-					{
-						uint16_t pixel = SwapEndian(*OffsetPointer((uint16_t*)pixelsIn, inputPixelIndex * sizeof(uint16_t)));
-
-						uint32_t outputPixel = 0;
-
-
-						*OffsetPointer((uint8_t*)&outputPixel, 0) = pixel & 0xFF;
-						*OffsetPointer((uint8_t*)&outputPixel, 1) = pixel & 0xFF;
-						*OffsetPointer((uint8_t*)&outputPixel, 2) = pixel & 0xFF;
-						*OffsetPointer((uint8_t*)&outputPixel, 3) = (pixel & 0xFF00) >> 8;
-
-						*((uint32_t*)OffsetPointer(pixelsOut, 4 * (((y + j) * width + x) + k))) = outputPixel;
-						inputPixelIndex++;
-					}
-				}
-			}
+			// GCN: Use midpoint RGB rather than black
+			codes[8 + i] = (uint8_t)((c + d) / 2);
+			codes[12 + i] = codes[8 + i];
 		}
-		break;
-	}
-	case 0x0://I4 //todo: untested
-	{
-		int inputPixelIndex = 0;
-		for (int y = 0; y < height; y += 8)
+		else
 		{
-			for (int x = 0; x < width; x += 8)
-			{
-				for (int j = 0; j < 8; j++)
-				{
-					for (int k = 0; k < 8; k += 2)
-					{
-						uint8_t pixel = *OffsetPointer((uint8_t*)pixelsIn, inputPixelIndex * sizeof(uint8_t));
-
-						uint32_t outputPixel = 0;
-
-						*OffsetPointer((uint8_t*)&outputPixel, 0) = (pixel & 0b11110000) >> 4;
-						*OffsetPointer((uint8_t*)&outputPixel, 1) = (pixel & 0b11110000) >> 4;
-						*OffsetPointer((uint8_t*)&outputPixel, 2) = (pixel & 0b11110000) >> 4;
-						*OffsetPointer((uint8_t*)&outputPixel, 3) = 0xFF;
-
-						*((uint32_t*)OffsetPointer(pixelsOut, 4 * (((y + j) * width + x) + k))) = outputPixel;
-
-						*OffsetPointer((uint8_t*)&outputPixel, 0) = (pixel & 0b00001111);
-						*OffsetPointer((uint8_t*)&outputPixel, 1) = (pixel & 0b00001111);
-						*OffsetPointer((uint8_t*)&outputPixel, 2) = (pixel & 0b00001111);
-						*OffsetPointer((uint8_t*)&outputPixel, 3) = 0xFF;
-
-
-						*((uint32_t*)OffsetPointer(pixelsOut, 4 * (((y + j) * width + x) + k + 1))) = outputPixel;
-						inputPixelIndex++;
-					}
-				}
-			}
+			// GCN: 3/8 blend rather than 1/3
+			codes[8 + i] = (uint8_t)((c * 5 + d * 3) >> 3);
+			codes[12 + i] = (uint8_t)((c * 3 + d * 5) >> 3);
 		}
-		break;
 	}
-	case 0x2://IA4 //todo: untested
+	codes[8 + 3] = 255;
+	codes[12 + 3] = (a <= b) ? 0 : 255;
+
+	for (int row = 0; row < 4; row++, out += pitch)
 	{
-		int inputPixelIndex = 0;
-		for (int y = 0; y < height; y += 4)
-		{
-			for (int x = 0; x < width; x += 8)
-			{
-				for (int j = 0; j < 4; j++)
-				{
-					for (int k = 0; k < 8; k++)
-					{
-						uint8_t pixel = *OffsetPointer((uint8_t*)pixelsIn, inputPixelIndex * sizeof(uint8_t));
+		uint8_t indices = block[4 + row];
+		out[0] = palette[indices >> 6];
+		out[1] = palette[(indices >> 4) & 3];
+		out[2] = palette[(indices >> 2) & 3];
+		out[3] = palette[indices & 3];
+	}
+}
 
-						uint32_t outputPixel = 0;
+//4 blocks: top left, top right, bottom left, bottom right
+static inline void convertCMPRTile(const uint8_t* in, uint32_t* out, size_t pitch)
+{
+	decodeCMPRBlock(in, out, pitch);
+	decodeCMPRBlock(in + 8, out + 4, pitch);
+	decodeCMPRBlock(in + 16, out + pitch * 4, pitch);
+	decodeCMPRBlock(in + 24, out + pitch * 4 + 4, pitch);
+}
 
-						uint8_t grayScale = (pixel & 0b00001111) * 0x11;
-						uint8_t alpha = ((pixel & 0b11110000) >> 4) * 0x11;
+DEFINE_TILE_DECODER(decodeI4Texture, 8, 8, 32, convertI4Tile)
+DEFINE_TILE_DECODER(decodeI8Texture, 8, 4, 32, convertI8Tile)
+DEFINE_TILE_DECODER(decodeIA4Texture, 8, 4, 32, convertIA4Tile)
+DEFINE_TILE_DECODER(decodeIA8Texture, 4, 4, 32, convertIA8Tile)
+DEFINE_TILE_DECODER(decodeRGB565Texture, 4, 4, 32, convertRGB565Tile)
+DEFINE_TILE_DECODER(decodeRGB5A3Texture, 4, 4, 32, convertRGB5A3Tile)
+DEFINE_TILE_DECODER(decodeRGBA8Texture, 4, 4, 64, convertRGBA8Tile)
+DEFINE_TILE_DECODER(decodeCMPRTexture, 8, 8, 32, convertCMPRTile)
 
-						*OffsetPointer((uint8_t*)&outputPixel, 0) = grayScale;
-						*OffsetPointer((uint8_t*)&outputPixel, 1) = grayScale;
-						*OffsetPointer((uint8_t*)&outputPixel, 2) = grayScale;
-						*OffsetPointer((uint8_t*)&outputPixel, 3) = alpha;
+//GX texture format names by format number, for traces and listings
+static const char* textureFormatNames[16] = { "I4", "I8", "IA4", "IA8", "RGB565", "RGB5A3", "RGBA8", "format 7", "C4", "C8", "C14X2", "format B", "format C", "format D", "CMPR", "format F" };
 
-						*((uint32_t*)OffsetPointer(pixelsOut, 4 * (((y + j) * width + x) + k))) = outputPixel;
-						inputPixelIndex++;
-					}
-				}
-			}
-		}
-		break;
-	}
-	case 0x4://RGB565
+//writes width x height rgba texels, the palette formats (C4, C8, C14X2) are left alone
+void decodeTexture(uint32_t width, uint32_t height, uint32_t pixelCount, const uint8_t* _In_ pixelsIn, uint8_t* _Out_ pixelsOut, const uint8_t format)
+{
+	TRACE_BEGIN(decodeSpan);
+	uint32_t* texels = (uint32_t*)pixelsOut;
+	switch (format)
 	{
-		int inputPixelIndex = 0;
-		for (int y = 0; y < height; y += 4)
-		{
-			for (int x = 0; x < width; x += 4)
-			{
-				for (int j = 0; j < 4; j++)
-				{
-					for (int k = 0; k < 4; k++)
-					{
-						//Unpack565() swaps endian internally
-						uint16_t pixel = *OffsetPointer((uint16_t*)pixelsIn, inputPixelIndex * sizeof(uint16_t));
-
-						uint32_t outputPixel = 0;
-						Unpack565(&pixel, &outputPixel);
-
-
-						*((uint32_t*)OffsetPointer(pixelsOut, 4 * (((y + j) * width + x) + k))) = outputPixel;
-						inputPixelIndex++;
-					}
-				}
-			}
-		}
-		break;
-	}
+	case 0x0: decodeI4Texture(width, height, pixelsIn, texels); break;
+	case 0x1: decodeI8Texture(width, height, pixelsIn, texels); break;
+	case 0x2: decodeIA4Texture(width, height, pixelsIn, texels); break;
+	case 0x3: decodeIA8Texture(width, height, pixelsIn, texels); break;
+	case 0x4: decodeRGB565Texture(width, height, pixelsIn, texels); break;
+	case 0x5: decodeRGB5A3Texture(width, height, pixelsIn, texels); break;
+	case 0x6: decodeRGBA8Texture(width, height, pixelsIn, texels); break;
+	case 0xE: decodeCMPRTexture(width, height, pixelsIn, texels); break;
 	default:
-
 		//DebugBreak();
+		break;
 	}
+	TRACE_END(decodeSpan, textureFormatNames[format & 0xF]);
+}
+
+//the formats decodeTexture writes texels for
+static inline bool isDecodableTextureFormat(uint8_t format)
+{
+	return format <= 0x6 || format == 0xE;
 }
 
 int DecompressYAZ
 (
 	// returns:
-	//	    ERR_OK:           compression done
-	//	    ERR_WARNING:      silent==true: dest buffer too small
-	//	    ERR_INVALID_DATA: invalid source data
+	//	    0:  decompression done
+	//	    -1: dest buffer too small, it's filled as far as it goes
+	//	    -2: invalid source data, a back reference before the start of the output or a truncated operation
 
 	const void* data,		// source data
 	size_t		data_size,	// size of 'data'
@@ -419,14 +691,13 @@ int DecompressYAZ
 	size_t* write_status,	// number of written bytes
 	//ccp			fname,		// file name for error messages
 	int			yaz_version,	// yaz version for error messages (0|1)
-	bool		silent,		// true: don't print error messages
-	FILE* hexdump	// not NULL: write decrompression hex-dump
+	bool		silent		// true: don't print error messages
 )
 {
 	assert(data);
 	assert(dest_buf);
-	assert(dest_buf_size);
 	//TRACE("DecompressYAZ(vers=%d) src=%p+%zu, dest=%p+%zu\n", yaz_version, data, data_size, dest_buf, dest_buf_size);
+	TRACE_BEGIN(decompressionSpan);
 
 	const uint8_t* src = data;
 	const uint8_t* src_end = src + data_size;
@@ -434,50 +705,59 @@ int DecompressYAZ
 	uint8_t* dest_end = dest + dest_buf_size;
 	uint8_t  code = 0;
 	int code_len = 0;
+	int status = 0;
 
-	unsigned int count0 = 0;
-	unsigned int count1 = 0;
-	unsigned int count2 = 0;
-	unsigned int count3 = 0;
-
-	int addr_fw = 0;
-	char buf[12];
-	if (hexdump)
-	{
-		fprintf(hexdump, "\n"
-			"# size of compressed data:    %#8zx = %9zu\n"
-			"# size of de-compressed data: %#8zx = %9zu\n"
-			"\n",
-			data_size, data_size, dest_buf_size, dest_buf_size);
-		addr_fw = snprintf(buf, sizeof(buf), "%zx", dest_buf_size - 1) + 1;
-	}
-
-	while (src < src_end && dest < dest_end)
+	// fast path: while a whole group (a type byte and 8 operations of at most 3 bytes) is left in the source
+	// and 8 of the longest copies still fit in the destination, only back reference distances need checking
+	const size_t group_src_size = 1 + 8 * 3;
+	const size_t group_dest_size = 8 * 0x111;
+	while ((size_t)(src_end - src) >= group_src_size && (size_t)(dest_end - dest) >= group_dest_size)
 	{
-		if (!code_len--)
-		{
-			if (hexdump)
-			{
-				count0++;
-				fprintf(hexdump,
-					"%*x: %02x -- -- : type byte\n",
-					addr_fw, (unsigned int)(src - (uint8_t*)data), *src);
-			}
-
-			code = *src++;
-			code_len = 7;
-		}
-
-		if (code & 0x80)
+		code = *src++;
+		for (int i = 0; i < 8; i++, code <<= 1)
 		{
-			if (hexdump)
+			if (code & 0x80)
 			{
-				count1++;
-				fprintf(hexdump,
-					"%*x: %02x -- -- : copy direct\n",
-					addr_fw, (unsigned int)(src - (uint8_t*)data), *src);
+				*dest++ = *src++;
+				continue;
 			}
 
+			const uint8_t b1 = *src++;
+			const uint8_t b2 = *src++;
+			const size_t distance = ((b1 & 0x0f) << 8 | b2) + 1;
+			int n = b1 >> 4;
+			if (!n)
+				n = *src++ + 0x12;
+			else
+				n += 2;
+
+			if (distance > (size_t)(dest - (uint8_t*)dest_buf))
+			{
+				status = -2;
+				goto done;
+			}
+
+			// don't use memcpy() or memmove() here because
+			// they don't work with self referencing chunks.
+			const uint8_t* copy_src = dest - distance;
+			while (n-- > 0)
+				*dest++ = *copy_src++;
+		}
+	}
+
+	// the rest is checked operation by operation
+	while (src < src_end && dest < dest_end)
+	{
+		if (!code_len--)
+		{
+			code = *src++;
+			code_len = 7;
+			if (src == src_end)
+				break;
+		}
+
+		if (code & 0x80)
+		{
 			// copy 1 byte direct
 			*dest++ = *src++;
 		}
@@ -485,9 +765,15 @@ int DecompressYAZ
 		{
 			// rle part
 
+			if (src_end - src < 2 || (!(src[0] >> 4) && src_end - src < 3))
+			{
+				status = -2;
+				break;
+			}
+
 			const uint8_t b1 = *src++;
 			const uint8_t b2 = *src++;
-			const uint8_t* copy_src = dest - ((b1 & 0x0f) << 8 | b2) - 1;
+			const size_t distance = ((b1 & 0x0f) << 8 | b2) + 1;
 
 			int n = b1 >> 4;
 			if (!n)
@@ -496,16 +782,14 @@ int DecompressYAZ
 				n += 2;
 			assert(n >= 3 && n <= 0x111);
 
-			//noPRINT_IF(copy_src + n > dest, "RLE OVERLAP: copy %zu..%zu -> %zu\n", copy_src - szs->data, copy_src + n - szs->data, dest - szs->data);
-
-			if (copy_src < (uint8_t*)dest_buf)
+			if (distance > (size_t)(dest - (uint8_t*)dest_buf))
 			{
-				if (write_status)
-					*write_status = dest - (uint8_t*)dest_buf;
 				//if (!silent)
 				//	ERROR0(ERR_INVALID_DATA, "YAZ%u data corrupted: Back reference points before beginning of data: %s\n", yaz_version, fname ? fname : "?");
-				//return ERR_INVALID_DATA;
+				status = -2;
+				break;
 			}
+			const uint8_t* copy_src = dest - distance;
 
 			if (dest + n > dest_end)
 			{
@@ -513,730 +797,14218 @@ int DecompressYAZ
 				while (dest < dest_end)
 					*dest++ = *copy_src++;
 
-				if (write_status)
-					*write_status = dest - (uint8_t*)dest_buf;
 				//return silent ? ERR_WARNING : ERROR0(ERR_INVALID_DATA, "YAZ%u data corrupted: Decompressed data larger than specified (%zu>%zu): %s\n", yaz_version, GetDecompressedSizeYAZ(data, data_size), dest_buf_size, fname ? fname : "?");
-				return -1;
+				status = -1;
+				break;
 			}
 
-			if (hexdump)
-			{
-				if (n < 0x12)
-				{
-					count2++;
-					fprintf(hexdump, "%*x: %02x %02x --", addr_fw, (unsigned int)(src - 2 - (uint8_t*)data), src[-2], src[-1]);
-				}
-				else
-				{
-					count3++;
-					fprintf(hexdump, "%*x: %02x %02x %02x",
-						addr_fw, (unsigned int)(src - 3 - (uint8_t*)data),
-						src[-3], src[-2], src[-1]);
-				}
-				fprintf(hexdump, " : copy %03x off %04d:", n, (unsigned int)(copy_src - dest));
-				int max = n < 10 ? n : 10;
-				const uint8_t* hex_src = copy_src;
-
-				// copy data before hexdump
-				while (n-- > 0)
-					*dest++ = *copy_src++;
-
-				while (max-- > 0)
-					fprintf(hexdump, " %02x", *hex_src++);
-				if (hex_src != copy_src)
-					fputs(" ...\n", hexdump);
-				else
-					fputc('\n', hexdump);
-			}
-			else
-			{
-				// don't use memcpy() or memmove() here because
-				// they don't work with self referencing chunks.
-				while (n-- > 0)
-					*dest++ = *copy_src++;
-			}
+			// don't use memcpy() or memmove() here because
+			// they don't work with self referencing chunks.
+			while (n-- > 0)
+				*dest++ = *copy_src++;
 		}
 
 		code <<= 1;
 	}
+done:
 	assert(src <= src_end);
 	assert(dest <= dest_end);
 
-	if (hexdump)
-		fprintf(hexdump, "\n"
-			"# %u type bytes, %u single bytes, %u+%u back references\n"
-			"\n",
-			count0, count1, count2, count3);
-
 	if (write_status)
 		*write_status = dest - (uint8_t*)dest_buf;
-	return 0;
+	TRACE_END(decompressionSpan, "DecompressYAZ");
+	TRACE_COUNTER("decompressed bytes", dest - (uint8_t*)dest_buf);
+	return status;
 }
 
-LRESULT CALLBACK FileViewerWindowProcedure(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+/*
+* text (generator/route/parameter) file parser
+* tokens are whitespace delimited, '#' starts a comment that runs to the end of the line.
+* tokens reference the mapped file directly, nothing is copied.
+*/
+
+const uint8_t TEXT_TOKEN_INTEGER = 0;
+const uint8_t TEXT_TOKEN_FLOAT = 1;
+const uint8_t TEXT_TOKEN_WORD = 2;
+const uint8_t TEXT_TOKEN_OPEN_BRACE = 3;
+const uint8_t TEXT_TOKEN_CLOSE_BRACE = 4;
+
+struct textToken
 {
-	static SCROLLINFO si = { 0 };
-	switch (msg)
+	uint32_t offset;//from the start of the file
+	uint16_t length;
+	uint8_t type;
+	uint8_t depth;//brace depth the token lives at
+	uint32_t line;
+	union
 	{
-		case WM_CREATE:
-		{
-			si.cbSize = sizeof(si);
-			si.fMask = SIF_RANGE | SIF_PAGE;
-			si.nMin = 0;
-			si.nMax = 200;
-			si.nPage = 50;
-			SetScrollInfo(hwnd, SB_VERT, &si, TRUE);
-			break;
-		}
-		case WM_VSCROLL:
-		{
-			si.cbSize = sizeof(si);
-			si.fMask = SIF_ALL;
-			GetScrollInfo(hwnd, SB_VERT, &si);
-			switch (LOWORD(wParam))
-			{
-			case SB_TOP:
-				si.nPos = si.nMin;
-				break;
-			case SB_BOTTOM:
-				si.nPos = si.nMax;
-				break;
-			case SB_LINEUP:
-				si.nPos -= 1;
-				break;
-			case SB_LINEDOWN:
-				si.nPos += 1;
-				break;
-			case SB_PAGEUP:
-				si.nPos -= si.nPage;
-				break;
-			case SB_PAGEDOWN:
-				si.nPos += si.nPage;
-				break;
-			case SB_THUMBTRACK:
-				si.nPos = si.nTrackPos;
-				break;
-			default:
-				break;
-			}
-			si.fMask = SIF_POS;
-			SetScrollInfo(hwnd, SB_VERT, &si, TRUE);
+		int32_t asInt;
+		float asFloat;
+	};
+};
 
-			InvalidateRect(hwnd, nullptr, TRUE);
-			UpdateWindow(hwnd);
-		}
-		break;
-		case WM_PAINT:
-		{
+struct textObject
+{
+	uint32_t nameToken;//first word in the block that isn't a version tag
+	uint32_t firstToken;
+	uint32_t tokenCount;
+	int32_t positionIndex;//-1 if the block has no position
+};
 
-			//decodedAssetCount = 1;
-			//decodedAssets[0].assetType = ASSET_TYPE_TEXT;
-			//decodedAssets[0].assetPtr = gameFileList[selectedFileIndex].filePtr;
-			PAINTSTRUCT ps = { 0 };
-			HDC hdc = BeginPaint(hwnd, &ps);
-			int nextAssetLocationY = 0;
-			for (int i = 0; i < decodedAssetCount; i++)
-			{
-				switch (decodedAssetTable[i].assetType)
-				{
-				case ASSET_TYPE_TEXT:
-				{
-					RECT rect = { 25, si.nPos * -25, 500, 2000 };
-					DrawTextA(hdc, decodedAssetTable[i].assetPtr, -1, &rect, DT_LEFT | DT_TOP);
-					break;
-				}
-				case ASSET_TYPE_TEXTURE:
-				{
-					const struct decodedImage* imgHeader = decodedAssetTable[i].assetPtr;
-					BITMAPINFO info = { 0 };
-					info.bmiHeader.biBitCount = 32;
-					info.bmiHeader.biWidth = imgHeader->width;
-					info.bmiHeader.biHeight = imgHeader->height;
-					info.bmiHeader.biPlanes = 1;
-					info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-					info.bmiHeader.biSizeImage = imgHeader->pixelCount * 4;
+struct textWaypoint
+{
+	int32_t index;
+	uint32_t linkCount;
+	uint32_t firstLink;//into parsedTextFile::links
+	uint32_t positionIndex;
+	float radius;
+};
 
-					// Draw the pixel
-					StretchDIBits(hdc, 0, nextAssetLocationY, imgHeader->width * 4, imgHeader->height * 4, 0, 0, imgHeader->width, imgHeader->height, imgHeader->pixels, &info, DIB_RGB_COLORS, SRCCOPY);
-					nextAssetLocationY += imgHeader->height * 4;
-					break;
-				}
-				}
-			}
-			
+struct textParameter
+{
+	uint32_t nameToken;//{p000} style id
+	uint32_t valueToken;//last numeric token on the same line
+};
 
-			EndPaint(hwnd, &ps);
-			break;
-		}
-		case WM_DESTROY:
-			PostQuitMessage(0);
-			break;
-		default:
-			return DefWindowProc(hwnd, msg, wParam, lParam);
-	}
-	return 0;
-}
+struct parsedTextFile
+{
+	const char* source;
+	uint32_t sourceSize;
 
-LRESULT CALLBACK WindowProcedure(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+	uint32_t tokenCount;
+	struct textToken* tokens;
+
+	uint32_t objectCount;
+	struct textObject* objects;
+
+	uint32_t waypointCount;
+	struct textWaypoint* waypoints;
+
+	uint32_t linkCount;
+	uint16_t* links;
+
+	uint32_t parameterCount;
+	struct textParameter* parameters;
+
+	//positions are stored struct-of-arrays so spatial queries only touch the components they need
+	uint32_t positionCount;
+	float* positionX;
+	float* positionY;
+	float* positionZ;
+};
+
+/*
+* character classes:
+* 0: part of a token
+* 1: whitespace
+* 2: comment start
+*/
+static uint8_t textCharacterClass[256];
+
+void initTextCharacterClasses()
 {
-	static HWND hTreeView;
-	static HWND hFileView;
+	textCharacterClass[' '] = 1;
+	textCharacterClass['\t'] = 1;
+	textCharacterClass['\r'] = 1;
+	textCharacterClass['\n'] = 1;
+	textCharacterClass['\0'] = 1;
+	textCharacterClass['#'] = 2;
+}
 
-	switch (msg)
-	{
-	case WM_CREATE:
+//returns the token type, numbers are only accepted if the whole token is consumed
+uint8_t classifyTextToken(const char* _In_reads_(length) token, uint32_t length, struct textToken* _Out_ result)
+{
+	if (length == 1 && token[0] == '{')
+		return TEXT_TOKEN_OPEN_BRACE;
+	if (length == 1 && token[0] == '}')
+		return TEXT_TOKEN_CLOSE_BRACE;
+
+	uint32_t i = 0;
+	bool negative = false;
+	if (token[0] == '-' || token[0] == '+')
 	{
-		WNDCLASSW wc = { 0 };
+		negative = token[0] == '-';
+		i++;
+	}
 
-		wc.hbrBackground = (HBRUSH)COLOR_WINDOW;
-		wc.hCursor = LoadCursor(NULL, IDC_ARROW);
-		wc.hInstance = GetModuleHandleW(nullptr);
-		wc.lpszClassName = L"FileViewerWindowClass";
-		wc.lpfnWndProc = &FileViewerWindowProcedure;
-		RegisterClassW(&wc);
+	if (i == length || ((token[i] < '0' || token[i] > '9') && token[i] != '.'))
+		return TEXT_TOKEN_WORD;
 
+	uint32_t integerPart = 0;
+	uint32_t digitCount = 0;
+	for (; i < length && token[i] >= '0' && token[i] <= '9'; i++, digitCount++)
+		integerPart = integerPart * 10 + (token[i] - '0');
 
-		hTreeView = CreateWindowExW(0, WC_TREEVIEW, L"Tree View",
-			WS_VISIBLE | WS_CHILD | WS_BORDER | TVS_HASLINES,
-			0, 0, 200, 500,
-			hwnd, NULL, NULL, NULL);
+	if (i == length)
+	{
+		result->asInt = negative ? -(int32_t)integerPart : (int32_t)integerPart;
+		return TEXT_TOKEN_INTEGER;
+	}
 
-		hFileView = CreateWindowExW(0, L"FileViewerWindowClass", L"File View",
-			WS_VISIBLE | WS_CHILD | WS_BORDER | TVS_HASLINES | WS_VSCROLL,
-			200, 0, 200, 500,
-			hwnd, NULL, NULL, NULL);
+	//fraction (a trailing 'f' is tolerated, some files use c style literals)
+	double value = integerPart;
+	if (token[i] == '.')
+	{
+		i++;
+		double scale = 0.1;
+		for (; i < length && token[i] >= '0' && token[i] <= '9'; i++, digitCount++)
+		{
+			value += (token[i] - '0') * scale;
+			scale *= 0.1;
+		}
+	}
+
+	if (digitCount == 0)
+		return TEXT_TOKEN_WORD;
 
+	if (i < length && (token[i] == 'e' || token[i] == 'E'))
+	{
+		i++;
+		bool negativeExponent = false;
+		if (i < length && (token[i] == '-' || token[i] == '+'))
 		{
-			struct DiskHeader
-			{
-				uint32_t GameCode;
-				uint16_t MakerCode;
-				uint8_t DiskID;
-				uint8_t Version;
-				uint8_t AudioStreaming;
-				uint8_t StreamBufferSize;
-				uint8_t unused1[18];
-				uint32_t Magic;
-				char GameName[992];
-				uint32_t DebugMonitorOffset;
-				uint32_t Unknown;
-				uint8_t unused2[24];
-				uint32_t DOLOffset;
-				uint32_t FSTOffset;
-				uint32_t FSTSize;
-				uint32_t MaxFSTSize;
-			};
+			negativeExponent = token[i] == '-';
+			i++;
+		}
+		int exponent = 0;
+		for (; i < length && token[i] >= '0' && token[i] <= '9'; i++)
+			exponent = exponent * 10 + (token[i] - '0');
+		value *= pow(10.0, negativeExponent ? -exponent : exponent);
+	}
 
-			struct DiskHeader* dh = GameImageAddress;
+	if (i < length && token[i] == 'f')
+		i++;
 
-			struct FileEntry
-			{
-				uint8_t Flags;
-				uint8_t FileNameOffsetp1;
-				uint8_t FileNameOffsetp2;
-				uint8_t FileNameOffsetp3;
-				uint32_t FileOffset;
-				uint32_t Unknown;
-			};
+	if (i != length)
+		return TEXT_TOKEN_WORD;
 
-			struct FileEntry* FST = OffsetPointer(GameImageAddress, SwapEndian(dh->FSTOffset));
-			void* StringTable = OffsetPointer(FST, SwapEndian(FST->Unknown) * sizeof(struct FileEntry));
-			int NumEntries = SwapEndian(FST->Unknown);
+	result->asFloat = (float)(negative ? -value : value);
+	return TEXT_TOKEN_FLOAT;
+}
 
-			//how many directories in we are (max 16)
-			int deepness = 0;
+//returns the number of tokens written, or -1 if maxTokens was not enough
+int tokenizeTextFile(const char* _In_reads_(size) text, uint32_t size, struct textToken* _Out_writes_(maxTokens) tokens, uint32_t maxTokens)
+{
+	if (textCharacterClass[' '] == 0)
+		initTextCharacterClasses();
 
-			uint32_t endOfDirectoryLocation[16] = { 0 };
-			HTREEITEM parentDirectoryDropdowns[16] = { 0 };
+	uint32_t tokenCount = 0;
+	uint32_t line = 1;
+	int depth = 0;
+	uint32_t i = 0;
 
-			TVINSERTSTRUCTW rootNode = { 0 };
-			rootNode.hParent = NULL;
-			rootNode.hInsertAfter = TVI_ROOT;
-			rootNode.item.mask = TVIF_TEXT;
-			rootNode.item.pszText = L"<root>";
+	while (i < size)
+	{
+		uint8_t c = text[i];
+		switch (textCharacterClass[c])
+		{
+		case 1://whitespace
+			line += c == '\n';
+			i++;
+			break;
+		case 2://comment
+		{
+			const char* lineEnd = memchr(text + i, '\n', size - i);
+			i = lineEnd ? (uint32_t)(lineEnd - text) : size;
+			break;
+		}
+		default:
+		{
+			uint32_t start = i;
+			while (i < size && textCharacterClass[(uint8_t)text[i]] == 0)
+				i++;
 
-			parentDirectoryDropdowns[0] = (HTREEITEM)SendMessageW(hTreeView, TVM_INSERTITEMW, 0, (LPARAM)&rootNode);
+			if (tokenCount == maxTokens)
+				return -1;
 
-			int x = 0;
+			struct textToken* token = &tokens[tokenCount++];
+			token->offset = start;
+			token->length = (uint16_t)min(i - start, 0xFFFF);
+			token->line = line;
+			token->asInt = 0;
+			token->type = classifyTextToken(text + start, i - start, token);
+
+			if (token->type == TEXT_TOKEN_CLOSE_BRACE && depth > 0)
+				depth--;
+			token->depth = (uint8_t)min(depth, 0xFF);
+			if (token->type == TEXT_TOKEN_OPEN_BRACE)
+				depth++;
+			break;
+		}
+		}
+	}
 
-			for (int i = 0; i < NumEntries; i++)
-			{
-				struct FileEntry* FE = FST + i;
+	return tokenCount;
+}
 
-				uint32_t FileNameOffset = (FE->FileNameOffsetp1 << 16) | (FE->FileNameOffsetp2 << 8) | FE->FileNameOffsetp3;
+static inline bool isTextNumber(const struct textToken* token)
+{
+	return token->type == TEXT_TOKEN_INTEGER || token->type == TEXT_TOKEN_FLOAT;
+}
 
-				if (i != 0)
-				{
-					if (FE->Flags == 1)//directories
-					{
-						deepness++;
-						endOfDirectoryLocation[deepness] = i;
-
-						wchar_t itemname[100];
-
-						MultiByteToWideChar(
-							CP_OEMCP,
-							0,
-							OffsetPointer(StringTable, FileNameOffset),
-							-1,
-							itemname,
-							100
-							);
+//integers that can be used as a count or an index
+static inline bool isTextCount(const struct textToken* token)
+{
+	return token->type == TEXT_TOKEN_INTEGER && token->asInt >= 0;
+}
 
-						rootNode.hParent = parentDirectoryDropdowns[deepness - 1];
-						rootNode.item.pszText = itemname;
+static inline float textTokenAsFloat(const struct textToken* token)
+{
+	return token->type == TEXT_TOKEN_FLOAT ? token->asFloat : (float)token->asInt;
+}
 
+static inline bool textTokenEquals(const struct parsedTextFile* file, uint32_t tokenIndex, const char* string)
+{
+	const struct textToken* token = &file->tokens[tokenIndex];
+	return strlen(string) == token->length && memcmp(file->source + token->offset, string, token->length) == 0;
+}
 
-						parentDirectoryDropdowns[deepness] = (HTREEITEM)SendMessageW(hTreeView, TVM_INSERTITEMW, 0, (LPARAM)&rootNode);
+static uint32_t addTextPosition(struct parsedTextFile* file, const struct textToken* xyz)
+{
+	file->positionX[file->positionCount] = textTokenAsFloat(&xyz[0]);
+	file->positionY[file->positionCount] = textTokenAsFloat(&xyz[1]);
+	file->positionZ[file->positionCount] = textTokenAsFloat(&xyz[2]);
+	return file->positionCount++;
+}
 
-					}
-					else//files
-					{
-						wchar_t itemname[100];
-
-						MultiByteToWideChar(
-							CP_OEMCP,
-							0,
-							OffsetPointer(StringTable, FileNameOffset),
-							-1,
-							itemname,
-							100
-						);
+//finds the closing brace of the block opened at openToken
+static uint32_t findTextBlockEnd(const struct parsedTextFile* file, uint32_t openToken)
+{
+	uint8_t depth = file->tokens[openToken].depth;
+	for (uint32_t i = openToken + 1; i < file->tokenCount; i++)
+		if (file->tokens[i].type == TEXT_TOKEN_CLOSE_BRACE && file->tokens[i].depth == depth)
+			return i;
+	return file->tokenCount;
+}
 
-						rootNode.hParent = parentDirectoryDropdowns[deepness];
-						rootNode.item.mask = TVIF_TEXT | TVIF_PARAM;
-						rootNode.item.pszText = itemname;
-						rootNode.item.lParam = (LPARAM)x;
+/*
+* route files are a waypoint count followed by, per waypoint:
+* index, link count, links..., x y z, radius
+* braces around waypoints are optional, so only numbers are read
+*/
+static void parseTextRoute(struct parsedTextFile* file)
+{
+	uint32_t numberCount = 0;
+	for (uint32_t i = 0; i < file->tokenCount; i++)
+		if (isTextNumber(&file->tokens[i]))
+			file->tokens[numberCount++ + file->tokenCount] = file->tokens[i];
+
+	const struct textToken* numbers = file->tokens + file->tokenCount;
+	if (numberCount == 0)
+		return;
+
+	uint32_t expectedWaypoints = isTextCount(&numbers[0]) ? numbers[0].asInt : 0;
+	uint32_t n = 1;
+	for (uint32_t w = 0; w < expectedWaypoints; w++)
+	{
+		//index, link count, then at least the position and radius
+		if (n + 6 > numberCount || !isTextCount(&numbers[n]) || !isTextCount(&numbers[n + 1]))
+			break;
 
-						gameFileList[x].treeItem = (HTREEITEM)SendMessageW(hTreeView, TVM_INSERTITEMW, 0, (LPARAM)&rootNode);
+		struct textWaypoint* waypoint = &file->waypoints[file->waypointCount];
+		waypoint->index = numbers[n++].asInt;
+		waypoint->linkCount = numbers[n++].asInt;
 
-						gameFileList[x].filePtr = OffsetPointer(GameImageAddress, SwapEndian(FE->FileOffset));
+		if (waypoint->linkCount > numberCount - n - 4)
+			break;
 
-						gameFileList[x].fileSize = SwapEndian(FE->Unknown);
+		bool linksValid = true;
+		for (uint32_t l = 0; l < waypoint->linkCount; l++)
+			linksValid &= isTextCount(&numbers[n + l]) && numbers[n + l].asInt <= UINT16_MAX;
+		if (!linksValid)
+			break;
 
-						x++;
+		waypoint->firstLink = file->linkCount;
+		for (uint32_t l = 0; l < waypoint->linkCount; l++)
+			file->links[file->linkCount++] = (uint16_t)numbers[n++].asInt;
 
-						while (i >= (SwapEndian((FST + endOfDirectoryLocation[deepness])->Unknown) - 1))
-						{
-							deepness--;
-						}
-					}
-				}
-			}
-		}
-		break;
+		waypoint->positionIndex = addTextPosition(file, &numbers[n]);
+		n += 3;
+		waypoint->radius = textTokenAsFloat(&numbers[n++]);
+		file->waypointCount++;
 	}
-	case WM_SIZE:
-	{
+}
+
+/*
+* generator and parameter files:
+* an object is the outermost block that contains a name and a line of 3 numbers (its position),
+* a parameter is a {xxxx} id followed by numbers on the same line
+*/
+static void parseTextObjects(struct parsedTextFile* file)
+{
+	const struct textToken* tokens = file->tokens;
+
+	for (uint32_t i = 0; i < file->tokenCount; i++)
+	{
+		if (tokens[i].type == TEXT_TOKEN_WORD && tokens[i].length > 2 && file->source[tokens[i].offset] == '{' && file->source[tokens[i].offset + tokens[i].length - 1] == '}')
+		{
+			uint32_t last = i;
+			while (last + 1 < file->tokenCount && tokens[last + 1].line == tokens[i].line && isTextNumber(&tokens[last + 1]))
+				last++;
+
+			if (last != i)
+			{
+				file->parameters[file->parameterCount].nameToken = i;
+				file->parameters[file->parameterCount].valueToken = last;
+				file->parameterCount++;
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < file->tokenCount; i++)
+	{
+		if (tokens[i].type != TEXT_TOKEN_OPEN_BRACE)
+			continue;
+
+		uint32_t end = findTextBlockEnd(file, i);
+
+		uint32_t nameToken = UINT32_MAX;
+		int32_t positionToken = -1;
+		for (uint32_t j = i + 1; j < end; j++)
+		{
+			if (nameToken == UINT32_MAX && tokens[j].type == TEXT_TOKEN_WORD && !(file->source[tokens[j].offset] == 'v' && tokens[j].length > 1 && file->source[tokens[j].offset + 1] >= '0' && file->source[tokens[j].offset + 1] <= '9'))
+				nameToken = j;
+
+			if (positionToken == -1 && j + 2 < end &&
+				isTextNumber(&tokens[j]) && isTextNumber(&tokens[j + 1]) && isTextNumber(&tokens[j + 2]) &&
+				tokens[j].line == tokens[j + 2].line && (j == 0 || tokens[j - 1].line != tokens[j].line))
+				positionToken = j;
+		}
+
+		if (nameToken == UINT32_MAX || positionToken == -1)
+			continue;
+
+		struct textObject* object = &file->objects[file->objectCount++];
+		object->nameToken = nameToken;
+		object->firstToken = i;
+		object->tokenCount = end - i + 1;
+		object->positionIndex = addTextPosition(file, &tokens[positionToken]);
+
+		//nested blocks belong to this object
+		i = end;
+	}
+}
+
+/*
+* parses a text file into workspace, all arrays in the result point into it.
+* returns false if the workspace is too small.
+*/
+bool parseTextFile(const char* _In_reads_(size) text, uint32_t size, const char* fileName, void* workspace, size_t workspaceSize, struct parsedTextFile* _Out_ result)
+{
+	memset(result, 0, sizeof(struct parsedTextFile));
+	result->source = text;
+	result->sourceSize = size;
+
+	//every token is at least one character followed by a separator
+	uint32_t maxTokens = size / 2 + 1;
+
+	//tokens (twice, the route parser uses the second half as scratch), objects, waypoints, links, parameters, positions
+	size_t required =
+		sizeof(struct textToken) * maxTokens * 2 +
+		sizeof(struct textObject) * maxTokens / 3 +
+		sizeof(struct textWaypoint) * maxTokens / 3 +
+		sizeof(uint16_t) * maxTokens +
+		sizeof(struct textParameter) * maxTokens / 2 +
+		sizeof(float) * 3 * (maxTokens / 3 + 1);
+	if (required > workspaceSize)
+		return false;
+
+	void* freeZone = workspace;
+	result->tokens = freeZone;
+	freeZone = OffsetPointer(freeZone, sizeof(struct textToken) * maxTokens * 2);
+	result->objects = freeZone;
+	freeZone = OffsetPointer(freeZone, sizeof(struct textObject) * (maxTokens / 3));
+	result->waypoints = freeZone;
+	freeZone = OffsetPointer(freeZone, sizeof(struct textWaypoint) * (maxTokens / 3));
+	result->parameters = freeZone;
+	freeZone = OffsetPointer(freeZone, sizeof(struct textParameter) * (maxTokens / 2));
+	result->positionX = freeZone;
+	freeZone = OffsetPointer(freeZone, sizeof(float) * (maxTokens / 3 + 1));
+	result->positionY = freeZone;
+	freeZone = OffsetPointer(freeZone, sizeof(float) * (maxTokens / 3 + 1));
+	result->positionZ = freeZone;
+	freeZone = OffsetPointer(freeZone, sizeof(float) * (maxTokens / 3 + 1));
+	result->links = freeZone;
+
+	int tokenCount = tokenizeTextFile(text, size, result->tokens, maxTokens);
+	if (tokenCount < 0)
+		return false;
+	result->tokenCount = tokenCount;
+
+	if (fileName != nullptr && _strnicmp(fileName, "route", 5) == 0)
+		parseTextRoute(result);
+	else
+		parseTextObjects(result);
+
+	return true;
+}
+
+//_snprintf_s returns -1 when _TRUNCATE cuts the output short, the buffer is full at that point
+static inline int addFormattedLength(int length, int written, int bufferSize)
+{
+	return written < 0 ? bufferSize - 1 : length + written;
+}
+
+//writes a readable listing of the records followed by the raw text, returns the number of characters written
+int formatParsedTextFile(const struct parsedTextFile* file, char* _Out_writes_(bufferSize) buffer, int bufferSize)
+{
+	int length = addFormattedLength(0, _snprintf_s(buffer, bufferSize, _TRUNCATE, "%u tokens, %u objects, %u waypoints, %u parameters\n\n",
+		file->tokenCount, file->objectCount, file->waypointCount, file->parameterCount), bufferSize);
+
+	for (uint32_t i = 0; i < file->objectCount && length < bufferSize - 1; i++)
+	{
+		const struct textObject* object = &file->objects[i];
+		const struct textToken* name = &file->tokens[object->nameToken];
+		length = addFormattedLength(length, _snprintf_s(buffer + length, bufferSize - length, _TRUNCATE, "%.*s (%.2f, %.2f, %.2f)\n",
+			name->length, file->source + name->offset,
+			file->positionX[object->positionIndex], file->positionY[object->positionIndex], file->positionZ[object->positionIndex]), bufferSize);
+	}
+
+	for (uint32_t i = 0; i < file->waypointCount && length < bufferSize - 1; i++)
+	{
+		const struct textWaypoint* waypoint = &file->waypoints[i];
+		length = addFormattedLength(length, _snprintf_s(buffer + length, bufferSize - length, _TRUNCATE, "waypoint %i (%.2f, %.2f, %.2f) r=%.2f ->",
+			waypoint->index, file->positionX[waypoint->positionIndex], file->positionY[waypoint->positionIndex], file->positionZ[waypoint->positionIndex], waypoint->radius), bufferSize);
+		for (uint32_t l = 0; l < waypoint->linkCount; l++)
+			length = addFormattedLength(length, _snprintf_s(buffer + length, bufferSize - length, _TRUNCATE, " %u", file->links[waypoint->firstLink + l]), bufferSize);
+		length = addFormattedLength(length, _snprintf_s(buffer + length, bufferSize - length, _TRUNCATE, "\n"), bufferSize);
+	}
+
+	for (uint32_t i = 0; i < file->parameterCount && length < bufferSize - 1; i++)
+	{
+		const struct textToken* name = &file->tokens[file->parameters[i].nameToken];
+		const struct textToken* value = &file->tokens[file->parameters[i].valueToken];
+		length = addFormattedLength(length, _snprintf_s(buffer + length, bufferSize - length, _TRUNCATE, "%.*s = %.*s\n",
+			name->length, file->source + name->offset, value->length, file->source + value->offset), bufferSize);
+	}
+
+	//the mapped file isn't null terminated, so it's copied
+	if (length < bufferSize - 2)
+	{
+		buffer[length++] = '\n';
+		int rawLength = min((int)file->sourceSize, bufferSize - length - 1);
+		memcpy(buffer + length, file->source, rawLength);
+		length += rawLength;
+	}
+	buffer[length] = '\0';
+
+	return length;
+}
+
+/*
+* BMG message files
+* a MESGbmg1 header followed by INF1 (one entry per message, starting with its offset into DAT1), DAT1 (the strings)
+* and usually MID1 (the message ids, in INF1 order).
+* escapes are a 0x1A code unit, the escape's length in bytes (including the 0x1A), a tag group, a 16 bit tag and parameters.
+* parsing only builds the id -> message index, the strings are decoded when they're read.
+*/
+#define BMG_ENCODING_CP1252 1
+#define BMG_ENCODING_UTF16 2
+#define BMG_ENCODING_SHIFT_JIS 3
+#define BMG_ENCODING_UTF8 4
+
+struct bmgHeader
+{
+	char magic[8];
+	uint32_t fileSize;
+	uint32_t sectionCount;
+	uint8_t encoding;
+	uint8_t padding[15];
+};
+
+struct bmgSection
+{
+	char type[4];
+	uint32_t size;
+};
+
+struct bmgINF1
+{
+	char type[4];
+	uint32_t size;
+	uint16_t entryCount;
+	uint16_t entrySize;
+	uint16_t groupId;
+	uint8_t defaultColor;
+	uint8_t padding;
+};
+
+struct bmgMID1
+{
+	char type[4];
+	uint32_t size;
+	uint16_t idCount;
+	uint8_t format;
+	uint8_t info;
+	uint32_t reserved;
+};
+
+struct bmgMessage
+{
+	uint32_t id;
+	uint32_t offset;//into strings
+	uint32_t index;//INF1 order, the attributes are at attributes + index * attributeSize
+};
+
+struct bmgFile
+{
+	const uint8_t* strings;
+	uint32_t stringsSize;
+	const uint8_t* attributes;
+	uint16_t attributeSize;
+	uint8_t encoding;
+	uint32_t messageCount;
+	struct bmgMessage* messages;//sorted by id
+};
+
+bool isBMGFile(const void* data, uint32_t size)
+{
+	return size >= sizeof(struct bmgHeader) && memcmp(data, "MESGbmg1", 8) == 0;
+}
+
+static int compareBMGMessages(const void* a, const void* b)
+{
+	const struct bmgMessage* messageA = a;
+	const struct bmgMessage* messageB = b;
+	if (messageA->id != messageB->id)
+		return messageA->id < messageB->id ? -1 : 1;
+	return messageA->index < messageB->index ? -1 : messageA->index > messageB->index ? 1 : 0;
+}
+
+/*
+* parses a bmg file, the message index goes into workspace and the strings stay in the file.
+* returns false if the file is malformed or the workspace is too small.
+*/
+bool parseBMGFile(const void* data, uint32_t size, void* workspace, size_t workspaceSize, struct bmgFile* _Out_ bmg)
+{
+	memset(bmg, 0, sizeof(struct bmgFile));
+	if (!isBMGFile(data, size))
+		return false;
+
+	const struct bmgHeader* header = data;
+	bmg->encoding = header->encoding;
+
+	const struct bmgINF1* info = nullptr;
+	const struct bmgMID1* ids = nullptr;
+	uint32_t offset = sizeof(struct bmgHeader);
+	for (uint32_t i = 0; i < SwapEndian(header->sectionCount) && offset + sizeof(struct bmgSection) <= size; i++)
+	{
+		const struct bmgSection* section = OffsetPointer(data, offset);
+		uint32_t sectionSize = SwapEndian(section->size);
+		if (sectionSize < sizeof(struct bmgSection) || sectionSize > size - offset)
+			return false;
+
+		if (memcmp(section->type, "INF1", 4) == 0 && sectionSize >= sizeof(struct bmgINF1))
+			info = (const struct bmgINF1*)section;
+		else if (memcmp(section->type, "DAT1", 4) == 0)
+		{
+			bmg->strings = OffsetPointer((const uint8_t*)section, sizeof(struct bmgSection));
+			bmg->stringsSize = sectionSize - sizeof(struct bmgSection);
+		}
+		else if (memcmp(section->type, "MID1", 4) == 0 && sectionSize >= sizeof(struct bmgMID1))
+			ids = (const struct bmgMID1*)section;
+
+		offset += sectionSize;
+	}
+
+	if (info == nullptr || bmg->strings == nullptr)
+		return false;
+
+	uint32_t entryCount = SwapEndian(info->entryCount);
+	uint32_t entrySize = SwapEndian(info->entrySize);
+	if (entrySize < 4 || sizeof(struct bmgINF1) + (size_t)entryCount * entrySize > SwapEndian(info->size))
+		return false;
+	if (ids != nullptr && (SwapEndian(ids->idCount) < entryCount || sizeof(struct bmgMID1) + (size_t)entryCount * 4 > SwapEndian(ids->size)))
+		ids = nullptr;
+
+	if (sizeof(struct bmgMessage) * entryCount > workspaceSize)
+		return false;
+
+	const uint8_t* entries = OffsetPointer((const uint8_t*)info, sizeof(struct bmgINF1));
+	const uint32_t* idTable = ids ? OffsetPointer((const uint32_t*)ids, sizeof(struct bmgMID1)) : nullptr;
+	bmg->attributes = entries + 4;
+	bmg->attributeSize = (uint16_t)(entrySize - 4);
+	bmg->messages = workspace;
+	bmg->messageCount = entryCount;
+
+	bool sorted = true;
+	for (uint32_t i = 0; i < entryCount; i++)
+	{
+		struct bmgMessage* message = &bmg->messages[i];
+		message->offset = SwapEndian(*(const uint32_t*)(entries + i * entrySize));
+		message->id = idTable ? SwapEndian(idTable[i]) : i;
+		message->index = i;
+		if (message->offset >= bmg->stringsSize)
+			message->offset = bmg->stringsSize;//reads as an empty string
+		sorted &= i == 0 || bmg->messages[i - 1].id <= message->id;
+	}
+
+	if (!sorted)
+		qsort(bmg->messages, entryCount, sizeof(struct bmgMessage), compareBMGMessages);
+
+	return true;
+}
+
+//binary search over the index, nullptr if the id isn't in the file
+const struct bmgMessage* findBMGMessage(const struct bmgFile* bmg, uint32_t id)
+{
+	uint32_t low = 0;
+	uint32_t high = bmg->messageCount;
+	while (low < high)
+	{
+		uint32_t middle = (low + high) / 2;
+		if (bmg->messages[middle].id < id)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low < bmg->messageCount && bmg->messages[low].id == id ? &bmg->messages[low] : nullptr;
+}
+
+/*
+* text conversion tables
+* shift-jis double byte characters are looked up by (lead, trail) in a table filled from code page 932 on first use,
+* ascii and half-width katakana are converted without it.
+*/
+#define SHIFT_JIS_TRAIL_COUNT (0xFD - 0x40)
+
+static uint16_t shiftJisTable[60 * SHIFT_JIS_TRAIL_COUNT];
+static volatile bool shiftJisTableReady = false;
+
+static const uint16_t cp1252Table[32] = {
+	0x20AC, 0xFFFD, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0xFFFD, 0x017D, 0xFFFD,
+	0xFFFD, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0xFFFD, 0x017E, 0x0178,
+};
+
+//lead bytes 0x81-0x9F and 0xE0-0xFC, -1 for anything else
+static inline int getShiftJisLeadIndex(uint8_t lead)
+{
+	if (lead >= 0x81 && lead <= 0x9F)
+		return lead - 0x81;
+	if (lead >= 0xE0 && lead <= 0xFC)
+		return lead - 0xE0 + 31;
+	return -1;
+}
+
+void initShiftJisTable()
+{
+	for (int lead = 0x81; lead <= 0xFC; lead++)
+	{
+		int leadIndex = getShiftJisLeadIndex((uint8_t)lead);
+		if (leadIndex < 0)
+			continue;
+
+		for (int trail = 0x40; trail <= 0xFC; trail++)
+		{
+			char pair[2] = { (char)lead, (char)trail };
+			wchar_t character = 0;
+			if (MultiByteToWideChar(932, MB_ERR_INVALID_CHARS, pair, 2, &character, 1) != 1)
+				character = 0xFFFD;
+			shiftJisTable[leadIndex * SHIFT_JIS_TRAIL_COUNT + trail - 0x40] = (uint16_t)character;
+		}
+	}
+	shiftJisTableReady = true;
+}
+
+//appends a code point as utf-8, returns false (and writes nothing) if it doesn't fit
+static inline bool appendUtf8(char* buffer, int bufferSize, int* length, uint32_t codePoint)
+{
+	uint8_t bytes[4];
+	int count;
+	if (codePoint < 0x80) { bytes[0] = (uint8_t)codePoint; count = 1; }
+	else if (codePoint < 0x800) { bytes[0] = (uint8_t)(0xC0 | codePoint >> 6); bytes[1] = (uint8_t)(0x80 | (codePoint & 0x3F)); count = 2; }
+	else if (codePoint < 0x10000) { bytes[0] = (uint8_t)(0xE0 | codePoint >> 12); bytes[1] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F)); bytes[2] = (uint8_t)(0x80 | (codePoint & 0x3F)); count = 3; }
+	else { bytes[0] = (uint8_t)(0xF0 | codePoint >> 18); bytes[1] = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3F)); bytes[2] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F)); bytes[3] = (uint8_t)(0x80 | (codePoint & 0x3F)); count = 4; }
+
+	if (*length + count >= bufferSize)
+		return false;
+	memcpy(buffer + *length, bytes, count);
+	*length += count;
+	return true;
+}
+
+/*
+* decodes a message to null terminated utf-8, escapes are written as {group.tag:parameters in hex}.
+* returns the number of bytes written, the message is cut off if the buffer is too small.
+*/
+int decodeBMGMessage(const struct bmgFile* bmg, const struct bmgMessage* message, char* _Out_writes_(bufferSize) buffer, int bufferSize)
+{
+	if (bmg->encoding == BMG_ENCODING_SHIFT_JIS && !shiftJisTableReady)
+		initShiftJisTable();
+
+	const uint8_t* text = bmg->strings + message->offset;
+	uint32_t available = bmg->stringsSize - message->offset;
+	uint32_t unitSize = bmg->encoding == BMG_ENCODING_UTF16 ? 2 : 1;
+	int length = 0;
+	uint32_t i = 0;
+
+	while (i + unitSize <= available)
+	{
+		uint32_t unit = unitSize == 2 ? (uint32_t)(text[i] << 8 | text[i + 1]) : text[i];
+		if (unit == 0)
+			break;
+
+		if (unit == 0x1A)
+		{
+			//length byte, group, 16 bit tag, parameters
+			if (i + unitSize + 4 > available)
+				break;
+			uint32_t escapeSize = text[i + unitSize];
+			uint32_t group = text[i + unitSize + 1];
+			uint32_t tag = text[i + unitSize + 2] << 8 | text[i + unitSize + 3];
+			if (escapeSize < unitSize + 4 || i + escapeSize > available)
+				break;
+
+			char escape[96];
+			int escapeLength = _snprintf_s(escape, sizeof(escape), _TRUNCATE, "{%u.%u", group, tag);
+			for (uint32_t p = i + unitSize + 4; p < i + escapeSize && escapeLength < sizeof(escape) - 4; p++)
+				escapeLength += _snprintf_s(escape + escapeLength, sizeof(escape) - escapeLength, _TRUNCATE, p == i + unitSize + 4 ? ":%02X" : "%02X", text[p]);
+			escape[escapeLength++] = '}';
+			if (length + escapeLength >= bufferSize)
+				break;
+			memcpy(buffer + length, escape, escapeLength);
+			length += escapeLength;
+
+			i += escapeSize;
+			continue;
+		}
+
+		//utf-8 is copied as is, only the escapes need handling
+		if (bmg->encoding == BMG_ENCODING_UTF8)
+		{
+			if (length + 1 >= bufferSize)
+				break;
+			buffer[length++] = (char)unit;
+			i++;
+			continue;
+		}
+
+		uint32_t codePoint;
+		uint32_t unitCount = 1;
+		switch (bmg->encoding)
+		{
+		case BMG_ENCODING_UTF16:
+			codePoint = unit;
+			if (unit >= 0xD800 && unit < 0xDC00 && i + 4 <= available)
+			{
+				uint32_t low = text[i + 2] << 8 | text[i + 3];
+				if (low >= 0xDC00 && low < 0xE000)
+				{
+					codePoint = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+					unitCount = 2;
+				}
+			}
+			break;
+		case BMG_ENCODING_SHIFT_JIS:
+		{
+			int leadIndex = getShiftJisLeadIndex((uint8_t)unit);
+			if (unit < 0x80)
+				codePoint = unit;
+			else if (unit >= 0xA1 && unit <= 0xDF)
+				codePoint = 0xFF61 + unit - 0xA1;
+			else if (leadIndex >= 0 && i + 1 < available && text[i + 1] >= 0x40 && text[i + 1] <= 0xFC)
+			{
+				codePoint = shiftJisTable[leadIndex * SHIFT_JIS_TRAIL_COUNT + text[i + 1] - 0x40];
+				unitCount = 2;
+			}
+			else
+				codePoint = 0xFFFD;
+			break;
+		}
+		default:
+			codePoint = (unit >= 0x80 && unit < 0xA0) ? cp1252Table[unit - 0x80] : unit;
+			break;
+		}
+
+		if (!appendUtf8(buffer, bufferSize, &length, codePoint))
+			break;
+		i += unitCount * unitSize;
+	}
+
+	if (bufferSize > 0)
+		buffer[min(length, bufferSize - 1)] = '\0';
+	return length;
+}
+
+const char* getBMGEncodingName(uint8_t encoding)
+{
+	switch (encoding)
+	{
+	case BMG_ENCODING_UTF16: return "utf-16";
+	case BMG_ENCODING_SHIFT_JIS: return "shift-jis";
+	case BMG_ENCODING_UTF8: return "utf-8";
+	default: return "cp1252";
+	}
+}
+
+//writes every message as "id: text" in id order, returns the number of characters written
+int formatBMGFile(const struct bmgFile* bmg, char* _Out_writes_(bufferSize) buffer, int bufferSize)
+{
+	int length = _snprintf_s(buffer, bufferSize, _TRUNCATE, "%u messages, %s\n\n", bmg->messageCount, getBMGEncodingName(bmg->encoding));
+
+	for (uint32_t i = 0; i < bmg->messageCount && length < bufferSize - 16; i++)
+	{
+		length += _snprintf_s(buffer + length, bufferSize - length, _TRUNCATE, "%u: ", bmg->messages[i].id);
+		length += decodeBMGMessage(bmg, &bmg->messages[i], buffer + length, bufferSize - length - 1);
+		buffer[length++] = '\n';
+	}
+	buffer[min(length, bufferSize - 1)] = '\0';
+
+	return length;
+}
+
+/*
+* GameCube audio
+* DSP-ADPCM (.dsp): 8 byte frames of 14 samples. the frame header's high nibble picks one of the 8 coefficient pairs
+* stored in the file header and the low nibble is the scale, as a power of two.
+* AFC (.ast streams and JAudio wave banks): 9 byte frames of 16 samples, the header nibbles are the other way around
+* and the 16 coefficient pairs are a fixed table.
+* both predict every sample from the previous two: (nibble * scale << 11 + coef1 * hist1 + coef2 * hist2) >> 11, clamped to 16 bits
+*/
+#define AUDIO_CODEC_DSP 0
+#define AUDIO_CODEC_AFC 1
+#define AUDIO_CODEC_PCM16 2//big endian
+#define AUDIO_CODEC_PCM8 3
+
+#define AUDIO_AST 0
+#define AUDIO_DSP 1
+#define AUDIO_WAVE 2
+
+//coef1 in the low half and coef2 in the high half, the layout _mm_madd_epi16 needs against (hist1, hist2)
+#define PACK_ADPCM_COEFFICIENTS(coef1, coef2) ((int32_t)((uint32_t)(uint16_t)(coef1) | ((uint32_t)(uint16_t)(coef2) << 16)))
+
+static const int32_t afcCoefficients[16] = {
+	PACK_ADPCM_COEFFICIENTS(0, 0),
+	PACK_ADPCM_COEFFICIENTS(2048, 0),
+	PACK_ADPCM_COEFFICIENTS(0, 2048),
+	PACK_ADPCM_COEFFICIENTS(1024, 1024),
+	PACK_ADPCM_COEFFICIENTS(4096, -2048),
+	PACK_ADPCM_COEFFICIENTS(3584, -1536),
+	PACK_ADPCM_COEFFICIENTS(3072, -1024),
+	PACK_ADPCM_COEFFICIENTS(4608, -2560),
+	PACK_ADPCM_COEFFICIENTS(4200, -2248),
+	PACK_ADPCM_COEFFICIENTS(4800, -2300),
+	PACK_ADPCM_COEFFICIENTS(5120, -3072),
+	PACK_ADPCM_COEFFICIENTS(2048, -2048),
+	PACK_ADPCM_COEFFICIENTS(1024, -1024),
+	PACK_ADPCM_COEFFICIENTS(-1024, 1024),
+	PACK_ADPCM_COEFFICIENTS(-1024, 0),
+	PACK_ADPCM_COEFFICIENTS(-2048, 0),
+};
+
+struct adpcmChannel
+{
+	const uint8_t* data;//next frame
+	const int32_t* coefficients;//packed pairs, indexed by the frame header
+	int16_t history1;
+	int16_t history2;
+};
+
+/*
+* decodes frameCount whole frames of up to 4 channels at once, each channel is an SSE lane.
+* the residuals of a frame don't depend on earlier samples so they're expanded first, the prediction then runs over all
+* lanes with one madd per sample. samples are written interleaved, sampleStride int16s apart
+*/
+void decodeADPCMFrames(uint32_t codec, struct adpcmChannel* channels, uint32_t channelCount, uint32_t frameCount, int16_t* _Out_ samples, uint32_t sampleStride)
+{
+	const uint32_t frameSize = codec == AUDIO_CODEC_DSP ? 8 : 9;
+	const uint32_t samplesPerFrame = codec == AUDIO_CODEC_DSP ? 14 : 16;
+	const __m128i rounding = _mm_set1_epi32(codec == AUDIO_CODEC_DSP ? 1024 : 0);
+	const __m128i zero = _mm_setzero_si128();
+
+	alignas(16) int32_t history[4] = { 0 };
+	alignas(16) int32_t coefficients[4] = { 0 };
+	alignas(16) int32_t residuals[16][4] = { 0 };
+	for (uint32_t c = 0; c < channelCount; c++)
+		history[c] = PACK_ADPCM_COEFFICIENTS(channels[c].history1, channels[c].history2);
+	__m128i historyLanes = _mm_load_si128((const __m128i*)history);
+
+	for (uint32_t frame = 0; frame < frameCount; frame++)
+	{
+		for (uint32_t c = 0; c < channelCount; c++)
+		{
+			const uint8_t* data = channels[c].data;
+			uint32_t predictor = codec == AUDIO_CODEC_DSP ? (data[0] >> 4) & 7 : data[0] & 0xF;
+			int32_t scale = (1 << (codec == AUDIO_CODEC_DSP ? data[0] & 0xF : data[0] >> 4)) * 2048;
+			coefficients[c] = channels[c].coefficients[predictor];
+			for (uint32_t i = 0; i < samplesPerFrame; i += 2)
+			{
+				residuals[i][c] = ((int8_t)data[1 + i / 2] >> 4) * scale;
+				residuals[i + 1][c] = ((int8_t)(data[1 + i / 2] << 4) >> 4) * scale;
+			}
+			channels[c].data += frameSize;
+		}
+
+		const __m128i coefficientLanes = _mm_load_si128((const __m128i*)coefficients);
+		for (uint32_t i = 0; i < samplesPerFrame; i++)
+		{
+			__m128i prediction = _mm_madd_epi16(historyLanes, coefficientLanes);
+			__m128i sample = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_load_si128((const __m128i*)residuals[i]), prediction), rounding), 11);
+			__m128i clamped = _mm_packs_epi32(sample, sample);
+
+			//hist2 = hist1, hist1 = sample
+			historyLanes = _mm_or_si128(_mm_slli_epi32(historyLanes, 16), _mm_unpacklo_epi16(clamped, zero));
+
+			alignas(16) int16_t laneSamples[8];
+			_mm_storel_epi64((__m128i*)laneSamples, clamped);
+			memcpy(samples, laneSamples, channelCount * sizeof(int16_t));
+			samples += sampleStride;
+		}
+	}
+
+	_mm_store_si128((__m128i*)history, historyLanes);
+	for (uint32_t c = 0; c < channelCount; c++)
+	{
+		channels[c].history1 = (int16_t)history[c];
+		channels[c].history2 = (int16_t)(history[c] >> 16);
+	}
+}
+
+/*
+* a decodable stream, loaded by loadASTStream/loadDSPStream/loadWSYSWave and decoded by decodeAudioStream
+*/
+struct audioStream
+{
+	uint32_t container;//AUDIO_AST, AUDIO_DSP or AUDIO_WAVE
+	uint32_t codec;//AUDIO_CODEC_*
+	const uint8_t* data;//the first frame, or the first block header of an AST
+	size_t dataSize;
+	uint32_t channelCount;
+	uint32_t sampleRate;
+	uint32_t sampleCount;//per channel
+	bool looping;
+	uint32_t loopStart;
+	uint32_t loopEnd;
+	int32_t coefficients[8];//DSP only, packed
+	int16_t history1;
+	int16_t history2;
+};
+
+//bytes of input sampleCount samples per channel take, headers that claim more samples than the file holds are rejected with it
+static uint64_t getEncodedAudioSize(uint32_t codec, uint32_t channelCount, uint32_t sampleCount)
+{
+	uint64_t channelSize;
+	switch (codec)
+	{
+	case AUDIO_CODEC_DSP:
+		channelSize = ((uint64_t)sampleCount + 13) / 14 * 8;
+		break;
+	case AUDIO_CODEC_AFC:
+		channelSize = ((uint64_t)sampleCount + 15) / 16 * 9;
+		break;
+	case AUDIO_CODEC_PCM16:
+		channelSize = (uint64_t)sampleCount * 2;
+		break;
+	default:
+		channelSize = sampleCount;
+		break;
+	}
+	return channelSize * channelCount;
+}
+
+/*
+* AST: a header, then blocks of every channel's data one after the other. the decoder state carries over between blocks
+*/
+struct astHeader
+{
+	char magic[4];//STRM
+	uint32_t dataSize;
+	uint16_t format;//0 AFC, 1 PCM16
+	uint16_t bitsPerSample;
+	uint16_t channelCount;
+	uint16_t loopFlag;//0xFFFF if the stream loops
+	uint32_t sampleRate;
+	uint32_t sampleCount;
+	uint32_t loopStart;
+	uint32_t loopEnd;
+	uint32_t firstBlockSize;
+	uint8_t padding[0x1C];
+};
+
+struct astBlockHeader
+{
+	char magic[4];//BLCK
+	uint32_t size;//per channel
+	uint8_t padding[0x18];
+};
+
+bool loadASTStream(const void* data, size_t size, struct audioStream* _Out_ stream)
+{
+	memset(stream, 0, sizeof(struct audioStream));
+	const struct astHeader* header = data;
+	if (size < sizeof(struct astHeader) || memcmp(header->magic, "STRM", 4) != 0)
+		return false;
+
+	uint16_t format = SwapEndian(header->format);
+	stream->container = AUDIO_AST;
+	stream->codec = format == 0 ? AUDIO_CODEC_AFC : AUDIO_CODEC_PCM16;
+	stream->data = OffsetPointer((const uint8_t*)data, sizeof(struct astHeader));
+	stream->dataSize = size - sizeof(struct astHeader);
+	stream->channelCount = SwapEndian(header->channelCount);
+	stream->sampleRate = SwapEndian(header->sampleRate);
+	stream->sampleCount = SwapEndian(header->sampleCount);
+	stream->looping = SwapEndian(header->loopFlag) == 0xFFFF;
+	stream->loopStart = SwapEndian(header->loopStart);
+	stream->loopEnd = SwapEndian(header->loopEnd);
+	return format <= 1 && stream->channelCount != 0 && stream->channelCount <= 16 &&
+		getEncodedAudioSize(stream->codec, stream->channelCount, stream->sampleCount) <= stream->dataSize;
+}
+
+/*
+* the standard 0x60 byte DSP-ADPCM header of a mono .dsp file
+*/
+struct dspHeader
+{
+	uint32_t sampleCount;
+	uint32_t nibbleCount;
+	uint32_t sampleRate;
+	uint16_t loopFlag;
+	uint16_t format;//always 0
+	uint32_t loopStartNibble;
+	uint32_t loopEndNibble;
+	uint32_t currentAddress;
+	int16_t coefficients[16];
+	uint16_t gain;
+	uint16_t predictorScale;
+	int16_t history1;
+	int16_t history2;
+	uint16_t loopPredictorScale;
+	int16_t loopHistory1;
+	int16_t loopHistory2;
+	uint16_t padding[11];
+};
+
+//nibble addresses count the frame headers too, 16 nibbles per 14 samples
+static inline uint32_t getDSPSampleFromNibble(uint32_t nibble)
+{
+	return nibble / 16 * 14 + max(nibble % 16, 2) - 2;
+}
+
+bool loadDSPStream(const void* data, size_t size, struct audioStream* _Out_ stream)
+{
+	memset(stream, 0, sizeof(struct audioStream));
+	const struct dspHeader* header = data;
+	if (size < sizeof(struct dspHeader) || header->format != 0)
+		return false;
+
+	stream->container = AUDIO_DSP;
+	stream->codec = AUDIO_CODEC_DSP;
+	stream->data = OffsetPointer((const uint8_t*)data, sizeof(struct dspHeader));
+	stream->dataSize = size - sizeof(struct dspHeader);
+	stream->channelCount = 1;
+	stream->sampleRate = SwapEndian(header->sampleRate);
+	stream->sampleCount = SwapEndian(header->sampleCount);
+	stream->looping = header->loopFlag != 0;
+	stream->loopStart = getDSPSampleFromNibble(SwapEndian(header->loopStartNibble));
+	stream->loopEnd = getDSPSampleFromNibble(SwapEndian(header->loopEndNibble));
+	for (int i = 0; i < 8; i++)
+		stream->coefficients[i] = PACK_ADPCM_COEFFICIENTS(SwapEndian(header->coefficients[i * 2]), SwapEndian(header->coefficients[i * 2 + 1]));
+	stream->history1 = SwapEndian(header->history1);
+	stream->history2 = SwapEndian(header->history2);
+
+	//the first frame header is repeated in the file header, which is what tells a .dsp from other data
+	return stream->sampleCount != 0 && stream->dataSize != 0 && SwapEndian(header->predictorScale) == stream->data[0] &&
+		getEncodedAudioSize(stream->codec, 1, stream->sampleCount) <= stream->dataSize;
+}
+
+/*
+* JAudio wave banks: the .baa (or .aaf) bank file holds WSYS chunks describing waves, the samples are in .aw files that
+* are nothing but the waves back to back. all WSYS offsets are relative to the WSYS chunk
+*/
+#define WAVE_FORMAT_AFC 0
+#define WAVE_FORMAT_AFC_2BIT 1
+#define WAVE_FORMAT_PCM8 2
+#define WAVE_FORMAT_PCM16 3
+
+struct wsysHeader
+{
+	char magic[4];//WSYS
+	uint32_t size;
+	uint32_t id;
+	uint32_t unknown;
+	uint32_t waveInfoOffset;//WINF
+	uint32_t waveTableOffset;//WBCT
+};
+
+struct wsysWaveInfo
+{
+	char magic[4];//WINF
+	uint32_t groupCount;
+	uint32_t groupOffsets[];
+};
+
+struct wsysWaveGroup
+{
+	char archiveName[0x70];//the .aw file
+	uint32_t waveCount;
+	uint32_t waveOffsets[];
+};
+
+struct wsysWave
+{
+	uint8_t unknown;
+	uint8_t format;//WAVE_FORMAT_*
+	uint8_t baseKey;
+	uint8_t unknown2;
+	uint32_t sampleRate;//float
+	uint32_t offset;//into the .aw file
+	uint32_t size;
+	uint32_t loopFlag;//0xFFFFFFFF if the wave loops
+	uint32_t loopStart;
+	uint32_t loopEnd;
+	uint32_t sampleCount;
+};
+
+//the next WSYS chunk at or after *offset in a bank file. the chunks are found by their magic, which works for .baa and .aaf alike
+const struct wsysHeader* findWSYSChunk(const void* bank, size_t bankSize, size_t* offset)
+{
+	for (size_t i = (*offset + 3) & ~(size_t)3; i + sizeof(struct wsysHeader) <= bankSize; i += 4)
+	{
+		const struct wsysHeader* wsys = OffsetPointer(bank, i);
+		uint32_t size = SwapEndian(wsys->size);
+		if (memcmp(wsys->magic, "WSYS", 4) != 0 || size < sizeof(struct wsysHeader) || size > bankSize - i)
+			continue;
+		if (SwapEndian(wsys->waveInfoOffset) > size - sizeof(struct wsysWaveInfo))
+			continue;
+		*offset = i + size;
+		return wsys;
+	}
+	*offset = bankSize;
+	return nullptr;
+}
+
+//a wave group of a WSYS chunk, nullptr if it's out of bounds
+const struct wsysWaveGroup* getWSYSWaveGroup(const struct wsysHeader* wsys, uint32_t groupIndex)
+{
+	uint32_t size = SwapEndian(wsys->size);
+	const struct wsysWaveInfo* info = OffsetPointer(wsys, SwapEndian(wsys->waveInfoOffset));
+	if (memcmp(info->magic, "WINF", 4) != 0 || groupIndex >= SwapEndian(info->groupCount) ||
+		SwapEndian(wsys->waveInfoOffset) + sizeof(struct wsysWaveInfo) + (groupIndex + 1) * sizeof(uint32_t) > size)
+		return nullptr;
+
+	uint32_t groupOffset = SwapEndian(info->groupOffsets[groupIndex]);
+	if (groupOffset > size - sizeof(struct wsysWaveGroup))
+		return nullptr;
+	const struct wsysWaveGroup* group = OffsetPointer(wsys, groupOffset);
+	if (groupOffset + sizeof(struct wsysWaveGroup) + (size_t)SwapEndian(group->waveCount) * sizeof(uint32_t) > size)
+		return nullptr;
+	return group;
+}
+
+const struct wsysWave* getWSYSWave(const struct wsysHeader* wsys, const struct wsysWaveGroup* group, uint32_t waveIndex)
+{
+	uint32_t waveOffset = SwapEndian(group->waveOffsets[waveIndex]);
+	if (waveOffset > SwapEndian(wsys->size) - sizeof(struct wsysWave))
+		return nullptr;
+	return OffsetPointer(wsys, waveOffset);
+}
+
+bool loadWSYSWave(const struct wsysWave* wave, const void* archive, size_t archiveSize, struct audioStream* _Out_ stream)
+{
+	memset(stream, 0, sizeof(struct audioStream));
+	static const uint32_t codecs[] = { AUDIO_CODEC_AFC, 0, AUDIO_CODEC_PCM8, AUDIO_CODEC_PCM16 };
+	uint32_t offset = SwapEndian(wave->offset);
+	uint32_t size = SwapEndian(wave->size);
+	//2 bit AFC isn't decoded
+	if (wave->format >= countof(codecs) || wave->format == WAVE_FORMAT_AFC_2BIT || offset > archiveSize || size > archiveSize - offset)
+		return false;
+
+	stream->container = AUDIO_WAVE;
+	stream->codec = codecs[wave->format];
+	stream->data = OffsetPointer((const uint8_t*)archive, offset);
+	stream->dataSize = size;
+	stream->channelCount = 1;
+	stream->sampleRate = (uint32_t)IntAsFloat(SwapEndian(wave->sampleRate));
+	stream->sampleCount = SwapEndian(wave->sampleCount);
+	stream->looping = SwapEndian(wave->loopFlag) == 0xFFFFFFFF;
+	stream->loopStart = SwapEndian(wave->loopStart);
+	stream->loopEnd = SwapEndian(wave->loopEnd);
+	return getEncodedAudioSize(stream->codec, 1, stream->sampleCount) <= stream->dataSize;
+}
+
+//bytes of interleaved 16 bit samples decodeAudioStream may write, the last frame is decoded whole
+size_t getDecodedAudioSize(const struct audioStream* stream)
+{
+	return ((size_t)stream->sampleCount + 16 * 2) / 16 * 16 * stream->channelCount * sizeof(int16_t);
+}
+
+//decodes up to maxSamples samples per channel of one block of channel data, returns how many it decoded
+static uint32_t decodeAudioBlock(const struct audioStream* stream, const uint8_t* data, size_t channelDataSize, struct adpcmChannel* channels, int16_t* _Out_ samples, uint32_t maxSamples)
+{
+	uint32_t channelCount = stream->channelCount;
+	switch (stream->codec)
+	{
+	case AUDIO_CODEC_DSP:
+	case AUDIO_CODEC_AFC:
+	{
+		uint32_t frameSize = stream->codec == AUDIO_CODEC_DSP ? 8 : 9;
+		uint32_t samplesPerFrame = stream->codec == AUDIO_CODEC_DSP ? 14 : 16;
+		uint32_t frameCount = min((uint32_t)(channelDataSize / frameSize), maxSamples / samplesPerFrame);
+		for (uint32_t c = 0; c < channelCount; c++)
+			channels[c].data = data + c * channelDataSize;
+		for (uint32_t c = 0; c < channelCount; c += 4)
+			decodeADPCMFrames(stream->codec, &channels[c], min(channelCount - c, 4), frameCount, samples + c, channelCount);
+		return frameCount * samplesPerFrame;
+	}
+	case AUDIO_CODEC_PCM16:
+	{
+		uint32_t sampleCount = min((uint32_t)(channelDataSize / 2), maxSamples);
+		for (uint32_t c = 0; c < channelCount; c++)
+		{
+			const uint16_t* channelData = OffsetPointer((const uint16_t*)data, c * channelDataSize);
+			for (uint32_t i = 0; i < sampleCount; i++)
+				samples[i * channelCount + c] = (int16_t)SwapEndian(channelData[i]);
+		}
+		return sampleCount;
+	}
+	default:
+	{
+		uint32_t sampleCount = min((uint32_t)channelDataSize, maxSamples);
+		for (uint32_t c = 0; c < channelCount; c++)
+			for (uint32_t i = 0; i < sampleCount; i++)
+				samples[i * channelCount + c] = (int16_t)(((int8_t)data[c * channelDataSize + i]) * 256);
+		return sampleCount;
+	}
+	}
+}
+
+//decodes the whole stream to interleaved 16 bit samples (getDecodedAudioSize bytes), returns the samples per channel
+uint32_t decodeAudioStream(const struct audioStream* stream, int16_t* _Out_ samples)
+{
+	uint32_t maxSamples = (uint32_t)(getDecodedAudioSize(stream) / sizeof(int16_t) / stream->channelCount);
+	struct adpcmChannel channels[16];
+	for (uint32_t c = 0; c < stream->channelCount; c++)
+	{
+		channels[c].coefficients = stream->codec == AUDIO_CODEC_DSP ? stream->coefficients : afcCoefficients;
+		channels[c].history1 = stream->history1;
+		channels[c].history2 = stream->history2;
+	}
+
+	uint32_t decoded = 0;
+	if (stream->container == AUDIO_AST)
+	{
+		size_t offset = 0;
+		while (offset + sizeof(struct astBlockHeader) <= stream->dataSize && decoded < stream->sampleCount)
+		{
+			const struct astBlockHeader* block = OffsetPointer(stream->data, offset);
+			size_t channelDataSize = SwapEndian(block->size);
+			if (memcmp(block->magic, "BLCK", 4) != 0 || channelDataSize * stream->channelCount > stream->dataSize - offset - sizeof(struct astBlockHeader))
+				break;
+
+			decoded += decodeAudioBlock(stream, OffsetPointer((const uint8_t*)block, sizeof(struct astBlockHeader)), channelDataSize, channels, samples + (size_t)decoded * stream->channelCount, maxSamples - decoded);
+			offset += sizeof(struct astBlockHeader) + channelDataSize * stream->channelCount;
+		}
+	}
+	else
+	{
+		decoded = decodeAudioBlock(stream, stream->data, stream->dataSize, channels, samples, maxSamples);
+	}
+
+	return min(decoded, stream->sampleCount);
+}
+
+//the 44 byte header of a 16 bit pcm .wav
+void getWAVHeader(uint32_t channelCount, uint32_t sampleRate, uint32_t sampleCount, uint8_t header[44])
+{
+	uint32_t dataSize = sampleCount * channelCount * sizeof(int16_t);
+	uint32_t fields[11] = {
+		0x46464952,//RIFF
+		36 + dataSize,
+		0x45564157,//WAVE
+		0x20746D66,//fmt
+		16,
+		1 | (channelCount << 16),//pcm
+		sampleRate,
+		sampleRate * channelCount * sizeof(int16_t),
+		(channelCount * sizeof(int16_t)) | (16 << 16),
+		0x61746164,//data
+		dataSize,
+	};
+	memcpy(header, fields, sizeof(fields));
+}
+
+struct yaz0Header
+{
+	char magic[4];
+	uint32_t uncompressedSize;
+	uint32_t reserved1;
+	uint32_t reserved2;
+};
+
+bool isYaz0(const void* data, uint32_t size)
+{
+	return size >= sizeof(struct yaz0Header) && memcmp(data, "Yaz0", 4) == 0;
+}
+
+uint32_t getYaz0UncompressedSize(const void* data)
+{
+	return SwapEndian(((const struct yaz0Header*)data)->uncompressedSize);
+}
+
+//dest must hold getYaz0UncompressedSize() bytes
+int decompressYaz0File(const void* data, uint32_t size, void* dest)
+{
+	return DecompressYAZ(
+		OffsetPointer(data, sizeof(struct yaz0Header)),
+		size - sizeof(struct yaz0Header),
+		dest,
+		getYaz0UncompressedSize(data),
+		nullptr,
+		0,
+		true
+	);
+}
+
+/*
+* yaz0 compressor: greedy matching over hash chains of 3 byte sequences inside the 4K window.
+* DecompressYAZ reads the result back byte for byte, the game does too
+*/
+#define YAZ0_WINDOW_SIZE 4096
+#define YAZ0_MAX_MATCH 0x111
+#define YAZ0_HASH_BITS 15
+#define YAZ0_CHAIN_DEPTH 32
+
+//worst case: every byte a literal, plus a group byte per 8
+size_t getYaz0Bound(uint32_t size)
+{
+	return sizeof(struct yaz0Header) + size + (size + 7) / 8;
+}
+
+static inline uint32_t hashYaz0Sequence(const uint8_t* bytes)
+{
+	return ((bytes[0] << 16 | bytes[1] << 8 | bytes[2]) * 2654435761u) >> (32 - YAZ0_HASH_BITS);
+}
+
+//hashTable holds 1 << YAZ0_HASH_BITS entries, chain holds YAZ0_WINDOW_SIZE. returns the file size including the header
+size_t encodeYaz0(const uint8_t* _In_ in, uint32_t size, uint32_t* hashTable, uint32_t* chain, uint8_t* _Out_ out)
+{
+	struct yaz0Header* header = (struct yaz0Header*)out;
+	memcpy(header->magic, "Yaz0", 4);
+	header->uncompressedSize = SwapEndian(size);
+	header->reserved1 = 0;
+	header->reserved2 = 0;
+
+	memset(hashTable, 0, sizeof(uint32_t) << YAZ0_HASH_BITS);
+
+	uint8_t* o = out + sizeof(struct yaz0Header);
+	uint8_t* groupByte = nullptr;
+	uint32_t groupBit = 8;
+	uint32_t i = 0;
+	while (i < size)
+	{
+		if (groupBit == 8)
+		{
+			groupByte = o++;
+			*groupByte = 0;
+			groupBit = 0;
+		}
+
+		//positions are stored + 1 so 0 means empty
+		uint32_t bestLength = 0;
+		uint32_t bestDistance = 0;
+		if (i + 3 <= size)
+		{
+			uint32_t maxLength = min(size - i, YAZ0_MAX_MATCH);
+			uint32_t candidate = hashTable[hashYaz0Sequence(in + i)];
+			for (int depth = 0; depth < YAZ0_CHAIN_DEPTH && candidate != 0 && i + 1 - candidate <= YAZ0_WINDOW_SIZE; depth++)
+			{
+				uint32_t position = candidate - 1;
+				if (in[position + bestLength] == in[i + bestLength])
+				{
+					uint32_t length = 0;
+					while (length < maxLength && in[position + length] == in[i + length])
+						length++;
+					if (length > bestLength)
+					{
+						bestLength = length;
+						bestDistance = i - position;
+						if (length == maxLength)
+							break;
+					}
+				}
+				candidate = chain[position & (YAZ0_WINDOW_SIZE - 1)];
+			}
+		}
+
+		uint32_t advance = bestLength >= 3 ? bestLength : 1;
+		if (bestLength >= 3)
+		{
+			uint32_t distance = bestDistance - 1;
+			if (bestLength < 0x12)
+			{
+				*o++ = (uint8_t)((bestLength - 2) << 4 | distance >> 8);
+				*o++ = (uint8_t)distance;
+			}
+			else
+			{
+				*o++ = (uint8_t)(distance >> 8);
+				*o++ = (uint8_t)distance;
+				*o++ = (uint8_t)(bestLength - 0x12);
+			}
+		}
+		else
+		{
+			*groupByte |= 0x80 >> groupBit;
+			*o++ = in[i];
+		}
+		groupBit++;
+
+		//every position goes into the chains, including the ones a match skips
+		for (uint32_t end = i + advance; i < end; i++)
+		{
+			if (i + 3 > size)
+				continue;
+			uint32_t hash = hashYaz0Sequence(in + i);
+			chain[i & (YAZ0_WINDOW_SIZE - 1)] = hashTable[hash];
+			hashTable[hash] = i + 1;
+		}
+	}
+	return o - out;
+}
+
+/*
+* runs job(jobIndex, threadIndex, context) for every job index on all cores.
+* jobs are handed out one at a time, so uneven job sizes balance themselves.
+*/
+typedef void (*parallelJob)(int jobIndex, int threadIndex, void* context);
+
+#define MAX_THREADS 64
+
+struct parallelJobList
+{
+	parallelJob job;
+	void* context;
+	int jobCount;
+	volatile LONG nextJob;
+};
+
+struct parallelWorker
+{
+	struct parallelJobList* jobList;
+	int threadIndex;
+};
+
+int getThreadCount()
+{
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	return min(max((int)systemInfo.dwNumberOfProcessors, 1), MAX_THREADS);
+}
+
+DWORD WINAPI parallelWorkerProcedure(LPVOID parameter)
+{
+	const struct parallelWorker* worker = parameter;
+	struct parallelJobList* jobList = worker->jobList;
+
+	for (;;)
+	{
+		int jobIndex = InterlockedIncrement(&jobList->nextJob) - 1;
+		if (jobIndex >= jobList->jobCount)
+			break;
+		TRACE_BEGIN(jobSpan);
+		jobList->job(jobIndex, worker->threadIndex, jobList->context);
+		TRACE_END(jobSpan, "parallel job");
+	}
+
+	//worker 0 is the calling thread, which keeps its ring
+	if (worker->threadIndex != 0)
+		releaseTraceRing();
+	return 0;
+}
+
+void runParallel(int jobCount, parallelJob job, void* context)
+{
+	struct parallelJobList jobList = { job, context, jobCount, 0 };
+
+	int threadCount = min(getThreadCount(), max(jobCount, 1));
+	struct parallelWorker workers[MAX_THREADS];
+	HANDLE threads[MAX_THREADS];
+
+	//the calling thread is worker 0
+	for (int i = 1; i < threadCount; i++)
+	{
+		workers[i].jobList = &jobList;
+		workers[i].threadIndex = i;
+		threads[i] = CreateThread(nullptr, 0, parallelWorkerProcedure, &workers[i], 0, nullptr);
+		VALIDATE_HANDLE(threads[i]);
+	}
+
+	workers[0].jobList = &jobList;
+	workers[0].threadIndex = 0;
+	parallelWorkerProcedure(&workers[0]);
+
+	if (threadCount > 1)
+	{
+		WaitForMultipleObjects(threadCount - 1, threads + 1, TRUE, INFINITE);
+		for (int i = 1; i < threadCount; i++)
+			CloseHandle(threads[i]);
+	}
+}
+
+/*
+* RARC archives (the contents of most .szs files)
+* all offsets in the info block are relative to the end of the 0x20 byte header
+*/
+struct rarcHeader
+{
+	char magic[4];
+	uint32_t fileSize;
+	uint32_t headerSize;
+	uint32_t fileDataOffset;
+	uint32_t fileDataLength;
+	uint32_t unknown[3];
+};
+
+struct rarcInfo
+{
+	uint32_t nodeCount;
+	uint32_t nodeOffset;
+	uint32_t fileEntryCount;
+	uint32_t fileEntryOffset;
+	uint32_t stringTableSize;
+	uint32_t stringTableOffset;
+	uint16_t fileCount;
+	uint8_t syncFileIds;
+	uint8_t padding[5];
+};
+
+struct rarcFileEntry
+{
+	uint16_t id;
+	uint16_t nameHash;
+	uint8_t flags;//0x01: file, 0x02: directory
+	uint8_t padding1;
+	uint16_t nameOffset;
+	uint32_t dataOffset;
+	uint32_t dataSize;
+	uint32_t padding2;
+};
+
+struct archiveMember
+{
+	const char* name;
+	const void* data;
+	uint32_t size;
+};
+
+bool isRarc(const void* data, uint32_t size)
+{
+	return size >= sizeof(struct rarcHeader) + sizeof(struct rarcInfo) && memcmp(data, "RARC", 4) == 0;
+}
+
+/*
+* fills members with the files in the archive (directories are skipped), returns the member count.
+* the entry table is checked against the archive once, then each member only needs its name terminated and its data
+* inside the file data, members that aren't are left out
+*/
+int listRarcMembers(const void* archive, uint32_t archiveSize, struct archiveMember* _Out_writes_(maxMembers) members, int maxMembers)
+{
+	if (!isRarc(archive, archiveSize))
+		return 0;
+
+	const struct rarcHeader* header = archive;
+	const struct rarcInfo* info = OffsetPointer(archive, sizeof(struct rarcHeader));
+	uint32_t infoSize = archiveSize - sizeof(struct rarcHeader);
+	uint32_t entryCount = SwapEndian(info->fileEntryCount);
+	uint32_t stringTableOffset = SwapEndian(info->stringTableOffset);
+	uint32_t fileDataOffset = SwapEndian(header->fileDataOffset);
+	if (!isRangeInside(SwapEndian(info->fileEntryOffset), (uint64_t)entryCount * sizeof(struct rarcFileEntry), infoSize) ||
+		stringTableOffset >= infoSize || fileDataOffset > infoSize)
+		return 0;
+
+	const struct rarcFileEntry* entries = OffsetPointer(info, SwapEndian(info->fileEntryOffset));
+	const char* stringTable = OffsetPointer((const char*)info, stringTableOffset);
+	const void* fileData = OffsetPointer(info, fileDataOffset);
+	uint32_t stringTableSize = infoSize - stringTableOffset;
+	uint32_t fileDataSize = infoSize - fileDataOffset;
+
+	int memberCount = 0;
+	for (uint32_t i = 0; i < entryCount && memberCount < maxMembers; i++)
+	{
+		if ((entries[i].flags & 0x02) || SwapEndian(entries[i].id) == 0xFFFF)
+			continue;
+
+		uint32_t nameOffset = SwapEndian(entries[i].nameOffset);
+		if (nameOffset >= stringTableSize || memchr(stringTable + nameOffset, 0, stringTableSize - nameOffset) == nullptr ||
+			!isRangeInside(SwapEndian(entries[i].dataOffset), SwapEndian(entries[i].dataSize), fileDataSize))
+			continue;
+
+		members[memberCount].name = stringTable + nameOffset;
+		members[memberCount].data = OffsetPointer(fileData, SwapEndian(entries[i].dataOffset));
+		members[memberCount].size = SwapEndian(entries[i].dataSize);
+		memberCount++;
+	}
+	return memberCount;
+}
+
+/*
+* J3D files (bmd/bdl models, and the animation formats) share this header and chunk layout
+*/
+struct J3DFileHeader {
+	uint32_t J3DVersion;
+	uint32_t fileVersion;
+	uint8_t unknown1[4];
+	uint32_t blockCount;
+	uint8_t unknown2[16];
+};
+
+struct bmdSection
+{
+	char chunkType[4];
+	int32_t size;
+};
+
+struct TEX1
+{
+	char chunkType[4];
+	int32_t size;
+	uint16_t textureCount;
+	uint16_t padding;
+	int32_t textureHeaderOffset;
+	int32_t stringTableOffset;
+};
+
+struct BTI
+{
+	int8_t format;
+	bool alphaEnabled;
+	int16_t width;
+	int16_t height;
+	int8_t wrapS;
+	int8_t wrapT;
+	bool palettesEnabled;
+	int8_t palletteFormat;
+	int16_t palletteCount;
+	int32_t palletteOffset;
+	bool mipsEnabled;
+	bool doEdgeLOD;
+	bool biasClamp;
+	int8_t maxAnisotropy;
+	int8_t GXMinFilter;
+	int8_t GXMaxFilter;
+	int8_t MinLOD;
+	int8_t MaxLOD;
+	int8_t mipCount;
+	int8_t unknown;
+	int16_t LODBias;
+	int32_t textureDataOffset;
+};
+
+bool isJ3DModel(const void* data, uint32_t size)
+{
+	return size >= sizeof(struct J3DFileHeader) && memcmp(data, "J3D2", 4) == 0 &&
+		(memcmp(OffsetPointer(data, 4), "bmd3", 4) == 0 || memcmp(OffsetPointer(data, 4), "bdl4", 4) == 0);
+}
+
+/*
+* checked cursor over the chunks of a J3D file. a chunk is only returned if all of it lies inside the file, so readers can
+* check their tables against the chunk size once and index them freely after that.
+* chunks are padded to 32 bytes, which also covers every chunk header the readers look at before checking the size
+*/
+#define J3D_MIN_CHUNK_SIZE 0x20
+
+struct j3dChunkCursor
+{
+	const uint8_t* file;
+	uint32_t fileSize;
+	uint32_t offset;
+	uint32_t remaining;//chunks the file header still announces
+};
+
+void initJ3DChunkCursor(struct j3dChunkCursor* cursor, const void* j3dFile, uint32_t fileSize)
+{
+	cursor->file = j3dFile;
+	cursor->fileSize = fileSize;
+	cursor->offset = sizeof(struct J3DFileHeader);
+	cursor->remaining = fileSize >= sizeof(struct J3DFileHeader) ? SwapEndian(((const struct J3DFileHeader*)j3dFile)->blockCount) : 0;
+}
+
+//nullptr after the last chunk, or at the first one that doesn't fit (everything after it is unreachable)
+const struct bmdSection* nextJ3DChunk(struct j3dChunkCursor* cursor)
+{
+	if (cursor->remaining == 0 || !isRangeInside(cursor->offset, sizeof(struct bmdSection), cursor->fileSize))
+		return nullptr;
+
+	const struct bmdSection* chunk = OffsetPointer((const struct bmdSection*)cursor->file, cursor->offset);
+	uint32_t size = SwapEndian(chunk->size);
+	if (size < J3D_MIN_CHUNK_SIZE || !isRangeInside(cursor->offset, size, cursor->fileSize))
+	{
+		cursor->remaining = 0;
+		return nullptr;
+	}
+	cursor->offset += size;
+	cursor->remaining--;
+	return chunk;
+}
+
+//returns the first chunk with the given type, or nullptr
+const struct bmdSection* findJ3DChunk(const void* j3dFile, uint32_t fileSize, const char* chunkType)
+{
+	struct j3dChunkCursor cursor;
+	initJ3DChunkCursor(&cursor, j3dFile, fileSize);
+	for (const struct bmdSection* chunk; (chunk = nextJ3DChunk(&cursor)) != nullptr;)
+		if (memcmp(chunk->chunkType, chunkType, 4) == 0)
+			return chunk;
+	return nullptr;
+}
+
+//tile size and bits per pixel of a GX texture format, false for formats without one
+bool getTextureTileLayout(uint8_t format, uint32_t* _Out_ tileWidth, uint32_t* _Out_ tileHeight, uint32_t* _Out_ bitsPerPixel)
+{
+	switch (format)
+	{
+	case 0x0://I4
+	case 0x8://C4
+	case 0xE://CMPR
+		*tileWidth = 8; *tileHeight = 8; *bitsPerPixel = 4;
+		return true;
+	case 0x1://I8
+	case 0x2://IA4
+	case 0x9://C8
+		*tileWidth = 8; *tileHeight = 4; *bitsPerPixel = 8;
+		return true;
+	case 0x3://IA8
+	case 0x4://RGB565
+	case 0x5://RGB5A3
+	case 0xA://C14X2
+		*tileWidth = 4; *tileHeight = 4; *bitsPerPixel = 16;
+		return true;
+	case 0x6://RGBA8
+		*tileWidth = 4; *tileHeight = 4; *bitsPerPixel = 32;
+		return true;
+	default:
+		return false;
+	}
+}
+
+//size in bytes of the image data of a GX texture format, images are padded to whole tiles
+uint32_t getTextureDataSize(uint8_t format, uint32_t width, uint32_t height)
+{
+	uint32_t tileWidth, tileHeight, bitsPerPixel;
+	if (!getTextureTileLayout(format, &tileWidth, &tileHeight, &bitsPerPixel))
+		return 0;
+
+	//65535 x 65535 RGBA8 would overflow, sizes past 4 GB are reported as unsupported
+	uint64_t tilesX = (width + tileWidth - 1) / tileWidth;
+	uint64_t tilesY = (height + tileHeight - 1) / tileHeight;
+	uint64_t size = tilesX * tilesY * tileWidth * tileHeight * bitsPerPixel / 8;
+	return size <= UINT32_MAX ? (uint32_t)size : 0;
+}
+
+/*
+* BTI texture loader
+* TEX1 entries and standalone .bti files use the same header, in both cases the data offset is relative to the header itself.
+*/
+struct btiTexture
+{
+	const struct BTI* header;
+	const uint8_t* data;
+	uint32_t dataSize;//first level only
+	uint32_t width;
+	uint32_t height;
+	uint8_t format;
+	uint8_t levelCount;//mip levels whose data is in the file, the base level included
+	const uint8_t* palette;//nullptr if the texture has none or it's past the end of the file
+	uint32_t paletteSize;
+};
+
+//availableSize is how many bytes of the file start at the header, the data has to fit in them
+bool loadBTITexture(const void* header, size_t availableSize, struct btiTexture* _Out_ texture)
+{
+	memset(texture, 0, sizeof(struct btiTexture));
+	if (availableSize < sizeof(struct BTI))
+		return false;
+
+	const struct BTI* bti = header;
+	uint32_t dataOffset = SwapEndian(bti->textureDataOffset);
+	texture->header = bti;
+	texture->width = (uint16_t)SwapEndian(bti->width);
+	texture->height = (uint16_t)SwapEndian(bti->height);
+	texture->format = (uint8_t)bti->format;
+	texture->dataSize = getTextureDataSize(texture->format, texture->width, texture->height);
+
+	if (texture->width == 0 || texture->height == 0 || texture->dataSize == 0 || dataOffset > availableSize || availableSize - dataOffset < texture->dataSize)
+		return false;
+
+	texture->data = OffsetPointer((const uint8_t*)bti, dataOffset);
+
+	//declared levels past the end of the file are dropped
+	uint64_t levelOffset = dataOffset;
+	while (texture->levelCount < min(max((uint8_t)bti->mipCount, 1), 16))
+	{
+		uint32_t levelSize = getTextureDataSize(texture->format, max(texture->width >> texture->levelCount, 1), max(texture->height >> texture->levelCount, 1));
+		if (!isRangeInside(levelOffset, levelSize, availableSize))
+			break;
+		levelOffset += levelSize;
+		texture->levelCount++;
+	}
+
+	uint32_t paletteOffset = SwapEndian(bti->palletteOffset);
+	uint32_t paletteSize = (uint32_t)(uint16_t)SwapEndian(bti->palletteCount) * 2;
+	if (bti->palettesEnabled && isRangeInside(paletteOffset, paletteSize, availableSize))
+	{
+		texture->palette = OffsetPointer((const uint8_t*)bti, paletteOffset);
+		texture->paletteSize = paletteSize;
+	}
+	return true;
+}
+
+//textures has to come from findJ3DChunk or a j3dChunkCursor, its size is trusted
+bool loadTEX1Texture(const struct TEX1* textures, uint32_t textureIndex, struct btiTexture* _Out_ texture)
+{
+	uint32_t chunkSize = SwapEndian(textures->size);
+	uint64_t headerOffset = (uint64_t)(uint32_t)SwapEndian(textures->textureHeaderOffset) + (uint64_t)textureIndex * sizeof(struct BTI);
+	if (textureIndex >= (uint16_t)SwapEndian(textures->textureCount) || headerOffset > chunkSize)
+	{
+		memset(texture, 0, sizeof(struct btiTexture));
+		return false;
+	}
+	return loadBTITexture(OffsetPointer(textures, headerOffset), (size_t)(chunkSize - headerOffset), texture);
+}
+
+//bytes of every mip level in the file, they're stored back to back after the base level
+static uint32_t getTextureLevelsSize(const struct btiTexture* texture)
+{
+	uint32_t size = 0;
+	for (uint32_t level = 0; level < texture->levelCount; level++)
+		size += getTextureDataSize(texture->format, max(texture->width >> level, 1), max(texture->height >> level, 1));
+	return size;
+}
+
+//size of decodeTexture's output
+size_t getDecodedTextureSize(uint32_t width, uint32_t height)
+{
+	return (size_t)width * height * 4;
+}
+
+//pixels must hold getDecodedTextureSize bytes
+void decodeBTITexture(const struct btiTexture* texture, void* _Out_ pixels, struct decodedImage* _Out_ image)
+{
+	image->width = texture->width;
+	image->height = texture->height;
+	image->pixelCount = texture->width * texture->height;
+	image->pixels = pixels;
+	decodeTexture(texture->width, texture->height, image->pixelCount, texture->data, pixels, texture->format);
+}
+
+/*
+* CMPR -> BC1 transcoding
+* CMPR is DXT1 with big endian endpoints, the 2 bit indices of a row stored from the most significant bits down,
+* and 4 blocks per 8x8 tile (top left, top right, bottom left, bottom right).
+* the top two blocks of a tile are neighbours in a linear BC1 row, so every tile is two 16 byte stores.
+*/
+#define GX_TF_CMPR 0xE
+
+uint32_t getBC1DataSize(uint32_t width, uint32_t height)
+{
+	return max((width + 3) / 4, 1) * max((height + 3) / 4, 1) * 8;
+}
+
+static inline __m128i convertCMPRBlocks(__m128i blocks)
+{
+	//the endpoints are the first 4 bytes of every 8: swap the bytes of those 16 bit words
+	const __m128i endpointMask = _mm_set_epi32(0, -1, 0, -1);
+	__m128i swapped = _mm_or_si128(_mm_slli_epi16(blocks, 8), _mm_srli_epi16(blocks, 8));
+
+	//reverse the order of the 2 bit indices in every byte: swap neighbouring pairs, then nibbles
+	__m128i indices = _mm_or_si128(
+		_mm_and_si128(_mm_slli_epi16(blocks, 2), _mm_set1_epi8((char)0xCC)),
+		_mm_and_si128(_mm_srli_epi16(blocks, 2), _mm_set1_epi8(0x33)));
+	indices = _mm_or_si128(
+		_mm_and_si128(_mm_slli_epi16(indices, 4), _mm_set1_epi8((char)0xF0)),
+		_mm_and_si128(_mm_srli_epi16(indices, 4), _mm_set1_epi8(0x0F)));
+
+	return _mm_or_si128(_mm_and_si128(endpointMask, swapped), _mm_andnot_si128(endpointMask, indices));
+}
+
+//transcodes one CMPR image (tile padded, like getTextureDataSize) into row-major BC1 blocks, returns the BC1 size
+uint32_t transcodeCMPRToBC1(const uint8_t* _In_ cmpr, uint32_t width, uint32_t height, uint8_t* _Out_ bc1)
+{
+	uint32_t blocksWide = max((width + 3) / 4, 1);
+	uint32_t blocksHigh = max((height + 3) / 4, 1);
+	uint32_t tilesWide = (blocksWide + 1) / 2;
+	uint32_t tilesHigh = (blocksHigh + 1) / 2;
+	size_t rowPitch = blocksWide * 8;
+
+	for (uint32_t tileY = 0; tileY < tilesHigh; tileY++)
+	{
+		uint8_t* topRow = bc1 + tileY * 2 * rowPitch;
+		uint8_t* bottomRow = topRow + rowPitch;
+		bool hasBottom = tileY * 2 + 1 < blocksHigh;
+
+		for (uint32_t tileX = 0; tileX < tilesWide; tileX++, cmpr += 32)
+		{
+			__m128i top = convertCMPRBlocks(_mm_loadu_si128((const __m128i*)cmpr));
+			__m128i bottom = convertCMPRBlocks(_mm_loadu_si128((const __m128i*)(cmpr + 16)));
+
+			//images with an odd number of blocks only use the left half of the last tile
+			if (tileX * 2 + 1 < blocksWide)
+			{
+				_mm_storeu_si128((__m128i*)(topRow + tileX * 16), top);
+				if (hasBottom)
+					_mm_storeu_si128((__m128i*)(bottomRow + tileX * 16), bottom);
+			}
+			else
+			{
+				_mm_storel_epi64((__m128i*)(topRow + tileX * 16), top);
+				if (hasBottom)
+					_mm_storel_epi64((__m128i*)(bottomRow + tileX * 16), bottom);
+			}
+		}
+	}
+	return blocksWide * blocksHigh * 8;
+}
+
+/*
+* the bit exact difference between a GX and a BC1 decode of the same blocks, only measured when asked for:
+* 4 color blocks blend 5/8 + 3/8 on GX instead of 2/3 + 1/3,
+* and the transparent texel of 3 color blocks is the midpoint on GX instead of black.
+*/
+struct cmprPrecisionStats
+{
+	uint64_t blockCount;
+	uint64_t blendedBlockCount;//4 color blocks that use an interpolated color
+	uint64_t transparentBlockCount;//3 color blocks with transparent texels
+	uint64_t errorSum;//over blended blocks
+	uint32_t maxError;//largest 8 bit channel difference of an interpolated color
+};
+
+void measureCMPRPrecision(const uint8_t* _In_ cmpr, uint32_t width, uint32_t height, struct cmprPrecisionStats* stats)
+{
+	uint32_t blockCount = ((max(width, 1) + 7) / 8) * ((max(height, 1) + 7) / 8) * 4;
+	for (uint32_t i = 0; i < blockCount; i++, cmpr += 8)
+	{
+		stats->blockCount++;
+
+		uint8_t color0[4];
+		uint8_t color1[4];
+		int endpoint0 = Unpack565(cmpr, color0);
+		int endpoint1 = Unpack565(cmpr + 2, color1);
+
+		uint32_t usedIndices = 0;
+		for (int row = 0; row < 4; row++)
+			for (int pixel = 0; pixel < 4; pixel++)
+				usedIndices |= 1 << ((cmpr[4 + row] >> (pixel * 2)) & 3);
+
+		if (endpoint0 <= endpoint1)
+		{
+			if (usedIndices & 8)
+				stats->transparentBlockCount++;
+			continue;
+		}
+
+		if ((usedIndices & 0xC) == 0)
+			continue;
+
+		uint32_t blockError = 0;
+		for (int channel = 0; channel < 3; channel++)
+		{
+			int c = color0[channel];
+			int d = color1[channel];
+			int gx2 = (c * 5 + d * 3) >> 3;
+			int gx3 = (c * 3 + d * 5) >> 3;
+			int bc2 = (c * 2 + d) / 3;
+			int bc3 = (c + d * 2) / 3;
+			if (usedIndices & 4)
+				blockError = max(blockError, (uint32_t)abs(gx2 - bc2));
+			if (usedIndices & 8)
+				blockError = max(blockError, (uint32_t)abs(gx3 - bc3));
+		}
+		stats->blendedBlockCount++;
+		stats->errorSum += blockError;
+		stats->maxError = max(stats->maxError, blockError);
+	}
+}
+
+/*
+* DDS (DXT1) and KTX2 (VK_FORMAT_BC1_RGBA_UNORM_BLOCK) containers for CMPR textures.
+* both return the file size, or 0 if the texture isn't CMPR or the buffer is too small.
+*/
+#define DDS_HEADER_SIZE 128
+
+uint32_t getBC1ContainerCapacity(const struct btiTexture* texture)
+{
+	uint32_t size = 256 + 24 * 16;
+	for (uint32_t level = 0; level < texture->levelCount; level++)
+		size += getBC1DataSize(max(texture->width >> level, 1), max(texture->height >> level, 1)) + 8;
+	return size;
+}
+
+uint32_t buildDDSFile(const struct btiTexture* texture, uint8_t* _Out_ file, uint32_t fileCapacity)
+{
+	uint32_t width = texture->width;
+	uint32_t height = texture->height;
+	uint32_t levelCount = texture->levelCount;
+	if (texture->format != GX_TF_CMPR || width == 0 || height == 0 || getBC1ContainerCapacity(texture) > fileCapacity)
+		return 0;
+
+	uint32_t* header = (uint32_t*)file;
+	memset(header, 0, DDS_HEADER_SIZE);
+	memcpy(header, "DDS ", 4);
+	header[1] = 124;//header size
+	header[2] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000 | (levelCount > 1 ? 0x20000 : 0);//caps, height, width, pixel format, linear size, mip count
+	header[3] = height;
+	header[4] = width;
+	header[5] = getBC1DataSize(width, height);
+	header[7] = levelCount;
+	header[19] = 32;//pixel format size
+	header[20] = 0x4;//fourcc
+	memcpy(&header[21], "DXT1", 4);
+	header[27] = 0x1000 | (levelCount > 1 ? 0x400008 : 0);//texture, mipmap + complex
+
+	const uint8_t* cmpr = texture->data;
+	uint32_t size = DDS_HEADER_SIZE;
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		uint32_t levelWidth = max(width >> level, 1);
+		uint32_t levelHeight = max(height >> level, 1);
+		size += transcodeCMPRToBC1(cmpr, levelWidth, levelHeight, file + size);
+		cmpr += getTextureDataSize(GX_TF_CMPR, levelWidth, levelHeight);
+	}
+	return size;
+}
+
+uint32_t buildKTX2File(const struct btiTexture* texture, uint8_t* _Out_ file, uint32_t fileCapacity)
+{
+	uint32_t width = texture->width;
+	uint32_t height = texture->height;
+	uint32_t levelCount = texture->levelCount;
+	if (texture->format != GX_TF_CMPR || width == 0 || height == 0 || getBC1ContainerCapacity(texture) > fileCapacity)
+		return 0;
+
+	static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	const uint32_t levelIndexOffset = 80;
+	const uint32_t dfdOffset = levelIndexOffset + levelCount * 24;
+	const uint32_t dfdSize = 44;
+
+	memset(file, 0, dfdOffset + dfdSize);
+	memcpy(file, identifier, sizeof(identifier));
+
+	uint32_t* header = (uint32_t*)(file + 12);
+	header[0] = 133;//VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+	header[1] = 1;//type size
+	header[2] = width;
+	header[3] = height;
+	header[6] = 1;//faces
+	header[7] = levelCount;
+	header[9] = dfdOffset;
+	header[10] = dfdSize;
+
+	//basic data format descriptor: BC1A, one 64 bit sample
+	uint32_t* dfd = (uint32_t*)(file + dfdOffset);
+	dfd[0] = dfdSize;
+	dfd[1] = 0;//vendor, type
+	dfd[2] = 2 | (40 << 16);//version, block size
+	dfd[3] = 128 | (1 << 8) | (1 << 16);//BC1A, BT.709 primaries, linear
+	dfd[4] = 3 | (3 << 8);//4x4 texel blocks
+	dfd[5] = 8;//bytes per block
+	dfd[7] = 0 | (63 << 16) | (1 << 24);//bit offset, bit length - 1, alpha present channel
+	dfd[10] = 0xFFFFFFFF;//sample upper
+
+	//levels are stored smallest first, each 8 byte aligned
+	uint64_t* levelIndex = (uint64_t*)(file + levelIndexOffset);
+	uint32_t size = (dfdOffset + dfdSize + 7) & ~7;
+	const uint8_t* cmprLevels[16];
+	const uint8_t* cmpr = texture->data;
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		cmprLevels[level] = cmpr;
+		cmpr += getTextureDataSize(GX_TF_CMPR, max(width >> level, 1), max(height >> level, 1));
+	}
+	for (int level = levelCount - 1; level >= 0; level--)
+	{
+		uint32_t levelSize = transcodeCMPRToBC1(cmprLevels[level], max(width >> level, 1), max(height >> level, 1), file + size);
+		levelIndex[level * 3] = size;
+		levelIndex[level * 3 + 1] = levelSize;
+		levelIndex[level * 3 + 2] = levelSize;
+		size = (size + levelSize + 7) & ~7;
+	}
+	return size;
+}
+
+/*
+* GX texture encoders, the way back from decodeTexture's rgba for the formats it reads.
+* output is tile padded like getTextureDataSize, tiles past the edge of the image repeat its last row and column.
+* every format rounds to the code that decodes nearest, so re-encoding a decoded texture gives the same texels back (CMPR aside).
+* CMPR quality: 0 bounding box, 1 principal axis and a least squares refinement, 2 also searches the 565 endpoints around that and tries 3 color blocks.
+*/
+#define CMPR_QUALITY_FAST 0
+#define CMPR_QUALITY_NORMAL 1
+#define CMPR_QUALITY_BEST 2
+
+//rounds 8 bit channels in 16 bit lanes to 0..levels (a channel multiplied by 0 comes out as 0)
+static inline __m128i quantizeChannels(__m128i channels, __m128i levels)
+{
+	__m128i scaled = _mm_add_epi16(_mm_mullo_epi16(channels, levels), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(scaled, _mm_srli_epi16(scaled, 8)), 8);
+}
+
+//BT.601 luma of 4 rgba texels in 32 bit lanes, grey stays the same value
+static inline __m128i getTexelIntensity(__m128i texels)
+{
+	__m128i redBlue = _mm_and_si128(texels, _mm_set1_epi32(0x00FF00FF));
+	__m128i green = _mm_and_si128(_mm_srli_epi32(texels, 8), _mm_set1_epi32(0xFF));
+	__m128i sum = _mm_add_epi32(_mm_madd_epi16(redBlue, _mm_set1_epi32(77 | 29 << 16)), _mm_madd_epi16(green, _mm_set1_epi32(150)));
+	return _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8);
+}
+
+static inline __m128i encodeRGB565Texels(__m128i texels)
+{
+	const __m128i low = _mm_set1_epi32(0xFFFF);
+	__m128i redBlue = quantizeChannels(_mm_and_si128(texels, _mm_set1_epi32(0x00FF00FF)), _mm_set1_epi32(31 | 31 << 16));
+	__m128i green = quantizeChannels(_mm_and_si128(_mm_srli_epi32(texels, 8), _mm_set1_epi32(0xFF)), _mm_set1_epi32(63));
+	return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(redBlue, low), 11), _mm_slli_epi32(green, 5)), _mm_srli_epi32(redBlue, 16));
+}
+
+//texels whose alpha rounds to 7 of 3 bits are stored opaque with 5 bit colors, the rest with 3 bit alpha and 4 bit colors
+static inline __m128i encodeRGB5A3Texels(__m128i texels)
+{
+	const __m128i low = _mm_set1_epi32(0xFFFF);
+	__m128i redBlue = _mm_and_si128(texels, _mm_set1_epi32(0x00FF00FF));
+	__m128i greenAlpha = _mm_and_si128(_mm_srli_epi32(texels, 8), _mm_set1_epi32(0x00FF00FF));
+
+	__m128i redBlue5 = quantizeChannels(redBlue, _mm_set1_epi32(31 | 31 << 16));
+	__m128i greenAlpha5 = quantizeChannels(greenAlpha, _mm_set1_epi32(31 | 7 << 16));
+	__m128i redBlue4 = quantizeChannels(redBlue, _mm_set1_epi32(15 | 15 << 16));
+	__m128i green4 = quantizeChannels(greenAlpha, _mm_set1_epi32(15));
+	__m128i alpha = _mm_srli_epi32(greenAlpha5, 16);
+
+	__m128i opaque = _mm_or_si128(
+		_mm_or_si128(_mm_set1_epi32(0x8000), _mm_slli_epi32(_mm_and_si128(redBlue5, low), 10)),
+		_mm_or_si128(_mm_slli_epi32(_mm_and_si128(greenAlpha5, low), 5), _mm_srli_epi32(redBlue5, 16)));
+	__m128i translucent = _mm_or_si128(
+		_mm_or_si128(_mm_slli_epi32(alpha, 12), _mm_slli_epi32(_mm_and_si128(redBlue4, low), 8)),
+		_mm_or_si128(_mm_slli_epi32(green4, 4), _mm_srli_epi32(redBlue4, 16)));
+
+	//unless the 4 bit colors are exact, then the texel came from a 3 bit alpha of 7 and goes back to one
+	__m128i exact4 = _mm_and_si128(
+		_mm_cmpeq_epi32(_mm_mullo_epi16(redBlue4, _mm_set1_epi16(0x11)), redBlue),
+		_mm_cmpeq_epi32(_mm_mullo_epi16(green4, _mm_set1_epi16(0x11)), _mm_and_si128(greenAlpha, low)));
+	__m128i isOpaque = _mm_andnot_si128(exact4, _mm_cmpeq_epi32(alpha, _mm_set1_epi32(7)));
+	return _mm_or_si128(_mm_and_si128(isOpaque, opaque), _mm_andnot_si128(isOpaque, translucent));
+}
+
+static inline __m128i encodeIA8Texels(__m128i texels)
+{
+	return _mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(texels, 24), 8), getTexelIntensity(texels));
+}
+
+static inline __m128i encodeIA4Texels(__m128i texels)
+{
+	__m128i alphaIntensity = quantizeChannels(_mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(texels, 24), 16), getTexelIntensity(texels)), _mm_set1_epi32(15 | 15 << 16));
+	return _mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(alphaIntensity, 16), 4), _mm_and_si128(alphaIntensity, _mm_set1_epi32(0xF)));
+}
+
+//alpha/red as one big endian word, green/blue as another
+static inline __m128i encodeAlphaRedTexels(__m128i texels)
+{
+	return _mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(texels, 24), 8), _mm_and_si128(texels, _mm_set1_epi32(0xFF)));
+}
+
+static inline __m128i encodeGreenBlueTexels(__m128i texels)
+{
+	return _mm_or_si128(_mm_and_si128(texels, _mm_set1_epi32(0xFF00)), _mm_and_si128(_mm_srli_epi32(texels, 16), _mm_set1_epi32(0xFF)));
+}
+
+static inline __m128i encodeI4Texels(__m128i texels)
+{
+	return quantizeChannels(getTexelIntensity(texels), _mm_set1_epi32(15));
+}
+
+//the low 16 bits of the 32 bit lanes of a and b as 8 big endian words
+static inline __m128i packBigEndian16(__m128i a, __m128i b)
+{
+	//sign extended so the saturating pack keeps the bits
+	__m128i words = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+	return _mm_or_si128(_mm_slli_epi16(words, 8), _mm_srli_epi16(words, 8));
+}
+
+//16 texels of byte values in 32 bit lanes as 16 bytes
+static inline __m128i packBytes(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+	return _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+}
+
+//copies one tile of texels into tile (tileWidth texels a row), clamping to the image
+static void fetchTile(const uint32_t* pixels, uint32_t width, uint32_t height, uint32_t x, uint32_t y, uint32_t tileWidth, uint32_t tileHeight, uint32_t* _Out_ tile)
+{
+	for (uint32_t row = 0; row < tileHeight; row++)
+	{
+		const uint32_t* source = pixels + (size_t)min(y + row, height - 1) * width;
+		if (x + tileWidth <= width)
+			memcpy(tile + row * tileWidth, source + x, tileWidth * 4);
+		else
+			for (uint32_t column = 0; column < tileWidth; column++)
+				tile[row * tileWidth + column] = source[min(x + column, width - 1)];
+	}
+}
+
+/*
+* CMPR blocks
+* the palette is built with decodeTexture's arithmetic (5/8 + 3/8 blends, the midpoint in 3 color blocks),
+* indices go to the nearest palette color, texels with alpha below 128 make a 3 color block and take the transparent index.
+*/
+struct cmprBlock
+{
+	alignas(16) float r[16];
+	alignas(16) float g[16];
+	alignas(16) float b[16];
+	alignas(16) uint32_t opaque[16];//all bits set for texels with alpha >= 128
+	uint32_t opaqueCount;
+};
+
+struct cmprCandidate
+{
+	uint16_t endpoint0;
+	uint16_t endpoint1;
+	uint8_t indices[16];
+	float error;
+};
+
+static inline float sumLanes(__m128 v)
+{
+	v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+	return _mm_cvtss_f32(v);
+}
+
+//texels is 4x4 with a row pitch of 8 texels, one quarter of a CMPR tile
+static void loadCMPRBlock(const uint32_t* texels, struct cmprBlock* _Out_ block)
+{
+	const __m128i byteMask = _mm_set1_epi32(0xFF);
+	block->opaqueCount = 0;
+	for (int row = 0; row < 4; row++)
+	{
+		__m128i rowTexels = _mm_loadu_si128((const __m128i*)(texels + row * 8));
+		__m128i opaque = _mm_cmpgt_epi32(_mm_srli_epi32(rowTexels, 24), _mm_set1_epi32(127));
+		_mm_store_ps(block->r + row * 4, _mm_cvtepi32_ps(_mm_and_si128(rowTexels, byteMask)));
+		_mm_store_ps(block->g + row * 4, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(rowTexels, 8), byteMask)));
+		_mm_store_ps(block->b + row * 4, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(rowTexels, 16), byteMask)));
+		_mm_store_si128((__m128i*)(block->opaque + row * 4), opaque);
+
+		int mask = _mm_movemask_ps(_mm_castsi128_ps(opaque));
+		block->opaqueCount += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + (mask >> 3);
+	}
+}
+
+static uint16_t packEndpoint565(const float color[3])
+{
+	uint32_t red = (uint32_t)(min(max(color[0], 0.0f), 255.0f) * (31.0f / 255.0f) + 0.5f);
+	uint32_t green = (uint32_t)(min(max(color[1], 0.0f), 255.0f) * (63.0f / 255.0f) + 0.5f);
+	uint32_t blue = (uint32_t)(min(max(color[2], 0.0f), 255.0f) * (31.0f / 255.0f) + 0.5f);
+	return (uint16_t)(red << 11 | green << 5 | blue);
+}
+
+//nearest palette color of every texel, returns the squared error summed over the opaque texels
+static float findCMPRIndices(const struct cmprBlock* block, const float palette[4][3], int colorCount, uint8_t* _Out_ indices)
+{
+	__m128 total = _mm_setzero_ps();
+	for (int group = 0; group < 16; group += 4)
+	{
+		__m128 r = _mm_load_ps(block->r + group);
+		__m128 g = _mm_load_ps(block->g + group);
+		__m128 b = _mm_load_ps(block->b + group);
+		__m128 best = _mm_set1_ps(FLT_MAX);
+		__m128i bestIndex = _mm_setzero_si128();
+		for (int i = 0; i < colorCount; i++)
+		{
+			__m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[i][0]));
+			__m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[i][1]));
+			__m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[i][2]));
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+			__m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+			best = _mm_min_ps(distance, best);
+			bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(i)), _mm_andnot_si128(closer, bestIndex));
+		}
+
+		__m128i opaque = _mm_load_si128((const __m128i*)(block->opaque + group));
+		bestIndex = _mm_or_si128(_mm_and_si128(opaque, bestIndex), _mm_andnot_si128(opaque, _mm_set1_epi32(3)));
+		total = _mm_add_ps(total, _mm_and_ps(_mm_castsi128_ps(opaque), best));
+
+		__m128i words = _mm_packs_epi32(bestIndex, bestIndex);
+		int indices4 = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+		memcpy(indices + group, &indices4, 4);
+	}
+	return sumLanes(total);
+}
+
+//puts 565 endpoints in the order the block type needs and picks the indices
+static void evaluatePackedCMPREndpoints(const struct cmprBlock* block, uint16_t packed0, uint16_t packed1, bool threeColor, struct cmprCandidate* _Out_ candidate)
+{
+	if (threeColor ? packed0 > packed1 : packed0 < packed1)
+	{
+		uint16_t swap = packed0;
+		packed0 = packed1;
+		packed1 = swap;
+	}
+	candidate->endpoint0 = packed0;
+	candidate->endpoint1 = packed1;
+
+	uint8_t bytes[4] = { (uint8_t)(packed0 >> 8), (uint8_t)packed0, (uint8_t)(packed1 >> 8), (uint8_t)packed1 };
+	uint8_t color0[4];
+	uint8_t color1[4];
+	Unpack565(bytes, color0);
+	Unpack565(bytes + 2, color1);
+
+	float palette[4][3];
+	for (int i = 0; i < 3; i++)
+	{
+		palette[0][i] = color0[i];
+		palette[1][i] = color1[i];
+		if (packed0 > packed1)
+		{
+			palette[2][i] = (float)((color0[i] * 5 + color1[i] * 3) >> 3);
+			palette[3][i] = (float)((color0[i] * 3 + color1[i] * 5) >> 3);
+		}
+		else
+		{
+			palette[2][i] = (float)((color0[i] + color1[i]) / 2);
+			palette[3][i] = palette[2][i];
+		}
+	}
+	candidate->error = findCMPRIndices(block, palette, packed0 > packed1 ? 4 : 3, candidate->indices);
+}
+
+static void evaluateCMPREndpoints(const struct cmprBlock* block, const float endpoint0[3], const float endpoint1[3], bool threeColor, struct cmprCandidate* _Out_ candidate)
+{
+	evaluatePackedCMPREndpoints(block, packEndpoint565(endpoint0), packEndpoint565(endpoint1), threeColor, candidate);
+}
+
+//nudges every 565 field of both endpoints up and down by one while that lowers the error
+static void searchCMPREndpoints(const struct cmprBlock* block, bool threeColor, struct cmprCandidate* best)
+{
+	static const uint16_t fieldUnits[3] = { 1 << 11, 1 << 5, 1 };
+	static const uint16_t fieldMasks[3] = { 0x1F << 11, 0x3F << 5, 0x1F };
+	for (int pass = 0; pass < 2; pass++)
+	{
+		bool improved = false;
+		for (int field = 0; field < 6; field++)
+		{
+			for (int direction = -1; direction <= 1; direction += 2)
+			{
+				uint16_t endpoints[2] = { best->endpoint0, best->endpoint1 };
+				uint16_t* endpoint = &endpoints[field / 3];
+				uint16_t unit = fieldUnits[field % 3];
+				uint16_t value = *endpoint & fieldMasks[field % 3];
+				if (direction < 0 ? value == 0 : value == fieldMasks[field % 3])
+					continue;
+				*endpoint = direction < 0 ? *endpoint - unit : *endpoint + unit;
+
+				struct cmprCandidate candidate;
+				evaluatePackedCMPREndpoints(block, endpoints[0], endpoints[1], threeColor, &candidate);
+				if (candidate.error < best->error)
+				{
+					*best = candidate;
+					improved = true;
+				}
+			}
+		}
+		if (!improved || best->error == 0.0f)
+			break;
+	}
+}
+
+//the endpoints that best fit the texels for the candidate's indices, false if they don't pin two endpoints down
+static bool refineCMPREndpoints(const struct cmprBlock* block, const struct cmprCandidate* candidate, float endpoint0[3], float endpoint1[3])
+{
+	//share of endpoint0 in the color of every index
+	static const float fourColorWeights[4] = { 1.0f, 0.0f, 5.0f / 8.0f, 3.0f / 8.0f };
+	static const float threeColorWeights[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+	const float* weights = candidate->endpoint0 > candidate->endpoint1 ? fourColorWeights : threeColorWeights;
+
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float sum0[3] = { 0.0f, 0.0f, 0.0f };
+	float sum1[3] = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++)
+	{
+		if (!block->opaque[i])
+			continue;
+		float a = weights[candidate->indices[i]];
+		float b = 1.0f - a;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		sum0[0] += a * block->r[i]; sum0[1] += a * block->g[i]; sum0[2] += a * block->b[i];
+		sum1[0] += b * block->r[i]; sum1[1] += b * block->g[i]; sum1[2] += b * block->b[i];
+	}
+
+	float determinant = aa * bb - ab * ab;
+	if (fabsf(determinant) < 1e-6f)
+		return false;
+	for (int channel = 0; channel < 3; channel++)
+	{
+		endpoint0[channel] = (bb * sum0[channel] - ab * sum1[channel]) / determinant;
+		endpoint1[channel] = (aa * sum1[channel] - ab * sum0[channel]) / determinant;
+	}
+	return true;
+}
+
+//starting endpoints: the corners of the bounding box along the colors' direction, or the extent along the principal axis
+static void findCMPREndpoints(const struct cmprBlock* block, uint8_t quality, float endpoint0[3], float endpoint1[3])
+{
+	const float* channels[3] = { block->r, block->g, block->b };
+	float mean[3], low[3], high[3];
+	for (int c = 0; c < 3; c++)
+	{
+		__m128 sum = _mm_setzero_ps();
+		__m128 minimum = _mm_set1_ps(FLT_MAX);
+		__m128 maximum = _mm_set1_ps(-FLT_MAX);
+		for (int group = 0; group < 16; group += 4)
+		{
+			__m128 opaque = _mm_load_ps((const float*)(block->opaque + group));
+			__m128 v = _mm_load_ps(channels[c] + group);
+			sum = _mm_add_ps(sum, _mm_and_ps(opaque, v));
+			minimum = _mm_min_ps(minimum, _mm_or_ps(_mm_and_ps(opaque, v), _mm_andnot_ps(opaque, _mm_set1_ps(FLT_MAX))));
+			maximum = _mm_max_ps(maximum, _mm_or_ps(_mm_and_ps(opaque, v), _mm_andnot_ps(opaque, _mm_set1_ps(-FLT_MAX))));
+		}
+		mean[c] = sumLanes(sum) / block->opaqueCount;
+		alignas(16) float lanes[8];
+		_mm_store_ps(lanes, minimum);
+		_mm_store_ps(lanes + 4, maximum);
+		low[c] = min(min(lanes[0], lanes[1]), min(lanes[2], lanes[3]));
+		high[c] = max(max(lanes[4], lanes[5]), max(lanes[6], lanes[7]));
+	}
+
+	//covariance, rr rg rb gg gb bb
+	float covariance[6];
+	const int pairs[6][2] = { { 0, 0 }, { 0, 1 }, { 0, 2 }, { 1, 1 }, { 1, 2 }, { 2, 2 } };
+	for (int p = 0; p < 6; p++)
+	{
+		__m128 sum = _mm_setzero_ps();
+		__m128 meanA = _mm_set1_ps(mean[pairs[p][0]]);
+		__m128 meanB = _mm_set1_ps(mean[pairs[p][1]]);
+		for (int group = 0; group < 16; group += 4)
+		{
+			__m128 opaque = _mm_load_ps((const float*)(block->opaque + group));
+			__m128 a = _mm_sub_ps(_mm_load_ps(channels[pairs[p][0]] + group), meanA);
+			__m128 b = _mm_sub_ps(_mm_load_ps(channels[pairs[p][1]] + group), meanB);
+			sum = _mm_add_ps(sum, _mm_and_ps(opaque, _mm_mul_ps(a, b)));
+		}
+		covariance[p] = sumLanes(sum);
+	}
+
+	//bounding box diagonal: channels that fall as the widest one rises swap their ends
+	int widest = 0;
+	for (int c = 1; c < 3; c++)
+		if (high[c] - low[c] > high[widest] - low[widest])
+			widest = c;
+	const int covarianceIndex[3][3] = { { 0, 1, 2 }, { 1, 3, 4 }, { 2, 4, 5 } };
+	float axis[3];
+	for (int c = 0; c < 3; c++)
+	{
+		endpoint0[c] = high[c];
+		endpoint1[c] = low[c];
+		if (covariance[covarianceIndex[widest][c]] < 0.0f)
+		{
+			endpoint0[c] = low[c];
+			endpoint1[c] = high[c];
+		}
+		axis[c] = endpoint0[c] - endpoint1[c];
+	}
+
+	if (quality == CMPR_QUALITY_FAST)
+	{
+		//inset by 1/16 of the range, the ends are rarely worth a palette entry of their own
+		for (int c = 0; c < 3; c++)
+		{
+			float inset = (endpoint0[c] - endpoint1[c]) / 16.0f;
+			endpoint0[c] -= inset;
+			endpoint1[c] += inset;
+		}
+		return;
+	}
+
+	//principal axis by power iteration from the diagonal
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float next[3];
+		for (int c = 0; c < 3; c++)
+			next[c] = covariance[covarianceIndex[c][0]] * axis[0] + covariance[covarianceIndex[c][1]] * axis[1] + covariance[covarianceIndex[c][2]] * axis[2];
+		float length = max(max(fabsf(next[0]), fabsf(next[1])), fabsf(next[2]));
+		if (length < 1e-6f)
+			return;
+		for (int c = 0; c < 3; c++)
+			axis[c] = next[c] / length;
+	}
+
+	float projectionLow = FLT_MAX;
+	float projectionHigh = -FLT_MAX;
+	float lengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	for (int i = 0; i < 16; i++)
+	{
+		if (!block->opaque[i])
+			continue;
+		float t = (block->r[i] - mean[0]) * axis[0] + (block->g[i] - mean[1]) * axis[1] + (block->b[i] - mean[2]) * axis[2];
+		projectionLow = min(projectionLow, t);
+		projectionHigh = max(projectionHigh, t);
+	}
+	for (int c = 0; c < 3; c++)
+	{
+		endpoint0[c] = mean[c] + axis[c] * projectionHigh / lengthSquared;
+		endpoint1[c] = mean[c] + axis[c] * projectionLow / lengthSquared;
+	}
+}
+
+static void encodeCMPRBlock(const uint32_t* texels, uint8_t quality, uint8_t* _Out_ out)
+{
+	struct cmprBlock block;
+	loadCMPRBlock(texels, &block);
+
+	struct cmprCandidate best;
+	if (block.opaqueCount == 0)
+	{
+		best.endpoint0 = 0;
+		best.endpoint1 = 0;
+		memset(best.indices, 3, sizeof(best.indices));
+	}
+	else
+	{
+		bool threeColor = block.opaqueCount < 16;
+		float endpoint0[3], endpoint1[3];
+		findCMPREndpoints(&block, quality, endpoint0, endpoint1);
+		evaluateCMPREndpoints(&block, endpoint0, endpoint1, threeColor, &best);
+
+		int refinements = quality == CMPR_QUALITY_FAST ? 0 : quality == CMPR_QUALITY_NORMAL ? 1 : 2;
+		for (int i = 0; i < refinements && best.error > 0.0f && refineCMPREndpoints(&block, &best, endpoint0, endpoint1); i++)
+		{
+			struct cmprCandidate candidate;
+			evaluateCMPREndpoints(&block, endpoint0, endpoint1, threeColor, &candidate);
+			if (candidate.error >= best.error)
+				break;
+			best = candidate;
+		}
+
+		if (quality >= CMPR_QUALITY_BEST && best.error > 0.0f)
+			searchCMPREndpoints(&block, threeColor, &best);
+
+		//an exact midpoint sometimes beats the 3/8 blends
+		if (quality >= CMPR_QUALITY_BEST && !threeColor && best.error > 0.0f)
+		{
+			struct cmprCandidate candidate;
+			findCMPREndpoints(&block, quality, endpoint0, endpoint1);
+			evaluateCMPREndpoints(&block, endpoint0, endpoint1, true, &candidate);
+			if (refineCMPREndpoints(&block, &candidate, endpoint0, endpoint1))
+			{
+				struct cmprCandidate refined;
+				evaluateCMPREndpoints(&block, endpoint0, endpoint1, true, &refined);
+				if (refined.error < candidate.error)
+					candidate = refined;
+			}
+			if (candidate.error < best.error)
+				best = candidate;
+		}
+	}
+
+	out[0] = (uint8_t)(best.endpoint0 >> 8);
+	out[1] = (uint8_t)best.endpoint0;
+	out[2] = (uint8_t)(best.endpoint1 >> 8);
+	out[3] = (uint8_t)best.endpoint1;
+	for (int row = 0; row < 4; row++)
+	{
+		const uint8_t* index = best.indices + row * 4;
+		out[4 + row] = (uint8_t)(index[0] << 6 | index[1] << 4 | index[2] << 2 | index[3]);
+	}
+}
+
+//tile holds the texels of one tile in row order, as fetchTile leaves them
+static void encodeTile(const uint32_t* tile, uint8_t format, uint8_t quality, uint8_t* _Out_ out)
+{
+	switch (format)
+	{
+	case 0xE://CMPR, 4 blocks: top left, top right, bottom left, bottom right
+		encodeCMPRBlock(tile, quality, out);
+		encodeCMPRBlock(tile + 4, quality, out + 8);
+		encodeCMPRBlock(tile + 32, quality, out + 16);
+		encodeCMPRBlock(tile + 36, quality, out + 24);
+		break;
+	case 0x5://RGB5A3
+	case 0x4://RGB565
+	case 0x3://IA8
+		for (int i = 0; i < 16; i += 8)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)(tile + i));
+			__m128i b = _mm_loadu_si128((const __m128i*)(tile + i + 4));
+			__m128i words = format == 0x5 ? packBigEndian16(encodeRGB5A3Texels(a), encodeRGB5A3Texels(b)) :
+				format == 0x4 ? packBigEndian16(encodeRGB565Texels(a), encodeRGB565Texels(b)) :
+				packBigEndian16(encodeIA8Texels(a), encodeIA8Texels(b));
+			_mm_storeu_si128((__m128i*)(out + i * 2), words);
+		}
+		break;
+	case 0x6://RGBA8, the alpha/red pairs of the 16 texels, then the green/blue pairs
+		for (int i = 0; i < 16; i += 8)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)(tile + i));
+			__m128i b = _mm_loadu_si128((const __m128i*)(tile + i + 4));
+			_mm_storeu_si128((__m128i*)(out + i * 2), packBigEndian16(encodeAlphaRedTexels(a), encodeAlphaRedTexels(b)));
+			_mm_storeu_si128((__m128i*)(out + 32 + i * 2), packBigEndian16(encodeGreenBlueTexels(a), encodeGreenBlueTexels(b)));
+		}
+		break;
+	case 0x1://I8
+		for (int i = 0; i < 32; i += 16)
+		{
+			const __m128i* texels = (const __m128i*)(tile + i);
+			_mm_storeu_si128((__m128i*)(out + i), packBytes(
+				getTexelIntensity(_mm_loadu_si128(texels)), getTexelIntensity(_mm_loadu_si128(texels + 1)),
+				getTexelIntensity(_mm_loadu_si128(texels + 2)), getTexelIntensity(_mm_loadu_si128(texels + 3))));
+		}
+		break;
+	case 0x2://IA4
+		for (int i = 0; i < 32; i += 16)
+		{
+			const __m128i* texels = (const __m128i*)(tile + i);
+			_mm_storeu_si128((__m128i*)(out + i), packBytes(
+				encodeIA4Texels(_mm_loadu_si128(texels)), encodeIA4Texels(_mm_loadu_si128(texels + 1)),
+				encodeIA4Texels(_mm_loadu_si128(texels + 2)), encodeIA4Texels(_mm_loadu_si128(texels + 3))));
+		}
+		break;
+	case 0x0://I4, two texels a byte, the first in the high nibble
+		for (int i = 0; i < 64; i += 32)
+		{
+			__m128i pairs[2];
+			for (int half = 0; half < 2; half++)
+			{
+				const __m128i* texels = (const __m128i*)(tile + i + half * 16);
+				__m128i bytes = packBytes(
+					encodeI4Texels(_mm_loadu_si128(texels)), encodeI4Texels(_mm_loadu_si128(texels + 1)),
+					encodeI4Texels(_mm_loadu_si128(texels + 2)), encodeI4Texels(_mm_loadu_si128(texels + 3)));
+				pairs[half] = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(bytes, _mm_set1_epi16(0xFF)), 4), _mm_srli_epi16(bytes, 8));
+			}
+			_mm_storeu_si128((__m128i*)(out + i / 2), _mm_packus_epi16(pairs[0], pairs[1]));
+		}
+		break;
+	}
+}
+
+struct textureEncoding
+{
+	const uint32_t* pixels;
+	uint8_t* out;
+	uint32_t width;
+	uint32_t height;
+	uint32_t tileWidth;
+	uint32_t tileHeight;
+	uint32_t tileSize;
+	uint32_t tilesWide;
+	uint32_t tilesHigh;
+	uint32_t rowsPerBand;
+	uint8_t format;
+	uint8_t quality;
+};
+
+static void encodeTextureBandJob(int band, int threadIndex, void* context)
+{
+	const struct textureEncoding* encoding = context;
+	alignas(16) uint32_t tile[64];
+
+	uint32_t firstRow = band * encoding->rowsPerBand;
+	uint32_t endRow = min(firstRow + encoding->rowsPerBand, encoding->tilesHigh);
+	uint8_t* out = encoding->out + (size_t)firstRow * encoding->tilesWide * encoding->tileSize;
+	for (uint32_t tileY = firstRow; tileY < endRow; tileY++)
+	{
+		for (uint32_t tileX = 0; tileX < encoding->tilesWide; tileX++, out += encoding->tileSize)
+		{
+			fetchTile(encoding->pixels, encoding->width, encoding->height, tileX * encoding->tileWidth, tileY * encoding->tileHeight, encoding->tileWidth, encoding->tileHeight, tile);
+			encodeTile(tile, encoding->format, encoding->quality, out);
+		}
+	}
+}
+
+/*
+* encodes width x height rgba pixels (decodeTexture layout) as one level of a GX texture, pixelsOut must hold getTextureDataSize bytes.
+* returns the size written, 0 for formats decodeTexture can't read back.
+* multithreaded spreads bands of tile rows over all cores, batch callers encode one texture per thread instead.
+*/
+uint32_t encodeTexture(uint32_t width, uint32_t height, const uint8_t* _In_ pixelsIn, uint8_t* _Out_ pixelsOut, const uint8_t format, uint8_t quality, bool multithreaded)
+{
+	struct textureEncoding encoding = { (const uint32_t*)pixelsIn, pixelsOut, width, height };
+	uint32_t bitsPerPixel;
+	if (!isDecodableTextureFormat(format) || width == 0 || height == 0 || !getTextureTileLayout(format, &encoding.tileWidth, &encoding.tileHeight, &bitsPerPixel))
+		return 0;
+
+	TRACE_BEGIN(encodeSpan);
+	encoding.tileSize = encoding.tileWidth * encoding.tileHeight * bitsPerPixel / 8;
+	encoding.tilesWide = (width + encoding.tileWidth - 1) / encoding.tileWidth;
+	encoding.tilesHigh = (height + encoding.tileHeight - 1) / encoding.tileHeight;
+	encoding.format = format;
+	encoding.quality = quality;
+
+	//bands of at least 64 tiles, thread startup costs more than encoding fewer
+	uint32_t bandCount = 1;
+	if (multithreaded)
+		bandCount = min(min(encoding.tilesHigh, max(encoding.tilesWide * encoding.tilesHigh / 64, 1)), (uint32_t)getThreadCount() * 4);
+	encoding.rowsPerBand = (encoding.tilesHigh + bandCount - 1) / bandCount;
+	bandCount = (encoding.tilesHigh + encoding.rowsPerBand - 1) / encoding.rowsPerBand;
+
+	if (bandCount > 1)
+		runParallel(bandCount, encodeTextureBandJob, &encoding);
+	else
+		encodeTextureBandJob(0, 0, &encoding);
+	TRACE_END(encodeSpan, "encodeTexture");
+	return encoding.tilesWide * encoding.tilesHigh * encoding.tileSize;
+}
+
+/*
+* QOI and PNG encoders for decodedImage (rgba) outputs.
+* all buffers come from an imageEncoder that only grows, nothing is allocated per row or per image once it's warm.
+*/
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xC0
+#define QOI_OP_RGB 0xFE
+#define QOI_OP_RGBA 0xFF
+
+size_t getQOIBound(const struct decodedImage* image)
+{
+	return (size_t)image->pixelCount * 5 + 14 + 8;
+}
+
+//out must hold getQOIBound bytes, returns the file size
+size_t encodeQOI(const struct decodedImage* image, uint8_t* _Out_ out)
+{
+	uint8_t* o = out;
+	memcpy(o, "qoif", 4);
+	o[4] = (uint8_t)(image->width >> 24); o[5] = (uint8_t)(image->width >> 16); o[6] = (uint8_t)(image->width >> 8); o[7] = (uint8_t)image->width;
+	o[8] = (uint8_t)(image->height >> 24); o[9] = (uint8_t)(image->height >> 16); o[10] = (uint8_t)(image->height >> 8); o[11] = (uint8_t)image->height;
+	o[12] = 4;//channels
+	o[13] = 0;//srgb with linear alpha
+	o += 14;
+
+	uint32_t index[64] = { 0 };
+	const uint32_t* pixels = image->pixels;
+	uint32_t previous = 0xFF000000;
+	uint32_t run = 0;
+
+	for (uint32_t i = 0; i < image->pixelCount; i++)
+	{
+		uint32_t pixel = pixels[i];
+		if (pixel == previous)
+		{
+			run++;
+			if (run == 62 || i + 1 == image->pixelCount)
+			{
+				*o++ = QOI_OP_RUN | (uint8_t)(run - 1);
+				run = 0;
+			}
+			continue;
+		}
+
+		if (run > 0)
+		{
+			*o++ = QOI_OP_RUN | (uint8_t)(run - 1);
+			run = 0;
+		}
+
+		uint8_t r = (uint8_t)pixel, g = (uint8_t)(pixel >> 8), b = (uint8_t)(pixel >> 16), a = (uint8_t)(pixel >> 24);
+		uint32_t hash = (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+		if (index[hash] == pixel)
+		{
+			*o++ = QOI_OP_INDEX | (uint8_t)hash;
+		}
+		else
+		{
+			index[hash] = pixel;
+			if (a == (uint8_t)(previous >> 24))
+			{
+				int8_t dr = (int8_t)(r - (uint8_t)previous);
+				int8_t dg = (int8_t)(g - (uint8_t)(previous >> 8));
+				int8_t db = (int8_t)(b - (uint8_t)(previous >> 16));
+				int8_t drg = dr - dg;
+				int8_t dbg = db - dg;
+
+				if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+				{
+					*o++ = QOI_OP_DIFF | (uint8_t)((dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+				}
+				else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7)
+				{
+					*o++ = QOI_OP_LUMA | (uint8_t)(dg + 32);
+					*o++ = (uint8_t)((drg + 8) << 4 | (dbg + 8));
+				}
+				else
+				{
+					*o++ = QOI_OP_RGB;
+					*o++ = r;
+					*o++ = g;
+					*o++ = b;
+				}
+			}
+			else
+			{
+				*o++ = QOI_OP_RGBA;
+				*o++ = r;
+				*o++ = g;
+				*o++ = b;
+				*o++ = a;
+			}
+		}
+		previous = pixel;
+	}
+
+	static const uint8_t end[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+	memcpy(o, end, sizeof(end));
+	return o + sizeof(end) - out;
+}
+
+/*
+* deflate with the fixed huffman code and greedy single probe LZ77.
+* the filtered image is split into row chunks that are compressed independently (and in parallel when asked),
+* every chunk but the last ends in an empty stored block so they can be concatenated like pigz does.
+*/
+#define DEFLATE_HASH_BITS 15
+#define DEFLATE_WINDOW_SIZE 32768
+#define PNG_CHUNK_TARGET_SIZE (1024 * 256)
+
+static uint16_t fixedLiteralCodes[288];//bit reversed, ready to be written lsb first
+static uint8_t fixedLiteralLengths[288];
+static uint32_t crcTable[256];
+
+void initDeflateTables()
+{
+	for (uint32_t symbol = 0; symbol < 288; symbol++)
+	{
+		uint32_t code, length;
+		if (symbol < 144) { code = 0x30 + symbol; length = 8; }
+		else if (symbol < 256) { code = 0x190 + symbol - 144; length = 9; }
+		else if (symbol < 280) { code = symbol - 256; length = 7; }
+		else { code = 0xC0 + symbol - 280; length = 8; }
+
+		uint32_t reversed = 0;
+		for (uint32_t bit = 0; bit < length; bit++)
+			reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+		fixedLiteralCodes[symbol] = (uint16_t)reversed;
+	}
+
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		uint32_t crc = i;
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		crcTable[i] = crc;
+	}
+
+	//written last, it's what the lazy init checks
+	for (uint32_t symbol = 0; symbol < 288; symbol++)
+		fixedLiteralLengths[symbol] = symbol < 144 ? 8 : symbol < 256 ? 9 : symbol < 280 ? 7 : 8;
+}
+
+uint32_t updateCrc32(uint32_t crc, const uint8_t* data, size_t size)
+{
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+uint32_t updateAdler32(uint32_t adler, const uint8_t* data, size_t size)
+{
+	uint32_t a = adler & 0xFFFF;
+	uint32_t b = adler >> 16;
+	while (size > 0)
+	{
+		//5552 is the most bytes that can be summed before b overflows
+		size_t blockSize = min(size, 5552);
+		size -= blockSize;
+		for (size_t i = 0; i < blockSize; i++)
+		{
+			a += data[i];
+			b += a;
+		}
+		data += blockSize;
+		a %= 65521;
+		b %= 65521;
+	}
+	return a | (b << 16);
+}
+
+//adler32 of two concatenated buffers from their separate checksums (the second one is secondSize bytes)
+uint32_t combineAdler32(uint32_t first, uint32_t second, size_t secondSize)
+{
+	const uint32_t base = 65521;
+	uint32_t remainder = (uint32_t)(secondSize % base);
+	uint32_t sum1 = first & 0xFFFF;
+	uint32_t sum2 = (uint32_t)(((uint64_t)remainder * sum1) % base);
+	sum1 += (second & 0xFFFF) + base - 1;
+	sum2 += ((first >> 16) & 0xFFFF) + ((second >> 16) & 0xFFFF) + base - remainder;
+	if (sum1 >= base) sum1 -= base;
+	if (sum1 >= base) sum1 -= base;
+	if (sum2 >= (base << 1)) sum2 -= (base << 1);
+	if (sum2 >= base) sum2 -= base;
+	return sum1 | (sum2 << 16);
+}
+
+struct deflateBitWriter
+{
+	uint8_t* out;
+	uint64_t bits;
+	uint32_t bitCount;
+};
+
+static inline void writeDeflateBits(struct deflateBitWriter* writer, uint32_t value, uint32_t count)
+{
+	writer->bits |= (uint64_t)value << writer->bitCount;
+	writer->bitCount += count;
+	while (writer->bitCount >= 8)
+	{
+		*writer->out++ = (uint8_t)writer->bits;
+		writer->bits >>= 8;
+		writer->bitCount -= 8;
+	}
+}
+
+static inline void writeDeflateSymbol(struct deflateBitWriter* writer, uint32_t symbol)
+{
+	writeDeflateBits(writer, fixedLiteralCodes[symbol], fixedLiteralLengths[symbol]);
+}
+
+static void writeDeflateMatch(struct deflateBitWriter* writer, uint32_t length, uint32_t distance)
+{
+	uint32_t x = length - 3;
+	if (length == 258)
+	{
+		writeDeflateSymbol(writer, 285);
+	}
+	else if (x < 8)
+	{
+		writeDeflateSymbol(writer, 257 + x);
+	}
+	else
+	{
+		unsigned long highBit;
+		_BitScanReverse(&highBit, x);
+		uint32_t extraBits = highBit - 2;
+		writeDeflateSymbol(writer, 257 + 4 * (highBit - 1) + ((x >> extraBits) & 3));
+		writeDeflateBits(writer, x & ((1 << extraBits) - 1), extraBits);
+	}
+
+	//distance codes are 5 bit fixed codes, bit reversed
+	uint32_t code;
+	uint32_t extraBits = 0;
+	x = distance - 1;
+	if (x < 4)
+	{
+		code = x;
+	}
+	else
+	{
+		unsigned long highBit;
+		_BitScanReverse(&highBit, x);
+		extraBits = highBit - 1;
+		code = 2 * highBit + ((x >> extraBits) & 1);
+	}
+	uint32_t reversed = ((code & 1) << 4) | ((code & 2) << 2) | (code & 4) | ((code & 8) >> 2) | ((code & 16) >> 4);
+	writeDeflateBits(writer, reversed, 5);
+	if (extraBits > 0)
+		writeDeflateBits(writer, x & ((1 << extraBits) - 1), extraBits);
+}
+
+//worst case: every byte a 9 bit literal, plus block headers and the flush
+size_t getDeflateBound(size_t size)
+{
+	return size + size / 8 + 16;
+}
+
+//compresses one chunk as a fixed huffman block, returns the compressed size
+size_t deflateChunk(const uint8_t* _In_ in, size_t size, bool last, uint32_t* hashTable, uint8_t* _Out_ out)
+{
+	struct deflateBitWriter writer = { out, 0, 0 };
+	writeDeflateBits(&writer, last ? 1 : 0, 1);
+	writeDeflateBits(&writer, 1, 2);
+
+	memset(hashTable, 0, sizeof(uint32_t) << DEFLATE_HASH_BITS);
+
+	size_t i = 0;
+	while (i + 4 <= size)
+	{
+		uint32_t sequence;
+		memcpy(&sequence, in + i, 4);
+		uint32_t hash = (sequence * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+		//positions are stored + 1 so 0 means empty
+		size_t candidate = hashTable[hash];
+		hashTable[hash] = (uint32_t)i + 1;
+
+		uint32_t candidateSequence;
+		if (candidate != 0 && i + 1 - candidate <= DEFLATE_WINDOW_SIZE && (memcpy(&candidateSequence, in + candidate - 1, 4), candidateSequence == sequence))
+		{
+			candidate--;
+			size_t length = 4;
+			size_t maxLength = min(size - i, 258);
+			while (length < maxLength && in[candidate + length] == in[i + length])
+				length++;
+
+			writeDeflateMatch(&writer, (uint32_t)length, (uint32_t)(i - candidate));
+			i += length;
+		}
+		else
+		{
+			writeDeflateSymbol(&writer, in[i]);
+			i++;
+		}
+	}
+	for (; i < size; i++)
+		writeDeflateSymbol(&writer, in[i]);
+
+	writeDeflateSymbol(&writer, 256);
+
+	if (!last)
+	{
+		//empty stored block: byte aligns the stream so the next chunk can start on a fresh byte
+		writeDeflateBits(&writer, 0, 3);
+		writeDeflateBits(&writer, 0, (8 - writer.bitCount) & 7);
+		writeDeflateBits(&writer, 0x0000, 16);
+		writeDeflateBits(&writer, 0xFFFF, 16);
+	}
+	else if (writer.bitCount > 0)
+	{
+		writeDeflateBits(&writer, 0, 8 - writer.bitCount);
+	}
+
+	return writer.out - out;
+}
+
+static inline uint8_t paethPredictor(int a, int b, int c)
+{
+	int p = a + b - c;
+	int pa = abs(p - a);
+	int pb = abs(p - b);
+	int pc = abs(p - c);
+	return (uint8_t)((pa <= pb && pa <= pc) ? a : pb <= pc ? b : c);
+}
+
+//filters one row with every PNG filter and keeps the one with the smallest sum of absolute values
+static void filterPngRow(const uint8_t* row, const uint8_t* previousRow, uint32_t rowSize, uint8_t* _Out_ out, uint8_t* _Out_ scratch)
+{
+	uint32_t bestSum = UINT32_MAX;
+	uint8_t filterCount = previousRow ? 5 : 2;
+
+	for (uint8_t filter = 0; filter < filterCount; filter++)
+	{
+		//none goes straight into out, the others only get copied over it when they win
+		uint8_t* target = filter == 0 ? out + 1 : scratch;
+		uint32_t sum = 0;
+		for (uint32_t i = 0; i < rowSize; i++)
+		{
+			int left = i >= 4 ? row[i - 4] : 0;
+			int up = previousRow ? previousRow[i] : 0;
+			int upLeft = (previousRow && i >= 4) ? previousRow[i - 4] : 0;
+			uint8_t value;
+			switch (filter)
+			{
+			case 0: value = row[i]; break;
+			case 1: value = (uint8_t)(row[i] - left); break;
+			case 2: value = (uint8_t)(row[i] - up); break;
+			case 3: value = (uint8_t)(row[i] - ((left + up) >> 1)); break;
+			default: value = (uint8_t)(row[i] - paethPredictor(left, up, upLeft)); break;
+			}
+			target[i] = value;
+			sum += value < 128 ? value : 256 - value;
+		}
+
+		if (sum < bestSum)
+		{
+			bestSum = sum;
+			out[0] = filter;
+			if (filter != 0)
+				memcpy(out + 1, scratch, rowSize);
+		}
+	}
+}
+
+struct pngChunk
+{
+	uint32_t firstRow;
+	uint32_t rowCount;
+	size_t compressedSize;
+	uint32_t adler;
+};
+
+struct imageEncoder
+{
+	//grown on demand, never shrunk
+	uint8_t* filtered;
+	size_t filteredCapacity;
+	uint8_t* compressed;
+	size_t compressedCapacity;
+	uint8_t* output;
+	size_t outputCapacity;
+	uint32_t* hashTables;
+	uint8_t* rowScratch;
+	uint32_t hashTableCount;
+	uint32_t rowScratchSize;
+
+	struct pngChunk chunks[512];
+	uint32_t chunkCount;
+	size_t chunkCapacity;//compressed bytes reserved per chunk
+	const struct decodedImage* image;
+};
+
+//false if the buffer can't grow, it is left as it was
+static bool growEncoderBuffer(uint8_t** buffer, size_t* capacity, size_t size)
+{
+	if (size > *capacity)
+	{
+		size_t grownCapacity = max(size, *capacity * 2);
+		uint8_t* grown = realloc(*buffer, grownCapacity);
+		if (grown == nullptr)
+			return false;
+		*buffer = grown;
+		*capacity = grownCapacity;
+	}
+	return true;
+}
+
+static void encodePngChunkJob(int chunkIndex, int threadIndex, void* context)
+{
+	struct imageEncoder* encoder = context;
+	struct pngChunk* chunk = &encoder->chunks[chunkIndex];
+	const struct decodedImage* image = encoder->image;
+	uint32_t rowSize = image->width * 4;
+
+	uint8_t* filtered = encoder->filtered + (size_t)chunk->firstRow * (rowSize + 1);
+	uint8_t* scratch = encoder->rowScratch + (size_t)threadIndex * rowSize;
+	for (uint32_t y = chunk->firstRow; y < chunk->firstRow + chunk->rowCount; y++)
+	{
+		const uint8_t* row = OffsetPointer((const uint8_t*)image->pixels, (size_t)y * rowSize);
+		filterPngRow(row, y > 0 ? row - rowSize : nullptr, rowSize, filtered + (size_t)(y - chunk->firstRow) * (rowSize + 1), scratch);
+	}
+
+	size_t filteredSize = (size_t)chunk->rowCount * (rowSize + 1);
+	chunk->adler = updateAdler32(1, filtered, filteredSize);
+	chunk->compressedSize = deflateChunk(
+		filtered,
+		filteredSize,
+		chunkIndex + 1 == encoder->chunkCount,
+		encoder->hashTables + ((size_t)threadIndex << DEFLATE_HASH_BITS),
+		encoder->compressed + chunkIndex * encoder->chunkCapacity);
+}
+
+static uint8_t* writePngChunkHeader(uint8_t* out, uint32_t size, const char* type)
+{
+	out[0] = (uint8_t)(size >> 24); out[1] = (uint8_t)(size >> 16); out[2] = (uint8_t)(size >> 8); out[3] = (uint8_t)size;
+	memcpy(out + 4, type, 4);
+	return out + 8;
+}
+
+static uint8_t* writeBigEndian32(uint8_t* out, uint32_t value)
+{
+	out[0] = (uint8_t)(value >> 24); out[1] = (uint8_t)(value >> 16); out[2] = (uint8_t)(value >> 8); out[3] = (uint8_t)value;
+	return out + 4;
+}
+
+/*
+* encodes an rgba image as PNG into encoder->output, returns the file size (0 if the encoder's buffers can't grow).
+* multithreaded compresses the row chunks on all cores, batch callers encode one image per thread instead.
+*/
+size_t encodePNG(const struct decodedImage* image, struct imageEncoder* encoder, bool multithreaded)
+{
+	if (fixedLiteralLengths[287] == 0)
+		initDeflateTables();
+
+	uint32_t rowSize = image->width * 4;
+	uint32_t rowsPerChunk = max(PNG_CHUNK_TARGET_SIZE / (rowSize + 1), 1);
+	rowsPerChunk = max(rowsPerChunk, (image->height + countof(encoder->chunks) - 1) / countof(encoder->chunks));
+
+	encoder->image = image;
+	encoder->chunkCount = max((image->height + rowsPerChunk - 1) / rowsPerChunk, 1);
+	encoder->chunkCapacity = getDeflateBound((size_t)rowsPerChunk * (rowSize + 1));
+
+	uint32_t threadCount = multithreaded ? getThreadCount() : 1;
+	size_t filteredSize = (size_t)image->height * (rowSize + 1);
+	if (!growEncoderBuffer(&encoder->filtered, &encoder->filteredCapacity, filteredSize) ||
+		!growEncoderBuffer(&encoder->compressed, &encoder->compressedCapacity, encoder->chunkCapacity * encoder->chunkCount))
+		return 0;
+	if (encoder->hashTableCount < threadCount)
+	{
+		uint32_t* hashTables = realloc(encoder->hashTables, (sizeof(uint32_t) << DEFLATE_HASH_BITS) * threadCount);
+		if (hashTables == nullptr)
+			return 0;
+		encoder->hashTables = hashTables;
+		encoder->hashTableCount = threadCount;
+	}
+	if (encoder->rowScratchSize < rowSize * threadCount)
+	{
+		uint8_t* rowScratch = realloc(encoder->rowScratch, rowSize * threadCount);
+		if (rowScratch == nullptr)
+			return 0;
+		encoder->rowScratch = rowScratch;
+		encoder->rowScratchSize = rowSize * threadCount;
+	}
+
+	for (uint32_t i = 0; i < encoder->chunkCount; i++)
+	{
+		encoder->chunks[i].firstRow = i * rowsPerChunk;
+		encoder->chunks[i].rowCount = min(rowsPerChunk, image->height - i * rowsPerChunk);
+	}
+	if (image->height == 0)
+		encoder->chunks[0].rowCount = 0;
+
+	if (multithreaded)
+		runParallel(encoder->chunkCount, encodePngChunkJob, encoder);
+	else
+		for (uint32_t i = 0; i < encoder->chunkCount; i++)
+			encodePngChunkJob(i, 0, encoder);
+
+	size_t compressedSize = 0;
+	uint32_t adler = 1;
+	for (uint32_t i = 0; i < encoder->chunkCount; i++)
+	{
+		compressedSize += encoder->chunks[i].compressedSize;
+		adler = combineAdler32(adler, encoder->chunks[i].adler, (size_t)encoder->chunks[i].rowCount * (rowSize + 1));
+	}
+
+	//signature, IHDR, IDAT header, zlib header, data, adler, IDAT crc, IEND
+	size_t idatSize = 2 + compressedSize + 4;
+	if (!growEncoderBuffer(&encoder->output, &encoder->outputCapacity, 8 + 25 + 8 + idatSize + 4 + 12))
+		return 0;
+
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	uint8_t* o = encoder->output;
+	memcpy(o, signature, sizeof(signature));
+	o += sizeof(signature);
+
+	uint8_t* chunkStart = o + 4;
+	o = writePngChunkHeader(o, 13, "IHDR");
+	o = writeBigEndian32(o, image->width);
+	o = writeBigEndian32(o, image->height);
+	*o++ = 8;//bit depth
+	*o++ = 6;//rgba
+	*o++ = 0;
+	*o++ = 0;
+	*o++ = 0;
+	o = writeBigEndian32(o, updateCrc32(0, chunkStart, o - chunkStart));
+
+	chunkStart = o + 4;
+	o = writePngChunkHeader(o, (uint32_t)idatSize, "IDAT");
+	*o++ = 0x78;//deflate, 32k window
+	*o++ = 0x01;
+	for (uint32_t i = 0; i < encoder->chunkCount; i++)
+	{
+		memcpy(o, encoder->compressed + i * encoder->chunkCapacity, encoder->chunks[i].compressedSize);
+		o += encoder->chunks[i].compressedSize;
+	}
+	o = writeBigEndian32(o, adler);
+	o = writeBigEndian32(o, updateCrc32(0, chunkStart, o - chunkStart));
+
+	chunkStart = o + 4;
+	o = writePngChunkHeader(o, 0, "IEND");
+	o = writeBigEndian32(o, updateCrc32(0, chunkStart, 4));
+
+	return o - encoder->output;
+}
+
+//QOI goes through the same encoder buffers so batch callers can switch formats freely. 0 if the output can't grow
+size_t encodeQOIWithEncoder(const struct decodedImage* image, struct imageEncoder* encoder)
+{
+	if (!growEncoderBuffer(&encoder->output, &encoder->outputCapacity, getQOIBound(image)))
+		return 0;
+	return encodeQOI(image, encoder->output);
+}
+
+void freeImageEncoder(struct imageEncoder* encoder)
+{
+	free(encoder->filtered);
+	free(encoder->compressed);
+	free(encoder->output);
+	free(encoder->hashTables);
+	free(encoder->rowScratch);
+	memset(encoder, 0, sizeof(struct imageEncoder));
+}
+
+/*
+* J3D model parser
+* VTX1/EVP1/DRW1/JNT1/SHP1/MAT3 (+ the INF1 hierarchy for joint parents and shape materials)
+* are decoded into a j3dModel. vertices are interleaved and deduplicated per shape, triangles use 32 bit indices,
+* everything else is struct-of-arrays. all arrays are carved out of a caller provided workspace.
+*/
+
+struct matrix34
+{
+	float m[3][4];
+};
+
+static const struct matrix34 identityMatrix34 = { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 } } };
+
+//result may be a or b
+void multiplyMatrix34(const struct matrix34* a, const struct matrix34* b, struct matrix34* _Out_ result)
+{
+	//every result row is a weighted sum of the rows of b, plus a's translation
+	const __m128 b0 = _mm_loadu_ps(b->m[0]);
+	const __m128 b1 = _mm_loadu_ps(b->m[1]);
+	const __m128 b2 = _mm_loadu_ps(b->m[2]);
+	const __m128 b3 = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+
+	__m128 rows[3];
+	for (int row = 0; row < 3; row++)
+	{
+		__m128 r = _mm_mul_ps(_mm_set1_ps(a->m[row][0]), b0);
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a->m[row][1]), b1));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a->m[row][2]), b2));
+		rows[row] = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a->m[row][3]), b3));
+	}
+
+	_mm_storeu_ps(result->m[0], rows[0]);
+	_mm_storeu_ps(result->m[1], rows[1]);
+	_mm_storeu_ps(result->m[2], rows[2]);
+}
+
+//J3D joints are scaled, then rotated around x, y, z, then translated
+void composeJointMatrix(const float scale[3], const float rotation[3], const float translation[3], struct matrix34* _Out_ result)
+{
+	float sx = sinf(rotation[0]), cx = cosf(rotation[0]);
+	float sy = sinf(rotation[1]), cy = cosf(rotation[1]);
+	float sz = sinf(rotation[2]), cz = cosf(rotation[2]);
+
+	result->m[0][0] = cz * cy * scale[0];
+	result->m[0][1] = (cz * sy * sx - sz * cx) * scale[1];
+	result->m[0][2] = (cz * sy * cx + sz * sx) * scale[2];
+	result->m[0][3] = translation[0];
+
+	result->m[1][0] = sz * cy * scale[0];
+	result->m[1][1] = (sz * sy * sx + cz * cx) * scale[1];
+	result->m[1][2] = (sz * sy * cx - cz * sx) * scale[2];
+	result->m[1][3] = translation[1];
+
+	result->m[2][0] = -sy * scale[0];
+	result->m[2][1] = cy * sx * scale[1];
+	result->m[2][2] = cy * cx * scale[2];
+	result->m[2][3] = translation[2];
+}
+
+/*
+* bump allocator over a caller owned buffer, like decodedAssetFreeZone.
+* allocations are 16 byte aligned, failed is set instead of returning nullptr so callers can check once at the end.
+*/
+struct workspaceAllocator
+{
+	uint8_t* next;
+	uint8_t* end;
+	bool failed;
+};
+
+void initWorkspaceAllocator(struct workspaceAllocator* allocator, void* workspace, size_t workspaceSize)
+{
+	allocator->next = workspace;
+	allocator->end = OffsetPointer((uint8_t*)workspace, workspaceSize);
+	allocator->failed = false;
+}
+
+void* workspaceAlloc(struct workspaceAllocator* allocator, size_t size)
+{
+	uint8_t* aligned = (uint8_t*)(((uintptr_t)allocator->next + 15) & ~(uintptr_t)15);
+	if (allocator->failed || size > (size_t)(allocator->end - aligned))
+	{
+		allocator->failed = true;
+		//a valid dummy pointer so callers don't need to branch, the result is discarded anyway
+		static uint8_t failedAllocation[64];
+		return failedAllocation;
+	}
+	allocator->next = aligned + size;
+	return aligned;
+}
+
+#define workspaceAllocArray(allocator, type, count) ((type*)workspaceAlloc((allocator), sizeof(type) * (size_t)(count)))
+
+/*
+* chunk layouts
+*/
+struct INF1
+{
+	char chunkType[4];
+	int32_t size;
+	int16_t miscFlags;
+	int16_t padding;
+	int32_t matrixGroupCount;
+	int32_t vertexCount;
+	int32_t hierarchyDataOffset;
+};
+
+struct hierarchyNode
+{
+	short NodeType;
+	short Data;
+};
+
+//INF1 node types, 0x00 ends the hierarchy and 0x01/0x02 open and close a level
+#define J3D_NODE_JOINT 0x10
+#define J3D_NODE_MATERIAL 0x11
+#define J3D_NODE_SHAPE 0x12
+
+//GX vertex attributes
+#define GX_VA_PNMTXIDX 0
+#define GX_VA_TEX7MTXIDX 8
+#define GX_VA_POS 9
+#define GX_VA_NRM 10
+#define GX_VA_CLR0 11
+#define GX_VA_CLR1 12
+#define GX_VA_TEX0 13
+#define GX_VA_TEX7 20
+#define GX_VA_NULL 0xFF
+
+//GX vertex descriptor types
+#define GX_NONE 0
+#define GX_DIRECT 1
+#define GX_INDEX8 2
+#define GX_INDEX16 3
+
+//GX primitives
+#define GX_TRIANGLES 0x90
+#define GX_TRIANGLESTRIP 0x98
+#define GX_TRIANGLEFAN 0xA0
+
+struct VTX1
+{
+	char chunkType[4];
+	int32_t size;
+	uint32_t formatOffset;
+	//positions, normals, nbt, color0, color1, tex0-7
+	uint32_t dataOffsets[13];
+};
+
+struct vertexFormat
+{
+	uint32_t attribute;
+	uint32_t componentCount;
+	uint32_t componentType;
+	uint8_t fractionalBits;
+	uint8_t padding[3];
+};
+
+struct EVP1
+{
+	char chunkType[4];
+	int32_t size;
+	uint16_t envelopeCount;
+	uint16_t padding;
+	uint32_t weightCountOffset;
+	uint32_t jointIndexOffset;
+	uint32_t weightOffset;
+	uint32_t inverseBindMatrixOffset;
+};
+
+struct DRW1
+{
+	char chunkType[4];
+	int32_t size;
+	uint16_t count;
+	uint16_t padding;
+	uint32_t isWeightedOffset;
+	uint32_t indexOffset;
+};
+
+struct JNT1
+{
+	char chunkType[4];
+	int32_t size;
+	uint16_t jointCount;
+	uint16_t padding;
+	uint32_t jointDataOffset;
+	uint32_t remapOffset;
+	uint32_t nameTableOffset;
+};
+
+struct jointData
+{
+	uint16_t matrixType;
+	uint8_t inheritScale;
+	uint8_t padding1;
+	float scale[3];
+	int16_t rotation[3];
+	uint16_t padding2;
+	float translation[3];
+	float boundingRadius;
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+struct SHP1
+{
+	char chunkType[4];
+	int32_t size;
+	uint16_t shapeCount;
+	uint16_t padding;
+	uint32_t shapeDataOffset;
+	uint32_t remapOffset;
+	uint32_t nameTableOffset;
+	uint32_t vertexDescriptorOffset;
+	uint32_t matrixTableOffset;
+	uint32_t displayListOffset;
+	uint32_t matrixDataOffset;
+	uint32_t packetOffset;
+};
+
+struct shapeData
+{
+	uint8_t matrixType;
+	uint8_t padding1;
+	uint16_t packetCount;
+	uint16_t vertexDescriptorOffset;
+	uint16_t firstMatrixData;
+	uint16_t firstPacket;
+	uint16_t padding2;
+	float boundingRadius;
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+struct vertexDescriptor
+{
+	uint32_t attribute;
+	uint32_t type;
+};
+
+struct shapeMatrixData
+{
+	uint16_t useMatrixIndex;
+	uint16_t matrixCount;
+	uint32_t firstMatrixIndex;
+};
+
+struct shapePacket
+{
+	uint32_t displayListSize;
+	uint32_t displayListOffset;
+};
+
+struct MAT3
+{
+	char chunkType[4];
+	int32_t size;
+	uint16_t materialCount;
+	uint16_t padding;
+	uint32_t materialDataOffset;
+	uint32_t remapOffset;
+	uint32_t nameTableOffset;
+	uint32_t indirectOffset;
+	uint32_t cullModeOffset;
+	uint32_t materialColorOffset;
+	uint32_t colorChannelCountOffset;
+	uint32_t colorChannelOffset;
+	uint32_t ambientColorOffset;
+	uint32_t lightOffset;
+	uint32_t texGenCountOffset;
+	uint32_t texCoordOffset;
+	uint32_t texCoord2Offset;
+	uint32_t texMatrixOffset;
+	uint32_t postTexMatrixOffset;
+	uint32_t textureRemapOffset;
+	uint32_t tevOrderOffset;
+	uint32_t tevColorOffset;
+	uint32_t tevKColorOffset;
+	uint32_t tevStageCountOffset;
+	uint32_t tevStageOffset;
+	uint32_t tevSwapModeOffset;
+	uint32_t tevSwapModeTableOffset;
+	uint32_t fogOffset;
+	uint32_t alphaCompareOffset;
+	uint32_t blendModeOffset;
+	uint32_t zModeOffset;
+	uint32_t zCompareLocationOffset;
+	uint32_t ditherOffset;
+	uint32_t nbtScaleOffset;
+};
+
+struct materialData
+{
+	uint8_t flag;
+	uint8_t cullModeIndex;
+	uint8_t colorChannelCountIndex;
+	uint8_t texGenCountIndex;
+	uint8_t tevStageCountIndex;
+	uint8_t zCompareLocationIndex;
+	uint8_t zModeIndex;
+	uint8_t ditherIndex;
+	int16_t materialColorIndex[2];
+	int16_t colorChannelIndex[4];
+	int16_t ambientColorIndex[2];
+	int16_t lightIndex[8];
+	int16_t texGenIndex[8];
+	int16_t postTexGenIndex[8];
+	int16_t texMatrixIndex[10];
+	int16_t postTexMatrixIndex[20];
+	int16_t textureIndex[8];
+	int16_t tevKColorIndex[4];
+	uint8_t tevKColorSelect[16];
+	uint8_t tevKAlphaSelect[16];
+	int16_t tevOrderIndex[16];
+	int16_t tevColorIndex[4];
+	int16_t tevStageIndex[16];
+	int16_t tevSwapModeIndex[16];
+	int16_t tevSwapModeTableIndex[4];
+	int16_t unknownIndices[12];
+	int16_t fogIndex;
+	int16_t alphaCompareIndex;
+	int16_t blendModeIndex;
+	int16_t nbtScaleIndex;
+};
+
+//J3D name tables: count, then (hash, offset from the table) pairs, then the strings
+//returns the table at offset in chunk if its entries and every string end inside the chunk, nullptr otherwise (or if offset is 0)
+const void* getJ3DNameTable(const void* chunk, uint32_t offset)
+{
+	uint32_t chunkSize = SwapEndian(((const struct bmdSection*)chunk)->size);
+	if (offset == 0 || !isRangeInside(offset, 4, chunkSize))
+		return nullptr;
+
+	const uint8_t* table = OffsetPointer((const uint8_t*)chunk, offset);
+	uint32_t tableSize = chunkSize - offset;
+	uint32_t count = SwapEndian(*(const uint16_t*)table);
+	if (4 + (uint64_t)count * 4 > tableSize)
+		return nullptr;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint16_t nameOffset = SwapEndian(*(const uint16_t*)(table + 4 + i * 4 + 2));
+		if (nameOffset >= tableSize || memchr(table + nameOffset, 0, tableSize - nameOffset) == nullptr)
+			return nullptr;
+	}
+	return table;
+}
+
+//how many elements of elementSize fit between offset and the end of the chunk
+static inline uint32_t getJ3DTableCapacity(const void* chunk, uint32_t offset, uint32_t elementSize)
+{
+	uint32_t chunkSize = SwapEndian(((const struct bmdSection*)chunk)->size);
+	return offset < chunkSize ? (chunkSize - offset) / elementSize : 0;
+}
+
+//nameTable comes from getJ3DNameTable
+const char* getJ3DName(const void* nameTable, uint32_t index)
+{
+	if (nameTable == nullptr || index >= SwapEndian(*(const uint16_t*)nameTable))
+		return "";
+	uint16_t offset = SwapEndian(*(const uint16_t*)OffsetPointer(nameTable, 4 + index * 4 + 2));
+	return OffsetPointer((const char*)nameTable, offset);
+}
+
+/*
+* the parsed model
+*/
+struct j3dVertex
+{
+	float position[3];
+	float normal[3];
+	uint8_t color[4];
+	float texCoord[2];
+};
+
+#define J3D_MAX_TEXTURES_PER_MATERIAL 8
+
+struct j3dModel
+{
+	//interleaved vertex buffer, positions and normals are in bind pose model space
+	uint32_t vertexCount;
+	struct j3dVertex* vertices;
+	uint16_t* vertexDrawMatrices;//DRW1 index per vertex, for skinning
+
+	uint32_t indexCount;
+	uint32_t* indices;//triangle list
+
+	uint32_t shapeCount;
+	uint32_t* shapeFirstIndex;
+	uint32_t* shapeIndexCount;
+	int16_t* shapeMaterials;//-1 if the hierarchy never assigns one
+	float* shapeBoundingRadius;
+	float* shapeBounds;//min xyz, max xyz
+
+	//the INF1 hierarchy flattened in traversal order, a node always comes after its parent
+	uint32_t nodeCount;
+	uint8_t* nodeTypes;//J3D_NODE_*
+	uint16_t* nodeIndices;//joint, material or shape index
+	int32_t* nodeParents;//node index, -1 for roots
+
+	//joints parent first (jointCount of them, joints INF1 never mentions are added as roots), materials and shapes in traversal order
+	uint16_t* hierarchyJoints;
+	uint32_t hierarchyMaterialCount;
+	uint16_t* hierarchyMaterials;
+	uint32_t hierarchyShapeCount;
+	uint16_t* hierarchyShapes;
+
+	uint32_t jointCount;
+	const char** jointNames;
+	int16_t* jointParents;//-1 for roots
+	float* jointScales;//xyz per joint
+	float* jointRotations;//radians, xyz per joint
+	float* jointTranslations;//xyz per joint
+	struct matrix34* jointWorldMatrices;//bind pose
+	struct matrix34* inverseBindMatrices;//from EVP1, identity if the model has no envelopes
+
+	uint32_t envelopeCount;
+	uint8_t* envelopeWeightCounts;
+	uint32_t* envelopeFirstWeights;
+	uint16_t* envelopeJoints;
+	float* envelopeWeights;
+
+	uint32_t drawMatrixCount;
+	uint8_t* drawMatrixWeighted;
+	uint16_t* drawMatrixIndices;//joint if not weighted, envelope if weighted
+
+	uint32_t materialCount;
+	const char** materialNames;
+	uint8_t* materialCullModes;//GX cull mode: 0 none, 1 front, 2 back, 3 all
+	uint32_t* materialColors;//rgba8
+	int16_t* materialTextures;//J3D_MAX_TEXTURES_PER_MATERIAL TEX1 indices per material, -1 if unused
+
+	const struct TEX1* textures;//points into the file, nullptr for bdl files without one
+
+	uint32_t skippedChunkCount;
+	size_t workspaceUsed;//bytes at the start of the workspace the arrays take, the rest is free for the caller
+};
+
+//reads one component of a VTX1 array, applying the fixed point scale
+static inline float readVertexComponent(const uint8_t* data, uint32_t componentType, float scale)
+{
+	switch (componentType)
+	{
+	case 0://u8
+		return *data * scale;
+	case 1://s8
+		return *(const int8_t*)data * scale;
+	case 2://u16
+		return (uint16_t)SwapEndian(*(const uint16_t*)data) * scale;
+	case 3://s16
+		return (int16_t)SwapEndian(*(const uint16_t*)data) * scale;
+	default://f32
+		return IntAsFloat(SwapEndian(*(const uint32_t*)data));
+	}
+}
+
+static inline uint32_t getVertexComponentSize(uint32_t componentType)
+{
+	static const uint8_t sizes[] = { 1, 1, 2, 2, 4 };
+	return componentType < countof(sizes) ? sizes[componentType] : 4;
+}
+
+struct vertexArray
+{
+	const uint8_t* data;
+	uint32_t count;//elements
+	uint32_t stride;
+	uint32_t componentCount;
+	uint32_t componentType;
+	float scale;
+	bool present;
+};
+
+static void readVertexArrays(const struct VTX1* vtx1, struct vertexArray arrays[13])
+{
+	memset(arrays, 0, sizeof(struct vertexArray) * 13);
+	if (vtx1 == nullptr)
+		return;
+
+	const struct vertexFormat* format = OffsetPointer(vtx1, SwapEndian(vtx1->formatOffset));
+	for (; SwapEndian(format->attribute) != GX_VA_NULL; format++)
+	{
+		uint32_t attribute = SwapEndian(format->attribute);
+		int arrayIndex;
+		if (attribute == GX_VA_POS)
+			arrayIndex = 0;
+		else if (attribute == GX_VA_NRM)
+			arrayIndex = 1;
+		else if (attribute == GX_VA_CLR0 || attribute == GX_VA_CLR1)
+			arrayIndex = 3 + attribute - GX_VA_CLR0;
+		else if (attribute >= GX_VA_TEX0 && attribute <= GX_VA_TEX7)
+			arrayIndex = 5 + attribute - GX_VA_TEX0;
+		else
+			continue;
+
+		struct vertexArray* array = &arrays[arrayIndex];
+		uint32_t offset = SwapEndian(vtx1->dataOffsets[arrayIndex]);
+		if (offset == 0 || offset >= (uint32_t)SwapEndian(vtx1->size))
+			continue;
+
+		array->present = true;
+		array->data = OffsetPointer((const uint8_t*)vtx1, offset);
+		array->componentCount = SwapEndian(format->componentCount);
+		array->componentType = SwapEndian(format->componentType);
+		array->scale = 1.0f / (float)(1 << format->fractionalBits);
+
+		if (arrayIndex == 0)
+			array->stride = getVertexComponentSize(array->componentType) * (array->componentCount == 0 ? 2 : 3);
+		else if (arrayIndex == 1)
+			array->stride = getVertexComponentSize(array->componentType) * (array->componentCount == 0 ? 3 : 9);
+		else if (arrayIndex <= 4)
+		{
+			static const uint8_t colorSizes[] = { 2, 3, 4, 2, 3, 4 };
+			array->stride = array->componentType < countof(colorSizes) ? colorSizes[array->componentType] : 4;
+		}
+		else
+			array->stride = getVertexComponentSize(array->componentType) * (array->componentCount == 0 ? 1 : 2);
+
+		//arrays run until the next array or the end of the chunk
+		uint32_t end = SwapEndian(vtx1->size);
+		for (int i = 0; i < 13; i++)
+		{
+			uint32_t otherOffset = SwapEndian(vtx1->dataOffsets[i]);
+			if (otherOffset > offset && otherOffset < end)
+				end = otherOffset;
+		}
+		array->count = (end - offset) / array->stride;
+	}
+}
+
+static void readVertexColor(const struct vertexArray* array, uint32_t index, uint8_t* _Out_ rgba)
+{
+	const uint8_t* c = array->data + (size_t)index * array->stride;
+	switch (array->componentType)
+	{
+	case 0://rgb565
+		Unpack565(c, rgba);
+		break;
+	case 1://rgb8
+		rgba[0] = c[0]; rgba[1] = c[1]; rgba[2] = c[2]; rgba[3] = 255;
+		break;
+	case 2://rgbx8
+		rgba[0] = c[0]; rgba[1] = c[1]; rgba[2] = c[2]; rgba[3] = 255;
+		break;
+	case 3://rgba4
+		rgba[0] = (c[0] >> 4) * 0x11; rgba[1] = (c[0] & 0xF) * 0x11; rgba[2] = (c[1] >> 4) * 0x11; rgba[3] = (c[1] & 0xF) * 0x11;
+		break;
+	case 4://rgba6
+	{
+		uint32_t v = (c[0] << 16) | (c[1] << 8) | c[2];
+		rgba[0] = ((v >> 18) & 0x3F) << 2; rgba[1] = ((v >> 12) & 0x3F) << 2; rgba[2] = ((v >> 6) & 0x3F) << 2; rgba[3] = (v & 0x3F) << 2;
+		break;
+	}
+	default://rgba8
+		rgba[0] = c[0]; rgba[1] = c[1]; rgba[2] = c[2]; rgba[3] = c[3];
+		break;
+	}
+}
+
+//key of a display list vertex, used to merge vertices that reference the same data
+struct vertexKey
+{
+	uint32_t position;
+	uint32_t normal;
+	uint32_t color;
+	uint32_t texCoord;
+	uint32_t drawMatrix;
+};
+
+static inline uint32_t hashVertexKey(const struct vertexKey* key)
+{
+	uint32_t hash = key->position * 0x9E3779B1u;
+	hash = (hash ^ key->normal) * 0x85EBCA77u;
+	hash = (hash ^ key->color) * 0xC2B2AE3Du;
+	hash = (hash ^ key->texCoord) * 0x27D4EB2Fu;
+	hash = (hash ^ key->drawMatrix) * 0x165667B1u;
+	return hash ^ (hash >> 15);
+}
+
+struct shapeDecodeState
+{
+	struct j3dModel* model;
+	const struct vertexArray* arrays;
+
+	//dedup table for the current shape
+	struct vertexKey* keys;
+	uint32_t* slots;//vertex index + 1, 0 = empty
+	uint32_t tableMask;
+
+	uint32_t maxVertices;
+	uint32_t maxIndices;
+};
+
+static uint32_t emitVertex(struct shapeDecodeState* state, const struct vertexKey* key)
+{
+	struct j3dModel* model = state->model;
+
+	uint32_t slot = hashVertexKey(key) & state->tableMask;
+	while (state->slots[slot] != 0)
+	{
+		if (memcmp(&state->keys[slot], key, sizeof(struct vertexKey)) == 0)
+			return state->slots[slot] - 1;
+		slot = (slot + 1) & state->tableMask;
+	}
+
+	uint32_t vertexIndex = model->vertexCount++;
+	state->keys[slot] = *key;
+	state->slots[slot] = vertexIndex + 1;
+
+	struct j3dVertex* vertex = &model->vertices[vertexIndex];
+	memset(vertex, 0, sizeof(struct j3dVertex));
+
+	const struct vertexArray* positions = &state->arrays[0];
+	if (key->position < positions->count)
+	{
+		const uint8_t* p = positions->data + (size_t)key->position * positions->stride;
+		uint32_t componentSize = getVertexComponentSize(positions->componentType);
+		vertex->position[0] = readVertexComponent(p, positions->componentType, positions->scale);
+		vertex->position[1] = readVertexComponent(p + componentSize, positions->componentType, positions->scale);
+		if (positions->componentCount != 0)
+			vertex->position[2] = readVertexComponent(p + componentSize * 2, positions->componentType, positions->scale);
+	}
+
+	const struct vertexArray* normals = &state->arrays[1];
+	if (key->normal < normals->count)
+	{
+		const uint8_t* n = normals->data + (size_t)key->normal * normals->stride;
+		uint32_t componentSize = getVertexComponentSize(normals->componentType);
+		for (int i = 0; i < 3; i++)
+			vertex->normal[i] = readVertexComponent(n + componentSize * i, normals->componentType, normals->scale);
+	}
+
+	if (key->color < state->arrays[3].count)
+		readVertexColor(&state->arrays[3], key->color, vertex->color);
+	else
+		memset(vertex->color, 255, 4);
+
+	const struct vertexArray* texCoords = &state->arrays[5];
+	if (key->texCoord < texCoords->count)
+	{
+		const uint8_t* t = texCoords->data + (size_t)key->texCoord * texCoords->stride;
+		vertex->texCoord[0] = readVertexComponent(t, texCoords->componentType, texCoords->scale);
+		if (texCoords->componentCount != 0)
+			vertex->texCoord[1] = readVertexComponent(t + getVertexComponentSize(texCoords->componentType), texCoords->componentType, texCoords->scale);
+	}
+
+	model->vertexDrawMatrices[vertexIndex] = (uint16_t)key->drawMatrix;
+	return vertexIndex;
+}
+
+static inline void emitTriangle(struct j3dModel* model, uint32_t a, uint32_t b, uint32_t c)
+{
+	//degenerate triangles are used to join strips, they'd only cost rasterizer time
+	if (a == b || b == c || a == c)
+		return;
+	model->indices[model->indexCount++] = a;
+	model->indices[model->indexCount++] = b;
+	model->indices[model->indexCount++] = c;
+}
+
+//direct vertex data isn't used by J3D models, it's skipped using the array layout
+static inline const struct vertexArray* getDirectAttributeArray(const struct vertexArray arrays[13], uint32_t attribute)
+{
+	if (attribute == GX_VA_POS) return &arrays[0];
+	if (attribute == GX_VA_NRM) return &arrays[1];
+	if (attribute == GX_VA_CLR0 || attribute == GX_VA_CLR1) return &arrays[3 + attribute - GX_VA_CLR0];
+	if (attribute >= GX_VA_TEX0 && attribute <= GX_VA_TEX7) return &arrays[5 + attribute - GX_VA_TEX0];
+	return nullptr;
+}
+
+//the shape's tables were checked by isSHP1Valid, only the primitives inside each display list are checked here
+static void decodeShape(struct shapeDecodeState* state, const struct SHP1* shp1, const struct shapeData* shape)
+{
+	struct j3dModel* model = state->model;
+
+	const struct vertexDescriptor* firstDescriptor = OffsetPointer(shp1, SwapEndian(shp1->vertexDescriptorOffset) + SwapEndian(shape->vertexDescriptorOffset));
+	const uint16_t* matrixTable = OffsetPointer(shp1, SwapEndian(shp1->matrixTableOffset));
+	const struct shapeMatrixData* matrixData = OffsetPointer(shp1, SwapEndian(shp1->matrixDataOffset));
+	const struct shapePacket* packets = OffsetPointer(shp1, SwapEndian(shp1->packetOffset));
+	const uint8_t* displayLists = OffsetPointer((const uint8_t*)shp1, SwapEndian(shp1->displayListOffset));
+
+	memset(state->slots, 0, (state->tableMask + 1) * sizeof(uint32_t));
+
+	//display list bytes per vertex, so a whole primitive is checked once instead of every attribute read
+	size_t vertexSize = 0;
+	for (const struct vertexDescriptor* descriptor = firstDescriptor; SwapEndian(descriptor->attribute) != GX_VA_NULL; descriptor++)
+	{
+		uint32_t attribute = SwapEndian(descriptor->attribute);
+		uint32_t type = SwapEndian(descriptor->type);
+		if (type == GX_INDEX16)
+			vertexSize += 2;
+		else if (type == GX_INDEX8 || (type == GX_DIRECT && attribute <= GX_VA_TEX7MTXIDX))
+			vertexSize += 1;
+		else if (type == GX_DIRECT)
+		{
+			const struct vertexArray* array = getDirectAttributeArray(state->arrays, attribute);
+			vertexSize += array ? array->stride : 0;
+		}
+	}
+
+	uint16_t packetMatrices[10] = { 0 };
+
+	//temporary indices of the current primitive are written past the model indices
+	for (uint32_t packetIndex = 0; packetIndex < SwapEndian(shape->packetCount); packetIndex++)
+	{
+		const struct shapeMatrixData* packetMatrixData = &matrixData[SwapEndian(shape->firstMatrixData) + packetIndex];
+		for (uint32_t i = 0; i < SwapEndian(packetMatrixData->matrixCount) && i < countof(packetMatrices); i++)
+		{
+			uint16_t drawMatrix = SwapEndian(matrixTable[SwapEndian(packetMatrixData->firstMatrixIndex) + i]);
+			//0xFFFF: keep the matrix of the previous packet
+			if (drawMatrix != 0xFFFF)
+				packetMatrices[i] = drawMatrix;
+		}
+
+		const struct shapePacket* packet = &packets[SwapEndian(shape->firstPacket) + packetIndex];
+		const uint8_t* command = displayLists + SwapEndian(packet->displayListOffset);
+		const uint8_t* commandEnd = command + SwapEndian(packet->displayListSize);
+
+		while (command < commandEnd)
+		{
+			uint8_t primitive = *command++ & 0xF8;
+			if (primitive != GX_TRIANGLES && primitive != GX_TRIANGLESTRIP && primitive != GX_TRIANGLEFAN)
+			{
+				//0 is padding at the end of the list, anything else isn't a primitive this parser knows
+				break;
+			}
+
+			if (commandEnd - command < 2)
+				break;
+			uint16_t vertexCount = SwapEndian(*(const uint16_t*)command);
+			command += 2;
+			if (vertexCount * vertexSize > (size_t)(commandEnd - command))
+				break;
+
+			uint32_t* primitiveVertices = model->indices + model->indexCount + vertexCount * 3;
+			if (model->indexCount + vertexCount * 4 > state->maxIndices || model->vertexCount + vertexCount > state->maxVertices)
+				return;
+
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				struct vertexKey key = { UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX, packetMatrices[0] };
+
+				for (const struct vertexDescriptor* descriptor = firstDescriptor; SwapEndian(descriptor->attribute) != GX_VA_NULL; descriptor++)
+				{
+					uint32_t attribute = SwapEndian(descriptor->attribute);
+					uint32_t type = SwapEndian(descriptor->type);
+
+					uint32_t value = 0;
+					if (type == GX_INDEX16)
+					{
+						value = SwapEndian(*(const uint16_t*)command);
+						command += 2;
+					}
+					else if (type == GX_INDEX8 || (type == GX_DIRECT && attribute <= GX_VA_TEX7MTXIDX))
+					{
+						value = *command++;
+					}
+					else if (type == GX_DIRECT)
+					{
+						const struct vertexArray* array = getDirectAttributeArray(state->arrays, attribute);
+						command += array ? array->stride : 0;
+						continue;
+					}
+
+					if (attribute == GX_VA_PNMTXIDX)
+						key.drawMatrix = packetMatrices[min(value / 3, countof(packetMatrices) - 1)];
+					else if (attribute == GX_VA_POS)
+						key.position = value;
+					else if (attribute == GX_VA_NRM)
+						key.normal = value;
+					else if (attribute == GX_VA_CLR0)
+						key.color = value;
+					else if (attribute == GX_VA_TEX0)
+						key.texCoord = value;
+				}
+
+				primitiveVertices[v] = emitVertex(state, &key);
+			}
+
+			if (primitive == GX_TRIANGLES)
+			{
+				for (uint32_t v = 0; v + 2 < vertexCount; v += 3)
+					emitTriangle(model, primitiveVertices[v], primitiveVertices[v + 1], primitiveVertices[v + 2]);
+			}
+			else if (primitive == GX_TRIANGLESTRIP)
+			{
+				for (uint32_t v = 0; v + 2 < vertexCount; v++)
+				{
+					if (v & 1)
+						emitTriangle(model, primitiveVertices[v + 1], primitiveVertices[v], primitiveVertices[v + 2]);
+					else
+						emitTriangle(model, primitiveVertices[v], primitiveVertices[v + 1], primitiveVertices[v + 2]);
+				}
+			}
+			else
+			{
+				for (uint32_t v = 1; v + 1 < vertexCount; v++)
+					emitTriangle(model, primitiveVertices[0], primitiveVertices[v], primitiveVertices[v + 1]);
+			}
+		}
+	}
+}
+
+//counts the INF1 nodes of each type before the end marker, the end of the chunk stops it too
+static uint32_t countJ3DHierarchyNodes(const struct INF1* inf1, uint32_t* _Out_ jointNodes, uint32_t* _Out_ materialNodes, uint32_t* _Out_ shapeNodes)
+{
+	*jointNodes = 0;
+	*materialNodes = 0;
+	*shapeNodes = 0;
+	if (inf1 == nullptr)
+		return 0;
+
+	const struct hierarchyNode* bmdHierarchy = OffsetPointer(inf1, SwapEndian(inf1->hierarchyDataOffset));
+	uint32_t entryCount = (SwapEndian(inf1->size) - min((uint32_t)SwapEndian(inf1->hierarchyDataOffset), (uint32_t)SwapEndian(inf1->size))) / sizeof(struct hierarchyNode);
+	uint32_t i = 0;
+	for (; i < entryCount && SwapEndian(bmdHierarchy[i].NodeType) != 0x00; i++)
+	{
+		switch (SwapEndian(bmdHierarchy[i].NodeType))
+		{
+		case J3D_NODE_JOINT: (*jointNodes)++; break;
+		case J3D_NODE_MATERIAL: (*materialNodes)++; break;
+		case J3D_NODE_SHAPE: (*shapeNodes)++; break;
+		}
+	}
+	return i;
+}
+
+/*
+* flattens INF1 into the node arrays. each 0x01 remembers the last node/joint/material so the children can refer to it
+* and 0x02 can restore it. the arrays are sized by countJ3DHierarchyNodes
+*/
+static void readJ3DHierarchy(const struct INF1* inf1, uint32_t entryCount, struct j3dModel* model)
+{
+	//-2 marks joints the hierarchy hasn't reached yet
+	for (uint32_t i = 0; i < model->jointCount; i++)
+		model->jointParents[i] = -2;
+	for (uint32_t i = 0; i < model->shapeCount; i++)
+		model->shapeMaterials[i] = -1;
+
+	model->nodeCount = 0;
+	model->hierarchyMaterialCount = 0;
+	model->hierarchyShapeCount = 0;
+	uint32_t orderedJointCount = 0;
+
+	if (inf1 != nullptr)
+	{
+		const struct hierarchyNode* bmdHierarchy = OffsetPointer(inf1, SwapEndian(inf1->hierarchyDataOffset));
+
+		int32_t nodeStack[64];
+		int16_t jointStack[64];
+		int16_t materialStack[64];
+		int depth = 0;
+		int32_t lastNode = -1;
+		int16_t lastJoint = -1;
+		int16_t lastMaterial = -1;
+
+		for (uint32_t hierarchyNodeIndex = 0; hierarchyNodeIndex < entryCount; hierarchyNodeIndex++)
+		{
+			uint16_t type = SwapEndian(bmdHierarchy[hierarchyNodeIndex].NodeType);
+			uint16_t data = SwapEndian(bmdHierarchy[hierarchyNodeIndex].Data);
+			bool inStack = depth > 0 && depth <= countof(nodeStack);
+
+			switch (type)
+			{
+			case 0x01:
+				if (depth < countof(nodeStack))
+				{
+					nodeStack[depth] = lastNode;
+					jointStack[depth] = lastJoint;
+					materialStack[depth] = lastMaterial;
+				}
+				depth++;
+				continue;
+			case 0x02:
+				//a close without an open has nothing to restore
+				if (depth == 0)
+					continue;
+				depth--;
+				if (depth < countof(nodeStack))
+				{
+					lastNode = nodeStack[depth];
+					lastJoint = jointStack[depth];
+					lastMaterial = materialStack[depth];
+				}
+				continue;
+			case J3D_NODE_JOINT:
+				if (data < model->jointCount && model->jointParents[data] == -2)
+				{
+					model->jointParents[data] = inStack ? jointStack[depth - 1] : -1;
+					model->hierarchyJoints[orderedJointCount++] = data;
+				}
+				if (data < model->jointCount)
+					lastJoint = data;
+				break;
+			case J3D_NODE_MATERIAL:
+				model->hierarchyMaterials[model->hierarchyMaterialCount++] = data;
+				lastMaterial = data < model->materialCount ? data : -1;
+				break;
+			case J3D_NODE_SHAPE:
+				model->hierarchyShapes[model->hierarchyShapeCount++] = data;
+				if (data < model->shapeCount)
+					model->shapeMaterials[data] = lastMaterial;
+				break;
+			default:
+				continue;
+			}
+
+			uint32_t node = model->nodeCount++;
+			model->nodeTypes[node] = (uint8_t)type;
+			model->nodeIndices[node] = data;
+			model->nodeParents[node] = inStack ? nodeStack[depth - 1] : -1;
+			lastNode = node;
+		}
+	}
+
+	for (uint32_t i = 0; i < model->jointCount; i++)
+	{
+		if (model->jointParents[i] == -2)
+		{
+			model->jointParents[i] = -1;
+			model->hierarchyJoints[orderedJointCount++] = (uint16_t)i;
+		}
+	}
+}
+
+/*
+* world matrices from local joint transforms (xyz per joint, like jointScales/jointRotations/jointTranslations) in two linear passes:
+* every local matrix first, then each joint in hierarchy order is multiplied by its parent's world matrix, which is always done by then.
+* nothing is allocated, world holds jointCount matrices
+*/
+void evaluateJointWorldMatrices(const struct j3dModel* model, const float* scales, const float* rotations, const float* translations, struct matrix34* _Out_ world)
+{
+	for (uint32_t i = 0; i < model->jointCount; i++)
+		composeJointMatrix(&scales[i * 3], &rotations[i * 3], &translations[i * 3], &world[i]);
+
+	for (uint32_t i = 0; i < model->jointCount; i++)
+	{
+		uint16_t joint = model->hierarchyJoints[i];
+		int16_t parent = model->jointParents[joint];
+		if (parent >= 0)
+			multiplyMatrix34(&world[parent], &world[joint], &world[joint]);
+	}
+}
+
+
+static void readJ3DJoints(const struct JNT1* jnt1, struct j3dModel* model)
+{
+	const struct jointData* joints = OffsetPointer(jnt1, SwapEndian(jnt1->jointDataOffset));
+	const uint16_t* remap = OffsetPointer(jnt1, SwapEndian(jnt1->remapOffset));
+	const void* names = getJ3DNameTable(jnt1, SwapEndian(jnt1->nameTableOffset));
+
+	for (uint32_t i = 0; i < model->jointCount; i++)
+	{
+		const struct jointData* joint = &joints[SwapEndian(remap[i])];
+		model->jointNames[i] = getJ3DName(names, i);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			model->jointScales[i * 3 + axis] = SwapEndianFloat(joint->scale[axis]);
+			model->jointRotations[i * 3 + axis] = (int16_t)SwapEndian(joint->rotation[axis]) * (3.14159265f / 32768.0f);
+			model->jointTranslations[i * 3 + axis] = SwapEndianFloat(joint->translation[axis]);
+		}
+	}
+}
+
+static void readJ3DEnvelopes(const struct EVP1* evp1, const struct DRW1* drw1, struct j3dModel* model)
+{
+	for (uint32_t i = 0; i < model->jointCount; i++)
+		model->inverseBindMatrices[i] = identityMatrix34;
+
+	if (evp1 != nullptr)
+	{
+		const uint8_t* weightCounts = OffsetPointer((const uint8_t*)evp1, SwapEndian(evp1->weightCountOffset));
+		const uint16_t* jointIndices = OffsetPointer(evp1, SwapEndian(evp1->jointIndexOffset));
+		const float* weights = OffsetPointer(evp1, SwapEndian(evp1->weightOffset));
+
+		uint32_t weightIndex = 0;
+		for (uint32_t i = 0; i < model->envelopeCount; i++)
+		{
+			model->envelopeWeightCounts[i] = weightCounts[i];
+			model->envelopeFirstWeights[i] = weightIndex;
+			for (uint32_t w = 0; w < weightCounts[i]; w++, weightIndex++)
+			{
+				model->envelopeJoints[weightIndex] = SwapEndian(jointIndices[weightIndex]);
+				model->envelopeWeights[weightIndex] = SwapEndianFloat(weights[weightIndex]);
+			}
+		}
+
+		if (evp1->inverseBindMatrixOffset != 0)
+		{
+			const float* matrices = OffsetPointer(evp1, SwapEndian(evp1->inverseBindMatrixOffset));
+			uint32_t matrixCount = getJ3DTableCapacity(evp1, SwapEndian(evp1->inverseBindMatrixOffset), sizeof(struct matrix34));
+			for (uint32_t i = 0; i < model->jointCount && i < matrixCount; i++)
+				for (int j = 0; j < 12; j++)
+					model->inverseBindMatrices[i].m[j / 4][j % 4] = SwapEndianFloat(matrices[i * 12 + j]);
+		}
+	}
+
+	if (drw1 != nullptr)
+	{
+		const uint8_t* isWeighted = OffsetPointer((const uint8_t*)drw1, SwapEndian(drw1->isWeightedOffset));
+		const uint16_t* indices = OffsetPointer(drw1, SwapEndian(drw1->indexOffset));
+		for (uint32_t i = 0; i < model->drawMatrixCount; i++)
+		{
+			model->drawMatrixWeighted[i] = isWeighted[i];
+			model->drawMatrixIndices[i] = SwapEndian(indices[i]);
+		}
+	}
+}
+
+static void readJ3DMaterials(const struct MAT3* mat3, struct j3dModel* model)
+{
+	const struct materialData* materials = OffsetPointer(mat3, SwapEndian(mat3->materialDataOffset));
+	const uint16_t* remap = OffsetPointer(mat3, SwapEndian(mat3->remapOffset));
+	const void* names = getJ3DNameTable(mat3, SwapEndian(mat3->nameTableOffset));
+	const uint32_t* cullModes = mat3->cullModeOffset ? OffsetPointer(mat3, SwapEndian(mat3->cullModeOffset)) : nullptr;
+	const uint32_t* materialColors = mat3->materialColorOffset ? OffsetPointer(mat3, SwapEndian(mat3->materialColorOffset)) : nullptr;
+	const uint16_t* textureRemap = mat3->textureRemapOffset ? OffsetPointer(mat3, SwapEndian(mat3->textureRemapOffset)) : nullptr;
+
+	for (uint32_t i = 0; i < model->materialCount; i++)
+	{
+		const struct materialData* material = &materials[SwapEndian(remap[i])];
+		model->materialNames[i] = getJ3DName(names, i);
+		model->materialCullModes[i] = cullModes ? (uint8_t)SwapEndian(cullModes[material->cullModeIndex]) : 2;
+
+		int16_t colorIndex = SwapEndian(material->materialColorIndex[0]);
+		model->materialColors[i] = (materialColors && colorIndex >= 0) ? SwapEndian(materialColors[colorIndex]) : 0xFFFFFFFF;
+
+		for (int t = 0; t < J3D_MAX_TEXTURES_PER_MATERIAL; t++)
+		{
+			int16_t textureIndex = SwapEndian(material->textureIndex[t]);
+			model->materialTextures[i * J3D_MAX_TEXTURES_PER_MATERIAL + t] = (textureIndex >= 0 && textureRemap) ? (int16_t)SwapEndian(textureRemap[textureIndex]) : -1;
+		}
+	}
+}
+
+//joint world matrices, then skin every vertex into model space
+static void applyJ3DBindPose(struct j3dModel* model)
+{
+	evaluateJointWorldMatrices(model, model->jointScales, model->jointRotations, model->jointTranslations, model->jointWorldMatrices);
+
+	if (model->drawMatrixCount == 0)
+		return;
+
+	for (uint32_t v = 0; v < model->vertexCount; v++)
+	{
+		uint16_t drawMatrix = model->vertexDrawMatrices[v];
+		if (drawMatrix >= model->drawMatrixCount)
+			continue;
+
+		struct matrix34 skin;
+		uint16_t index = model->drawMatrixIndices[drawMatrix];
+		if (!model->drawMatrixWeighted[drawMatrix])
+		{
+			if (index >= model->jointCount)
+				continue;
+			skin = model->jointWorldMatrices[index];
+		}
+		else
+		{
+			if (index >= model->envelopeCount)
+				continue;
+			memset(&skin, 0, sizeof(skin));
+			for (uint32_t w = 0; w < model->envelopeWeightCounts[index]; w++)
+			{
+				uint32_t weightIndex = model->envelopeFirstWeights[index] + w;
+				uint16_t joint = model->envelopeJoints[weightIndex];
+				if (joint >= model->jointCount)
+					continue;
+				struct matrix34 jointSkin;
+				multiplyMatrix34(&model->jointWorldMatrices[joint], &model->inverseBindMatrices[joint], &jointSkin);
+				for (int j = 0; j < 12; j++)
+					skin.m[j / 4][j % 4] += jointSkin.m[j / 4][j % 4] * model->envelopeWeights[weightIndex];
+			}
+		}
+
+		struct j3dVertex* vertex = &model->vertices[v];
+		float p[3] = { vertex->position[0], vertex->position[1], vertex->position[2] };
+		float n[3] = { vertex->normal[0], vertex->normal[1], vertex->normal[2] };
+		for (int row = 0; row < 3; row++)
+		{
+			vertex->position[row] = skin.m[row][0] * p[0] + skin.m[row][1] * p[1] + skin.m[row][2] * p[2] + skin.m[row][3];
+			vertex->normal[row] = skin.m[row][0] * n[0] + skin.m[row][1] * n[1] + skin.m[row][2] * n[2];
+		}
+		float length = sqrtf(vertex->normal[0] * vertex->normal[0] + vertex->normal[1] * vertex->normal[1] + vertex->normal[2] * vertex->normal[2]);
+		if (length > 0.0f)
+		{
+			vertex->normal[0] /= length;
+			vertex->normal[1] /= length;
+			vertex->normal[2] /= length;
+		}
+	}
+}
+
+/*
+* chunk validation: every table a reader indexes with a count or index from the file is checked against its chunk here,
+* once per chunk, so the readers and the display list decoder can stay unchecked. a chunk that fails is dropped.
+*/
+static bool isJNT1Valid(const struct JNT1* jnt1)
+{
+	uint32_t jointCount = SwapEndian(jnt1->jointCount);
+	uint32_t jointCapacity = getJ3DTableCapacity(jnt1, SwapEndian(jnt1->jointDataOffset), sizeof(struct jointData));
+	if (getJ3DTableCapacity(jnt1, SwapEndian(jnt1->remapOffset), sizeof(uint16_t)) < jointCount)
+		return false;
+
+	const uint16_t* remap = OffsetPointer(jnt1, SwapEndian(jnt1->remapOffset));
+	for (uint32_t i = 0; i < jointCount; i++)
+		if (SwapEndian(remap[i]) >= jointCapacity)
+			return false;
+	return true;
+}
+
+//also returns the number of weights all envelopes use
+static bool isEVP1Valid(const struct EVP1* evp1, uint32_t* _Out_ weightCount)
+{
+	uint32_t envelopeCount = SwapEndian(evp1->envelopeCount);
+	*weightCount = 0;
+	if (getJ3DTableCapacity(evp1, SwapEndian(evp1->weightCountOffset), sizeof(uint8_t)) < envelopeCount)
+		return false;
+
+	const uint8_t* weightCounts = OffsetPointer((const uint8_t*)evp1, SwapEndian(evp1->weightCountOffset));
+	for (uint32_t i = 0; i < envelopeCount; i++)
+		*weightCount += weightCounts[i];
+	return getJ3DTableCapacity(evp1, SwapEndian(evp1->jointIndexOffset), sizeof(uint16_t)) >= *weightCount &&
+		getJ3DTableCapacity(evp1, SwapEndian(evp1->weightOffset), sizeof(float)) >= *weightCount;
+}
+
+static bool isDRW1Valid(const struct DRW1* drw1)
+{
+	uint32_t count = SwapEndian(drw1->count);
+	return getJ3DTableCapacity(drw1, SwapEndian(drw1->isWeightedOffset), sizeof(uint8_t)) >= count &&
+		getJ3DTableCapacity(drw1, SwapEndian(drw1->indexOffset), sizeof(uint16_t)) >= count;
+}
+
+static bool isMAT3Valid(const struct MAT3* mat3)
+{
+	uint32_t materialCount = SwapEndian(mat3->materialCount);
+	uint32_t materialCapacity = getJ3DTableCapacity(mat3, SwapEndian(mat3->materialDataOffset), sizeof(struct materialData));
+	//tables that are absent aren't read, so any index into them is fine
+	uint32_t cullModeCapacity = mat3->cullModeOffset ? getJ3DTableCapacity(mat3, SwapEndian(mat3->cullModeOffset), sizeof(uint32_t)) : UINT32_MAX;
+	uint32_t colorCapacity = mat3->materialColorOffset ? getJ3DTableCapacity(mat3, SwapEndian(mat3->materialColorOffset), sizeof(uint32_t)) : UINT32_MAX;
+	uint32_t textureRemapCapacity = mat3->textureRemapOffset ? getJ3DTableCapacity(mat3, SwapEndian(mat3->textureRemapOffset), sizeof(uint16_t)) : UINT32_MAX;
+	if (getJ3DTableCapacity(mat3, SwapEndian(mat3->remapOffset), sizeof(uint16_t)) < materialCount)
+		return false;
+
+	const struct materialData* materials = OffsetPointer(mat3, SwapEndian(mat3->materialDataOffset));
+	const uint16_t* remap = OffsetPointer(mat3, SwapEndian(mat3->remapOffset));
+	for (uint32_t i = 0; i < materialCount; i++)
+	{
+		if (SwapEndian(remap[i]) >= materialCapacity)
+			return false;
+		const struct materialData* material = &materials[SwapEndian(remap[i])];
+		if (material->cullModeIndex >= cullModeCapacity)
+			return false;
+		int16_t colorIndex = SwapEndian(material->materialColorIndex[0]);
+		if (colorIndex >= 0 && (uint32_t)colorIndex >= colorCapacity)
+			return false;
+		for (int t = 0; t < J3D_MAX_TEXTURES_PER_MATERIAL; t++)
+		{
+			int16_t textureIndex = SwapEndian(material->textureIndex[t]);
+			if (textureIndex >= 0 && (uint32_t)textureIndex >= textureRemapCapacity)
+				return false;
+		}
+	}
+	return true;
+}
+
+//the format list has to end inside the chunk
+static bool isVTX1Valid(const struct VTX1* vtx1)
+{
+	uint32_t formatCapacity = getJ3DTableCapacity(vtx1, SwapEndian(vtx1->formatOffset), sizeof(struct vertexFormat));
+	const struct vertexFormat* formats = OffsetPointer(vtx1, SwapEndian(vtx1->formatOffset));
+	for (uint32_t i = 0; i < formatCapacity; i++)
+		if (SwapEndian(formats[i].attribute) == GX_VA_NULL)
+			return true;
+	return false;
+}
+
+//shapes (the ones remap points at, those are what get decoded), descriptor lists, packet matrices and display lists all have to be inside the chunk
+static bool isSHP1Valid(const struct SHP1* shp1)
+{
+	uint32_t chunkSize = SwapEndian(shp1->size);
+	uint32_t shapeCount = SwapEndian(shp1->shapeCount);
+	uint32_t shapeCapacity = getJ3DTableCapacity(shp1, SwapEndian(shp1->shapeDataOffset), sizeof(struct shapeData));
+	uint32_t matrixDataCapacity = getJ3DTableCapacity(shp1, SwapEndian(shp1->matrixDataOffset), sizeof(struct shapeMatrixData));
+	uint32_t matrixTableCapacity = getJ3DTableCapacity(shp1, SwapEndian(shp1->matrixTableOffset), sizeof(uint16_t));
+	uint32_t packetCapacity = getJ3DTableCapacity(shp1, SwapEndian(shp1->packetOffset), sizeof(struct shapePacket));
+	if (shapeCapacity < shapeCount || getJ3DTableCapacity(shp1, SwapEndian(shp1->remapOffset), sizeof(uint16_t)) < shapeCount)
+		return false;
+
+	const struct shapeData* shapes = OffsetPointer(shp1, SwapEndian(shp1->shapeDataOffset));
+	const uint16_t* remap = OffsetPointer(shp1, SwapEndian(shp1->remapOffset));
+	const struct shapeMatrixData* matrixData = OffsetPointer(shp1, SwapEndian(shp1->matrixDataOffset));
+	const struct shapePacket* packets = OffsetPointer(shp1, SwapEndian(shp1->packetOffset));
+	for (uint32_t s = 0; s < shapeCount; s++)
+	{
+		if (SwapEndian(remap[s]) >= shapeCapacity)
+			return false;
+
+		const struct shapeData* shape = &shapes[SwapEndian(remap[s])];
+		uint32_t descriptorOffset = SwapEndian(shp1->vertexDescriptorOffset) + SwapEndian(shape->vertexDescriptorOffset);
+		uint32_t descriptorCapacity = getJ3DTableCapacity(shp1, descriptorOffset, sizeof(struct vertexDescriptor));
+		const struct vertexDescriptor* descriptors = OffsetPointer(shp1, descriptorOffset);
+		uint32_t d = 0;
+		while (d < descriptorCapacity && SwapEndian(descriptors[d].attribute) != GX_VA_NULL)
+			d++;
+		if (d == descriptorCapacity)
+			return false;
+
+		uint32_t packetCount = SwapEndian(shape->packetCount);
+		if ((uint64_t)SwapEndian(shape->firstMatrixData) + packetCount > matrixDataCapacity || (uint64_t)SwapEndian(shape->firstPacket) + packetCount > packetCapacity)
+			return false;
+		for (uint32_t p = 0; p < packetCount; p++)
+		{
+			const struct shapeMatrixData* packetMatrixData = &matrixData[SwapEndian(shape->firstMatrixData) + p];
+			uint32_t usedMatrices = min((uint32_t)SwapEndian(packetMatrixData->matrixCount), 10);
+			if ((uint64_t)SwapEndian(packetMatrixData->firstMatrixIndex) + usedMatrices > matrixTableCapacity)
+				return false;
+
+			const struct shapePacket* packet = &packets[SwapEndian(shape->firstPacket) + p];
+			if (!isRangeInside((uint64_t)SwapEndian(shp1->displayListOffset) + SwapEndian(packet->displayListOffset), SwapEndian(packet->displayListSize), chunkSize))
+				return false;
+		}
+	}
+	return true;
+}
+
+/*
+* parses a bmd/bdl file. returns false if the workspace is too small.
+* chunks this parser doesn't know are skipped and counted, so are chunks that fail validation.
+*/
+bool parseJ3DModel(const void* j3dFile, uint32_t fileSize, void* workspace, size_t workspaceSize, struct j3dModel* _Out_ model)
+{
+	memset(model, 0, sizeof(struct j3dModel));
+
+	const struct INF1* inf1 = nullptr;
+	const struct VTX1* vtx1 = nullptr;
+	const struct EVP1* evp1 = nullptr;
+	const struct DRW1* drw1 = nullptr;
+	const struct JNT1* jnt1 = nullptr;
+	const struct SHP1* shp1 = nullptr;
+	const struct MAT3* mat3 = nullptr;
+
+	uint32_t envelopeWeightCount = 0;
+
+	struct j3dChunkCursor cursor;
+	initJ3DChunkCursor(&cursor, j3dFile, fileSize);
+	for (const struct bmdSection* currentSection; (currentSection = nextJ3DChunk(&cursor)) != nullptr;)
+	{
+		uint32_t chunkSize = SwapEndian(currentSection->size);
+		uint32_t weightCount;
+		if (memcmp(currentSection->chunkType, "INF1", 4) == 0)
+			inf1 = (const struct INF1*)currentSection;
+		else if (memcmp(currentSection->chunkType, "VTX1", 4) == 0 && chunkSize >= sizeof(struct VTX1) && isVTX1Valid((const struct VTX1*)currentSection))
+			vtx1 = (const struct VTX1*)currentSection;
+		else if (memcmp(currentSection->chunkType, "EVP1", 4) == 0 && isEVP1Valid((const struct EVP1*)currentSection, &weightCount))
+		{
+			evp1 = (const struct EVP1*)currentSection;
+			envelopeWeightCount = weightCount;
+		}
+		else if (memcmp(currentSection->chunkType, "DRW1", 4) == 0 && isDRW1Valid((const struct DRW1*)currentSection))
+			drw1 = (const struct DRW1*)currentSection;
+		else if (memcmp(currentSection->chunkType, "JNT1", 4) == 0 && isJNT1Valid((const struct JNT1*)currentSection))
+			jnt1 = (const struct JNT1*)currentSection;
+		else if (memcmp(currentSection->chunkType, "SHP1", 4) == 0 && chunkSize >= sizeof(struct SHP1) && isSHP1Valid((const struct SHP1*)currentSection))
+			shp1 = (const struct SHP1*)currentSection;
+		else if ((memcmp(currentSection->chunkType, "MAT3", 4) == 0 || memcmp(currentSection->chunkType, "MAT2", 4) == 0) && chunkSize >= sizeof(struct MAT3) && isMAT3Valid((const struct MAT3*)currentSection))
+			mat3 = (const struct MAT3*)currentSection;
+		else if (memcmp(currentSection->chunkType, "TEX1", 4) == 0)
+			model->textures = (const struct TEX1*)currentSection;
+		else
+			model->skippedChunkCount++;
+	}
+
+	struct workspaceAllocator allocator;
+	initWorkspaceAllocator(&allocator, workspace, workspaceSize);
+
+	model->jointCount = jnt1 ? SwapEndian(jnt1->jointCount) : 0;
+	model->shapeCount = shp1 ? SwapEndian(shp1->shapeCount) : 0;
+	model->materialCount = mat3 ? SwapEndian(mat3->materialCount) : 0;
+	model->envelopeCount = evp1 ? SwapEndian(evp1->envelopeCount) : 0;
+	model->drawMatrixCount = drw1 ? SwapEndian(drw1->count) : 0;
+
+	//upper bounds for the vertex buffers: every display list vertex is at least one byte per attribute
+	uint32_t maxVertices = 0;
+	uint32_t maxShapeVertices = 0;
+	if (shp1 != nullptr)
+	{
+		const struct shapeData* shapes = OffsetPointer(shp1, SwapEndian(shp1->shapeDataOffset));
+		const struct shapePacket* packets = OffsetPointer(shp1, SwapEndian(shp1->packetOffset));
+		const uint16_t* remap = OffsetPointer(shp1, SwapEndian(shp1->remapOffset));
+		for (uint32_t s = 0; s < model->shapeCount; s++)
+		{
+			const struct shapeData* shape = &shapes[SwapEndian(remap[s])];
+			const struct vertexDescriptor* descriptor = OffsetPointer(shp1, SwapEndian(shp1->vertexDescriptorOffset) + SwapEndian(shape->vertexDescriptorOffset));
+			uint32_t attributeCount = 0;
+			for (; SwapEndian(descriptor->attribute) != GX_VA_NULL; descriptor++)
+				attributeCount += SwapEndian(descriptor->type) != GX_NONE;
+
+			uint32_t shapeVertices = 0;
+			for (uint32_t p = 0; p < SwapEndian(shape->packetCount); p++)
+				shapeVertices += SwapEndian(packets[SwapEndian(shape->firstPacket) + p].displayListSize) / max(attributeCount, 1);
+			maxVertices += shapeVertices;
+			maxShapeVertices = max(maxShapeVertices, shapeVertices);
+		}
+	}
+	uint32_t maxIndices = maxVertices * 4;
+
+	model->vertices = workspaceAllocArray(&allocator, struct j3dVertex, maxVertices);
+	model->vertexDrawMatrices = workspaceAllocArray(&allocator, uint16_t, maxVertices);
+	model->indices = workspaceAllocArray(&allocator, uint32_t, maxIndices);
+
+	model->shapeFirstIndex = workspaceAllocArray(&allocator, uint32_t, model->shapeCount);
+	model->shapeIndexCount = workspaceAllocArray(&allocator, uint32_t, model->shapeCount);
+	model->shapeMaterials = workspaceAllocArray(&allocator, int16_t, model->shapeCount);
+	model->shapeBoundingRadius = workspaceAllocArray(&allocator, float, model->shapeCount);
+	model->shapeBounds = workspaceAllocArray(&allocator, float, model->shapeCount * 6);
+
+	uint32_t jointNodes, materialNodes, shapeNodes;
+	uint32_t hierarchyEntryCount = countJ3DHierarchyNodes(inf1, &jointNodes, &materialNodes, &shapeNodes);
+	uint32_t nodeCount = jointNodes + materialNodes + shapeNodes;
+	model->nodeTypes = workspaceAllocArray(&allocator, uint8_t, nodeCount);
+	model->nodeIndices = workspaceAllocArray(&allocator, uint16_t, nodeCount);
+	model->nodeParents = workspaceAllocArray(&allocator, int32_t, nodeCount);
+	model->hierarchyJoints = workspaceAllocArray(&allocator, uint16_t, model->jointCount);
+	model->hierarchyMaterials = workspaceAllocArray(&allocator, uint16_t, materialNodes);
+	model->hierarchyShapes = workspaceAllocArray(&allocator, uint16_t, shapeNodes);
+
+	model->jointNames = workspaceAllocArray(&allocator, const char*, model->jointCount);
+	model->jointParents = workspaceAllocArray(&allocator, int16_t, model->jointCount);
+	model->jointScales = workspaceAllocArray(&allocator, float, model->jointCount * 3);
+	model->jointRotations = workspaceAllocArray(&allocator, float, model->jointCount * 3);
+	model->jointTranslations = workspaceAllocArray(&allocator, float, model->jointCount * 3);
+	model->jointWorldMatrices = workspaceAllocArray(&allocator, struct matrix34, model->jointCount);
+	model->inverseBindMatrices = workspaceAllocArray(&allocator, struct matrix34, model->jointCount);
+
+	model->envelopeWeightCounts = workspaceAllocArray(&allocator, uint8_t, model->envelopeCount);
+	model->envelopeFirstWeights = workspaceAllocArray(&allocator, uint32_t, model->envelopeCount);
+	model->envelopeJoints = workspaceAllocArray(&allocator, uint16_t, envelopeWeightCount);
+	model->envelopeWeights = workspaceAllocArray(&allocator, float, envelopeWeightCount);
+
+	model->drawMatrixWeighted = workspaceAllocArray(&allocator, uint8_t, model->drawMatrixCount);
+	model->drawMatrixIndices = workspaceAllocArray(&allocator, uint16_t, model->drawMatrixCount);
+
+	model->materialNames = workspaceAllocArray(&allocator, const char*, model->materialCount);
+	model->materialCullModes = workspaceAllocArray(&allocator, uint8_t, model->materialCount);
+	model->materialColors = workspaceAllocArray(&allocator, uint32_t, model->materialCount);
+	model->materialTextures = workspaceAllocArray(&allocator, int16_t, model->materialCount * J3D_MAX_TEXTURES_PER_MATERIAL);
+
+	//dedup table, at most half full
+	uint32_t tableSize = 64;
+	while (tableSize < maxShapeVertices * 2)
+		tableSize *= 2;
+	struct shapeDecodeState state = { 0 };
+	state.keys = workspaceAllocArray(&allocator, struct vertexKey, tableSize);
+	state.slots = workspaceAllocArray(&allocator, uint32_t, tableSize);
+
+	if (allocator.failed)
+		return false;
+
+	//one span per chunk handler
+	TRACE_BEGIN(hierarchySpan);
+	readJ3DHierarchy(inf1, hierarchyEntryCount, model);
+	TRACE_END(hierarchySpan, "INF1");
+
+	TRACE_BEGIN(jointSpan);
+	if (jnt1 != nullptr)
+		readJ3DJoints(jnt1, model);
+	TRACE_END(jointSpan, "JNT1");
+
+	TRACE_BEGIN(envelopeSpan);
+	readJ3DEnvelopes(evp1, drw1, model);
+	TRACE_END(envelopeSpan, "EVP1/DRW1");
+
+	TRACE_BEGIN(materialSpan);
+	if (mat3 != nullptr)
+		readJ3DMaterials(mat3, model);
+	TRACE_END(materialSpan, "MAT3");
+
+	TRACE_BEGIN(shapeSpan);
+	if (shp1 != nullptr)
+	{
+		struct vertexArray arrays[13];
+		readVertexArrays(vtx1, arrays);
+
+		state.model = model;
+		state.arrays = arrays;
+		state.tableMask = tableSize - 1;
+		state.maxVertices = maxVertices;
+		state.maxIndices = maxIndices;
+
+		const struct shapeData* shapes = OffsetPointer(shp1, SwapEndian(shp1->shapeDataOffset));
+		const uint16_t* remap = OffsetPointer(shp1, SwapEndian(shp1->remapOffset));
+		for (uint32_t s = 0; s < model->shapeCount; s++)
+		{
+			const struct shapeData* shape = &shapes[SwapEndian(remap[s])];
+
+			model->shapeFirstIndex[s] = model->indexCount;
+			decodeShape(&state, shp1, shape);
+			model->shapeIndexCount[s] = model->indexCount - model->shapeFirstIndex[s];
+
+			model->shapeBoundingRadius[s] = SwapEndianFloat(shape->boundingRadius);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				model->shapeBounds[s * 6 + axis] = SwapEndianFloat(shape->boundsMin[axis]);
+				model->shapeBounds[s * 6 + 3 + axis] = SwapEndianFloat(shape->boundsMax[axis]);
+			}
+		}
+	}
+	TRACE_END(shapeSpan, "SHP1/VTX1");
+
+	TRACE_BEGIN(bindPoseSpan);
+	applyJ3DBindPose(model);
+	TRACE_END(bindPoseSpan, "bind pose");
+	TRACE_COUNTER("model vertices", model->vertexCount);
+
+	model->workspaceUsed = allocator.next - (uint8_t*)workspace;
+	return true;
+}
+
+//the model of the selected .szs file, its arrays live in modelWorkspace
+struct j3dModel displayedModel;
+bool displayedModelValid = false;
+
+/*
+* J3D animations
+* bck (ANK1) and bca (ANF1) animate joints, btk (TTK1) texture matrices and brk (TRK1) material colors.
+* every animated value is a track of keys into a value table. a track is sampled to one float per frame the first time
+* it's read and the samples are kept, so playback and export only ever index arrays.
+*/
+#define ANIMATION_JOINT 0
+#define ANIMATION_TEXTURE_SRT 1
+#define ANIMATION_COLOR 2
+
+//a key is (time, value, tangent) or (time, value, in tangent, out tangent), bca tracks store one value per frame
+#define TRACK_KEYS_SHARED_TANGENT 0
+#define TRACK_KEYS_SPLIT_TANGENTS 1
+#define TRACK_FRAMES 2
+
+//joint and texture matrix targets have scale xyz, rotation xyz (radians), translation xyz, in this order
+#define ANIMATION_SRT_TRACKS 9
+//color targets have r, g, b, a (1.0 is 255)
+#define ANIMATION_COLOR_TRACKS 4
+
+//ANF1 (bca) has the same header, angleMultiplier is padding there
+struct ANK1
+{
+	char chunkType[4];
+	uint32_t size;
+	uint8_t loopMode;
+	uint8_t angleMultiplier;
+	uint16_t frameCount;
+	uint16_t jointCount;
+	uint16_t scaleCount;
+	uint16_t rotationCount;
+	uint16_t translationCount;
+	uint32_t jointOffset;
+	uint32_t scaleOffset;
+	uint32_t rotationOffset;
+	uint32_t translationOffset;
+};
+
+struct TTK1
+{
+	char chunkType[4];
+	uint32_t size;
+	uint8_t loopMode;
+	uint8_t angleMultiplier;
+	uint16_t frameCount;
+	uint16_t animationCount;//3 per texture matrix
+	uint16_t scaleCount;
+	uint16_t rotationCount;
+	uint16_t translationCount;
+	uint32_t animationOffset;
+	uint32_t remapOffset;
+	uint32_t nameOffset;
+	uint32_t texMtxIndexOffset;
+	uint32_t centerOffset;
+	uint32_t scaleOffset;
+	uint32_t rotationOffset;
+	uint32_t translationOffset;
+};
+
+struct TRK1
+{
+	char chunkType[4];
+	uint32_t size;
+	uint8_t loopMode;
+	uint8_t padding;
+	uint16_t frameCount;
+	uint16_t registerCount;
+	uint16_t konstCount;
+	uint16_t registerValueCounts[4];
+	uint16_t konstValueCounts[4];
+	uint32_t registerOffset;
+	uint32_t konstOffset;
+	uint32_t registerRemapOffset;
+	uint32_t konstRemapOffset;
+	uint32_t registerNameOffset;
+	uint32_t konstNameOffset;
+	uint32_t registerValueOffsets[4];
+	uint32_t konstValueOffsets[4];
+};
+
+struct animationKeyIndex
+{
+	uint16_t count;
+	uint16_t index;
+	uint16_t tangentMode;
+};
+
+struct animationFrameIndex
+{
+	uint16_t count;
+	uint16_t index;
+};
+
+//one color of a TRK1 chunk, r g b a then the register
+struct colorAnimationEntry
+{
+	struct animationKeyIndex channels[4];
+	uint8_t colorIndex;
+	uint8_t padding[3];
+};
+
+struct animationTrack
+{
+	const uint8_t* values;//the value table, big endian floats or s16
+	uint16_t keyCount;
+	uint16_t firstValue;
+	uint8_t interpolation;
+	bool shortValues;
+	float scale;//s16 values and tangents are multiplied by it, times never are
+	float* samples;//frameCount floats once sampled
+};
+
+struct j3dAnimation
+{
+	uint8_t type;
+	uint8_t loopMode;
+	uint16_t frameCount;
+	uint32_t targetCount;
+	uint32_t tracksPerTarget;
+	struct animationTrack* tracks;//targetCount * tracksPerTarget
+	const char** targetNames;//material names for btk/brk, "" for joints
+	uint8_t* targetSlots;//texture matrix (btk) or color register (brk), the joint index for bck/bca
+	uint32_t firstKonstTarget;//brk targets from here on are konst colors, targetCount for everything else
+
+	//the rest of the workspace caches samples
+	struct workspaceAllocator sampleCache;
+	uint32_t sampledTrackCount;
+};
+
+//the chunk header and everything its size covers have to be inside the file
+static bool isJ3DChunkInFile(const void* j3dFile, uint32_t fileSize, const void* chunk, uint32_t headerSize)
+{
+	if (chunk == nullptr)
+		return false;
+	size_t offset = (const uint8_t*)chunk - (const uint8_t*)j3dFile;
+	if (offset + headerSize > fileSize)
+		return false;
+	uint32_t chunkSize = SwapEndian(((const struct bmdSection*)chunk)->size);
+	return chunkSize >= headerSize && chunkSize <= fileSize - offset;
+}
+
+bool isJ3DAnimation(const void* data, uint32_t size)
+{
+	if (size < sizeof(struct J3DFileHeader) || memcmp(data, "J3D1", 4) != 0)
+		return false;
+	const char* type = OffsetPointer((const char*)data, 4);
+	return memcmp(type, "bck1", 4) == 0 || memcmp(type, "bca1", 4) == 0 || memcmp(type, "btk1", 4) == 0 || memcmp(type, "brk1", 4) == 0;
+}
+
+//a value table is valueCount entries at valueOffset in a chunk of chunkSize bytes
+static bool initAnimationTrack(struct animationTrack* track, const void* chunk, uint32_t chunkSize, uint32_t valueOffset, uint32_t valueCount, bool shortValues, float scale, uint32_t keyCount, uint32_t firstValue, uint32_t interpolation)
+{
+	uint32_t valueSize = shortValues ? 2 : 4;
+	uint32_t stride = interpolation == TRACK_KEYS_SHARED_TANGENT ? 3 : interpolation == TRACK_KEYS_SPLIT_TANGENTS ? 4 : 1;
+	uint32_t usedValues = keyCount <= 1 ? 1 : keyCount * stride;
+
+	track->values = OffsetPointer((const uint8_t*)chunk, valueOffset);
+	track->keyCount = (uint16_t)keyCount;
+	track->firstValue = (uint16_t)firstValue;
+	track->interpolation = (uint8_t)interpolation;
+	track->shortValues = shortValues;
+	track->scale = shortValues ? scale : 1.0f;
+	track->samples = nullptr;
+
+	return keyCount > 0 && firstValue + usedValues <= valueCount && valueOffset <= chunkSize && (uint64_t)valueCount * valueSize <= chunkSize - valueOffset;
+}
+
+//scale, rotation, translation tracks for one axis of a bck/btk entry, the entry layout is x(s r t) y(s r t) z(s r t)
+static bool initSRTTracks(struct animationTrack* tracks, const struct animationKeyIndex* entry, const void* chunk, uint32_t chunkSize, const uint32_t valueOffsets[3], const uint16_t valueCounts[3], float rotationScale)
+{
+	bool valid = true;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int component = 0; component < 3; component++)
+		{
+			const struct animationKeyIndex* key = &entry[axis * 3 + component];
+			uint16_t tangentMode = SwapEndian(key->tangentMode);
+			valid &= initAnimationTrack(
+				&tracks[component * 3 + axis],
+				chunk,
+				chunkSize,
+				valueOffsets[component],
+				valueCounts[component],
+				component == 1,
+				rotationScale,
+				SwapEndian(key->count),
+				SwapEndian(key->index),
+				tangentMode == 0 ? TRACK_KEYS_SHARED_TANGENT : TRACK_KEYS_SPLIT_TANGENTS);
+		}
+	}
+	return valid;
+}
+
+/*
+* parses a bck/bca/btk/brk file. the tracks go into workspace, whatever is left of it caches samples.
+* returns false if the file is malformed or the workspace is too small.
+*/
+bool parseJ3DAnimation(const void* j3dFile, uint32_t fileSize, void* workspace, size_t workspaceSize, struct j3dAnimation* _Out_ animation)
+{
+	memset(animation, 0, sizeof(struct j3dAnimation));
+	if (!isJ3DAnimation(j3dFile, fileSize))
+		return false;
+
+	struct workspaceAllocator allocator;
+	initWorkspaceAllocator(&allocator, workspace, workspaceSize);
+
+	//rotations are s16 fractions of a half turn, scaled by 2^angleMultiplier
+	const float halfTurn = 3.14159265f / 32768.0f;
+	const char* type = OffsetPointer((const char*)j3dFile, 4);
+	bool valid = true;
+
+	if (memcmp(type, "bck1", 4) == 0 || memcmp(type, "btk1", 4) == 0)
+	{
+		bool texture = type[1] == 't';
+		const void* chunk = findJ3DChunk(j3dFile, fileSize, texture ? "TTK1" : "ANK1");
+		if (!isJ3DChunkInFile(j3dFile, fileSize, chunk, texture ? sizeof(struct TTK1) : sizeof(struct ANK1)))
+			return false;
+		uint32_t chunkSize = SwapEndian(((const struct bmdSection*)chunk)->size);
+
+		const struct ANK1* joints = chunk;
+		const struct TTK1* textures = chunk;
+		uint32_t valueOffsets[3];
+		uint16_t valueCounts[3];
+		uint32_t entryOffset;
+		float rotationScale;
+		if (texture)
+		{
+			animation->type = ANIMATION_TEXTURE_SRT;
+			animation->loopMode = textures->loopMode;
+			animation->frameCount = SwapEndian(textures->frameCount);
+			animation->targetCount = SwapEndian(textures->animationCount) / 3;
+			rotationScale = ldexpf(halfTurn, textures->angleMultiplier);
+			entryOffset = SwapEndian(textures->animationOffset);
+			valueOffsets[0] = SwapEndian(textures->scaleOffset);
+			valueOffsets[1] = SwapEndian(textures->rotationOffset);
+			valueOffsets[2] = SwapEndian(textures->translationOffset);
+			valueCounts[0] = SwapEndian(textures->scaleCount);
+			valueCounts[1] = SwapEndian(textures->rotationCount);
+			valueCounts[2] = SwapEndian(textures->translationCount);
+		}
+		else
+		{
+			animation->type = ANIMATION_JOINT;
+			animation->loopMode = joints->loopMode;
+			animation->frameCount = SwapEndian(joints->frameCount);
+			animation->targetCount = SwapEndian(joints->jointCount);
+			rotationScale = ldexpf(halfTurn, joints->angleMultiplier);
+			entryOffset = SwapEndian(joints->jointOffset);
+			valueOffsets[0] = SwapEndian(joints->scaleOffset);
+			valueOffsets[1] = SwapEndian(joints->rotationOffset);
+			valueOffsets[2] = SwapEndian(joints->translationOffset);
+			valueCounts[0] = SwapEndian(joints->scaleCount);
+			valueCounts[1] = SwapEndian(joints->rotationCount);
+			valueCounts[2] = SwapEndian(joints->translationCount);
+		}
+
+		const uint32_t entrySize = sizeof(struct animationKeyIndex) * 9;
+		if (entryOffset > chunkSize || (uint64_t)animation->targetCount * entrySize > chunkSize - entryOffset)
+			return false;
+
+		animation->tracksPerTarget = ANIMATION_SRT_TRACKS;
+		animation->tracks = workspaceAllocArray(&allocator, struct animationTrack, animation->targetCount * ANIMATION_SRT_TRACKS);
+		animation->targetNames = workspaceAllocArray(&allocator, const char*, animation->targetCount);
+		animation->targetSlots = workspaceAllocArray(&allocator, uint8_t, animation->targetCount);
+		if (allocator.failed)
+			return false;
+
+		const void* names = texture ? getJ3DNameTable(chunk, SwapEndian(textures->nameOffset)) : nullptr;
+		const uint8_t* texMtxIndices = texture && textures->texMtxIndexOffset ? OffsetPointer((const uint8_t*)chunk, SwapEndian(textures->texMtxIndexOffset)) : nullptr;
+		if (texMtxIndices != nullptr && SwapEndian(textures->texMtxIndexOffset) + animation->targetCount > chunkSize)
+			return false;
+		for (uint32_t i = 0; i < animation->targetCount; i++)
+		{
+			const struct animationKeyIndex* entry = OffsetPointer(chunk, entryOffset + i * entrySize);
+			valid &= initSRTTracks(&animation->tracks[i * ANIMATION_SRT_TRACKS], entry, chunk, chunkSize, valueOffsets, valueCounts, rotationScale);
+			animation->targetNames[i] = getJ3DName(names, i);
+			animation->targetSlots[i] = texMtxIndices ? texMtxIndices[i] : (uint8_t)i;
+		}
+		animation->firstKonstTarget = animation->targetCount;
+	}
+	else if (memcmp(type, "bca1", 4) == 0)
+	{
+		const struct ANK1* joints = (const struct ANK1*)findJ3DChunk(j3dFile, fileSize, "ANF1");
+		if (!isJ3DChunkInFile(j3dFile, fileSize, joints, sizeof(struct ANK1)))
+			return false;
+		uint32_t chunkSize = SwapEndian(joints->size);
+		uint32_t entryOffset = SwapEndian(joints->jointOffset);
+
+		animation->type = ANIMATION_JOINT;
+		animation->loopMode = joints->loopMode;
+		animation->frameCount = SwapEndian(joints->frameCount);
+		animation->targetCount = SwapEndian(joints->jointCount);
+		animation->tracksPerTarget = ANIMATION_SRT_TRACKS;
+		animation->firstKonstTarget = animation->targetCount;
+
+		const uint32_t entrySize = sizeof(struct animationFrameIndex) * 9;
+		if (entryOffset > chunkSize || (uint64_t)animation->targetCount * entrySize > chunkSize - entryOffset)
+			return false;
+
+		animation->tracks = workspaceAllocArray(&allocator, struct animationTrack, animation->targetCount * ANIMATION_SRT_TRACKS);
+		animation->targetNames = workspaceAllocArray(&allocator, const char*, animation->targetCount);
+		animation->targetSlots = workspaceAllocArray(&allocator, uint8_t, animation->targetCount);
+		if (allocator.failed)
+			return false;
+
+		const uint32_t valueOffsets[3] = { SwapEndian(joints->scaleOffset), SwapEndian(joints->rotationOffset), SwapEndian(joints->translationOffset) };
+		const uint16_t valueCounts[3] = { SwapEndian(joints->scaleCount), SwapEndian(joints->rotationCount), SwapEndian(joints->translationCount) };
+		for (uint32_t i = 0; i < animation->targetCount; i++)
+		{
+			const struct animationFrameIndex* entry = OffsetPointer(joints, entryOffset + i * entrySize);
+			for (int axis = 0; axis < 3; axis++)
+				for (int component = 0; component < 3; component++)
+				{
+					const struct animationFrameIndex* frames = &entry[axis * 3 + component];
+					valid &= initAnimationTrack(
+						&animation->tracks[i * ANIMATION_SRT_TRACKS + component * 3 + axis],
+						joints,
+						chunkSize,
+						valueOffsets[component],
+						valueCounts[component],
+						component == 1,
+						halfTurn,
+						SwapEndian(frames->count),
+						SwapEndian(frames->index),
+						TRACK_FRAMES);
+				}
+			animation->targetNames[i] = "";
+			animation->targetSlots[i] = (uint8_t)i;
+		}
+	}
+	else
+	{
+		const struct TRK1* colors = (const struct TRK1*)findJ3DChunk(j3dFile, fileSize, "TRK1");
+		if (!isJ3DChunkInFile(j3dFile, fileSize, colors, sizeof(struct TRK1)))
+			return false;
+		uint32_t chunkSize = SwapEndian(colors->size);
+
+		uint32_t registerCount = SwapEndian(colors->registerCount);
+		uint32_t konstCount = SwapEndian(colors->konstCount);
+		animation->type = ANIMATION_COLOR;
+		animation->loopMode = colors->loopMode;
+		animation->frameCount = SwapEndian(colors->frameCount);
+		animation->targetCount = registerCount + konstCount;
+		animation->tracksPerTarget = ANIMATION_COLOR_TRACKS;
+		animation->firstKonstTarget = registerCount;
+
+		animation->tracks = workspaceAllocArray(&allocator, struct animationTrack, animation->targetCount * ANIMATION_COLOR_TRACKS);
+		animation->targetNames = workspaceAllocArray(&allocator, const char*, animation->targetCount);
+		animation->targetSlots = workspaceAllocArray(&allocator, uint8_t, animation->targetCount);
+		if (allocator.failed)
+			return false;
+
+		for (int konst = 0; konst < 2; konst++)
+		{
+			uint32_t count = konst ? konstCount : registerCount;
+			uint32_t entryOffset = SwapEndian(konst ? colors->konstOffset : colors->registerOffset);
+			uint32_t nameOffset = SwapEndian(konst ? colors->konstNameOffset : colors->registerNameOffset);
+			const uint32_t* valueOffsets = konst ? colors->konstValueOffsets : colors->registerValueOffsets;
+			const uint16_t* valueCounts = konst ? colors->konstValueCounts : colors->registerValueCounts;
+			const void* names = getJ3DNameTable(colors, nameOffset);
+			if (entryOffset > chunkSize || (uint64_t)count * sizeof(struct colorAnimationEntry) > chunkSize - entryOffset)
+				return false;
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const struct colorAnimationEntry* entry = OffsetPointer((const struct colorAnimationEntry*)colors, entryOffset + i * sizeof(struct colorAnimationEntry));
+				uint32_t target = konst ? registerCount + i : i;
+				for (int channel = 0; channel < 4; channel++)
+				{
+					uint16_t tangentMode = SwapEndian(entry->channels[channel].tangentMode);
+					valid &= initAnimationTrack(
+						&animation->tracks[target * ANIMATION_COLOR_TRACKS + channel],
+						colors,
+						chunkSize,
+						SwapEndian(valueOffsets[channel]),
+						SwapEndian(valueCounts[channel]),
+						true,
+						1.0f / 255.0f,
+						SwapEndian(entry->channels[channel].count),
+						SwapEndian(entry->channels[channel].index),
+						tangentMode == 0 ? TRACK_KEYS_SHARED_TANGENT : TRACK_KEYS_SPLIT_TANGENTS);
+				}
+				animation->targetNames[target] = getJ3DName(names, i);
+				animation->targetSlots[target] = entry->colorIndex;
+			}
+		}
+	}
+
+	initWorkspaceAllocator(&animation->sampleCache, allocator.next, allocator.end - allocator.next);
+	return valid;
+}
+
+//raw table entry, s16 entries aren't scaled
+static inline float readAnimationValue(const struct animationTrack* track, uint32_t index)
+{
+	if (track->shortValues)
+		return (int16_t)SwapEndian(*(const uint16_t*)(track->values + index * 2));
+	return IntAsFloat(SwapEndian(*(const uint32_t*)(track->values + index * 4)));
+}
+
+static inline float hermiteInterpolate(float p0, float p1, float s0, float s1, float t)
+{
+	float t2 = t * t;
+	float t3 = t2 * t;
+	return p0 * (2.0f * t3 - 3.0f * t2 + 1.0f) + p1 * (-2.0f * t3 + 3.0f * t2) + s0 * (t3 - 2.0f * t2 + t) + s1 * (t3 - t2);
+}
+
+//evaluates a track at every frame, walking the keys forward once
+static void sampleAnimationTrack(const struct animationTrack* track, uint32_t frameCount, float* _Out_ samples)
+{
+	if (track->keyCount == 1)
+	{
+		float value = readAnimationValue(track, track->firstValue) * track->scale;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+			samples[frame] = value;
+		return;
+	}
+
+	if (track->interpolation == TRACK_FRAMES)
+	{
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+			samples[frame] = readAnimationValue(track, track->firstValue + min(frame, track->keyCount - 1u)) * track->scale;
+		return;
+	}
+
+	uint32_t stride = track->interpolation == TRACK_KEYS_SHARED_TANGENT ? 3 : 4;
+	uint32_t lastKey = track->keyCount - 1;
+	uint32_t key = 0;
+
+	//the segment between key and key + 1
+	float time0 = 0.0f, time1 = 0.0f, value0 = 0.0f, value1 = 0.0f, tangent0 = 0.0f, tangent1 = 0.0f;
+	bool segmentLoaded = false;
+
+	for (uint32_t frame = 0; frame < frameCount; frame++)
+	{
+		while (key < lastKey && readAnimationValue(track, track->firstValue + (key + 1) * stride) <= (float)frame)
+		{
+			key++;
+			segmentLoaded = false;
+		}
+
+		if (!segmentLoaded)
+		{
+			const uint32_t k0 = track->firstValue + key * stride;
+			const uint32_t k1 = track->firstValue + min(key + 1, lastKey) * stride;
+			time0 = readAnimationValue(track, k0);
+			value0 = readAnimationValue(track, k0 + 1) * track->scale;
+			tangent0 = readAnimationValue(track, k0 + stride - 1) * track->scale;//out tangent
+			time1 = readAnimationValue(track, k1);
+			value1 = readAnimationValue(track, k1 + 1) * track->scale;
+			tangent1 = readAnimationValue(track, k1 + 2) * track->scale;//in tangent
+			segmentLoaded = true;
+		}
+
+		if (key == lastKey || (float)frame <= time0 || time1 <= time0)
+		{
+			samples[frame] = value0;
+			continue;
+		}
+
+		float length = time1 - time0;
+		samples[frame] = hermiteInterpolate(value0, value1, tangent0 * length, tangent1 * length, ((float)frame - time0) / length);
+	}
+}
+
+//the samples of a track, sampled on first use. nullptr if the sample cache is full
+const float* getAnimationSamples(struct j3dAnimation* animation, uint32_t trackIndex)
+{
+	struct animationTrack* track = &animation->tracks[trackIndex];
+	if (track->samples != nullptr)
+		return track->samples;
+
+	float* samples = workspaceAllocArray(&animation->sampleCache, float, max(animation->frameCount, 1));
+	if (animation->sampleCache.failed)
+	{
+		animation->sampleCache.failed = false;
+		return nullptr;
+	}
+
+	sampleAnimationTrack(track, max(animation->frameCount, 1), samples);
+	track->samples = samples;
+	animation->sampledTrackCount++;
+	return samples;
+}
+
+//maps a playback frame into the animation according to its loop mode (2 repeats, 4 repeats mirrored, the rest stop on the last frame)
+uint32_t wrapAnimationFrame(const struct j3dAnimation* animation, uint32_t frame)
+{
+	uint32_t frameCount = max(animation->frameCount, 1);
+	if (animation->loopMode == 2)
+		return frame % frameCount;
+	if (animation->loopMode == 4 && frameCount > 1)
+	{
+		uint32_t period = (frameCount - 1) * 2;
+		uint32_t phase = frame % period;
+		return phase < frameCount ? phase : period - phase;
+	}
+	return min(frame, frameCount - 1);
+}
+
+//every track of a target at one frame (tracksPerTarget values). returns false if the sample cache is full
+bool getAnimationTargetValues(struct j3dAnimation* animation, uint32_t target, uint32_t frame, float* _Out_ values)
+{
+	frame = wrapAnimationFrame(animation, frame);
+	for (uint32_t i = 0; i < animation->tracksPerTarget; i++)
+	{
+		const float* samples = getAnimationSamples(animation, target * animation->tracksPerTarget + i);
+		if (samples == nullptr)
+			return false;
+		values[i] = samples[frame];
+	}
+	return true;
+}
+
+/*
+* JSystem resources outside J3D (JPA particles, J2D screens) use the same block header, its size includes the header
+*/
+struct jsystemBlock
+{
+	char magic[4];
+	uint32_t size;
+};
+
+//the block at offset if all of it is before end, offset is moved past it
+static const struct jsystemBlock* nextJSystemBlock(const uint8_t* file, uint32_t* offset, uint32_t end)
+{
+	if (!isRangeInside(*offset, sizeof(struct jsystemBlock), end))
+		return nullptr;
+	const struct jsystemBlock* block = OffsetPointer((const struct jsystemBlock*)file, *offset);
+	uint32_t size = SwapEndian(block->size);
+	if (size < sizeof(struct jsystemBlock) || !isRangeInside(*offset, size, end))
+		return nullptr;
+	*offset += size;
+	return block;
+}
+
+//bytes a texture takes in memory: every level in the file and the palette
+uint32_t getTextureMemorySize(const struct btiTexture* texture)
+{
+	return getTextureLevelsSize(texture) + texture->paletteSize;
+}
+
+/*
+* JPA particle resources (.jpc)
+* a JPAC2-10/2-11 file is a list of resources, one per emitter, each a header and its blocks: BEM1 (the emitter), BSP1, ESP1,
+* SSP1 and ETX1 (shapes), FLD1 (fields), KFA1 (keys) and TDB1, which maps the emitter's texture slots to the texture list.
+* the texture list follows the resources, one TEX1 block per texture with its name and a bti.
+* parseJPC reads the block headers, the BEM1 flags and TDB1 and nothing else, every slot is resolved to its bti.
+*/
+#define JPC_TEXTURE_NAME_LENGTH 0x14
+#define JPC_NO_TEXTURE 0xFFFF
+
+struct jpcHeader
+{
+	char magic[8];
+	uint16_t resourceCount;
+	uint16_t textureCount;
+	uint32_t textureTableOffset;
+};
+
+struct jpaResourceHeader
+{
+	uint16_t resourceId;
+	uint16_t blockCount;
+	uint8_t fieldBlockCount;
+	uint8_t keyBlockCount;
+	uint8_t textureSlotCount;
+	uint8_t padding;
+};
+
+//the bti header follows it
+struct jpaTextureBlock
+{
+	char magic[4];
+	uint32_t size;
+	uint8_t unknown[4];
+	char name[JPC_TEXTURE_NAME_LENGTH];
+};
+
+struct jpaEmitter
+{
+	uint16_t resourceId;
+	uint16_t blockCount;
+	uint8_t fieldBlockCount;
+	uint8_t keyBlockCount;
+	uint32_t emitterFlags;//first word of BEM1, 0 without one
+	uint32_t firstTextureSlot;//into jpcFile.textureSlots
+	uint32_t textureSlotCount;
+};
+
+struct jpcTexture
+{
+	char name[JPC_TEXTURE_NAME_LENGTH + 1];
+	struct btiTexture texture;//data is nullptr if the bti is malformed
+	uint32_t slotCount;//slots that resolve to it
+};
+
+struct jpcFile
+{
+	uint32_t emitterCount;
+	uint32_t textureCount;
+	uint32_t textureSlotCount;
+	uint32_t unresolvedSlotCount;
+	struct jpaEmitter* emitters;
+	struct jpcTexture* textures;
+	uint16_t* textureSlots;//texture list index per slot, JPC_NO_TEXTURE past the end of the list
+};
+
+bool isJPCFile(const void* data, uint32_t size)
+{
+	return size >= sizeof(struct jpcHeader) && (memcmp(data, "JPAC2-10", 8) == 0 || memcmp(data, "JPAC2-11", 8) == 0);
+}
+
+//the arrays go into workspace. returns false if the file is malformed or the workspace is too small
+bool parseJPC(const void* jpcData, uint32_t fileSize, void* workspace, size_t workspaceSize, struct jpcFile* _Out_ jpc)
+{
+	memset(jpc, 0, sizeof(struct jpcFile));
+	if (!isJPCFile(jpcData, fileSize))
+		return false;
+
+	const uint8_t* file = jpcData;
+	const struct jpcHeader* header = jpcData;
+	uint32_t resourceCount = SwapEndian(header->resourceCount);
+	uint32_t textureCount = SwapEndian(header->textureCount);
+	uint32_t textureTableOffset = SwapEndian(header->textureTableOffset);
+	if (textureTableOffset < sizeof(struct jpcHeader) || textureTableOffset > fileSize ||
+		(uint64_t)resourceCount * sizeof(struct jpaResourceHeader) > textureTableOffset - sizeof(struct jpcHeader) ||
+		(uint64_t)textureCount * sizeof(struct jpaTextureBlock) > fileSize - textureTableOffset)
+		return false;
+
+	//TDB1 blocks don't overlap, so there are fewer slots than u16s before the texture list
+	struct workspaceAllocator allocator;
+	initWorkspaceAllocator(&allocator, workspace, workspaceSize);
+	jpc->emitters = workspaceAllocArray(&allocator, struct jpaEmitter, resourceCount);
+	jpc->textures = workspaceAllocArray(&allocator, struct jpcTexture, textureCount);
+	jpc->textureSlots = workspaceAllocArray(&allocator, uint16_t, textureTableOffset / 2);
+	if (allocator.failed)
+		return false;
+
+	uint32_t offset = textureTableOffset;
+	for (uint32_t t = 0; t < textureCount; t++)
+	{
+		const struct jsystemBlock* block = nextJSystemBlock(file, &offset, fileSize);
+		if (block == nullptr || SwapEndian(block->size) < sizeof(struct jpaTextureBlock) || memcmp(block->magic, "TEX1", 4) != 0)
+			return false;
+
+		const struct jpaTextureBlock* entry = (const struct jpaTextureBlock*)block;
+		struct jpcTexture* texture = &jpc->textures[t];
+		memcpy(texture->name, entry->name, JPC_TEXTURE_NAME_LENGTH);
+		texture->name[JPC_TEXTURE_NAME_LENGTH] = 0;
+		texture->slotCount = 0;
+		loadBTITexture(OffsetPointer(entry, sizeof(struct jpaTextureBlock)), SwapEndian(block->size) - sizeof(struct jpaTextureBlock), &texture->texture);
+	}
+	jpc->textureCount = textureCount;
+
+	offset = sizeof(struct jpcHeader);
+	for (uint32_t r = 0; r < resourceCount; r++)
+	{
+		if (!isRangeInside(offset, sizeof(struct jpaResourceHeader), textureTableOffset))
+			return false;
+		const struct jpaResourceHeader* resource = OffsetPointer((const struct jpaResourceHeader*)file, offset);
+		offset += sizeof(struct jpaResourceHeader);
+
+		struct jpaEmitter* emitter = &jpc->emitters[r];
+		emitter->resourceId = SwapEndian(resource->resourceId);
+		emitter->blockCount = SwapEndian(resource->blockCount);
+		emitter->fieldBlockCount = resource->fieldBlockCount;
+		emitter->keyBlockCount = resource->keyBlockCount;
+		emitter->emitterFlags = 0;
+		emitter->firstTextureSlot = jpc->textureSlotCount;
+		emitter->textureSlotCount = 0;
+
+		for (uint32_t b = 0; b < emitter->blockCount; b++)
+		{
+			const struct jsystemBlock* block = nextJSystemBlock(file, &offset, textureTableOffset);
+			if (block == nullptr)
+				return false;
+			uint32_t blockSize = SwapEndian(block->size);
+
+			if (memcmp(block->magic, "BEM1", 4) == 0 && blockSize >= sizeof(struct jsystemBlock) + 4)
+			{
+				emitter->emitterFlags = SwapEndian(*OffsetPointer((const uint32_t*)block, sizeof(struct jsystemBlock)));
+			}
+			else if (memcmp(block->magic, "TDB1", 4) == 0)
+			{
+				//the resource header has the slot count, the block is padded
+				const uint8_t* slots = OffsetPointer((const uint8_t*)block, sizeof(struct jsystemBlock));
+				uint32_t slotCount = min((uint32_t)resource->textureSlotCount, (blockSize - (uint32_t)sizeof(struct jsystemBlock)) / 2);
+				for (uint32_t s = 0; s < slotCount; s++)
+				{
+					uint16_t index = (uint16_t)(slots[s * 2] << 8 | slots[s * 2 + 1]);
+					if (index < textureCount)
+					{
+						jpc->textures[index].slotCount++;
+					}
+					else
+					{
+						index = JPC_NO_TEXTURE;
+						jpc->unresolvedSlotCount++;
+					}
+					jpc->textureSlots[jpc->textureSlotCount++] = index;
+				}
+				emitter->textureSlotCount += slotCount;
+			}
+		}
+	}
+	jpc->emitterCount = resourceCount;
+	return true;
+}
+
+/*
+* J2D screen layouts (.blo)
+* a SCRNblo1 file is a list of blocks in draw order: INF1 (the screen size), panes (PAN1, PIC1, WIN1, TBX1), BGN1 and END1
+* around the children of the pane before them, and in files with materials the resource lists (TEX1, FNT1) and MAT1 first.
+* resources are named by reference strings, a type byte, a length byte and the name. panes carry their own when there are
+* no materials, otherwise TEX1 lists them. parseBLO flattens the pane tree and collects the .bti names without reading
+* anything else, resolveScreenTextures then looks them up in the archive the screen came from.
+*/
+#define BLO_MAX_DEPTH 32
+
+struct bloHeader
+{
+	char magic[8];
+	uint32_t fileSize;
+	uint32_t blockCount;
+	uint8_t padding[16];
+};
+
+struct bloInfo
+{
+	char magic[4];
+	uint32_t size;
+	uint16_t width;
+	uint16_t height;
+};
+
+struct screenPane
+{
+	char kind[4];//block type
+	int32_t parent;//-1 at the top
+	uint32_t depth;
+	uint32_t firstTexture;//into screenLayout.textureRefs
+	uint32_t textureCount;
+};
+
+struct screenTexture
+{
+	const char* name;//in the file, not terminated
+	uint32_t nameLength;
+	int32_t member;//archive member, -1 if it isn't resolved
+	uint32_t memorySize;//0 if it isn't resolved
+	uint32_t paneCount;//0 if it's only in the resource list
+};
+
+struct screenLayout
+{
+	uint16_t width;
+	uint16_t height;
+	uint32_t paneCount;
+	uint32_t maxDepth;
+	uint32_t textureCount;
+	uint32_t textureRefCount;
+	struct screenPane* panes;
+	struct screenTexture* textures;//every name once, in order of first use
+	uint32_t* textureRefs;//the textures of each pane
+	//set by resolveScreenTextures
+	uint32_t textureMemorySize;//every resolved file once
+	uint32_t missingTextureCount;
+};
+
+bool isBLOFile(const void* data, uint32_t size)
+{
+	return size >= sizeof(struct bloHeader) && memcmp(data, "SCRNblo1", 8) == 0;
+}
+
+static bool isScreenPaneBlock(const struct jsystemBlock* block)
+{
+	return memcmp(block->magic, "PAN1", 4) == 0 || memcmp(block->magic, "PIC1", 4) == 0 || memcmp(block->magic, "WIN1", 4) == 0 || memcmp(block->magic, "TBX1", 4) == 0;
+}
+
+//the next reference string ending in .bti in data[*offset, end), offset is moved past it
+static bool findBTIReference(const uint8_t* data, uint32_t* offset, uint32_t end, uint32_t* _Out_ nameOffset, uint32_t* _Out_ nameLength)
+{
+	for (uint32_t extension = *offset + 3; extension + 4 <= end; extension++)
+	{
+		if (data[extension] != '.' || _strnicmp((const char*)data + extension, ".bti", 4) != 0)
+			continue;
+
+		//the shortest printable name whose length byte matches, printable bytes are never a length under 32
+		uint32_t nameEnd = extension + 4;
+		for (uint32_t length = 5; length <= 255 && *offset + 2 + length <= nameEnd; length++)
+		{
+			uint8_t c = data[nameEnd - length];
+			if (c < 0x20 || c > 0x7E)
+				break;
+			if (data[nameEnd - length - 1] == length)
+			{
+				*nameOffset = nameEnd - length;
+				*nameLength = length;
+				*offset = nameEnd;
+				return true;
+			}
+		}
+	}
+	*offset = end;
+	return false;
+}
+
+//the index of a texture name, added if it's new
+static uint32_t addScreenTexture(struct screenLayout* screen, const char* name, uint32_t nameLength)
+{
+	for (uint32_t t = 0; t < screen->textureCount; t++)
+		if (screen->textures[t].nameLength == nameLength && _strnicmp(screen->textures[t].name, name, nameLength) == 0)
+			return t;
+
+	struct screenTexture* texture = &screen->textures[screen->textureCount];
+	texture->name = name;
+	texture->nameLength = nameLength;
+	texture->member = -1;
+	texture->memorySize = 0;
+	texture->paneCount = 0;
+	return screen->textureCount++;
+}
+
+//the arrays go into workspace. returns false if the file is malformed or the workspace is too small, blocks past one that doesn't fit are dropped
+bool parseBLO(const void* bloData, uint32_t fileSize, void* workspace, size_t workspaceSize, struct screenLayout* _Out_ screen)
+{
+	memset(screen, 0, sizeof(struct screenLayout));
+	if (!isBLOFile(bloData, fileSize))
+		return false;
+
+	//a block is at least its header and a reference at least its two bytes and "a.bti"
+	const uint8_t* file = bloData;
+	uint32_t blockCount = SwapEndian(((const struct bloHeader*)bloData)->blockCount);
+	uint32_t maxReferences = fileSize / 7;
+	struct workspaceAllocator allocator;
+	initWorkspaceAllocator(&allocator, workspace, workspaceSize);
+	screen->panes = workspaceAllocArray(&allocator, struct screenPane, min(blockCount, fileSize / (uint32_t)sizeof(struct jsystemBlock)));
+	screen->textures = workspaceAllocArray(&allocator, struct screenTexture, maxReferences);
+	screen->textureRefs = workspaceAllocArray(&allocator, uint32_t, maxReferences);
+	if (allocator.failed)
+		return false;
+
+	int32_t parents[BLO_MAX_DEPTH];
+	uint32_t depth = 0;
+	int32_t lastPane = -1;
+	uint32_t offset = sizeof(struct bloHeader);
+	for (uint32_t b = 0; b < blockCount; b++)
+	{
+		uint32_t blockOffset = offset;
+		const struct jsystemBlock* block = nextJSystemBlock(file, &offset, fileSize);
+		if (block == nullptr || memcmp(block->magic, "EXT1", 4) == 0)
+			break;
+
+		if (memcmp(block->magic, "INF1", 4) == 0 && SwapEndian(block->size) >= sizeof(struct bloInfo))
+		{
+			const struct bloInfo* info = (const struct bloInfo*)block;
+			screen->width = SwapEndian(info->width);
+			screen->height = SwapEndian(info->height);
+			continue;
+		}
+		if (memcmp(block->magic, "BGN1", 4) == 0)
+		{
+			if (lastPane < 0 || depth == BLO_MAX_DEPTH)
+				return false;
+			parents[depth++] = lastPane;
+			continue;
+		}
+		if (memcmp(block->magic, "END1", 4) == 0)
+		{
+			if (depth == 0)
+				return false;
+			lastPane = parents[--depth];
+			continue;
+		}
+
+		struct screenPane* pane = nullptr;
+		if (isScreenPaneBlock(block))
+		{
+			pane = &screen->panes[screen->paneCount];
+			memcpy(pane->kind, block->magic, 4);
+			pane->parent = depth > 0 ? parents[depth - 1] : -1;
+			pane->depth = depth;
+			pane->firstTexture = screen->textureRefCount;
+			pane->textureCount = 0;
+			screen->maxDepth = max(screen->maxDepth, depth);
+			lastPane = screen->paneCount++;
+		}
+
+		uint32_t cursor = blockOffset + sizeof(struct jsystemBlock);
+		uint32_t nameOffset, nameLength;
+		while (findBTIReference(file, &cursor, offset, &nameOffset, &nameLength))
+		{
+			uint32_t texture = addScreenTexture(screen, (const char*)file + nameOffset, nameLength);
+			if (pane == nullptr)
+				continue;
+
+			//a window can use the same texture for several corners, it's one use
+			bool repeated = false;
+			for (uint32_t i = 0; i < pane->textureCount; i++)
+				repeated |= screen->textureRefs[pane->firstTexture + i] == texture;
+			if (repeated)
+				continue;
+			screen->textureRefs[screen->textureRefCount++] = texture;
+			screen->textures[texture].paneCount++;
+			pane->textureCount++;
+		}
+	}
+	return true;
+}
+
+//looks the texture names up in the .bti members of the screen's archive by file name, directories in a name are ignored
+void resolveScreenTextures(struct screenLayout* screen, const struct archiveMember* members, int memberCount)
+{
+	screen->textureMemorySize = 0;
+	screen->missingTextureCount = 0;
+	for (uint32_t t = 0; t < screen->textureCount; t++)
+	{
+		struct screenTexture* texture = &screen->textures[t];
+		const char* fileName = texture->name;
+		for (uint32_t c = 0; c < texture->nameLength; c++)
+			if (texture->name[c] == '/' || texture->name[c] == '\\')
+				fileName = texture->name + c + 1;
+		size_t fileNameLength = texture->nameLength - (fileName - texture->name);
+
+		texture->member = -1;
+		texture->memorySize = 0;
+		for (int i = 0; i < memberCount; i++)
+		{
+			struct btiTexture bti;
+			if (strlen(members[i].name) != fileNameLength || _strnicmp(members[i].name, fileName, fileNameLength) != 0 ||
+				!loadBTITexture(members[i].data, members[i].size, &bti))
+				continue;
+			texture->member = i;
+			texture->memorySize = getTextureMemorySize(&bti);
+			break;
+		}
+
+		if (texture->member < 0)
+		{
+			screen->missingTextureCount++;
+			continue;
+		}
+
+		//names with different directories can resolve to the same file, it's only loaded once
+		bool counted = false;
+		for (uint32_t earlier = 0; earlier < t; earlier++)
+			counted |= screen->textures[earlier].member == texture->member;
+		if (!counted)
+			screen->textureMemorySize += texture->memorySize;
+	}
+}
+
+/*
+* software rasterizer for model previews
+* vertices are projected once, triangles are set up and binned into screen tiles,
+* then every tile is rasterized on its own, 4 pixels at a time with SSE edge functions, against a 1/w depth buffer.
+* there's no backface culling, materials that cull everything are skipped.
+*/
+#define RASTER_TILE_SIZE 32
+#define RASTER_MAX_CHUNKS 32
+#define RASTER_MAX_TEXTURES 256
+
+struct rasterVertex
+{
+	float x;
+	float y;
+	//invW (0 if behind the camera), then u, v, r, g, b, a premultiplied by invW for perspective correct interpolation
+	float attributes[7];
+};
+
+struct rasterTriangle
+{
+	float edgeA[3];
+	float edgeB[3];
+	float edgeC[3];
+	float invArea;
+	int32_t minX;//minX > maxX if the triangle isn't drawn
+	int32_t minY;
+	int32_t maxX;
+	int32_t maxY;
+	uint32_t vertices[3];
+	int32_t texture;
+	uint32_t color;
+};
+
+struct rasterizer
+{
+	const struct j3dModel* model;
+	const struct decodedImage* const* textures;
+	uint32_t textureCount;
+
+	uint32_t width;
+	uint32_t height;
+	uint32_t* color;
+	float* depth;
+
+	struct rasterVertex* vertices;
+	struct rasterTriangle* triangles;
+	uint32_t triangleCount;
+
+	//triangles are binned per chunk of the triangle list, so binning needs no locks
+	uint32_t tilesX;
+	uint32_t tilesY;
+	uint32_t tileCount;
+	uint32_t chunkCount;
+	uint32_t* binCounts;//[chunk][tile]
+	uint32_t* binOffsets;//[chunk][tile]
+	uint32_t* binTriangles;
+
+	float eye[3];
+	float right[3];
+	float up[3];
+	float forward[3];
+	float focal;
+};
+
+static void runRasterPhase(struct rasterizer* rasterizer, int jobCount, parallelJob job, bool multithreaded)
+{
+	if (multithreaded)
+		runParallel(jobCount, job, rasterizer);
+	else
+		for (int i = 0; i < jobCount; i++)
+			job(i, 0, rasterizer);
+}
+
+static inline float dot3(const float* a, const float* b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static inline void normalize3(float* v)
+{
+	float length = sqrtf(dot3(v, v));
+	if (length > 0.0f)
+	{
+		v[0] /= length;
+		v[1] /= length;
+		v[2] /= length;
+	}
+}
+
+//looks at the model bounds from the front, a bit from above and to the side
+static void setupRasterCamera(struct rasterizer* rasterizer)
+{
+	const struct j3dModel* model = rasterizer->model;
+
+	float boundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (uint32_t i = 0; i < model->vertexCount; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			boundsMin[axis] = fminf(boundsMin[axis], model->vertices[i].position[axis]);
+			boundsMax[axis] = fmaxf(boundsMax[axis], model->vertices[i].position[axis]);
+		}
+	}
+	if (model->vertexCount == 0)
+	{
+		memset(boundsMin, 0, sizeof(boundsMin));
+		memset(boundsMax, 0, sizeof(boundsMax));
+	}
+
+	float center[3];
+	float extent[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		center[axis] = (boundsMin[axis] + boundsMax[axis]) * 0.5f;
+		extent[axis] = (boundsMax[axis] - boundsMin[axis]) * 0.5f;
+	}
+	float radius = fmaxf(sqrtf(dot3(extent, extent)), 0.001f);
+
+	const float fieldOfView = 0.7f;
+	float distance = radius / sinf(fieldOfView * 0.5f);
+
+	float direction[3] = { 0.55f, 0.45f, 0.7f };
+	normalize3(direction);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		rasterizer->eye[axis] = center[axis] + direction[axis] * distance;
+		rasterizer->forward[axis] = -direction[axis];
+	}
+
+	const float worldUp[3] = { 0.0f, 1.0f, 0.0f };
+	rasterizer->right[0] = rasterizer->forward[1] * worldUp[2] - rasterizer->forward[2] * worldUp[1];
+	rasterizer->right[1] = rasterizer->forward[2] * worldUp[0] - rasterizer->forward[0] * worldUp[2];
+	rasterizer->right[2] = rasterizer->forward[0] * worldUp[1] - rasterizer->forward[1] * worldUp[0];
+	normalize3(rasterizer->right);
+	rasterizer->up[0] = rasterizer->right[1] * rasterizer->forward[2] - rasterizer->right[2] * rasterizer->forward[1];
+	rasterizer->up[1] = rasterizer->right[2] * rasterizer->forward[0] - rasterizer->right[0] * rasterizer->forward[2];
+	rasterizer->up[2] = rasterizer->right[0] * rasterizer->forward[1] - rasterizer->right[1] * rasterizer->forward[0];
+
+	rasterizer->focal = min(rasterizer->width, rasterizer->height) * 0.5f / tanf(fieldOfView * 0.5f);
+}
+
+static void projectVerticesJob(int chunkIndex, int threadIndex, void* context)
+{
+	struct rasterizer* rasterizer = context;
+	const struct j3dModel* model = rasterizer->model;
+
+	uint32_t begin = (uint32_t)((uint64_t)model->vertexCount * chunkIndex / rasterizer->chunkCount);
+	uint32_t end = (uint32_t)((uint64_t)model->vertexCount * (chunkIndex + 1) / rasterizer->chunkCount);
+
+	float light[3] = { 0.4f, 0.8f, 0.45f };
+	normalize3(light);
+
+	for (uint32_t i = begin; i < end; i++)
+	{
+		const struct j3dVertex* vertex = &model->vertices[i];
+		struct rasterVertex* out = &rasterizer->vertices[i];
+
+		float relative[3] = {
+			vertex->position[0] - rasterizer->eye[0],
+			vertex->position[1] - rasterizer->eye[1],
+			vertex->position[2] - rasterizer->eye[2]
+		};
+		float viewZ = dot3(relative, rasterizer->forward);
+		if (viewZ < 0.0001f)
+		{
+			out->attributes[0] = 0.0f;
+			continue;
+		}
+
+		float invW = 1.0f / viewZ;
+		out->attributes[0] = invW;
+		out->x = rasterizer->width * 0.5f + dot3(relative, rasterizer->right) * rasterizer->focal * invW;
+		out->y = rasterizer->height * 0.5f - dot3(relative, rasterizer->up) * rasterizer->focal * invW;
+		out->attributes[1] = vertex->texCoord[0] * invW;
+		out->attributes[2] = vertex->texCoord[1] * invW;
+
+		float shade = 1.0f;
+		if (dot3(vertex->normal, vertex->normal) > 0.0f)
+			shade = 0.4f + 0.6f * fmaxf(dot3(vertex->normal, light), 0.0f);
+
+		out->attributes[3] = vertex->color[0] * (1.0f / 255.0f) * shade * invW;
+		out->attributes[4] = vertex->color[1] * (1.0f / 255.0f) * shade * invW;
+		out->attributes[5] = vertex->color[2] * (1.0f / 255.0f) * shade * invW;
+		out->attributes[6] = vertex->color[3] * (1.0f / 255.0f) * invW;
+	}
+}
+
+static void setupTriangle(struct rasterizer* rasterizer, uint32_t triangleIndex, int16_t material)
+{
+	const struct j3dModel* model = rasterizer->model;
+	struct rasterTriangle* triangle = &rasterizer->triangles[triangleIndex];
+	triangle->minX = 1;
+	triangle->maxX = 0;
+
+	//GX cull mode 3 culls front and back faces. INF1 can name materials a missing or short MAT3 doesn't have
+	bool validMaterial = material >= 0 && (uint32_t)material < model->materialCount;
+	if (validMaterial && model->materialCullModes[material] == 3)
+		return;
+
+	uint32_t i0 = model->indices[triangleIndex * 3];
+	uint32_t i1 = model->indices[triangleIndex * 3 + 1];
+	uint32_t i2 = model->indices[triangleIndex * 3 + 2];
+	const struct rasterVertex* v0 = &rasterizer->vertices[i0];
+	const struct rasterVertex* v1 = &rasterizer->vertices[i1];
+	const struct rasterVertex* v2 = &rasterizer->vertices[i2];
+	if (v0->attributes[0] <= 0.0f || v1->attributes[0] <= 0.0f || v2->attributes[0] <= 0.0f)
+		return;
+
+	float area = (v1->x - v0->x) * (v2->y - v0->y) - (v1->y - v0->y) * (v2->x - v0->x);
+	if (fabsf(area) < 1e-6f)
+		return;
+	if (area < 0.0f)
+	{
+		const struct rasterVertex* swap = v1;
+		v1 = v2;
+		v2 = swap;
+		uint32_t swapIndex = i1;
+		i1 = i2;
+		i2 = swapIndex;
+		area = -area;
+	}
+
+	float minX = fmaxf(fminf(fminf(v0->x, v1->x), v2->x), 0.0f);
+	float minY = fmaxf(fminf(fminf(v0->y, v1->y), v2->y), 0.0f);
+	float maxX = fminf(fmaxf(fmaxf(v0->x, v1->x), v2->x), rasterizer->width - 1.0f);
+	float maxY = fminf(fmaxf(fmaxf(v0->y, v1->y), v2->y), rasterizer->height - 1.0f);
+	if (minX > maxX || minY > maxY)
+		return;
+
+	//edge k is opposite vertex k, so its value is the (unnormalized) barycentric weight of vertex k
+	const struct rasterVertex* edgeStart[3] = { v1, v2, v0 };
+	const struct rasterVertex* edgeEnd[3] = { v2, v0, v1 };
+	for (int edge = 0; edge < 3; edge++)
+	{
+		triangle->edgeA[edge] = edgeStart[edge]->y - edgeEnd[edge]->y;
+		triangle->edgeB[edge] = edgeEnd[edge]->x - edgeStart[edge]->x;
+		triangle->edgeC[edge] = -(triangle->edgeA[edge] * edgeStart[edge]->x + triangle->edgeB[edge] * edgeStart[edge]->y);
+	}
+
+	triangle->invArea = 1.0f / area;
+	triangle->minX = (int32_t)minX;
+	triangle->minY = (int32_t)minY;
+	triangle->maxX = (int32_t)ceilf(maxX);
+	triangle->maxY = (int32_t)ceilf(maxY);
+	triangle->vertices[0] = i0;
+	triangle->vertices[1] = i1;
+	triangle->vertices[2] = i2;
+
+	triangle->texture = -1;
+	triangle->color = 0xFFFFFFFF;
+	if (validMaterial)
+	{
+		int16_t texture = model->materialTextures[material * J3D_MAX_TEXTURES_PER_MATERIAL];
+		if (texture >= 0 && (uint32_t)texture < rasterizer->textureCount && rasterizer->textures[texture] != nullptr)
+			triangle->texture = texture;
+		else
+			triangle->color = model->materialColors[material];
+	}
+}
+
+static void setupTrianglesJob(int chunkIndex, int threadIndex, void* context)
+{
+	struct rasterizer* rasterizer = context;
+	const struct j3dModel* model = rasterizer->model;
+
+	uint32_t begin = (uint32_t)((uint64_t)rasterizer->triangleCount * chunkIndex / rasterizer->chunkCount);
+	uint32_t end = (uint32_t)((uint64_t)rasterizer->triangleCount * (chunkIndex + 1) / rasterizer->chunkCount);
+	uint32_t* binCounts = &rasterizer->binCounts[chunkIndex * rasterizer->tileCount];
+
+	uint32_t shape = 0;
+	for (uint32_t i = begin; i < end; i++)
+	{
+		while (shape + 1 < model->shapeCount && model->shapeFirstIndex[shape + 1] <= i * 3)
+			shape++;
+
+		setupTriangle(rasterizer, i, model->shapeCount ? model->shapeMaterials[shape] : -1);
+
+		const struct rasterTriangle* triangle = &rasterizer->triangles[i];
+		if (triangle->minX > triangle->maxX)
+			continue;
+
+		for (int32_t tileY = triangle->minY / RASTER_TILE_SIZE; tileY <= triangle->maxY / RASTER_TILE_SIZE; tileY++)
+			for (int32_t tileX = triangle->minX / RASTER_TILE_SIZE; tileX <= triangle->maxX / RASTER_TILE_SIZE; tileX++)
+				binCounts[tileY * rasterizer->tilesX + tileX]++;
+	}
+}
+
+static void binTrianglesJob(int chunkIndex, int threadIndex, void* context)
+{
+	struct rasterizer* rasterizer = context;
+
+	uint32_t begin = (uint32_t)((uint64_t)rasterizer->triangleCount * chunkIndex / rasterizer->chunkCount);
+	uint32_t end = (uint32_t)((uint64_t)rasterizer->triangleCount * (chunkIndex + 1) / rasterizer->chunkCount);
+	const uint32_t* binOffsets = &rasterizer->binOffsets[chunkIndex * rasterizer->tileCount];
+	uint32_t* binCounts = &rasterizer->binCounts[chunkIndex * rasterizer->tileCount];
+
+	for (uint32_t i = begin; i < end; i++)
+	{
+		const struct rasterTriangle* triangle = &rasterizer->triangles[i];
+		if (triangle->minX > triangle->maxX)
+			continue;
+
+		for (int32_t tileY = triangle->minY / RASTER_TILE_SIZE; tileY <= triangle->maxY / RASTER_TILE_SIZE; tileY++)
+		{
+			for (int32_t tileX = triangle->minX / RASTER_TILE_SIZE; tileX <= triangle->maxX / RASTER_TILE_SIZE; tileX++)
+			{
+				uint32_t tile = tileY * rasterizer->tilesX + tileX;
+				rasterizer->binTriangles[binOffsets[tile] + binCounts[tile]++] = i;
+			}
+		}
+	}
+}
+
+static inline int32_t wrapTexelCoordinate(int32_t coordinate, int32_t size, int8_t wrapMode)
+{
+	switch (wrapMode)
+	{
+	case 0://clamp
+		return coordinate < 0 ? 0 : coordinate >= size ? size - 1 : coordinate;
+	case 2://mirror
+	{
+		int32_t period = size * 2;
+		coordinate %= period;
+		if (coordinate < 0)
+			coordinate += period;
+		return coordinate < size ? coordinate : period - 1 - coordinate;
+	}
+	default://repeat
+		coordinate %= size;
+		return coordinate < 0 ? coordinate + size : coordinate;
+	}
+}
+
+static void rasterizeTriangle(struct rasterizer* rasterizer, const struct rasterTriangle* triangle, int32_t tileMinX, int32_t tileMinY, int32_t tileMaxX, int32_t tileMaxY)
+{
+	int32_t minX = max(triangle->minX, tileMinX) & ~3;
+	int32_t minY = max(triangle->minY, tileMinY);
+	int32_t maxX = min(triangle->maxX, tileMaxX);
+	int32_t maxY = min(triangle->maxY, tileMaxY);
+
+	const struct rasterVertex* v0 = &rasterizer->vertices[triangle->vertices[0]];
+	const struct rasterVertex* v1 = &rasterizer->vertices[triangle->vertices[1]];
+	const struct rasterVertex* v2 = &rasterizer->vertices[triangle->vertices[2]];
+
+	const struct decodedImage* texture = nullptr;
+	int8_t wrapS = 1;
+	int8_t wrapT = 1;
+	if (triangle->texture >= 0)
+	{
+		texture = rasterizer->textures[triangle->texture];
+		const struct BTI* textureHeader = &((const struct BTI*)OffsetPointer(rasterizer->model->textures, SwapEndian(rasterizer->model->textures->textureHeaderOffset)))[triangle->texture];
+		wrapS = textureHeader->wrapS;
+		wrapT = textureHeader->wrapT;
+	}
+
+	float colorR = (triangle->color >> 24) * (1.0f / 255.0f);
+	float colorG = ((triangle->color >> 16) & 0xFF) * (1.0f / 255.0f);
+	float colorB = ((triangle->color >> 8) & 0xFF) * (1.0f / 255.0f);
+	float colorA = (triangle->color & 0xFF) * (1.0f / 255.0f);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 pixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 invArea = _mm_set1_ps(triangle->invArea);
+
+	__m128 edgeA[3];
+	__m128 edgeStep[3];
+	for (int edge = 0; edge < 3; edge++)
+	{
+		edgeA[edge] = _mm_set1_ps(triangle->edgeA[edge]);
+		edgeStep[edge] = _mm_set1_ps(triangle->edgeA[edge] * 4.0f);
+	}
+
+	const float* attributes[3] = { v0->attributes, v1->attributes, v2->attributes };
+
+	for (int32_t y = minY; y <= maxY; y++)
+	{
+		__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)minX), pixelOffsets);
+		float pixelY = y + 0.5f;
+
+		__m128 edge[3];
+		for (int e = 0; e < 3; e++)
+			edge[e] = _mm_add_ps(_mm_mul_ps(edgeA[e], pixelX), _mm_set1_ps(triangle->edgeB[e] * pixelY + triangle->edgeC[e]));
+
+		uint32_t* colorRow = &rasterizer->color[y * rasterizer->width];
+		float* depthRow = &rasterizer->depth[y * rasterizer->width];
+
+		for (int32_t x = minX; x <= maxX; x += 4)
+		{
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge[0], zero), _mm_cmpge_ps(edge[1], zero)), _mm_cmpge_ps(edge[2], zero));
+			int mask = _mm_movemask_ps(inside);
+
+			if (mask != 0)
+			{
+				__m128 weight0 = _mm_mul_ps(edge[0], invArea);
+				__m128 weight1 = _mm_mul_ps(edge[1], invArea);
+				__m128 weight2 = _mm_mul_ps(edge[2], invArea);
+
+				__m128 interpolated[7];
+				for (int a = 0; a < 7; a++)
+				{
+					interpolated[a] = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(weight0, _mm_set1_ps(attributes[0][a])), _mm_mul_ps(weight1, _mm_set1_ps(attributes[1][a]))),
+						_mm_mul_ps(weight2, _mm_set1_ps(attributes[2][a])));
+				}
+
+				//larger 1/w is closer
+				mask &= _mm_movemask_ps(_mm_cmpgt_ps(interpolated[0], _mm_loadu_ps(&depthRow[x])));
+
+				if (mask != 0)
+				{
+					__m128 w = _mm_div_ps(one, interpolated[0]);
+					float lanes[7][4];
+					_mm_storeu_ps(lanes[0], interpolated[0]);
+					for (int a = 1; a < 7; a++)
+						_mm_storeu_ps(lanes[a], _mm_mul_ps(interpolated[a], w));
+
+					for (int lane = 0; lane < 4; lane++)
+					{
+						if ((mask & (1 << lane)) == 0)
+							continue;
+
+						float r = lanes[3][lane] * colorR;
+						float g = lanes[4][lane] * colorG;
+						float b = lanes[5][lane] * colorB;
+						float a = lanes[6][lane] * colorA;
+
+						if (texture != nullptr)
+						{
+							int32_t texelX = wrapTexelCoordinate((int32_t)floorf(lanes[1][lane] * texture->width), texture->width, wrapS);
+							int32_t texelY = wrapTexelCoordinate((int32_t)floorf(lanes[2][lane] * texture->height), texture->height, wrapT);
+							const uint8_t* texel = OffsetPointer((const uint8_t*)texture->pixels, (texelY * texture->width + texelX) * 4);
+							r *= texel[0] * (1.0f / 255.0f);
+							g *= texel[1] * (1.0f / 255.0f);
+							b *= texel[2] * (1.0f / 255.0f);
+							a *= texel[3] * (1.0f / 255.0f);
+						}
+
+						//alpha test, cutout foliage and such
+						if (a < 0.5f)
+							continue;
+
+						uint32_t red = (uint32_t)(fminf(r, 1.0f) * 255.0f);
+						uint32_t green = (uint32_t)(fminf(g, 1.0f) * 255.0f);
+						uint32_t blue = (uint32_t)(fminf(b, 1.0f) * 255.0f);
+						colorRow[x + lane] = red | (green << 8) | (blue << 16) | 0xFF000000;
+						depthRow[x + lane] = lanes[0][lane];
+					}
+				}
+			}
+
+			for (int e = 0; e < 3; e++)
+				edge[e] = _mm_add_ps(edge[e], edgeStep[e]);
+		}
+	}
+}
+
+static void rasterizeTileJob(int tileIndex, int threadIndex, void* context)
+{
+	struct rasterizer* rasterizer = context;
+
+	int32_t tileMinX = (tileIndex % rasterizer->tilesX) * RASTER_TILE_SIZE;
+	int32_t tileMinY = (tileIndex / rasterizer->tilesX) * RASTER_TILE_SIZE;
+	int32_t tileMaxX = min(tileMinX + RASTER_TILE_SIZE, (int32_t)rasterizer->width) - 1;
+	int32_t tileMaxY = min(tileMinY + RASTER_TILE_SIZE, (int32_t)rasterizer->height) - 1;
+
+	for (int32_t y = tileMinY; y <= tileMaxY; y++)
+	{
+		for (int32_t x = tileMinX; x <= tileMaxX; x++)
+		{
+			rasterizer->color[y * rasterizer->width + x] = 0xFF403830;
+			rasterizer->depth[y * rasterizer->width + x] = 0.0f;
+		}
+	}
+
+	//chunks are in triangle order, so overlapping triangles at equal depth resolve the same way every time
+	for (uint32_t chunk = 0; chunk < rasterizer->chunkCount; chunk++)
+	{
+		uint32_t bin = chunk * rasterizer->tileCount + tileIndex;
+		const uint32_t* triangles = &rasterizer->binTriangles[rasterizer->binOffsets[bin]];
+		for (uint32_t i = 0; i < rasterizer->binCounts[bin]; i++)
+			rasterizeTriangle(rasterizer, &rasterizer->triangles[triangles[i]], tileMinX, tileMinY, tileMaxX, tileMaxY);
+	}
+}
+
+/*
+* renders a model into an rgba image (same layout as decodeTexture output) allocated from workspace.
+* textures are indexed by TEX1 index and may be nullptr. width must be a multiple of 4.
+* multithreaded spreads every stage over all cores, batch callers render one model per thread instead.
+*/
+bool renderJ3DModel(const struct j3dModel* model, const struct decodedImage* const* textures, uint32_t textureCount, uint32_t width, uint32_t height, bool multithreaded, void* workspace, size_t workspaceSize, struct decodedImage* _Out_ image)
+{
+	if (width == 0 || height == 0 || (width & 3) != 0)
+		return false;
+
+	struct workspaceAllocator allocator;
+	initWorkspaceAllocator(&allocator, workspace, workspaceSize);
+
+	struct rasterizer* rasterizer = workspaceAlloc(&allocator, sizeof(struct rasterizer));
+	memset(rasterizer, 0, sizeof(struct rasterizer));
+	rasterizer->model = model;
+	rasterizer->textures = textures;
+	rasterizer->textureCount = model->textures ? min(textureCount, (uint32_t)SwapEndian(model->textures->textureCount)) : 0;
+	rasterizer->width = width;
+	rasterizer->height = height;
+	rasterizer->triangleCount = model->indexCount / 3;
+	rasterizer->tilesX = (width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	rasterizer->tilesY = (height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	rasterizer->tileCount = rasterizer->tilesX * rasterizer->tilesY;
+	rasterizer->chunkCount = multithreaded ? min(getThreadCount() * 2, RASTER_MAX_CHUNKS) : 1;
+
+	rasterizer->color = workspaceAllocArray(&allocator, uint32_t, width * height);
+	rasterizer->depth = workspaceAllocArray(&allocator, float, width * height);
+	rasterizer->vertices = workspaceAllocArray(&allocator, struct rasterVertex, model->vertexCount);
+	rasterizer->triangles = workspaceAllocArray(&allocator, struct rasterTriangle, rasterizer->triangleCount);
+	rasterizer->binCounts = workspaceAllocArray(&allocator, uint32_t, rasterizer->chunkCount * rasterizer->tileCount);
+	rasterizer->binOffsets = workspaceAllocArray(&allocator, uint32_t, rasterizer->chunkCount * rasterizer->tileCount);
+	if (allocator.failed)
+		return false;
+
+	memset(rasterizer->binCounts, 0, sizeof(uint32_t) * rasterizer->chunkCount * rasterizer->tileCount);
+
+	setupRasterCamera(rasterizer);
+	runRasterPhase(rasterizer, rasterizer->chunkCount, projectVerticesJob, multithreaded);
+	runRasterPhase(rasterizer, rasterizer->chunkCount, setupTrianglesJob, multithreaded);
+
+	uint32_t binnedCount = 0;
+	for (uint32_t i = 0; i < rasterizer->chunkCount * rasterizer->tileCount; i++)
+	{
+		rasterizer->binOffsets[i] = binnedCount;
+		binnedCount += rasterizer->binCounts[i];
+		rasterizer->binCounts[i] = 0;
+	}
+
+	rasterizer->binTriangles = workspaceAllocArray(&allocator, uint32_t, binnedCount);
+	if (allocator.failed)
+		return false;
+
+	runRasterPhase(rasterizer, rasterizer->chunkCount, binTrianglesJob, multithreaded);
+	runRasterPhase(rasterizer, rasterizer->tileCount, rasterizeTileJob, multithreaded);
+
+	image->width = width;
+	image->height = height;
+	image->pixelCount = width * height;
+	image->pixels = rasterizer->color;
+	return true;
+}
+
+/*
+* decodes every TEX1 texture of a model into workspace, textures that don't fit are left nullptr.
+* returns the texture count
+*/
+uint32_t decodeModelTextures(const struct j3dModel* model, const struct decodedImage** textures, uint32_t maxTextures, void* workspace, size_t workspaceSize)
+{
+	if (model->textures == nullptr)
+		return 0;
+
+	struct workspaceAllocator allocator;
+	initWorkspaceAllocator(&allocator, workspace, workspaceSize);
+
+	uint32_t textureCount = min((uint32_t)SwapEndian(model->textures->textureCount), maxTextures);
+	for (uint32_t texNum = 0; texNum < textureCount; texNum++)
+	{
+		struct btiTexture texture;
+		bool loaded = loadTEX1Texture(model->textures, texNum, &texture);
+
+		struct decodedImage* image = workspaceAlloc(&allocator, sizeof(struct decodedImage));
+		uint8_t* pixels = workspaceAlloc(&allocator, getDecodedTextureSize(texture.width, texture.height));
+		if (allocator.failed || !loaded)
+		{
+			textures[texNum] = nullptr;
+			allocator.failed = false;
+			continue;
+		}
+
+		decodeBTITexture(&texture, pixels, image);
+		textures[texNum] = image;
+	}
+	return textureCount;
+}
+
+/*
+* content hashing (xxh64)
+*/
+#define HASH_PRIME1 0x9E3779B185EBCA87ull
+#define HASH_PRIME2 0xC2B2AE3D27D4EB4Full
+#define HASH_PRIME3 0x165667B19E3779F9ull
+#define HASH_PRIME4 0x85EBCA77C2B2AE63ull
+#define HASH_PRIME5 0x27D4EB2F165667C5ull
+
+static inline uint64_t hashRound(uint64_t accumulator, uint64_t input)
+{
+	accumulator += input * HASH_PRIME2;
+	accumulator = _rotl64(accumulator, 31);
+	return accumulator * HASH_PRIME1;
+}
+
+static inline uint64_t hashMergeRound(uint64_t accumulator, uint64_t value)
+{
+	accumulator ^= hashRound(0, value);
+	return accumulator * HASH_PRIME1 + HASH_PRIME4;
+}
+
+uint64_t hashBytes(const void* _In_reads_bytes_(size) data, size_t size, uint64_t seed)
+{
+	const uint8_t* bytes = data;
+	const uint8_t* end = bytes + size;
+	uint64_t hash;
+
+	if (size >= 32)
+	{
+		uint64_t v1 = seed + HASH_PRIME1 + HASH_PRIME2;
+		uint64_t v2 = seed + HASH_PRIME2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - HASH_PRIME1;
+
+		const uint8_t* limit = end - 32;
+		do
+		{
+			uint64_t lanes[4];
+			memcpy(lanes, bytes, 32);
+			v1 = hashRound(v1, lanes[0]);
+			v2 = hashRound(v2, lanes[1]);
+			v3 = hashRound(v3, lanes[2]);
+			v4 = hashRound(v4, lanes[3]);
+			bytes += 32;
+		} while (bytes <= limit);
+
+		hash = _rotl64(v1, 1) + _rotl64(v2, 7) + _rotl64(v3, 12) + _rotl64(v4, 18);
+		hash = hashMergeRound(hash, v1);
+		hash = hashMergeRound(hash, v2);
+		hash = hashMergeRound(hash, v3);
+		hash = hashMergeRound(hash, v4);
+	}
+	else
+	{
+		hash = seed + HASH_PRIME5;
+	}
+
+	hash += size;
+
+	for (; bytes + 8 <= end; bytes += 8)
+	{
+		uint64_t lane;
+		memcpy(&lane, bytes, 8);
+		hash ^= hashRound(0, lane);
+		hash = _rotl64(hash, 27) * HASH_PRIME1 + HASH_PRIME4;
+	}
+
+	if (bytes + 4 <= end)
+	{
+		uint32_t lane;
+		memcpy(&lane, bytes, 4);
+		hash ^= lane * HASH_PRIME1;
+		hash = _rotl64(hash, 23) * HASH_PRIME2 + HASH_PRIME3;
+		bytes += 4;
+	}
+
+	for (; bytes < end; bytes++)
+	{
+		hash ^= *bytes * HASH_PRIME5;
+		hash = _rotl64(hash, 11) * HASH_PRIME1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= HASH_PRIME2;
+	hash ^= hash >> 29;
+	hash *= HASH_PRIME3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+//the format, dimensions and palette format are part of the hash, the same bytes decode differently otherwise
+uint64_t hashTexture(const struct btiTexture* texture)
+{
+	uint64_t seed = ((uint64_t)texture->format << 32) | (texture->width << 16) | texture->height;
+	uint64_t hash = hashBytes(texture->data, getTextureLevelsSize(texture), seed);
+	if (texture->palette != nullptr)
+		hash = hashBytes(texture->palette, texture->paletteSize, hash ^ ((uint64_t)(uint8_t)texture->header->palletteFormat << 40));
+	return hash;
+}
+
+//a hash match is only a hint, this compares the bytes
+bool isSameTexture(const struct btiTexture* a, const struct btiTexture* b)
+{
+	return a->format == b->format && a->width == b->width && a->height == b->height && a->levelCount == b->levelCount &&
+		(a->palette != nullptr) == (b->palette != nullptr) && a->paletteSize == b->paletteSize &&
+		(a->palette == nullptr || (a->header->palletteFormat == b->header->palletteFormat && memcmp(a->palette, b->palette, a->paletteSize) == 0)) &&
+		memcmp(a->data, b->data, getTextureLevelsSize(a)) == 0;
+}
+
+/*
+* hash -> decoded result, so identical blobs are only decoded once.
+* open addressing, capacity is a power of two and never more than half full.
+*/
+struct blobCache
+{
+	uint64_t* hashes;
+	void** values;
+	uint32_t capacity;
+	uint32_t count;
+};
+
+void initBlobCache(struct blobCache* cache, uint32_t capacity)
+{
+	cache->capacity = capacity;
+	cache->count = 0;
+	cache->hashes = calloc(capacity, sizeof(uint64_t));
+	cache->values = calloc(capacity, sizeof(void*));
+}
+
+void clearBlobCache(struct blobCache* cache)
+{
+	memset(cache->values, 0, cache->capacity * sizeof(void*));
+	cache->count = 0;
+}
+
+void* findCachedBlob(const struct blobCache* cache, uint64_t hash)
+{
+	for (uint32_t slot = (uint32_t)hash & (cache->capacity - 1); cache->values[slot] != nullptr; slot = (slot + 1) & (cache->capacity - 1))
+		if (cache->hashes[slot] == hash)
+			return cache->values[slot];
+	return nullptr;
+}
+
+//returns false when the cache is full, the caller then simply doesn't share the blob
+bool addCachedBlob(struct blobCache* cache, uint64_t hash, void* value)
+{
+	if (cache->count * 2 >= cache->capacity)
+		return false;
+
+	uint32_t slot = (uint32_t)hash & (cache->capacity - 1);
+	while (cache->values[slot] != nullptr)
+		slot = (slot + 1) & (cache->capacity - 1);
+	cache->hashes[slot] = hash;
+	cache->values[slot] = value;
+	cache->count++;
+	return true;
+}
+
+struct blobCache decodedTextureCache;
+
+//decodedTextureCache values, the source is kept so a hash match can be confirmed
+struct cachedTexture
+{
+	struct btiTexture source;
+	struct decodedImage image;
+};
+
+//the texture gallery further down paints itself
+static bool paintTextureGallery(HWND hwnd, HDC hdc, SCROLLINFO* si);
+
+LRESULT CALLBACK FileViewerWindowProcedure(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+	static SCROLLINFO si = { 0 };
+	switch (msg)
+	{
+		case WM_CREATE:
+		{
+			si.cbSize = sizeof(si);
+			si.fMask = SIF_RANGE | SIF_PAGE;
+			si.nMin = 0;
+			si.nMax = 200;
+			si.nPage = 50;
+			SetScrollInfo(hwnd, SB_VERT, &si, TRUE);
+			break;
+		}
+		case WM_VSCROLL:
+		{
+			si.cbSize = sizeof(si);
+			si.fMask = SIF_ALL;
+			GetScrollInfo(hwnd, SB_VERT, &si);
+			switch (LOWORD(wParam))
+			{
+			case SB_TOP:
+				si.nPos = si.nMin;
+				break;
+			case SB_BOTTOM:
+				si.nPos = si.nMax;
+				break;
+			case SB_LINEUP:
+				si.nPos -= 1;
+				break;
+			case SB_LINEDOWN:
+				si.nPos += 1;
+				break;
+			case SB_PAGEUP:
+				si.nPos -= si.nPage;
+				break;
+			case SB_PAGEDOWN:
+				si.nPos += si.nPage;
+				break;
+			case SB_THUMBTRACK:
+				si.nPos = si.nTrackPos;
+				break;
+			default:
+				break;
+			}
+			si.fMask = SIF_POS;
+			SetScrollInfo(hwnd, SB_VERT, &si, TRUE);
+
+			InvalidateRect(hwnd, nullptr, TRUE);
+			UpdateWindow(hwnd);
+		}
+		break;
+		case WM_PAINT:
+		{
+
+			//decodedAssetCount = 1;
+			//decodedAssets[0].assetType = ASSET_TYPE_TEXT;
+			//decodedAssets[0].assetPtr = gameFileList[selectedFileIndex].filePtr;
+			PAINTSTRUCT ps = { 0 };
+			HDC hdc = BeginPaint(hwnd, &ps);
+			if (paintTextureGallery(hwnd, hdc, &si))
+			{
+				EndPaint(hwnd, &ps);
+				break;
+			}
+			int nextAssetLocationY = 0;
+			for (int i = 0; i < decodedAssetCount; i++)
+			{
+				switch (decodedAssetTable[i].assetType)
+				{
+				case ASSET_TYPE_TEXT:
+				{
+					RECT rect = { 25, si.nPos * -25, 500, 2000 };
+					DrawTextA(hdc, decodedAssetTable[i].assetPtr, -1, &rect, DT_LEFT | DT_TOP);
+					break;
+				}
+				case ASSET_TYPE_TEXTURE:
+				{
+					const struct decodedImage* imgHeader = decodedAssetTable[i].assetPtr;
+					BITMAPINFO info = { 0 };
+					info.bmiHeader.biBitCount = 32;
+					info.bmiHeader.biWidth = imgHeader->width;
+					info.bmiHeader.biHeight = imgHeader->height;
+					info.bmiHeader.biPlanes = 1;
+					info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+					info.bmiHeader.biSizeImage = imgHeader->pixelCount * 4;
+
+					// Draw the pixel
+					StretchDIBits(hdc, 0, nextAssetLocationY, imgHeader->width * 4, imgHeader->height * 4, 0, 0, imgHeader->width, imgHeader->height, imgHeader->pixels, &info, DIB_RGB_COLORS, SRCCOPY);
+					nextAssetLocationY += imgHeader->height * 4;
+					break;
+				}
+				case ASSET_TYPE_MODEL:
+				{
+					//model previews are drawn top-down at their own size
+					const struct decodedImage* imgHeader = decodedAssetTable[i].assetPtr;
+					BITMAPINFO info = { 0 };
+					info.bmiHeader.biBitCount = 32;
+					info.bmiHeader.biWidth = imgHeader->width;
+					info.bmiHeader.biHeight = -(LONG)imgHeader->height;
+					info.bmiHeader.biPlanes = 1;
+					info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+					info.bmiHeader.biSizeImage = imgHeader->pixelCount * 4;
+
+					StretchDIBits(hdc, 0, nextAssetLocationY, imgHeader->width, imgHeader->height, 0, 0, imgHeader->width, imgHeader->height, imgHeader->pixels, &info, DIB_RGB_COLORS, SRCCOPY);
+					nextAssetLocationY += imgHeader->height;
+					break;
+				}
+				}
+			}
+			
+
+			EndPaint(hwnd, &ps);
+			break;
+		}
+		case WM_DESTROY:
+			PostQuitMessage(0);
+			break;
+		default:
+			return DefWindowProc(hwnd, msg, wParam, lParam);
+	}
+	return 0;
+}
+
+struct DiskHeader
+{
+	uint32_t GameCode;
+	uint16_t MakerCode;
+	uint8_t DiskID;
+	uint8_t Version;
+	uint8_t AudioStreaming;
+	uint8_t StreamBufferSize;
+	uint8_t unused1[18];
+	uint32_t Magic;
+	char GameName[992];
+	uint32_t DebugMonitorOffset;
+	uint32_t Unknown;
+	uint8_t unused2[24];
+	uint32_t DOLOffset;
+	uint32_t FSTOffset;
+	uint32_t FSTSize;
+	uint32_t MaxFSTSize;
+};
+
+struct FileEntry
+{
+	uint8_t Flags;
+	uint8_t FileNameOffsetp1;
+	uint8_t FileNameOffsetp2;
+	uint8_t FileNameOffsetp3;
+	uint32_t FileOffset;
+	uint32_t Unknown;
+};
+
+/*
+* the FST has to lie inside the image and its string table has to end with a terminator, then any name offset below the
+* table size is a string. returns the entry count, 0 if the FST can't be used
+*/
+uint32_t getFSTLayout(const struct FileEntry** _Out_ fst, const char** _Out_ stringTable, uint32_t* _Out_ stringTableSize)
+{
+	const struct DiskHeader* dh = GameImageAddress;
+	if (GameImageSize < sizeof(struct DiskHeader) || !isRangeInside(SwapEndian(dh->FSTOffset), SwapEndian(dh->FSTSize), GameImageSize) || SwapEndian(dh->FSTSize) < sizeof(struct FileEntry))
+		return 0;
+
+	*fst = OffsetPointer((const struct FileEntry*)GameImageAddress, SwapEndian(dh->FSTOffset));
+	uint32_t entryCount = SwapEndian((*fst)->Unknown);
+	if (entryCount == 0 || entryCount > MAX_GAME_FILES || (uint64_t)entryCount * sizeof(struct FileEntry) >= SwapEndian(dh->FSTSize))
+		return 0;
+
+	*stringTable = OffsetPointer((const char*)*fst, entryCount * sizeof(struct FileEntry));
+	*stringTableSize = SwapEndian(dh->FSTSize) - entryCount * sizeof(struct FileEntry);
+	if ((*stringTable)[*stringTableSize - 1] != 0)
+		return 0;
+	return entryCount;
+}
+
+//out of range offsets give the empty string at the end of the table
+static inline const char* getFSTName(const struct FileEntry* entry, const char* stringTable, uint32_t stringTableSize)
+{
+	uint32_t offset = (entry->FileNameOffsetp1 << 16) | (entry->FileNameOffsetp2 << 8) | entry->FileNameOffsetp3;
+	return stringTable + (offset < stringTableSize ? offset : stringTableSize - 1);
+}
+
+/*
+* hTreeView may be nullptr when running without a window.
+* the walk stops at a directory that doesn't end after itself or nests deeper than 16, files outside the image are empty
+*/
+void indexGameFiles(HWND hTreeView)
+{
+	TRACE_BEGIN(indexSpan);
+	const struct FileEntry* FST;
+	const char* StringTable;
+	uint32_t StringTableSize;
+	int NumEntries = getFSTLayout(&FST, &StringTable, &StringTableSize);
+	if ((uint32_t)max(NumEntries, 1) > gameFileCapacity)
+	{
+		//the old list stays if the larger one can't be had, with no files in it
+		struct gameFileInTree* list = trackedRealloc(MEMORY_FILE_INDEX, gameFileList, sizeof(struct gameFileInTree) * max(NumEntries, 1));
+		if (list == nullptr)
+		{
+			printf("not enough memory to index %i files\n", NumEntries);
+			gameFileCount = 0;
+			return;
+		}
+		gameFileList = list;
+		gameFileCapacity = max(NumEntries, 1);
+	}
+	//locals, so the stores into gameFileList don't force them to be reloaded for every file
+	const uint8_t* imageAddress = GameImageAddress;
+	uint64_t imageSize = GameImageSize;
+
+	//how many directories in we are (max 16)
+	int deepness = 0;
+
+	uint32_t endOfDirectoryLocation[16] = { 0 };
+	HTREEITEM parentDirectoryDropdowns[16] = { 0 };
+
+	TVINSERTSTRUCTW rootNode = { 0 };
+	rootNode.hParent = NULL;
+	rootNode.hInsertAfter = TVI_ROOT;
+	rootNode.item.mask = TVIF_TEXT;
+	rootNode.item.pszText = L"<root>";
+
+	if (hTreeView)
+		parentDirectoryDropdowns[0] = (HTREEITEM)SendMessageW(hTreeView, TVM_INSERTITEMW, 0, (LPARAM)&rootNode);
+
+	int x = 0;
+
+	for (int i = 0; i < NumEntries; i++)
+	{
+		const struct FileEntry* FE = FST + i;
+
+		const char* FileName = getFSTName(FE, StringTable, StringTableSize);
+
+		if (i != 0)
+		{
+			if (FE->Flags == 1)//directories
+			{
+				uint32_t nextEntry = SwapEndian(FE->Unknown);
+				if (deepness + 1 >= countof(endOfDirectoryLocation) || nextEntry <= (uint32_t)i || nextEntry > (uint32_t)NumEntries)
+					break;
+
+				deepness++;
+				endOfDirectoryLocation[deepness] = i;
+
+				if (hTreeView)
+				{
+					wchar_t itemname[100];
+
+					MultiByteToWideChar(
+						CP_OEMCP,
+						0,
+						FileName,
+						-1,
+						itemname,
+						100
+						);
+
+					rootNode.hParent = parentDirectoryDropdowns[deepness - 1];
+					rootNode.item.pszText = itemname;
+
+
+					parentDirectoryDropdowns[deepness] = (HTREEITEM)SendMessageW(hTreeView, TVM_INSERTITEMW, 0, (LPARAM)&rootNode);
+				}
+			}
+			else//files
+			{
+				if (hTreeView)
+				{
+					wchar_t itemname[100];
+
+					MultiByteToWideChar(
+						CP_OEMCP,
+						0,
+						FileName,
+						-1,
+						itemname,
+						100
+					);
+
+					rootNode.hParent = parentDirectoryDropdowns[deepness];
+					rootNode.item.mask = TVIF_TEXT | TVIF_PARAM;
+					rootNode.item.pszText = itemname;
+					rootNode.item.lParam = (LPARAM)x;
+
+					gameFileList[x].treeItem = (HTREEITEM)SendMessageW(hTreeView, TVM_INSERTITEMW, 0, (LPARAM)&rootNode);
+				}
+				else
+				{
+					gameFileList[x].treeItem = nullptr;
+				}
+
+				uint32_t fileOffset = SwapEndian(FE->FileOffset);
+				uint32_t fileSize = SwapEndian(FE->Unknown);
+				bool inside = isRangeInside(fileOffset, fileSize, imageSize);
+				gameFileList[x].filePtr = (void*)(imageAddress + (inside ? fileOffset : 0));
+				gameFileList[x].fileSize = inside ? fileSize : 0;
+
+				gameFileList[x].fileName = FileName;
+
+				gameFileList[x].directoryIndex = endOfDirectoryLocation[deepness];
+
+				x++;
+
+				while (deepness > 0 && i >= (SwapEndian((FST + endOfDirectoryLocation[deepness])->Unknown) - 1))
+				{
+					deepness--;
+				}
+			}
+		}
+	}
+
+	gameFileCount = x;
+	TRACE_END(indexSpan, hTreeView ? "FST indexing (tree view)" : "FST indexing");
+	TRACE_COUNTER("game files", gameFileCount);
+}
+
+//builds "dir/subdir/file.ext" for a file in gameFileList, returns the string length
+int getGameFilePath(int fileIndex, char* _Out_ buffer, int bufferSize)
+{
+	const struct FileEntry* FST;
+	const char* StringTable;
+	uint32_t StringTableSize;
+	uint32_t entryCount = getFSTLayout(&FST, &StringTable, &StringTableSize);
+
+	//collect the directory chain from the file up to the root
+	uint32_t directoryChain[16];
+	int chainLength = 0;
+	for (uint32_t dir = gameFileList[fileIndex].directoryIndex; dir != 0 && dir < entryCount && chainLength < 16; dir = SwapEndian(FST[dir].FileOffset))
+		directoryChain[chainLength++] = dir;
+
+	int length = 0;
+	for (int i = chainLength - 1; i >= 0; i--)
+		length = addFormattedLength(length, _snprintf_s(buffer + length, bufferSize - length, _TRUNCATE, "%s/", getFSTName(FST + directoryChain[i], StringTable, StringTableSize)), bufferSize);
+	length = addFormattedLength(length, _snprintf_s(buffer + length, bufferSize - length, _TRUNCATE, "%s", gameFileList[fileIndex].fileName), bufferSize);
+	return length;
+}
+
+//true if the file name of gameFileList[fileIndex] ends with extension (e.g. ".szs")
+bool nameHasExtension(const char* name, const char* extension)
+{
+	const char* nameExtension = strrchr(name, '.');
+	return nameExtension != nullptr && _stricmp(nameExtension, extension) == 0;
+}
+
+bool gameFileHasExtension(int fileIndex, const char* extension)
+{
+	return nameHasExtension(gameFileList[fileIndex].fileName, extension);
+}
+
+/*
+* DOL executables
+* 7 text and 11 data sections, each copied from a file offset to a virtual address at boot. parseDOL checks every section
+* against the file once and sorts them by address, then getDOLPointer hands out pointers into the mapped image: structs at
+* a virtual address are read in place with SwapEndian like every other file format here.
+*/
+#define DOL_TEXT_SECTIONS 7
+#define DOL_DATA_SECTIONS 11
+#define DOL_SECTIONS (DOL_TEXT_SECTIONS + DOL_DATA_SECTIONS)
+
+struct DOLHeader
+{
+	//text sections first, then data
+	uint32_t offsets[DOL_SECTIONS];
+	uint32_t addresses[DOL_SECTIONS];
+	uint32_t sizes[DOL_SECTIONS];
+	uint32_t bssAddress;
+	uint32_t bssSize;
+	uint32_t entryPoint;
+	uint8_t padding[0x1C];
+};
+
+struct dolSection
+{
+	uint32_t address;
+	uint32_t size;
+	uint32_t fileOffset;
+	uint8_t index;//in the header, below DOL_TEXT_SECTIONS is text
+	const uint8_t* data;
+};
+
+struct dolImage
+{
+	//the sections that are present, sorted by address
+	struct dolSection sections[DOL_SECTIONS];
+	uint32_t sectionCount;
+	uint32_t bssAddress;
+	uint32_t bssSize;
+	uint32_t entryPoint;
+};
+
+static int compareDOLSections(const void* a, const void* b)
+{
+	uint32_t addressA = ((const struct dolSection*)a)->address;
+	uint32_t addressB = ((const struct dolSection*)b)->address;
+	return addressA < addressB ? -1 : addressA > addressB ? 1 : 0;
+}
+
+//returns false if a section is outside the file, wraps around the address space or overlaps another one
+bool parseDOL(const void* data, uint64_t size, struct dolImage* _Out_ dol)
+{
+	memset(dol, 0, sizeof(struct dolImage));
+	if (size < sizeof(struct DOLHeader))
+		return false;
+
+	const struct DOLHeader* header = data;
+	for (uint32_t i = 0; i < DOL_SECTIONS; i++)
+	{
+		struct dolSection* section = &dol->sections[dol->sectionCount];
+		section->size = SwapEndian(header->sizes[i]);
+		if (section->size == 0)
+			continue;
+		section->address = SwapEndian(header->addresses[i]);
+		section->fileOffset = SwapEndian(header->offsets[i]);
+		section->index = (uint8_t)i;
+		if (!isRangeInside(section->fileOffset, section->size, size) || (uint64_t)section->address + section->size > UINT32_MAX + 1ull)
+			return false;
+		section->data = OffsetPointer((const uint8_t*)data, section->fileOffset);
+		dol->sectionCount++;
+	}
+
+	qsort(dol->sections, dol->sectionCount, sizeof(struct dolSection), compareDOLSections);
+	for (uint32_t i = 1; i < dol->sectionCount; i++)
+		if ((uint64_t)dol->sections[i - 1].address + dol->sections[i - 1].size > dol->sections[i].address)
+			return false;
+
+	dol->bssAddress = SwapEndian(header->bssAddress);
+	dol->bssSize = SwapEndian(header->bssSize);
+	dol->entryPoint = SwapEndian(header->entryPoint);
+	return true;
+}
+
+//the bytes at address, nullptr unless all size of them are in one section (bss has no bytes in the file)
+const void* getDOLPointer(const struct dolImage* dol, uint32_t address, uint32_t size)
+{
+	//last section starting at or before address
+	uint32_t low = 0;
+	uint32_t high = dol->sectionCount;
+	while (low < high)
+	{
+		uint32_t middle = (low + high) / 2;
+		if (dol->sections[middle].address <= address)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	if (low == 0)
+		return nullptr;
+
+	const struct dolSection* section = &dol->sections[low - 1];
+	if (!isRangeInside(address - section->address, size, section->size))
+		return nullptr;
+	return section->data + (address - section->address);
+}
+
+//a struct at a virtual address, read in place: fields still need SwapEndian
+#define getDOLStruct(dol, address, type) ((const type*)getDOLPointer(dol, address, sizeof(type)))
+
+/*
+* CodeWarrior symbol maps
+* "<name> section layout" starts a section, its symbols are lines of
+* "<offset in section> <size> <virtual address> [alignment] <name> <object file>", all hex but the alignment.
+* lines for the object file sections themselves (".text", ".data"...) and anything else are skipped.
+* symbols are kept sorted by address, and a second index sorted by name, both searched with a binary search.
+*/
+struct dolSymbol
+{
+	uint32_t address;
+	uint32_t size;
+	uint32_t nameOffset;//into the map's name pool
+	uint32_t sectionOffset;//the section name, same pool
+	uint64_t reachEnd;//the furthest end of this symbol and every one before it in address order
+};
+
+struct symbolName
+{
+	const char* name;
+	uint32_t symbol;
+};
+
+struct symbolMap
+{
+	struct dolSymbol* symbols;
+	struct symbolName* names;
+	uint32_t count;
+	char* namePool;
+	uint32_t namePoolSize;
+};
+
+static int compareDOLSymbols(const void* a, const void* b)
+{
+	const struct dolSymbol* symbolA = a;
+	const struct dolSymbol* symbolB = b;
+	if (symbolA->address != symbolB->address)
+		return symbolA->address < symbolB->address ? -1 : 1;
+	//the larger symbol first, so a lookup lands on the innermost one
+	return symbolA->size > symbolB->size ? -1 : symbolA->size < symbolB->size ? 1 : 0;
+}
+
+static int compareSymbolNames(const void* a, const void* b)
+{
+	return strcmp(((const struct symbolName*)a)->name, ((const struct symbolName*)b)->name);
+}
+
+static inline bool isMapSpace(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+//reads one hex or decimal number followed by a space, returns the text after the spaces or nullptr
+static const char* readMapNumber(const char* text, int base, uint32_t* _Out_ value)
+{
+	char* end;
+	*value = (uint32_t)strtoul(text, &end, base);
+	if (end == text || !isMapSpace(*end))
+		return nullptr;
+	while (isMapSpace(*end))
+		end++;
+	return end;
+}
+
+void freeSymbolMap(struct symbolMap* map)
+{
+	free(map->symbols);
+	free(map->names);
+	free(map->namePool);
+	memset(map, 0, sizeof(struct symbolMap));
+}
+
+//text is the whole zero terminated map file. returns false, with map left empty, if the map doesn't fit in memory
+bool parseSymbolMap(const char* text, struct symbolMap* _Out_ map)
+{
+	memset(map, 0, sizeof(struct symbolMap));
+
+	//names are copied out of the text with a terminator in place of the space after them, the pool never outgrows it
+	size_t textLength = strlen(text);
+	map->namePool = malloc(textLength + 1);
+	if (map->namePool == nullptr)
+		return false;
+	uint32_t capacity = 0;
+	uint32_t sectionOffset = UINT32_MAX;
+
+	for (const char* line = text; line != nullptr && *line != 0; line = strchr(line, '\n'), line = line ? line + 1 : nullptr)
+	{
+		const char* lineEnd = line + strcspn(line, "\r\n");
+		while (lineEnd > line && isMapSpace(lineEnd[-1]))
+			lineEnd--;
+		if (lineEnd == line)
+			continue;
+
+		//"<name> section layout" starts a section, any other unindented line (the memory map, linker symbols) ends it
+		if (!isMapSpace(*line))
+		{
+			static const char layout[] = " section layout";
+			uint32_t length = (uint32_t)(lineEnd - line) - (sizeof(layout) - 1);
+			sectionOffset = UINT32_MAX;
+			if (lineEnd - line > (ptrdiff_t)sizeof(layout) - 1 && memcmp(lineEnd - (sizeof(layout) - 1), layout, sizeof(layout) - 1) == 0)
+			{
+				sectionOffset = map->namePoolSize;
+				memcpy(map->namePool + map->namePoolSize, line, length);
+				map->namePool[map->namePoolSize + length] = 0;
+				map->namePoolSize += length + 1;
+			}
+			continue;
+		}
+		if (sectionOffset == UINT32_MAX)
+			continue;
+
+		const char* field = line;
+		while (isMapSpace(*field))
+			field++;
+		uint32_t start, size, address, alignment;
+		field = readMapNumber(field, 16, &start);
+		field = field ? readMapNumber(field, 16, &size) : nullptr;
+		field = field ? readMapNumber(field, 16, &address) : nullptr;
+		if (field == nullptr)
+			continue;
+		//newer maps have an alignment column, names never start with a digit
+		if (*field >= '0' && *field <= '9')
+			field = readMapNumber(field, 10, &alignment);
+		if (field == nullptr || *field == '.' || *field == '*' || field >= lineEnd)
+			continue;
+
+		uint32_t length = 0;
+		while (field + length < lineEnd && !isMapSpace(field[length]))
+			length++;
+
+		if (map->count == capacity)
+		{
+			capacity = max(capacity * 2, 1024);
+			struct dolSymbol* symbols = realloc(map->symbols, capacity * sizeof(struct dolSymbol));
+			if (symbols == nullptr)
+			{
+				freeSymbolMap(map);
+				return false;
+			}
+			map->symbols = symbols;
+		}
+		struct dolSymbol* symbol = &map->symbols[map->count++];
+		symbol->address = address;
+		symbol->size = size;
+		symbol->sectionOffset = sectionOffset;
+		symbol->nameOffset = map->namePoolSize;
+		memcpy(map->namePool + map->namePoolSize, field, length);
+		map->namePool[map->namePoolSize + length] = 0;
+		map->namePoolSize += length + 1;
+	}
+
+	qsort(map->symbols, map->count, sizeof(struct dolSymbol), compareDOLSymbols);
+	uint64_t reachEnd = 0;
+	for (uint32_t i = 0; i < map->count; i++)
+	{
+		reachEnd = max(reachEnd, (uint64_t)map->symbols[i].address + max(map->symbols[i].size, 1));
+		map->symbols[i].reachEnd = reachEnd;
+	}
+	map->names = malloc(max(map->count, 1) * sizeof(struct symbolName));
+	if (map->names == nullptr)
+	{
+		freeSymbolMap(map);
+		return false;
+	}
+	for (uint32_t i = 0; i < map->count; i++)
+		map->names[i] = (struct symbolName){ map->namePool + map->symbols[i].nameOffset, i };
+	qsort(map->names, map->count, sizeof(struct symbolName), compareSymbolNames);
+	return true;
+}
+
+static inline const char* getSymbolName(const struct symbolMap* map, const struct dolSymbol* symbol)
+{
+	return map->namePool + symbol->nameOffset;
+}
+
+static inline const char* getSymbolSection(const struct symbolMap* map, const struct dolSymbol* symbol)
+{
+	return map->namePool + symbol->sectionOffset;
+}
+
+//the symbol containing address, nullptr if there is none
+const struct dolSymbol* findSymbolByAddress(const struct symbolMap* map, uint32_t address)
+{
+	uint32_t low = 0;
+	uint32_t high = map->count;
+	while (low < high)
+	{
+		uint32_t middle = (low + high) / 2;
+		if (map->symbols[middle].address <= address)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	//a symbol that starts later is nested in the ones around it and symbols at one address are sorted larger first,
+	//so walking back finds the innermost one first. once nothing this far back reaches the address, nothing before does
+	for (uint32_t i = low; i > 0 && map->symbols[i - 1].reachEnd > address; i--)
+	{
+		const struct dolSymbol* symbol = &map->symbols[i - 1];
+		if (address - symbol->address < max(symbol->size, 1))
+			return symbol;
+	}
+	return nullptr;
+}
+
+const struct dolSymbol* findSymbolByName(const struct symbolMap* map, const char* name)
+{
+	uint32_t low = 0;
+	uint32_t high = map->count;
+	while (low < high)
+	{
+		uint32_t middle = (low + high) / 2;
+		int order = strcmp(map->names[middle].name, name);
+		if (order == 0)
+			return &map->symbols[map->names[middle].symbol];
+		if (order < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return nullptr;
+}
+
+//the DOL of the open image
+bool getGameDOL(struct dolImage* _Out_ dol)
+{
+	const struct DiskHeader* header = GameImageAddress;
+	if (GameImageSize < sizeof(struct DiskHeader) || SwapEndian(header->DOLOffset) >= GameImageSize)
+	{
+		memset(dol, 0, sizeof(struct dolImage));
+		return false;
+	}
+	uint32_t offset = SwapEndian(header->DOLOffset);
+	return parseDOL(OffsetPointer((const uint8_t*)GameImageAddress, offset), GameImageSize - offset, dol);
+}
+
+double getTimeSeconds()
+{
+	static LARGE_INTEGER frequency = { 0 };
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+
+//decodes a texture after decodedAssetFreeZone and appends it to the asset table, returns the new free zone (the old one if it didn't fit)
+void* addTextureAsset(const struct btiTexture* texture, void* decodedAssetFreeZone)
+{
+	size_t size = sizeof(struct decodedImage) + getDecodedTextureSize(texture->width, texture->height);
+	size_t freeSpace = DECODED_ASSET_DATA_SIZE - ((char*)decodedAssetFreeZone - (char*)decodedAssetData);
+	if (decodedAssetCount >= DECODED_ASSET_TABLE_SIZE || size > freeSpace)
+		return decodedAssetFreeZone;
+
+	struct decodedImage* image = decodedAssetFreeZone;
+	decodeBTITexture(texture, OffsetPointer(decodedAssetFreeZone, sizeof(struct decodedImage)), image);
+
+	decodedAssetTable[decodedAssetCount].assetType = ASSET_TYPE_TEXTURE;
+	decodedAssetTable[decodedAssetCount].assetPtr = image;
+	decodedAssetCount++;
+	return OffsetPointer(decodedAssetFreeZone, size);
+}
+
+//indexes a bmg file after decodedAssetFreeZone and appends its message listing to the asset table, returns the new free zone
+void* addMessageAsset(const void* data, uint32_t size, void* decodedAssetFreeZone)
+{
+	size_t freeSpace = DECODED_ASSET_DATA_SIZE - ((char*)decodedAssetFreeZone - (char*)decodedAssetData);
+	struct bmgFile bmg;
+	if (decodedAssetCount >= DECODED_ASSET_TABLE_SIZE || !parseBMGFile(data, size, decodedAssetFreeZone, freeSpace, &bmg))
+		return decodedAssetFreeZone;
+
+	//the listing goes after the index
+	size_t indexSize = sizeof(struct bmgMessage) * bmg.messageCount;
+	if (freeSpace - indexSize < 256)
+		return decodedAssetFreeZone;
+	char* listing = OffsetPointer(decodedAssetFreeZone, indexSize);
+	int length = formatBMGFile(&bmg, listing, (int)(freeSpace - indexSize));
+
+	decodedAssetTable[decodedAssetCount].assetType = ASSET_TYPE_TEXT;
+	decodedAssetTable[decodedAssetCount].assetPtr = listing;
+	decodedAssetCount++;
+	return OffsetPointer(listing, length + 1);
+}
+
+//the wav being played, PlaySound reads it from memory until it's stopped
+uint8_t* playbackWAV = nullptr;
+
+//decodes an .ast or .dsp file to a wav in memory and starts playing it
+void playAudioFile(int fileIndex)
+{
+	PlaySoundA(nullptr, nullptr, 0);
+	free(playbackWAV);
+	playbackWAV = nullptr;
+
+	struct audioStream stream;
+	const void* data = gameFileList[fileIndex].filePtr;
+	uint32_t size = gameFileList[fileIndex].fileSize;
+	if (!(gameFileHasExtension(fileIndex, ".ast") ? loadASTStream(data, size, &stream) : loadDSPStream(data, size, &stream)))
+	{
+		printf("not an ast or dsp file, or one in an unknown format\n");
+		return;
+	}
+
+	static const char* codecNames[] = { "dsp-adpcm", "afc", "pcm16", "pcm8" };
+	printf("%s, %u channels, %u Hz, %u samples (%.2f s)", codecNames[stream.codec], stream.channelCount, stream.sampleRate, stream.sampleCount, stream.sampleCount / (double)max(stream.sampleRate, 1));
+	if (stream.looping)
+		printf(", loops from %u to %u", stream.loopStart, stream.loopEnd);
+	printf("\n");
+
+	playbackWAV = malloc(44 + getDecodedAudioSize(&stream));
+	if (playbackWAV == nullptr)
+	{
+		printf("not enough memory to decode the stream\n");
+		return;
+	}
+	double start = getTimeSeconds();
+	uint32_t sampleCount = decodeAudioStream(&stream, (int16_t*)(playbackWAV + 44));
+	printf("decoded in %.3f ms\n", (getTimeSeconds() - start) * 1000.0);
+
+	getWAVHeader(stream.channelCount, stream.sampleRate, sampleCount, playbackWAV);
+	PlaySoundA((LPCSTR)playbackWAV, nullptr, SND_MEMORY | SND_ASYNC);
+}
+
+//prints the wave groups of every WSYS chunk in a .baa/.aaf bank file
+void listWaveBanks(const void* bank, size_t bankSize)
+{
+	size_t offset = 0;
+	for (const struct wsysHeader* wsys = findWSYSChunk(bank, bankSize, &offset); wsys != nullptr; wsys = findWSYSChunk(bank, bankSize, &offset))
+	{
+		printf("WSYS %u\n", SwapEndian(wsys->id));
+		const struct wsysWaveGroup* group;
+		for (uint32_t g = 0; (group = getWSYSWaveGroup(wsys, g)) != nullptr; g++)
+			printf("\t%.*s: %u waves\n", (int)sizeof(group->archiveName), group->archiveName, SwapEndian(group->waveCount));
+	}
+}
+
+//with the batch jobs below, which read game files the same way
+static int listGameFileMembers(int fileIndex, uint8_t** decompressionBuffer, struct archiveMember* members, int maxMembers);
+
+/*
+* texture gallery
+* every texture in a directory or an archive as a grid of thumbnails. a background thread lists the textures file by file
+* and makes thumbnails of the visible ones only: the first mip level in the file that fits GALLERY_THUMBNAIL_SIZE (or the
+* last level there is) is decoded and box filtered down by 2 until it fits, then packed into a shelf allocated atlas.
+* the atlas is kept across selections and cleared when it runs full, so the gallery needs the atlas and one decoded
+* texture however many textures there are
+*/
+#define GALLERY_THUMBNAIL_SIZE 64
+#define GALLERY_CELL_SIZE (GALLERY_THUMBNAIL_SIZE + 8)
+#define GALLERY_ATLAS_SIZE 2048
+//a thumbnail takes at most a GALLERY_THUMBNAIL_SIZE square of shelf, part filled shelves waste less than a quarter of the atlas
+#define GALLERY_MAX_VISIBLE ((GALLERY_ATLAS_SIZE / GALLERY_THUMBNAIL_SIZE) * (GALLERY_ATLAS_SIZE / GALLERY_THUMBNAIL_SIZE) * 3 / 4)
+#define GALLERY_MAX_FILE_TEXTURES 4096
+#define GALLERY_BTI_MEMBER 0xFFFF//texture index of a member that is a .bti itself
+#define GALLERY_EMPTY 0
+#define GALLERY_READY 1
+#define GALLERY_FAILED 2
+
+struct galleryEntry
+{
+	int fileIndex;
+	uint16_t member;//in listGameFileMembers order
+	uint16_t texture;//in its model's TEX1, or GALLERY_BTI_MEMBER
+	uint16_t width;
+	uint16_t height;
+	uint16_t atlasX;
+	uint16_t atlasY;
+	uint8_t thumbnailWidth;
+	uint8_t thumbnailHeight;
+	uint8_t format;
+	uint8_t state;
+	uint32_t atlasEpoch;//the thumbnail is only in the atlas while this matches the atlas
+};
+
+struct atlasShelf
+{
+	uint16_t y;
+	uint16_t height;
+	uint16_t usedWidth;
+};
+
+struct textureAtlas
+{
+	uint32_t* pixels;//GALLERY_ATLAS_SIZE squared, top down
+	struct atlasShelf shelves[GALLERY_ATLAS_SIZE / 4];
+	uint32_t shelfCount;
+	uint32_t usedHeight;
+	uint32_t epoch;//bumped by every clear
+};
+
+//the state of whoever makes the thumbnails, the members of the last file stay listed for the next texture in it
+struct galleryWorker
+{
+	uint8_t* decompressionBuffer;
+	struct archiveMember members[1024];
+	int memberCount;
+	int membersFile;
+	uint32_t* pixels;
+	size_t pixelsSize;
+	struct galleryEntry* listed;//GALLERY_MAX_FILE_TEXTURES
+	uint64_t decodedBytes;
+	uint64_t baseLevelBytes;//what decoding every base level would have been
+};
+
+//halves both sides (a side of 1 stays 1) averaging 2x2 blocks. dest may be src, no pixel is written before it is read
+void downsampleBox2x(const uint32_t* src, uint32_t width, uint32_t height, uint32_t* _Out_ dest)
+{
+	uint32_t outputWidth = max(width / 2, 1);
+	uint32_t outputHeight = max(height / 2, 1);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rounding = _mm_set1_epi16(2);
+	for (uint32_t y = 0; y < outputHeight; y++)
+	{
+		const uint32_t* top = src + (size_t)min(y * 2, height - 1) * width;
+		const uint32_t* bottom = src + (size_t)min(y * 2 + 1, height - 1) * width;
+		uint32_t* output = dest + (size_t)y * outputWidth;
+
+		//4x2 pixels to 2, the channels widened to 16 bits so the average is exact
+		uint32_t x = 0;
+		for (; x * 2 + 4 <= width; x += 2)
+		{
+			__m128i topPixels = _mm_loadu_si128((const __m128i*)(top + x * 2));
+			__m128i bottomPixels = _mm_loadu_si128((const __m128i*)(bottom + x * 2));
+			__m128i left = _mm_add_epi16(_mm_unpacklo_epi8(topPixels, zero), _mm_unpacklo_epi8(bottomPixels, zero));
+			__m128i right = _mm_add_epi16(_mm_unpackhi_epi8(topPixels, zero), _mm_unpackhi_epi8(bottomPixels, zero));
+			__m128i sums = _mm_add_epi16(_mm_unpacklo_epi64(left, right), _mm_unpackhi_epi64(left, right));
+			__m128i averages = _mm_srli_epi16(_mm_add_epi16(sums, rounding), 2);
+			_mm_storel_epi64((__m128i*)(output + x), _mm_packus_epi16(averages, averages));
+		}
+
+		//the last column of an odd width, and widths below 4
+		for (; x < outputWidth; x++)
+		{
+			uint32_t left = min(x * 2, width - 1);
+			uint32_t right = min(x * 2 + 1, width - 1);
+			uint32_t pixel = 0;
+			for (uint32_t shift = 0; shift < 32; shift += 8)
+			{
+				uint32_t sum = (top[left] >> shift & 0xFF) + (top[right] >> shift & 0xFF) + (bottom[left] >> shift & 0xFF) + (bottom[right] >> shift & 0xFF);
+				pixel |= (sum + 2) >> 2 << shift;
+			}
+			output[x] = pixel;
+		}
+	}
+}
+
+void clearTextureAtlas(struct textureAtlas* atlas)
+{
+	atlas->shelfCount = 0;
+	atlas->usedHeight = 0;
+	atlas->epoch++;
+}
+
+//shelves are as high as the power of two a thumbnail rounds up to, so thumbnails of similar heights share them
+bool allocateAtlasRect(struct textureAtlas* atlas, uint32_t width, uint32_t height, uint16_t* _Out_ x, uint16_t* _Out_ y)
+{
+	uint32_t shelfHeight = 4;
+	while (shelfHeight < height)
+		shelfHeight *= 2;
+
+	for (uint32_t i = 0; i < atlas->shelfCount; i++)
+	{
+		struct atlasShelf* shelf = &atlas->shelves[i];
+		if (shelf->height == shelfHeight && GALLERY_ATLAS_SIZE - shelf->usedWidth >= width)
+		{
+			*x = shelf->usedWidth;
+			*y = shelf->y;
+			shelf->usedWidth += width;
+			return true;
+		}
+	}
+
+	if (GALLERY_ATLAS_SIZE - atlas->usedHeight < shelfHeight || atlas->shelfCount == countof(atlas->shelves))
+		return false;
+	struct atlasShelf* shelf = &atlas->shelves[atlas->shelfCount++];
+	shelf->y = (uint16_t)atlas->usedHeight;
+	shelf->height = (uint16_t)shelfHeight;
+	shelf->usedWidth = (uint16_t)width;
+	atlas->usedHeight += shelfHeight;
+	*x = 0;
+	*y = shelf->y;
+	return true;
+}
+
+//returns false when the atlas is full
+static bool addGalleryThumbnail(struct textureAtlas* atlas, struct galleryEntry* entry, const uint32_t* pixels, uint32_t width, uint32_t height)
+{
+	if (!allocateAtlasRect(atlas, width, height, &entry->atlasX, &entry->atlasY))
+		return false;
+	for (uint32_t row = 0; row < height; row++)
+		memcpy(atlas->pixels + (size_t)(entry->atlasY + row) * GALLERY_ATLAS_SIZE + entry->atlasX, pixels + (size_t)row * width, width * 4);
+	entry->thumbnailWidth = (uint8_t)width;
+	entry->thumbnailHeight = (uint8_t)height;
+	entry->atlasEpoch = atlas->epoch;
+	entry->state = GALLERY_READY;
+	return true;
+}
+
+static void loadGalleryMembers(struct galleryWorker* worker, int fileIndex)
+{
+	if (worker->membersFile == fileIndex)
+		return;
+	worker->memberCount = listGameFileMembers(fileIndex, &worker->decompressionBuffer, worker->members, countof(worker->members));
+	worker->membersFile = fileIndex;
+}
+
+//fills worker->listed with the .bti files and members and the TEX1 textures of the models in a game file, returns how many.
+//palette formats aren't decoded, so they're left out
+static uint32_t listGalleryTextures(struct galleryWorker* worker, int fileIndex)
+{
+	//only these can hold textures, anything else isn't even decompressed
+	static const char* extensions[] = { ".szs", ".arc", ".bti", ".bmd", ".bdl" };
+	bool candidate = false;
+	for (uint32_t e = 0; e < countof(extensions); e++)
+		candidate |= gameFileHasExtension(fileIndex, extensions[e]);
+	if (!candidate)
+		return 0;
+
+	loadGalleryMembers(worker, fileIndex);
+	uint32_t count = 0;
+	for (int m = 0; m < worker->memberCount; m++)
+	{
+		const struct archiveMember* member = &worker->members[m];
+		struct btiTexture texture;
+		if (nameHasExtension(member->name, ".bti"))
+		{
+			if (count < GALLERY_MAX_FILE_TEXTURES && loadBTITexture(member->data, member->size, &texture) && isDecodableTextureFormat(texture.format))
+				worker->listed[count++] = (struct galleryEntry){ fileIndex, (uint16_t)m, GALLERY_BTI_MEMBER, (uint16_t)texture.width, (uint16_t)texture.height, .format = texture.format };
+			continue;
+		}
+
+		const struct TEX1* textures = isJ3DModel(member->data, member->size) ? (const struct TEX1*)findJ3DChunk(member->data, member->size, "TEX1") : nullptr;
+		for (uint32_t t = 0; textures != nullptr && t < (uint16_t)SwapEndian(textures->textureCount) && count < GALLERY_MAX_FILE_TEXTURES; t++)
+			if (loadTEX1Texture(textures, t, &texture) && isDecodableTextureFormat(texture.format))
+				worker->listed[count++] = (struct galleryEntry){ fileIndex, (uint16_t)m, (uint16_t)t, (uint16_t)texture.width, (uint16_t)texture.height, .format = texture.format };
+	}
+	return count;
+}
+
+//returns the thumbnail in worker->pixels, nullptr if the texture can't be found or decoded any more
+static const uint32_t* makeGalleryThumbnail(struct galleryWorker* worker, const struct galleryEntry* entry, uint32_t* _Out_ width, uint32_t* _Out_ height)
+{
+	loadGalleryMembers(worker, entry->fileIndex);
+	if (entry->member >= worker->memberCount)
+		return nullptr;
+
+	const struct archiveMember* member = &worker->members[entry->member];
+	struct btiTexture texture;
+	if (entry->texture == GALLERY_BTI_MEMBER)
+	{
+		if (!loadBTITexture(member->data, member->size, &texture))
+			return nullptr;
+	}
+	else
+	{
+		const struct TEX1* textures = isJ3DModel(member->data, member->size) ? (const struct TEX1*)findJ3DChunk(member->data, member->size, "TEX1") : nullptr;
+		if (textures == nullptr || !loadTEX1Texture(textures, entry->texture, &texture))
+			return nullptr;
+	}
+
+	//a smaller level that is in the file is decoded instead of the base one, the filter then has less or nothing to do
+	const uint8_t* data = texture.data;
+	uint32_t levelWidth = texture.width;
+	uint32_t levelHeight = texture.height;
+	for (uint32_t level = 1; level < texture.levelCount && max(levelWidth, levelHeight) > GALLERY_THUMBNAIL_SIZE; level++)
+	{
+		data += getTextureDataSize(texture.format, levelWidth, levelHeight);
+		levelWidth = max(levelWidth / 2, 1);
+		levelHeight = max(levelHeight / 2, 1);
+	}
+
+	size_t size = getDecodedTextureSize(levelWidth, levelHeight);
+	if (size > worker->pixelsSize)
+	{
+		uint32_t* pixels = trackedRealloc(MEMORY_PIXELS, worker->pixels, size);
+		if (pixels == nullptr)
+			return nullptr;
+		worker->pixels = pixels;
+		worker->pixelsSize = size;
+	}
+	decodeTexture(levelWidth, levelHeight, levelWidth * levelHeight, data, (uint8_t*)worker->pixels, texture.format);
+	worker->decodedBytes += (uint64_t)levelWidth * levelHeight * 4;
+	worker->baseLevelBytes += (uint64_t)texture.width * texture.height * 4;
+
+	while (max(levelWidth, levelHeight) > GALLERY_THUMBNAIL_SIZE)
+	{
+		downsampleBox2x(worker->pixels, levelWidth, levelHeight, worker->pixels);
+		levelWidth = max(levelWidth / 2, 1);
+		levelHeight = max(levelHeight / 2, 1);
+	}
+	*width = levelWidth;
+	*height = levelHeight;
+	return worker->pixels;
+}
+
+static void freeGalleryWorker(struct galleryWorker* worker)
+{
+	trackedFree(worker->decompressionBuffer);
+	trackedFree(worker->pixels);
+	free(worker->listed);
+}
+
+//the gallery of the file view, the worker is only touched by its thread
+struct textureGallery
+{
+	CRITICAL_SECTION lock;//everything below but the worker
+	HANDLE wake;
+	HWND view;
+	struct galleryWorker worker;
+	struct textureAtlas atlas;
+	struct galleryEntry* entries;
+	uint32_t entryCount;
+	uint32_t entryCapacity;
+	int* files;//to be listed
+	uint32_t fileCount;
+	uint32_t nextFile;
+	uint32_t visibleFirst;
+	uint32_t visibleEnd;
+	uint32_t selection;//bumped by every open and close, work for an older selection is dropped
+	bool active;
+};
+
+static struct textureGallery textureGallery;
+
+//visible thumbnails first, then the next file to list, then it waits for the view to scroll or another selection
+static DWORD WINAPI galleryWorkerProcedure(void* parameter)
+{
+	struct textureGallery* gallery = parameter;
+	for (;;)
+	{
+		WaitForSingleObject(gallery->wake, INFINITE);
+		for (;;)
+		{
+			EnterCriticalSection(&gallery->lock);
+			uint32_t selection = gallery->selection;
+			int entryIndex = -1;
+			for (uint32_t i = gallery->visibleFirst; i < min(gallery->visibleEnd, gallery->entryCount) && entryIndex < 0; i++)
+			{
+				const struct galleryEntry* entry = &gallery->entries[i];
+				if (entry->state == GALLERY_EMPTY || (entry->state == GALLERY_READY && entry->atlasEpoch != gallery->atlas.epoch))
+					entryIndex = i;
+			}
+			struct galleryEntry entry = entryIndex >= 0 ? gallery->entries[entryIndex] : (struct galleryEntry){ 0 };
+			int fileIndex = entryIndex < 0 && gallery->nextFile < gallery->fileCount ? gallery->files[gallery->nextFile++] : -1;
+			LeaveCriticalSection(&gallery->lock);
+
+			if (entryIndex < 0 && fileIndex < 0)
+				break;
+
+			if (entryIndex >= 0)
+			{
+				uint32_t width, height;
+				const uint32_t* thumbnail = makeGalleryThumbnail(&gallery->worker, &entry, &width, &height);
+				EnterCriticalSection(&gallery->lock);
+				if (gallery->selection == selection)
+				{
+					struct galleryEntry* target = &gallery->entries[entryIndex];
+					if (thumbnail == nullptr)
+					{
+						target->state = GALLERY_FAILED;
+					}
+					else if (!addGalleryThumbnail(&gallery->atlas, target, thumbnail, width, height))
+					{
+						//the visible range always fits in an empty atlas, what gets dropped here is offscreen
+						clearTextureAtlas(&gallery->atlas);
+						addGalleryThumbnail(&gallery->atlas, target, thumbnail, width, height);
+					}
+				}
+				LeaveCriticalSection(&gallery->lock);
+			}
+			else
+			{
+				uint32_t count = listGalleryTextures(&gallery->worker, fileIndex);
+				EnterCriticalSection(&gallery->lock);
+				if (gallery->selection == selection && count != 0)
+				{
+					//the file's textures are left out of the gallery if the entries can't grow
+					if (gallery->entryCount + count > gallery->entryCapacity)
+					{
+						uint32_t capacity = max(gallery->entryCapacity * 2, gallery->entryCount + count);
+						struct galleryEntry* entries = realloc(gallery->entries, capacity * sizeof(struct galleryEntry));
+						if (entries == nullptr)
+							count = 0;
+						else
+						{
+							gallery->entries = entries;
+							gallery->entryCapacity = capacity;
+						}
+					}
+					memcpy(gallery->entries + gallery->entryCount, gallery->worker.listed, count * sizeof(struct galleryEntry));
+					gallery->entryCount += count;
+				}
+				LeaveCriticalSection(&gallery->lock);
+				if (count == 0)
+					continue;
+			}
+			InvalidateRect(gallery->view, nullptr, FALSE);
+		}
+	}
+	return 0;
+}
+
+//shows the textures of files in view, the atlas and the thread are kept from the last gallery
+void openTextureGallery(HWND view, const int* files, uint32_t fileCount)
+{
+	struct textureGallery* gallery = &textureGallery;
+	if (gallery->wake == nullptr)
+	{
+		//nothing is set up until both buffers are there, the next open tries again
+		uint32_t* atlasPixels = calloc((size_t)GALLERY_ATLAS_SIZE * GALLERY_ATLAS_SIZE, sizeof(uint32_t));
+		struct galleryEntry* listed = malloc(sizeof(struct galleryEntry) * GALLERY_MAX_FILE_TEXTURES);
+		if (atlasPixels == nullptr || listed == nullptr)
+		{
+			printf("not enough memory for the texture gallery\n");
+			free(atlasPixels);
+			free(listed);
+			return;
+		}
+		InitializeCriticalSection(&gallery->lock);
+		gallery->wake = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+		gallery->atlas.pixels = atlasPixels;
+		gallery->worker.listed = listed;
+		gallery->worker.membersFile = -1;
+		CloseHandle(CreateThread(nullptr, 0, galleryWorkerProcedure, gallery, 0, nullptr));
+	}
+
+	EnterCriticalSection(&gallery->lock);
+	gallery->view = view;
+	//without room for the file list the gallery opens empty
+	int* galleryFiles = realloc(gallery->files, max(fileCount, 1) * sizeof(int));
+	if (galleryFiles == nullptr)
+		fileCount = 0;
+	else
+	{
+		gallery->files = galleryFiles;
+		memcpy(gallery->files, files, fileCount * sizeof(int));
+	}
+	gallery->fileCount = fileCount;
+	gallery->nextFile = 0;
+	gallery->entryCount = 0;
+	gallery->visibleFirst = 0;
+	gallery->visibleEnd = 0;
+	gallery->selection++;
+	gallery->active = true;
+	clearTextureAtlas(&gallery->atlas);
+	LeaveCriticalSection(&gallery->lock);
+	SetEvent(gallery->wake);
+}
+
+//the file view gets back the scroll range it is created with
+void closeTextureGallery()
+{
+	struct textureGallery* gallery = &textureGallery;
+	if (gallery->wake == nullptr || !gallery->active)
+		return;
+	EnterCriticalSection(&gallery->lock);
+	gallery->active = false;
+	gallery->fileCount = 0;
+	gallery->entryCount = 0;
+	gallery->selection++;
+	LeaveCriticalSection(&gallery->lock);
+
+	SCROLLINFO si = { sizeof(SCROLLINFO), SIF_RANGE | SIF_PAGE | SIF_POS, 0, 200, 50, 0 };
+	SetScrollInfo(gallery->view, SB_VERT, &si, TRUE);
+}
+
+//draws the open gallery into the file view, scrolled by rows. returns false if there is none
+static bool paintTextureGallery(HWND hwnd, HDC hdc, SCROLLINFO* si)
+{
+	struct textureGallery* gallery = &textureGallery;
+	if (gallery->wake == nullptr)
+		return false;
+
+	RECT client;
+	GetClientRect(hwnd, &client);
+	uint32_t columns = max(client.right / GALLERY_CELL_SIZE, 1);
+	uint32_t visibleRows = client.bottom / GALLERY_CELL_SIZE + 1;
+
+	EnterCriticalSection(&gallery->lock);
+	if (!gallery->active)
+	{
+		LeaveCriticalSection(&gallery->lock);
+		return false;
+	}
+
+	//the scroll range grows with the rows listed so far
+	uint32_t rows = (gallery->entryCount + columns - 1) / columns;
+	si->cbSize = sizeof(SCROLLINFO);
+	si->fMask = SIF_RANGE | SIF_PAGE | SIF_POS;
+	si->nMin = 0;
+	si->nMax = max(rows, 1);
+	si->nPage = visibleRows;
+	si->nPos = SetScrollInfo(hwnd, SB_VERT, si, TRUE);
+
+	uint32_t first = min(si->nPos * columns, gallery->entryCount);
+	uint32_t end = min(first + min(visibleRows * columns, GALLERY_MAX_VISIBLE), gallery->entryCount);
+	gallery->visibleFirst = first;
+	gallery->visibleEnd = end;
+
+	FillRect(hdc, &client, (HBRUSH)(COLOR_WINDOW + 1));
+	BITMAPINFO info = { 0 };
+	info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	info.bmiHeader.biWidth = GALLERY_ATLAS_SIZE;
+	info.bmiHeader.biPlanes = 1;
+	info.bmiHeader.biBitCount = 32;
+	for (uint32_t i = first; i < end; i++)
+	{
+		const struct galleryEntry* entry = &gallery->entries[i];
+		int cellX = (int)((i - first) % columns) * GALLERY_CELL_SIZE;
+		int cellY = (int)((i - first) / columns) * GALLERY_CELL_SIZE;
+		if (entry->state == GALLERY_READY && entry->atlasEpoch == gallery->atlas.epoch)
+		{
+			//the rows of the thumbnail as a top down bitmap of their own, so only the source x is an offset
+			info.bmiHeader.biHeight = -(LONG)entry->thumbnailHeight;
+			StretchDIBits(hdc, cellX + (GALLERY_CELL_SIZE - entry->thumbnailWidth) / 2, cellY + (GALLERY_CELL_SIZE - entry->thumbnailHeight) / 2,
+				entry->thumbnailWidth, entry->thumbnailHeight, entry->atlasX, 0, entry->thumbnailWidth, entry->thumbnailHeight,
+				gallery->atlas.pixels + (size_t)entry->atlasY * GALLERY_ATLAS_SIZE, &info, DIB_RGB_COLORS, SRCCOPY);
+		}
+		else if (entry->state != GALLERY_FAILED)
+		{
+			RECT placeholder = { cellX + 4, cellY + 4, cellX + GALLERY_CELL_SIZE - 4, cellY + GALLERY_CELL_SIZE - 4 };
+			FillRect(hdc, &placeholder, (HBRUSH)(COLOR_BTNFACE + 1));
+		}
+	}
+	LeaveCriticalSection(&gallery->lock);
+	SetEvent(gallery->wake);
+	return true;
+}
+
+//the game files under a tree item, in tree order. directory items carry a stale lParam, so a file is an lParam whose file points back at the item
+static uint32_t collectTreeFiles(HWND treeView, HTREEITEM item, int* files, uint32_t maxFiles, uint32_t count)
+{
+	for (HTREEITEM child = (HTREEITEM)SendMessageW(treeView, TVM_GETNEXTITEM, TVGN_CHILD, (LPARAM)item); child != nullptr && count < maxFiles;
+		child = (HTREEITEM)SendMessageW(treeView, TVM_GETNEXTITEM, TVGN_NEXT, (LPARAM)child))
+	{
+		TVITEMW tvi = { 0 };
+		tvi.mask = TVIF_PARAM;
+		tvi.hItem = child;
+		SendMessageW(treeView, TVM_GETITEMW, 0, (LPARAM)&tvi);
+		if (tvi.lParam >= 0 && tvi.lParam < gameFileCount && gameFileList[tvi.lParam].treeItem == child)
+			files[count++] = (int)tvi.lParam;
+		else
+			count = collectTreeFiles(treeView, child, files, maxFiles, count);
+	}
+	return count;
+}
+
+LRESULT CALLBACK WindowProcedure(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+	static HWND hTreeView;
+	static HWND hFileView;
+
+	switch (msg)
+	{
+	case WM_CREATE:
+	{
+		WNDCLASSW wc = { 0 };
+
+		wc.hbrBackground = (HBRUSH)COLOR_WINDOW;
+		wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+		wc.hInstance = GetModuleHandleW(nullptr);
+		wc.lpszClassName = L"FileViewerWindowClass";
+		wc.lpfnWndProc = &FileViewerWindowProcedure;
+		RegisterClassW(&wc);
+
+
+		hTreeView = CreateWindowExW(0, WC_TREEVIEW, L"Tree View",
+			WS_VISIBLE | WS_CHILD | WS_BORDER | TVS_HASLINES,
+			0, 0, 200, 500,
+			hwnd, NULL, NULL, NULL);
+
+		hFileView = CreateWindowExW(0, L"FileViewerWindowClass", L"File View",
+			WS_VISIBLE | WS_CHILD | WS_BORDER | TVS_HASLINES | WS_VSCROLL,
+			200, 0, 200, 500,
+			hwnd, NULL, NULL, NULL);
+
+		indexGameFiles(hTreeView);
+		break;
+	}
+	case WM_SIZE:
+	{
 		MoveWindow(hTreeView, 0, 0, LOWORD(lParam) / 5, HIWORD(lParam), TRUE);
 		MoveWindow(hFileView, LOWORD(lParam) / 5, 0, LOWORD(lParam) - (LOWORD(lParam) / 5), HIWORD(lParam), TRUE);
 		InvalidateRect(hFileView, nullptr, TRUE);
 		UpdateWindow(hFileView);
 
-		break;
+		break;
+
+	}
+	case WM_NOTIFY:
+	{
+		LPNMHDR lpnmh = (LPNMHDR)lParam;
+		if (lpnmh->code == TVN_SELCHANGED)
+		{
+			//printf("selection changed ");
+
+
+			LPNMTREEVIEWW lpnm = (LPNMTREEVIEWW)lParam;
+
+			HWND hTreeView = lpnm->hdr.hwndFrom;
+			HTREEITEM hSelected = lpnm->itemNew.hItem;
+
+			TCHAR buffer[64];
+			TVITEMW tvi;
+
+			tvi.mask = TVIF_TEXT;
+			tvi.hItem = hSelected;
+			tvi.pszText = buffer;
+			tvi.cchTextMax = sizeof(buffer) / sizeof(buffer[0]);
+
+			SendMessageW(hTreeView, TVM_GETITEM, 0, (LPARAM)&tvi);
+
+			//wprintf(L"selected item: %s\n", tvi.pszText);
+
+			const wchar_t* extensionType = wcsrchr(tvi.pszText, L'.');
+
+			TRACE_BEGIN(selectionSpan);
+			bool directory = true;
+			for (int i = 0; i < gameFileCount; i++)
+			{
+				if (gameFileList[i].treeItem == hSelected)
+				{
+					selectedFileIndex = i;
+					directory = false;
+					closeTextureGallery();
+
+					if (wcscmp(extensionType, L".szs") == 0)
+					{
+						printf("dealing with a compressed szs file!\n");
+
+						const struct yaz0Header* header = gameFileList[selectedFileIndex].filePtr;
+
+						printf("magic: ");
+						WriteConsoleA(ConsoleHandle, &header->magic, 4, nullptr, nullptr);
+						printf("\nuncompressed size: %i\n", SwapEndian(header->uncompressedSize));
+
+
+
+						const uint8_t* src = OffsetPointer(gameFileList[selectedFileIndex].filePtr, sizeof(struct yaz0Header));// pointer to start of source
+						const uint8_t* src_end = OffsetPointer(src, gameFileList[selectedFileIndex].fileSize - sizeof(struct yaz0Header));// pointer to end of source (last byte +1)
+						uint8_t* archive = trackedRealloc(MEMORY_YAZ0, selectedArchive, max(SwapEndian(header->uncompressedSize), 1));
+						if (archive == nullptr)
+						{
+							printf("not enough memory to decompress it\n");
+							break;
+						}
+						selectedArchive = archive;
+						uint8_t* dest = selectedArchive;// pointer to start of destination
+						memset(dest, 0, SwapEndian(header->uncompressedSize));
+						uint8_t* dest_end = OffsetPointer(dest, SwapEndian(header->uncompressedSize));// pointer to end of destination (last byte +1)
+
+						int decompressionStatus = DecompressYAZ(
+							src,//data
+							gameFileList[selectedFileIndex].fileSize - sizeof(struct yaz0Header),//data size
+							dest,//dest buf
+							SwapEndian(header->uncompressedSize),
+							nullptr,//write status
+							0,//yaz version (pikmin 2 uses yaz0)
+							true
+							);
+
+						printf("decompression status: %i\n", decompressionStatus);
+
+						//for (int j = 180; j < 512; j++)
+						//for (int j = 192; j < 512; j++)
+						//for (int j = 224; j < 512; j++)
+						//{
+						//	printf("%c", dest[j]);
+						//}
+
+						//printf("\n");
+
+						//todo: sort different files by type, but for now only the first model in the archive is shown
+						struct archiveMember members[1024];
+						int memberCount = listRarcMembers(dest, SwapEndian(header->uncompressedSize), members, countof(members));
+
+						const struct archiveMember* model = nullptr;
+						for (int i = 0; i < memberCount && model == nullptr; i++)
+							if (isJ3DModel(members[i].data, members[i].size))
+								model = &members[i];
+
+						decodedAssetCount = 0;
+						displayedModelValid = false;
+						clearBlobCache(&decodedTextureCache);
+						void* decodedAssetFreeZone = decodedAssetData;
+
+						if (model != nullptr)
+						{
+							printf("model: %s\n", model->name);
+
+							const struct J3DFileHeader* bmdFileHeader = model->data;
+
+							printf("block count: %i\n", SwapEndian(bmdFileHeader->blockCount));
+
+							decodedAssetCount = 0;
+
+							//TEX1 order, the preview is rendered with them once the model is parsed
+							const struct decodedImage* modelTextures[RASTER_MAX_TEXTURES] = { 0 };
+							uint32_t modelTextureCount = 0;
+
+
+							//iterate over bmd sections, the cursor stops at the first one that isn't inside the file
+							struct j3dChunkCursor cursor;
+							initJ3DChunkCursor(&cursor, model->data, model->size);
+
+							for (const struct bmdSection* currentSection; (currentSection = nextJ3DChunk(&cursor)) != nullptr;)
+							{
+								printf("chunk type: %c%c%c%c\n",
+									currentSection->chunkType[0],
+									currentSection->chunkType[1],
+									currentSection->chunkType[2],
+									currentSection->chunkType[3]
+								);
+
+								if (
+									currentSection->chunkType[0] == 'I' &&
+									currentSection->chunkType[1] == 'N' &&
+									currentSection->chunkType[2] == 'F' &&
+									currentSection->chunkType[3] == '1'
+									)
+								{
+									const struct INF1* header = currentSection;
+
+									printf("size: %i\n", SwapEndian(header->size));
+
+									printf("vertex count: %i\n", SwapEndian(header->vertexCount));
+
+									printf("hierarchy data offset: %i\n", SwapEndian(header->hierarchyDataOffset));
+
+									//the hierarchy itself is flattened by parseJ3DModel and printed after it
+								}
+								else if (
+									currentSection->chunkType[0] == 'T' &&
+									currentSection->chunkType[1] == 'E' &&
+									currentSection->chunkType[2] == 'X' &&
+									currentSection->chunkType[3] == '1')
+								{
+									printf("reading TEX1\n");
+
+									const struct TEX1* header = currentSection;
+
+
+									printf("texture count: %i\n", SwapEndian(header->textureCount));
+
+									TRACE_BEGIN(textureSpan);
+									for (int texNum = 0; texNum < SwapEndian(header->textureCount); texNum++)
+									{
+										struct btiTexture texture;
+										if (!loadTEX1Texture(header, texNum, &texture))
+										{
+											printf("texture %i is out of bounds or in an unknown format\n", texNum);
+											continue;
+										}
+
+										printf("texture format: 0x%X\n", texture.format);
+										printf("texture size: %u x %u\n", texture.width, texture.height);
+										printf("offset in file: 0x%X\n", SwapEndian(texture.header->textureDataOffset));
+
+										//identical textures are only decoded once and then shared
+										uint64_t textureHash = hashTexture(&texture);
+										struct cachedTexture* cached = findCachedBlob(&decodedTextureCache, textureHash);
+										if (cached != nullptr && !isSameTexture(&cached->source, &texture))
+											cached = nullptr;
+
+										size_t freeSpace = DECODED_ASSET_DATA_SIZE - ((char*)decodedAssetFreeZone - (char*)decodedAssetData);
+										if (decodedAssetCount >= DECODED_ASSET_TABLE_SIZE || (cached == nullptr && sizeof(struct cachedTexture) + getDecodedTextureSize(texture.width, texture.height) > freeSpace))
+										{
+											printf("texture %i doesn't fit in the asset buffer\n", texNum);
+											continue;
+										}
+
+										if (cached == nullptr)
+										{
+											cached = decodedAssetFreeZone;
+											cached->source = texture;
+											decodedAssetFreeZone = OffsetPointer(decodedAssetFreeZone, sizeof(struct cachedTexture));
+											decodeBTITexture(&texture, decodedAssetFreeZone, &cached->image);
+											decodedAssetFreeZone = OffsetPointer(decodedAssetFreeZone, getDecodedTextureSize(texture.width, texture.height));
+
+											addCachedBlob(&decodedTextureCache, textureHash, cached);
+										}
+										else
+										{
+											printf("same as an earlier texture, not decoded again\n");
+										}
+
+										if (texNum < RASTER_MAX_TEXTURES)
+										{
+											modelTextures[texNum] = &cached->image;
+											modelTextureCount = texNum + 1;
+										}
+
+										decodedAssetTable[decodedAssetCount].assetType = ASSET_TYPE_TEXTURE;
+										decodedAssetTable[decodedAssetCount].assetPtr = &cached->image;
+										decodedAssetCount++;
+									}
+									TRACE_END(textureSpan, "TEX1");
+								}
+								//the geometry chunks are read by parseJ3DModel below, anything else is skipped
+							}
+
+							TRACE_BEGIN(parseSpan);
+							displayedModelValid = parseJ3DModel(model->data, model->size, modelWorkspace, MODEL_WORKSPACE_SIZE, &displayedModel);
+							TRACE_END(parseSpan, "parseJ3DModel");
+							if (displayedModelValid)
+							{
+								printf("%u vertices, %u triangles, %u shapes, %u joints, %u materials, %u chunks skipped\n",
+									displayedModel.vertexCount,
+									displayedModel.indexCount / 3,
+									displayedModel.shapeCount,
+									displayedModel.jointCount,
+									displayedModel.materialCount,
+									displayedModel.skippedChunkCount
+								);
+
+								for (uint32_t node = 0; node < displayedModel.nodeCount; node++)
+								{
+									for (int32_t parent = displayedModel.nodeParents[node]; parent >= 0; parent = displayedModel.nodeParents[parent])
+										printf("\t");
+
+									uint16_t index = displayedModel.nodeIndices[node];
+									switch (displayedModel.nodeTypes[node])
+									{
+									case J3D_NODE_JOINT:
+										printf("joint %u (%s)\n", index, index < displayedModel.jointCount ? displayedModel.jointNames[index] : "?");
+										break;
+									case J3D_NODE_MATERIAL:
+										printf("material %u (%s)\n", index, index < displayedModel.materialCount ? displayedModel.materialNames[index] : "?");
+										break;
+									case J3D_NODE_SHAPE:
+										printf("shape %u\n", index);
+										break;
+									}
+								}
+
+								//the preview goes in front of the textures
+								struct decodedImage* preview = decodedAssetFreeZone;
+								size_t freeSpace = DECODED_ASSET_DATA_SIZE - ((char*)decodedAssetFreeZone - (char*)decodedAssetData);
+
+								double renderStart = getTimeSeconds();
+								TRACE_BEGIN(renderSpan);
+								bool rendered = decodedAssetCount < DECODED_ASSET_TABLE_SIZE && freeSpace > sizeof(struct decodedImage) &&
+									renderJ3DModel(&displayedModel, modelTextures, modelTextureCount, 512, 512, true, OffsetPointer(preview, sizeof(struct decodedImage)), freeSpace - sizeof(struct decodedImage), preview);
+								TRACE_END(renderSpan, "preview render");
+								if (rendered)
+								{
+									printf("preview rendered in %.3f ms\n", (getTimeSeconds() - renderStart) * 1000.0);
+									memmove(&decodedAssetTable[1], &decodedAssetTable[0], sizeof(struct decodedAsset) * decodedAssetCount);
+									decodedAssetTable[0].assetType = ASSET_TYPE_MODEL;
+									decodedAssetTable[0].assetPtr = preview;
+									decodedAssetCount++;
+								}
+
+								//the preview's pixels come first in the render workspace, the rest of it was scratch.
+								//without a preview nothing after its header was written
+								decodedAssetFreeZone = rendered ? OffsetPointer((void*)preview->pixels, (size_t)preview->pixelCount * 4) : (void*)preview;
+							}
+							else
+							{
+								printf("model doesn't fit in the model workspace\n");
+							}
+						}
+
+						//loose textures and message files in the archive are shown after the model
+						for (int i = 0; i < memberCount; i++)
+						{
+							struct btiTexture texture;
+							if (nameHasExtension(members[i].name, ".bti") && loadBTITexture(members[i].data, members[i].size, &texture))
+							{
+								printf("texture: %s (format 0x%X, %u x %u)\n", members[i].name, texture.format, texture.width, texture.height);
+								decodedAssetFreeZone = addTextureAsset(&texture, decodedAssetFreeZone);
+							}
+							else if (isBMGFile(members[i].data, members[i].size))
+							{
+								printf("messages: %s\n", members[i].name);
+								decodedAssetFreeZone = addMessageAsset(members[i].data, members[i].size, decodedAssetFreeZone);
+							}
+							else if (isJ3DAnimation(members[i].data, members[i].size))
+							{
+								//parsed in the free zone only to list it, nothing is kept
+								static const char* animationTypes[] = { "joint", "texture srt", "color" };
+								size_t freeSpace = DECODED_ASSET_DATA_SIZE - ((char*)decodedAssetFreeZone - (char*)decodedAssetData);
+								struct j3dAnimation animation;
+								if (parseJ3DAnimation(members[i].data, members[i].size, decodedAssetFreeZone, freeSpace, &animation))
+									printf("animation: %s (%s, %u frames, %u targets, loop mode %u)\n", members[i].name, animationTypes[animation.type], animation.frameCount, animation.targetCount, animation.loopMode);
+								else
+									printf("animation: %s (malformed)\n", members[i].name);
+							}
+							else if (isBLOFile(members[i].data, members[i].size))
+							{
+								//the layout itself isn't drawn, its textures are the archive's .bti files listed above
+								size_t freeSpace = DECODED_ASSET_DATA_SIZE - ((char*)decodedAssetFreeZone - (char*)decodedAssetData);
+								struct screenLayout layout;
+								if (parseBLO(members[i].data, members[i].size, decodedAssetFreeZone, freeSpace, &layout))
+								{
+									resolveScreenTextures(&layout, members, memberCount);
+									printf("screen: %s (%u x %u, %u panes, %u textures, %u bytes, %u missing)\n", members[i].name, layout.width, layout.height, layout.paneCount, layout.textureCount, layout.textureMemorySize, layout.missingTextureCount);
+								}
+								else
+									printf("screen: %s (malformed)\n", members[i].name);
+							}
+							else if (isJPCFile(members[i].data, members[i].size))
+							{
+								//the textures are shown, the arrays in the free zone are overwritten by them
+								size_t freeSpace = DECODED_ASSET_DATA_SIZE - ((char*)decodedAssetFreeZone - (char*)decodedAssetData);
+								struct jpcFile jpc;
+								if (parseJPC(members[i].data, members[i].size, decodedAssetFreeZone, freeSpace, &jpc))
+								{
+									printf("effects: %s (%u emitters, %u textures, %u texture slots)\n", members[i].name, jpc.emitterCount, jpc.textureCount, jpc.textureSlotCount);
+									struct btiTexture textures[256];
+									uint32_t textureCount = 0;
+									for (uint32_t t = 0; t < jpc.textureCount && textureCount < countof(textures); t++)
+										if (jpc.textures[t].texture.data != nullptr)
+											textures[textureCount++] = jpc.textures[t].texture;
+									for (uint32_t t = 0; t < textureCount; t++)
+										decodedAssetFreeZone = addTextureAsset(&textures[t], decodedAssetFreeZone);
+								}
+								else
+									printf("effects: %s (malformed)\n", members[i].name);
+							}
+						}
+					}
+					else if (wcscmp(extensionType, L".bti") == 0)
+					{
+						displayedFileType = 0;
+						decodedAssetCount = 0;
+
+						struct btiTexture texture;
+						if (loadBTITexture(gameFileList[selectedFileIndex].filePtr, gameFileList[selectedFileIndex].fileSize, &texture))
+						{
+							printf("texture format: 0x%X\n", texture.format);
+							printf("texture size: %u x %u\n", texture.width, texture.height);
+							addTextureAsset(&texture, decodedAssetData);
+						}
+						else
+						{
+							printf("not a bti texture, or one in an unknown format\n");
+						}
+					}
+					else if (wcscmp(extensionType, L".bmg") == 0)
+					{
+						displayedFileType = 0;
+						decodedAssetCount = 0;
+						if (addMessageAsset(gameFileList[selectedFileIndex].filePtr, gameFileList[selectedFileIndex].fileSize, decodedAssetData) == decodedAssetData)
+							printf("not a bmg file\n");
+					}
+					else if (wcscmp(extensionType, L".ast") == 0 || wcscmp(extensionType, L".dsp") == 0)
+					{
+						displayedFileType = 0;
+						decodedAssetCount = 0;
+						playAudioFile(selectedFileIndex);
+					}
+					else if (wcscmp(extensionType, L".baa") == 0 || wcscmp(extensionType, L".aaf") == 0)
+					{
+						displayedFileType = 0;
+						decodedAssetCount = 0;
+						listWaveBanks(gameFileList[selectedFileIndex].filePtr, gameFileList[selectedFileIndex].fileSize);
+					}
+					else if (wcscmp(extensionType, L".txt") == 0 || wcscmp(extensionType, L".ini") == 0)
+					{
+						displayedFileType = wcscmp(extensionType, L".txt") == 0 ? 1 : 2;
+
+						//the listing goes at the start of decodedAssetData, the parser works after it
+						const int listingSize = 1024 * 1024 * 4;
+						char* listing = decodedAssetData;
+						void* parserWorkspace = OffsetPointer(decodedAssetData, listingSize);
+
+						struct parsedTextFile parsedText;
+						decodedAssetCount = 1;
+						decodedAssetTable[0].assetType = ASSET_TYPE_TEXT;
+						if (parseTextFile(gameFileList[selectedFileIndex].filePtr, gameFileList[selectedFileIndex].fileSize, gameFileList[selectedFileIndex].fileName, parserWorkspace, DECODED_ASSET_DATA_SIZE - listingSize, &parsedText))
+						{
+							formatParsedTextFile(&parsedText, listing, listingSize);
+							decodedAssetTable[0].assetPtr = listing;
+						}
+						else
+						{
+							decodedAssetTable[0].assetPtr = gameFileList[selectedFileIndex].filePtr;
+						}
+					}
+					else
+					{
+						displayedFileType = 0;
+					}
+					break;
+				}
+			}
+
+			//a directory shows the textures of every file under it
+			if (directory)
+			{
+				int* files = malloc(max(gameFileCount, 1) * sizeof(int));
+				uint32_t fileCount = collectTreeFiles(hTreeView, hSelected, files, gameFileCount, 0);
+				printf("texture gallery of %u files\n", fileCount);
+				openTextureGallery(hFileView, files, fileCount);
+				free(files);
+			}
+			TRACE_END(selectionSpan, "file selection");
+
+			TRACE_BEGIN(paintSpan);
+			InvalidateRect(hFileView, nullptr, TRUE);
+			UpdateWindow(hFileView);
+			TRACE_END(paintSpan, "file view paint");
+		}
+		else if (lpnmh->code == TVN_KEYDOWN && ((LPNMTVKEYDOWN)lParam)->wVKey == 'G')
+		{
+			//G shows the textures of the selected file (an archive or a model) as a gallery instead
+			HTREEITEM hSelected = (HTREEITEM)SendMessageW(lpnmh->hwndFrom, TVM_GETNEXTITEM, TVGN_CARET, 0);
+			for (int i = 0; i < gameFileCount; i++)
+			{
+				if (gameFileList[i].treeItem == hSelected)
+				{
+					openTextureGallery(hFileView, &i, 1);
+					InvalidateRect(hFileView, nullptr, TRUE);
+					break;
+				}
+			}
+			//not part of the tree's incremental search
+			return TRUE;
+		}
+		break;
+	}
+	case WM_DESTROY:
+		PostQuitMessage(0);
+		break;
+	default:
+		return DefWindowProc(hwnd, msg, wParam, lParam);
+	}
+	return 0;
+}
+
+
+/*
+* disc search
+* files are scanned with an sse2 first/last byte filter, yaz0 files are searched after decompression.
+* an optional trigram bloom filter per file (<image>.ngram) skips files that can't contain the pattern.
+*/
+
+typedef void (*patternMatchCallback)(size_t offset, void* context);
+
+//calls onMatch for every occurrence of pattern in data, returns the number of matches
+uint32_t findPattern(const uint8_t* _In_reads_(size) data, size_t size, const uint8_t* _In_reads_(patternLength) pattern, size_t patternLength, patternMatchCallback onMatch, void* context)
+{
+	if (patternLength == 0 || patternLength > size)
+		return 0;
+
+	uint32_t matchCount = 0;
+	const size_t lastStart = size - patternLength;
+	size_t i = 0;
+
+	if (patternLength > 1)
+	{
+		//compare the first and last pattern byte at 16 positions at once, only candidates get a memcmp
+		const __m128i first = _mm_set1_epi8(pattern[0]);
+		const __m128i last = _mm_set1_epi8(pattern[patternLength - 1]);
+
+		for (; i + 16 <= lastStart + 1; i += 16)
+		{
+			const __m128i blockFirst = _mm_loadu_si128((const __m128i*)(data + i));
+			const __m128i blockLast = _mm_loadu_si128((const __m128i*)(data + i + patternLength - 1));
+			unsigned long mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast)));
+
+			while (mask)
+			{
+				unsigned long bit;
+				_BitScanForward(&bit, mask);
+				if (memcmp(data + i + bit + 1, pattern + 1, patternLength - 2) == 0)
+				{
+					matchCount++;
+					if (onMatch)
+						onMatch(i + bit, context);
+				}
+				mask &= mask - 1;
+			}
+		}
+	}
+	else
+	{
+		const __m128i first = _mm_set1_epi8(pattern[0]);
+		for (; i + 16 <= lastStart + 1; i += 16)
+		{
+			unsigned long mask = _mm_movemask_epi8(_mm_cmpeq_epi8(first, _mm_loadu_si128((const __m128i*)(data + i))));
+			while (mask)
+			{
+				unsigned long bit;
+				_BitScanForward(&bit, mask);
+				matchCount++;
+				if (onMatch)
+					onMatch(i + bit, context);
+				mask &= mask - 1;
+			}
+		}
+	}
+
+	for (; i <= lastStart; i++)
+	{
+		if (data[i] == pattern[0] && memcmp(data + i, pattern, patternLength) == 0)
+		{
+			matchCount++;
+			if (onMatch)
+				onMatch(i, context);
+		}
+	}
+
+	return matchCount;
+}
+
+#define NGRAM_INDEX_BITS_PER_FILE (1024 * 32)
+
+struct ngramIndexHeader
+{
+	char magic[4];
+	uint32_t fileCount;
+	uint32_t bitsPerFile;
+	uint32_t padding;
+	uint64_t imageSize;
+};
+
+static inline uint32_t hashTrigram(const uint8_t* bytes)
+{
+	return ((bytes[0] | (bytes[1] << 8) | (bytes[2] << 16)) * 2654435761u) >> 17;
+}
+
+void addTrigramsToFilter(const uint8_t* _In_reads_(size) data, size_t size, uint8_t* filter)
+{
+	for (size_t i = 0; i + 3 <= size; i++)
+	{
+		uint32_t bit = hashTrigram(data + i);
+		filter[bit >> 3] |= 1 << (bit & 7);
+	}
+}
+
+bool filterMayContain(const uint8_t* filter, const uint8_t* _In_reads_(patternLength) pattern, size_t patternLength)
+{
+	for (size_t i = 0; i + 3 <= patternLength; i++)
+	{
+		uint32_t bit = hashTrigram(pattern + i);
+		if ((filter[bit >> 3] & (1 << (bit & 7))) == 0)
+			return false;
+	}
+	return true;
+}
+
+struct searchContext
+{
+	const uint8_t* pattern;
+	size_t patternLength;
+
+	const uint8_t* ngramFilters;//nullptr when there's no index
+	uint8_t* threadBuffers[MAX_THREADS];
+
+	CRITICAL_SECTION outputLock;
+	volatile LONG64 matchCount;
+	volatile LONG64 bytesScanned;
+	volatile LONG filesScanned;
+};
+
+struct searchFileMatchContext
+{
+	struct searchContext* search;
+	int fileIndex;
+	bool decompressed;
+	uint32_t reported;
+};
+
+static void reportSearchMatch(size_t offset, void* context)
+{
+	struct searchFileMatchContext* fileContext = context;
+
+	//only the first few matches per file are printed, the rest are counted
+	if (fileContext->reported++ >= 16)
+		return;
+
+	char path[256];
+	getGameFilePath(fileContext->fileIndex, path, sizeof(path));
+
+	EnterCriticalSection(&fileContext->search->outputLock);
+	printf("%s%s: 0x%zX\n", path, fileContext->decompressed ? " (yaz0)" : "", offset);
+	LeaveCriticalSection(&fileContext->search->outputLock);
+}
+
+//returns a pointer to the searchable bytes of a file, decompressing yaz0 files into buffer. nullptr if that fails
+static const uint8_t* getSearchableFileData(int fileIndex, uint8_t* buffer, uint32_t* _Out_ size, bool* _Out_ decompressed)
+{
+	const struct gameFileInTree* gameFile = &gameFileList[fileIndex];
+	if (isYaz0(gameFile->filePtr, gameFile->fileSize))
+	{
+		*decompressed = true;
+		if (decompressYaz0File(gameFile->filePtr, gameFile->fileSize, buffer) != 0)
+		{
+			*size = 0;
+			return nullptr;
+		}
+		*size = getYaz0UncompressedSize(gameFile->filePtr);
+		return buffer;
+	}
+
+	*size = gameFile->fileSize;
+	*decompressed = false;
+	return gameFile->filePtr;
+}
+
+static void searchFileJob(int fileIndex, int threadIndex, void* context)
+{
+	struct searchContext* search = context;
+
+	if (search->ngramFilters && !filterMayContain(search->ngramFilters + (size_t)fileIndex * (NGRAM_INDEX_BITS_PER_FILE / 8), search->pattern, search->patternLength))
+		return;
+
+	struct searchFileMatchContext fileContext = { search, fileIndex, false, 0 };
+	uint32_t size;
+	const uint8_t* data = getSearchableFileData(fileIndex, search->threadBuffers[threadIndex], &size, &fileContext.decompressed);
+	if (data == nullptr)
+		return;
+
+	uint32_t matches = findPattern(data, size, search->pattern, search->patternLength, reportSearchMatch, &fileContext);
+
+	if (matches > 16)
+	{
+		char path[256];
+		getGameFilePath(fileIndex, path, sizeof(path));
+		EnterCriticalSection(&search->outputLock);
+		printf("%s: %u more matches\n", path, matches - 16);
+		LeaveCriticalSection(&search->outputLock);
+	}
+
+	InterlockedExchangeAdd64(&search->matchCount, matches);
+	InterlockedExchangeAdd64(&search->bytesScanned, size);
+	InterlockedIncrement(&search->filesScanned);
+}
+
+static void buildNgramFilterJob(int fileIndex, int threadIndex, void* context)
+{
+	struct searchContext* search = context;
+
+	uint32_t size;
+	bool decompressed;
+	const uint8_t* data = getSearchableFileData(fileIndex, search->threadBuffers[threadIndex], &size, &decompressed);
+	if (data == nullptr)
+		return;
+
+	addTrigramsToFilter(data, size, (uint8_t*)search->ngramFilters + (size_t)fileIndex * (NGRAM_INDEX_BITS_PER_FILE / 8));
+}
+
+//allocates one decompression buffer per thread, large enough for the biggest yaz0 file. freeSearchBuffers cleans up after a failure
+static bool allocateSearchBuffers(struct searchContext* search)
+{
+	uint32_t largestFile = 0;
+	for (int i = 0; i < gameFileCount; i++)
+		if (isYaz0(gameFileList[i].filePtr, gameFileList[i].fileSize))
+			largestFile = max(largestFile, getYaz0UncompressedSize(gameFileList[i].filePtr));
+
+	int threadCount = getThreadCount();
+	for (int i = 0; i < threadCount; i++)
+	{
+		search->threadBuffers[i] = malloc(max(largestFile, 1));
+		if (search->threadBuffers[i] == nullptr)
+		{
+			printf("not enough memory for %i buffers of %u bytes\n", threadCount, largestFile);
+			return false;
+		}
+	}
+	return true;
+}
+
+static void freeSearchBuffers(struct searchContext* search)
+{
+	for (int i = 0; i < MAX_THREADS; i++)
+		free(search->threadBuffers[i]);
+}
+
+static void getNgramIndexPath(char* buffer, int bufferSize)
+{
+	_snprintf_s(buffer, bufferSize, _TRUNCATE, "%s.ngram", GameImagePath);
+}
+
+//returns nullptr if there is no index for this image
+static uint8_t* loadNgramIndex()
+{
+	char indexPath[MAX_PATH];
+	getNgramIndexPath(indexPath, sizeof(indexPath));
+
+	HANDLE file = CreateFileA(indexPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	struct ngramIndexHeader header;
+	DWORD bytesRead = 0;
+	uint8_t* filters = nullptr;
+	if (ReadFile(file, &header, sizeof(header), &bytesRead, nullptr) && bytesRead == sizeof(header) &&
+		memcmp(header.magic, "NGRM", 4) == 0 &&
+		header.fileCount == gameFileCount &&
+		header.bitsPerFile == NGRAM_INDEX_BITS_PER_FILE &&
+		header.imageSize == GameImageSize)
+	{
+		size_t filterSize = (size_t)gameFileCount * (NGRAM_INDEX_BITS_PER_FILE / 8);
+		filters = malloc(filterSize);
+		if (!ReadFile(file, filters, (DWORD)filterSize, &bytesRead, nullptr) || bytesRead != filterSize)
+		{
+			free(filters);
+			filters = nullptr;
+		}
+	}
+
+	CloseHandle(file);
+	return filters;
+}
+
+int runBuildNgramIndex()
+{
+	double start = getTimeSeconds();
+
+	struct searchContext search = { 0 };
+	size_t filterSize = (size_t)gameFileCount * (NGRAM_INDEX_BITS_PER_FILE / 8);
+	search.ngramFilters = calloc(1, filterSize);
+	if (search.ngramFilters == nullptr || !allocateSearchBuffers(&search))
+	{
+		freeSearchBuffers(&search);
+		free((void*)search.ngramFilters);
+		return -1;
+	}
+
+	runParallel(gameFileCount, buildNgramFilterJob, &search);
+
+	char indexPath[MAX_PATH];
+	getNgramIndexPath(indexPath, sizeof(indexPath));
+
+	HANDLE file = CreateFileA(indexPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	VALIDATE_HANDLE(file);
+
+	struct ngramIndexHeader header = { { 'N', 'G', 'R', 'M' }, gameFileCount, NGRAM_INDEX_BITS_PER_FILE, 0, GameImageSize };
+	THROW_ON_FALSE(writeFileData(file, &header, sizeof(header)));
+	THROW_ON_FALSE(writeFileData(file, search.ngramFilters, filterSize));
+	CloseHandle(file);
+
+	printf("wrote %s (%zu bytes) in %.3f s\n", indexPath, filterSize + sizeof(header), getTimeSeconds() - start);
+
+	freeSearchBuffers(&search);
+	free((void*)search.ngramFilters);
+	return 0;
+}
+
+//"de ad be ef" or "deadbeef", returns the number of bytes, or -1 if the string isn't hex
+int parseHexPattern(const char* hex, uint8_t* _Out_ bytes, int maxBytes)
+{
+	int byteCount = 0;
+	int nibbleCount = 0;
+	for (; *hex; hex++)
+	{
+		int nibble;
+		if (*hex >= '0' && *hex <= '9')
+			nibble = *hex - '0';
+		else if (*hex >= 'a' && *hex <= 'f')
+			nibble = *hex - 'a' + 10;
+		else if (*hex >= 'A' && *hex <= 'F')
+			nibble = *hex - 'A' + 10;
+		else if (*hex == ' ')
+			continue;
+		else
+			return -1;
+
+		if (byteCount == maxBytes)
+			return -1;
+
+		if (nibbleCount++ & 1)
+			bytes[byteCount++] |= nibble;
+		else
+			bytes[byteCount] = nibble << 4;
+	}
+	return (nibbleCount & 1) ? -1 : byteCount;
+}
+
+int runSearch(const uint8_t* _In_reads_(patternLength) pattern, size_t patternLength)
+{
+	double start = getTimeSeconds();
+
+	struct searchContext search = { 0 };
+	search.pattern = pattern;
+	search.patternLength = patternLength;
+	search.ngramFilters = loadNgramIndex();
+	if (!allocateSearchBuffers(&search))
+	{
+		freeSearchBuffers(&search);
+		free((void*)search.ngramFilters);
+		return -1;
+	}
+	InitializeCriticalSection(&search.outputLock);
+
+	if (search.ngramFilters)
+		printf("using n-gram index\n");
+
+	runParallel(gameFileCount, searchFileJob, &search);
+
+	double elapsed = getTimeSeconds() - start;
+	printf("%lld matches, %i files scanned (%lld bytes) in %.3f s\n", search.matchCount, search.filesScanned, search.bytesScanned, elapsed);
+
+	freeSearchBuffers(&search);
+	free((void*)search.ngramFilters);
+	DeleteCriticalSection(&search.outputLock);
+	return search.matchCount ? 0 : 1;
+}
+
+/*
+* duplicate detection
+* every FST file, every member of a (decompressed) archive and every TEX1 image gets a content hash
+*/
+const uint8_t CONTENT_FILE = 0;
+const uint8_t CONTENT_ARCHIVE_MEMBER = 1;
+const uint8_t CONTENT_TEXTURE = 2;
+
+struct contentHashEntry
+{
+	uint64_t hash;
+	uint32_t size;
+	uint32_t fileIndex;
+	uint32_t nameOffset;//into the string pool of the thread that hashed it
+	uint16_t textureIndex;
+	uint8_t kind;
+	uint8_t threadIndex;
+};
+
+struct contentHashList
+{
+	struct contentHashEntry* entries;
+	uint32_t count;
+	uint32_t capacity;
+
+	char* names;
+	uint32_t namesSize;
+	uint32_t namesCapacity;
+
+	uint8_t* decompressionBuffer;
+};
+
+struct dedupContext
+{
+	struct contentHashList threadLists[MAX_THREADS];
+};
+
+//an entry that doesn't fit in memory is left out
+static void addContentHash(struct contentHashList* list, int threadIndex, uint8_t kind, uint64_t hash, uint32_t size, int fileIndex, const char* name, int textureIndex)
+{
+	if (list->count == list->capacity)
+	{
+		uint32_t capacity = max(list->capacity * 2, 1024);
+		struct contentHashEntry* entries = realloc(list->entries, capacity * sizeof(struct contentHashEntry));
+		if (entries == nullptr)
+			return;
+		list->entries = entries;
+		list->capacity = capacity;
+	}
+
+	uint32_t nameLength = name ? (uint32_t)strlen(name) + 1 : 1;
+	if (list->namesSize + nameLength > list->namesCapacity)
+	{
+		uint32_t namesCapacity = max(list->namesCapacity * 2, list->namesSize + nameLength + 4096);
+		char* names = realloc(list->names, namesCapacity);
+		if (names == nullptr)
+			return;
+		list->names = names;
+		list->namesCapacity = namesCapacity;
+	}
+	memcpy(list->names + list->namesSize, name ? name : "", nameLength);
+
+	struct contentHashEntry* entry = &list->entries[list->count++];
+	entry->hash = hash;
+	entry->size = size;
+	entry->fileIndex = fileIndex;
+	entry->nameOffset = list->namesSize;
+	entry->textureIndex = (uint16_t)textureIndex;
+	entry->kind = kind;
+	entry->threadIndex = (uint8_t)threadIndex;
+
+	list->namesSize += nameLength;
+}
+
+static void hashModelTextures(struct contentHashList* list, int threadIndex, int fileIndex, const struct archiveMember* member)
+{
+	const struct TEX1* textures = (const struct TEX1*)findJ3DChunk(member->data, member->size, "TEX1");
+	if (textures == nullptr)
+		return;
+
+	for (int texNum = 0; texNum < SwapEndian(textures->textureCount); texNum++)
+	{
+		struct btiTexture texture;
+		if (!loadTEX1Texture(textures, texNum, &texture))
+			continue;
+
+		addContentHash(list, threadIndex, CONTENT_TEXTURE, hashTexture(&texture), texture.dataSize, fileIndex, member->name, texNum);
+	}
+}
+
+static void hashFileContentsJob(int fileIndex, int threadIndex, void* context)
+{
+	struct dedupContext* dedup = context;
+	struct contentHashList* list = &dedup->threadLists[threadIndex];
+	const struct gameFileInTree* gameFile = &gameFileList[fileIndex];
+
+	addContentHash(list, threadIndex, CONTENT_FILE, hashBytes(gameFile->filePtr, gameFile->fileSize, 0), gameFile->fileSize, fileIndex, nullptr, 0);
+
+	//standalone textures are hashed like the TEX1 ones, so a .bti that was also baked into a model shows up as a duplicate
+	struct btiTexture texture;
+	if (gameFileHasExtension(fileIndex, ".bti") && loadBTITexture(gameFile->filePtr, gameFile->fileSize, &texture))
+		addContentHash(list, threadIndex, CONTENT_TEXTURE, hashTexture(&texture), texture.dataSize, fileIndex, nullptr, 0);
+
+	const void* archive = gameFile->filePtr;
+	uint32_t archiveSize = gameFile->fileSize;
+	if (isYaz0(gameFile->filePtr, gameFile->fileSize))
+	{
+		archiveSize = getYaz0UncompressedSize(gameFile->filePtr);
+		uint8_t* buffer = trackedRealloc(MEMORY_YAZ0, list->decompressionBuffer, max(archiveSize, 1));
+		if (buffer == nullptr)
+			return;
+		list->decompressionBuffer = buffer;
+		if (decompressYaz0File(gameFile->filePtr, gameFile->fileSize, list->decompressionBuffer) != 0)
+			return;
+		archive = list->decompressionBuffer;
+	}
+
+	struct archiveMember members[1024];
+	int memberCount = listRarcMembers(archive, archiveSize, members, countof(members));
+	for (int i = 0; i < memberCount; i++)
+	{
+		addContentHash(list, threadIndex, CONTENT_ARCHIVE_MEMBER, hashBytes(members[i].data, members[i].size, 0), members[i].size, fileIndex, members[i].name, 0);
+
+		if (isJ3DModel(members[i].data, members[i].size))
+			hashModelTextures(list, threadIndex, fileIndex, &members[i]);
+		else if (nameHasExtension(members[i].name, ".bti") && loadBTITexture(members[i].data, members[i].size, &texture))
+			addContentHash(list, threadIndex, CONTENT_TEXTURE, hashTexture(&texture), texture.dataSize, fileIndex, members[i].name, 0);
+	}
+}
+
+static int compareContentHashes(const void* a, const void* b)
+{
+	const struct contentHashEntry* entryA = a;
+	const struct contentHashEntry* entryB = b;
+	if (entryA->kind != entryB->kind)
+		return entryA->kind < entryB->kind ? -1 : 1;
+	if (entryA->hash != entryB->hash)
+		return entryA->hash < entryB->hash ? -1 : 1;
+	if (entryA->size != entryB->size)
+		return entryA->size < entryB->size ? -1 : 1;
+	return 0;
+}
+
+struct duplicateGroup
+{
+	uint32_t firstEntry;
+	uint32_t entryCount;
+	uint64_t wastedBytes;
+};
+
+static int compareDuplicateGroups(const void* a, const void* b)
+{
+	const struct duplicateGroup* groupA = a;
+	const struct duplicateGroup* groupB = b;
+	return groupA->wastedBytes < groupB->wastedBytes ? 1 : groupA->wastedBytes > groupB->wastedBytes ? -1 : 0;
+}
+
+static void printContentHashEntry(const struct dedupContext* dedup, const struct contentHashEntry* entry)
+{
+	char path[256];
+	getGameFilePath(entry->fileIndex, path, sizeof(path));
+	const char* name = dedup->threadLists[entry->threadIndex].names + entry->nameOffset;
+
+	if (entry->kind == CONTENT_FILE)
+		printf("\t%s\n", path);
+	else if (entry->kind == CONTENT_ARCHIVE_MEMBER)
+		printf("\t%s:%s\n", path, name);
+	else if (name[0] == 0)
+		printf("\t%s\n", path);
+	else
+		printf("\t%s:%s texture %u\n", path, name, entry->textureIndex);
+}
+
+//maxGroups: how many duplicate groups per kind are listed in full
+int runDuplicateReport(int maxGroups)
+{
+	double start = getTimeSeconds();
+
+	struct dedupContext* dedup = calloc(1, sizeof(struct dedupContext));
+	runParallel(gameFileCount, hashFileContentsJob, dedup);
+
+	double hashTime = getTimeSeconds() - start;
+
+	uint32_t totalCount = 0;
+	for (int i = 0; i < MAX_THREADS; i++)
+		totalCount += dedup->threadLists[i].count;
+
+	struct contentHashEntry* entries = malloc(max(totalCount, 1) * sizeof(struct contentHashEntry));
+	uint32_t entryCount = 0;
+	uint64_t hashedBytes = 0;
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		//threads that never ran have no list
+		if (dedup->threadLists[i].count == 0)
+			continue;
+		memcpy(entries + entryCount, dedup->threadLists[i].entries, dedup->threadLists[i].count * sizeof(struct contentHashEntry));
+		entryCount += dedup->threadLists[i].count;
+	}
+	for (uint32_t i = 0; i < entryCount; i++)
+		hashedBytes += entries[i].size;
+
+	qsort(entries, entryCount, sizeof(struct contentHashEntry), compareContentHashes);
+
+	struct duplicateGroup* groups = malloc(max(entryCount, 1) * sizeof(struct duplicateGroup));
+
+	const char* kindNames[] = { "files", "archive members", "textures" };
+	for (uint8_t kind = CONTENT_FILE; kind <= CONTENT_TEXTURE; kind++)
+	{
+		uint32_t groupCount = 0;
+		uint32_t kindCount = 0;
+		uint32_t uniqueCount = 0;
+		uint64_t wastedBytes = 0;
+
+		for (uint32_t i = 0; i < entryCount;)
+		{
+			uint32_t j = i + 1;
+			while (j < entryCount && compareContentHashes(&entries[i], &entries[j]) == 0)
+				j++;
+
+			if (entries[i].kind == kind)
+			{
+				kindCount += j - i;
+				uniqueCount++;
+				if (j - i > 1)
+				{
+					groups[groupCount].firstEntry = i;
+					groups[groupCount].entryCount = j - i;
+					groups[groupCount].wastedBytes = (uint64_t)entries[i].size * (j - i - 1);
+					wastedBytes += groups[groupCount].wastedBytes;
+					groupCount++;
+				}
+			}
+			i = j;
+		}
+
+		qsort(groups, groupCount, sizeof(struct duplicateGroup), compareDuplicateGroups);
+
+		printf("%s: %u total, %u unique, %u duplicated blobs, %llu bytes in copies\n", kindNames[kind], kindCount, uniqueCount, groupCount, wastedBytes);
+		for (uint32_t g = 0; g < groupCount && g < (uint32_t)maxGroups; g++)
+		{
+			printf("  %016llX: %u copies of %u bytes\n", entries[groups[g].firstEntry].hash, groups[g].entryCount, entries[groups[g].firstEntry].size);
+			for (uint32_t e = 0; e < groups[g].entryCount; e++)
+				printContentHashEntry(dedup, &entries[groups[g].firstEntry + e]);
+		}
+	}
+
+	printf("hashed %u blobs (%llu bytes) in %.3f s\n", entryCount, hashedBytes, hashTime);
+
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		free(dedup->threadLists[i].entries);
+		free(dedup->threadLists[i].names);
+		trackedFree(dedup->threadLists[i].decompressionBuffer);
+	}
+	free(dedup);
+	free(entries);
+	free(groups);
+	return 0;
+}
+
+/*
+* yaz0 stream analysis
+* walks the operations of every .szs without writing the output: match lengths and distances, literal runs and the
+* compression ratio per file. each file is also decoded (timed) and recompressed with encodeYaz0, the difference is what
+* recompressing would save, and files that barely compress show where storing them uncompressed would skip the decode
+*/
+#define YAZ0_LENGTH_BUCKETS 9//log2(length - 2), lengths are 3 to 0x111
+#define YAZ0_DISTANCE_BUCKETS 13//log2(distance), distances are 1 to 4096
+#define YAZ0_RUN_BUCKETS 12//log2(literal run), the last bucket holds everything longer
+#define YAZ0_POOR_RATIO 0.9//compressed to more than this of the uncompressed size
+
+struct yaz0Stats
+{
+	uint64_t compressedSize;//including the header
+	uint64_t uncompressedSize;
+	uint64_t recompressedSize;
+	uint64_t groupBytes;
+	uint64_t literals;
+	uint64_t matches;
+	uint64_t longMatches;//the 3 byte form, lengths 0x12 and up
+	uint64_t matchedBytes;
+	uint64_t lengths[YAZ0_LENGTH_BUCKETS];
+	uint64_t distances[YAZ0_DISTANCE_BUCKETS];
+	uint64_t literalRuns[YAZ0_RUN_BUCKETS];
+	double decodeTime;
+	uint32_t fileCount;
+	int fileIndex;
+	int status;//of the walk, like DecompressYAZ
+};
+
+struct yaz0AnalysisThread
+{
+	uint8_t* decompressionBuffer;
+	uint8_t* compressionBuffer;
+	uint32_t* hashTable;
+	uint32_t* chain;
+};
+
+struct yaz0Analysis
+{
+	struct yaz0Stats* files;//per game file, fileCount 0 if it isn't a yaz0 .szs
+	struct yaz0AnalysisThread threads[MAX_THREADS];
+};
+
+static inline uint32_t getLog2Bucket(uint32_t value, uint32_t bucketCount)
+{
+	uint32_t bucket = 0;
+	while (value >>= 1)
+		bucket++;
+	return min(bucket, bucketCount - 1);
+}
+
+static void addLiteralRun(struct yaz0Stats* stats, uint32_t run)
+{
+	if (run != 0)
+		stats->literalRuns[getLog2Bucket(run, YAZ0_RUN_BUCKETS)]++;
+}
+
+//the same checks as DecompressYAZ, but only the output position is tracked. returns 0, -1 (longer than the header says) or -2
+int analyzeYaz0Stream(const void* data, uint32_t size, struct yaz0Stats* stats)
+{
+	const uint8_t* src = OffsetPointer(data, sizeof(struct yaz0Header));
+	const uint8_t* srcEnd = OffsetPointer(data, size);
+	uint32_t outputSize = getYaz0UncompressedSize(data);
+	uint32_t position = 0;
+	uint32_t run = 0;
+	uint8_t code = 0;
+	int codeLength = 0;
+	int status = 0;
+
+	stats->compressedSize += size;
+	stats->uncompressedSize += outputSize;
+	while (src < srcEnd && position < outputSize)
+	{
+		if (!codeLength--)
+		{
+			code = *src++;
+			codeLength = 7;
+			stats->groupBytes++;
+			if (src == srcEnd)
+				break;
+		}
+
+		if (code & 0x80)
+		{
+			src++;
+			position++;
+			run++;
+			stats->literals++;
+		}
+		else
+		{
+			if (srcEnd - src < 2 || (!(src[0] >> 4) && srcEnd - src < 3))
+			{
+				status = -2;
+				break;
+			}
+			uint32_t distance = ((src[0] & 0x0f) << 8 | src[1]) + 1;
+			uint32_t length = src[0] >> 4;
+			if (length == 0)
+			{
+				length = src[2] + 0x12;
+				stats->longMatches++;
+				src += 3;
+			}
+			else
+			{
+				length += 2;
+				src += 2;
+			}
+			if (distance > position)
+			{
+				status = -2;
+				break;
+			}
+
+			addLiteralRun(stats, run);
+			run = 0;
+			stats->matches++;
+			stats->matchedBytes += length;
+			stats->lengths[getLog2Bucket(length - 2, YAZ0_LENGTH_BUCKETS)]++;
+			stats->distances[getLog2Bucket(distance, YAZ0_DISTANCE_BUCKETS)]++;
+			position += length;
+			if (position > outputSize)
+			{
+				status = -1;
+				break;
+			}
+		}
+		code <<= 1;
+	}
+	addLiteralRun(stats, run);
+	return status;
+}
+
+static void analyzeYaz0FileJob(int fileIndex, int threadIndex, void* context)
+{
+	struct yaz0Analysis* analysis = context;
+	struct yaz0AnalysisThread* thread = &analysis->threads[threadIndex];
+	const struct gameFileInTree* gameFile = &gameFileList[fileIndex];
+	if (!gameFileHasExtension(fileIndex, ".szs") || !isYaz0(gameFile->filePtr, gameFile->fileSize))
+		return;
+
+	struct yaz0Stats* stats = &analysis->files[fileIndex];
+	stats->fileCount = 1;
+	stats->fileIndex = fileIndex;
+	stats->status = analyzeYaz0Stream(gameFile->filePtr, gameFile->fileSize, stats);
+
+	//buffers only grow, realloc(nullptr) allocates the first one
+	uint32_t size = getYaz0UncompressedSize(gameFile->filePtr);
+	uint8_t* buffer = trackedRealloc(MEMORY_YAZ0, thread->decompressionBuffer, max(size, 1));
+	if (buffer == nullptr)
+		return;
+	thread->decompressionBuffer = buffer;
+	//without the compression buffers the file is only decoded, recompressedSize stays 0 and it isn't listed
+	uint8_t* compressionBuffer = realloc(thread->compressionBuffer, getYaz0Bound(size));
+	if (compressionBuffer != nullptr)
+		thread->compressionBuffer = compressionBuffer;
+	if (thread->hashTable == nullptr)
+		thread->hashTable = malloc(sizeof(uint32_t) << YAZ0_HASH_BITS);
+	if (thread->chain == nullptr)
+		thread->chain = malloc(sizeof(uint32_t) * YAZ0_WINDOW_SIZE);
+	bool recompress = compressionBuffer != nullptr && thread->hashTable != nullptr && thread->chain != nullptr;
+
+	double start = getTimeSeconds();
+	int decodeStatus = decompressYaz0File(gameFile->filePtr, gameFile->fileSize, thread->decompressionBuffer);
+	stats->decodeTime = getTimeSeconds() - start;
+	if (stats->status == 0 && decodeStatus == 0 && recompress)
+		stats->recompressedSize = encodeYaz0(thread->decompressionBuffer, size, thread->hashTable, thread->chain, thread->compressionBuffer);
+}
+
+static void addYaz0Stats(struct yaz0Stats* total, const struct yaz0Stats* stats)
+{
+	uint64_t* totalCounters = &total->compressedSize;
+	const uint64_t* counters = &stats->compressedSize;
+	for (size_t i = 0; i < offsetof(struct yaz0Stats, decodeTime) / sizeof(uint64_t); i++)
+		totalCounters[i] += counters[i];
+	total->decodeTime += stats->decodeTime;
+	total->fileCount += stats->fileCount;
+}
+
+//lowOffset is added to 1 << bucket for the printed ranges, the last bucket is open ended
+static void printYaz0Histogram(const char* title, const uint64_t* counts, uint32_t bucketCount, uint32_t lowOffset, uint32_t maxValue)
+{
+	uint64_t total = 0;
+	for (uint32_t b = 0; b < bucketCount; b++)
+		total += counts[b];
+	printf("%s:\n", title);
+	for (uint32_t b = 0; b < bucketCount; b++)
+	{
+		uint32_t low = (1u << b) + lowOffset;
+		uint32_t high = b + 1 < bucketCount ? (2u << b) - 1 + lowOffset : maxValue;
+		char range[32];
+		if (high == 0)
+			_snprintf_s(range, sizeof(range), _TRUNCATE, "%u+", low);
+		else if (low == high)
+			_snprintf_s(range, sizeof(range), _TRUNCATE, "%u", low);
+		else
+			_snprintf_s(range, sizeof(range), _TRUNCATE, "%u-%u", low, high);
+		printf("\t%-10s %12llu %6.2f%%\n", range, counts[b], total != 0 ? counts[b] * 100.0 / total : 0.0);
+	}
+}
+
+static int compareRecompressionSavings(const void* a, const void* b)
+{
+	int64_t savingsA = (int64_t)((const struct yaz0Stats*)a)->compressedSize - (int64_t)((const struct yaz0Stats*)a)->recompressedSize;
+	int64_t savingsB = (int64_t)((const struct yaz0Stats*)b)->compressedSize - (int64_t)((const struct yaz0Stats*)b)->recompressedSize;
+	return savingsA < savingsB ? 1 : savingsA > savingsB ? -1 : 0;
+}
+
+//maxFiles: how many files are listed, the ones recompression saves the most on first
+int runYaz0Analysis(int maxFiles)
+{
+	double start = getTimeSeconds();
+	struct yaz0Analysis* analysis = calloc(1, sizeof(struct yaz0Analysis));
+	analysis->files = calloc(max(gameFileCount, 1), sizeof(struct yaz0Stats));
+	runParallel(gameFileCount, analyzeYaz0FileJob, analysis);
+	double wallTime = getTimeSeconds() - start;
+
+	struct yaz0Stats total = { 0 };
+	struct yaz0Stats poor = { 0 };
+	struct yaz0Stats* sorted = malloc(max(gameFileCount, 1) * sizeof(struct yaz0Stats));
+	uint32_t sortedCount = 0;
+	uint32_t failedCount = 0;
+	for (int f = 0; f < gameFileCount; f++)
+	{
+		const struct yaz0Stats* stats = &analysis->files[f];
+		if (stats->fileCount == 0)
+			continue;
+		addYaz0Stats(&total, stats);
+		if (stats->status != 0 || stats->recompressedSize == 0)
+		{
+			failedCount++;
+			continue;
+		}
+		if (stats->compressedSize > stats->uncompressedSize * YAZ0_POOR_RATIO)
+			addYaz0Stats(&poor, stats);
+		sorted[sortedCount++] = *stats;
+	}
+	qsort(sorted, sortedCount, sizeof(struct yaz0Stats), compareRecompressionSavings);
+
+	printf("%-48s %10s %10s %6s %9s %10s %9s\n", "file", "stored", "size", "ratio", "decode", "recompress", "saves");
+	for (uint32_t i = 0; i < sortedCount && i < (uint32_t)maxFiles; i++)
+	{
+		const struct yaz0Stats* stats = &sorted[i];
+		char path[256];
+		getGameFilePath(stats->fileIndex, path, sizeof(path));
+		printf("%-48s %10llu %10llu %6.3f %6.0fMB/s %10llu %9lld\n", path, stats->compressedSize, stats->uncompressedSize,
+			(double)stats->compressedSize / max(stats->uncompressedSize, 1), stats->uncompressedSize / max(stats->decodeTime, 1e-9) / 1e6,
+			stats->recompressedSize, (int64_t)stats->compressedSize - (int64_t)stats->recompressedSize);
+	}
+
+	uint64_t recompressedTotal = 0;
+	uint64_t recompressedStored = 0;
+	for (uint32_t i = 0; i < sortedCount; i++)
+	{
+		recompressedTotal += sorted[i].recompressedSize;
+		recompressedStored += sorted[i].compressedSize;
+	}
+
+	printf("\nszs files: %u (%u invalid), %llu -> %llu bytes, ratio %.3f\n", total.fileCount, failedCount, total.compressedSize, total.uncompressedSize,
+		(double)total.compressedSize / max(total.uncompressedSize, 1));
+	printf("operations: %llu literals, %llu matches (%llu in the 3 byte form) covering %.1f%% of the output, %llu group bytes\n",
+		total.literals, total.matches, total.longMatches, total.matchedBytes * 100.0 / max(total.uncompressedSize, 1), total.groupBytes);
+	printf("decode: %.3f ms summed over threads, %.1f MB/s\n", total.decodeTime * 1000.0, total.uncompressedSize / max(total.decodeTime, 1e-9) / 1e6);
+	printf("recompressed with encodeYaz0: %llu -> %llu bytes (%+lld)\n", recompressedStored, recompressedTotal, (int64_t)recompressedTotal - (int64_t)recompressedStored);
+	printf("compressed to more than %.0f%%: %u files, %llu bytes stored, %llu uncompressed, %.3f ms of decode\n\n",
+		YAZ0_POOR_RATIO * 100.0, poor.fileCount, poor.compressedSize, poor.uncompressedSize, poor.decodeTime * 1000.0);
+
+	printYaz0Histogram("match lengths", total.lengths, YAZ0_LENGTH_BUCKETS, 2, YAZ0_MAX_MATCH);
+	printYaz0Histogram("match distances", total.distances, YAZ0_DISTANCE_BUCKETS, 0, YAZ0_WINDOW_SIZE);
+	printYaz0Histogram("literal runs", total.literalRuns, YAZ0_RUN_BUCKETS, 0, 0);
+	printf("wall: %.3f ms on %i threads\n", wallTime * 1000.0, getThreadCount());
+
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		trackedFree(analysis->threads[i].decompressionBuffer);
+		free(analysis->threads[i].compressionBuffer);
+		free(analysis->threads[i].hashTable);
+		free(analysis->threads[i].chain);
+	}
+	free(analysis->files);
+	free(analysis);
+	free(sorted);
+	return 0;
+}
+
+/*
+* the files inside a game file: the members of a (compressed) archive, or the file itself.
+* decompressionBuffer is grown as needed and owned by the caller
+*/
+static int listGameFileMembers(int fileIndex, uint8_t** decompressionBuffer, struct archiveMember* members, int maxMembers)
+{
+	const struct gameFileInTree* gameFile = &gameFileList[fileIndex];
+
+	const void* archive = gameFile->filePtr;
+	uint32_t archiveSize = gameFile->fileSize;
+	if (isYaz0(gameFile->filePtr, gameFile->fileSize))
+	{
+		archiveSize = getYaz0UncompressedSize(gameFile->filePtr);
+		uint8_t* buffer = trackedRealloc(MEMORY_YAZ0, *decompressionBuffer, max(archiveSize, 1));
+		if (buffer == nullptr)
+			return 0;
+		*decompressionBuffer = buffer;
+		if (decompressYaz0File(gameFile->filePtr, gameFile->fileSize, *decompressionBuffer) != 0)
+			return 0;
+		archive = *decompressionBuffer;
+	}
+
+	if (isRarc(archive, archiveSize))
+		return listRarcMembers(archive, archiveSize, members, maxMembers);
+
+	members[0].name = gameFile->fileName;
+	members[0].data = archive;
+	members[0].size = archiveSize;
+	return 1;
+}
+
+/*
+* model loading benchmark: every model in every archive (and loose bmd/bdl files) is parsed, one file per job
+*/
+struct modelBenchmarkThread
+{
+	uint8_t* decompressionBuffer;
+	void* workspace;
+	double decompressionTime;
+	double parseTime;
+	uint32_t modelCount;
+	uint32_t failedCount;
+	uint64_t vertexCount;
+	uint64_t triangleCount;
+	uint64_t modelBytes;
+};
+
+struct modelBenchmarkContext
+{
+	struct modelBenchmarkThread threads[MAX_THREADS];
+	size_t workspaceSize;
+};
+
+static void parseModelsJob(int fileIndex, int threadIndex, void* context)
+{
+	struct modelBenchmarkContext* benchmark = context;
+	struct modelBenchmarkThread* thread = &benchmark->threads[threadIndex];
+	const struct gameFileInTree* gameFile = &gameFileList[fileIndex];
+
+	if (thread->workspace == nullptr)
+		thread->workspace = trackedAlloc(MEMORY_MODELS, benchmark->workspaceSize);
+
+	double decompressionStart = getTimeSeconds();
+	struct archiveMember members[1024];
+	int memberCount = listGameFileMembers(fileIndex, &thread->decompressionBuffer, members, countof(members));
+	if (isYaz0(gameFile->filePtr, gameFile->fileSize))
+		thread->decompressionTime += getTimeSeconds() - decompressionStart;
+
+	for (int i = 0; i < memberCount; i++)
+	{
+		if (!isJ3DModel(members[i].data, members[i].size))
+			continue;
+
+		double start = getTimeSeconds();
+		struct j3dModel model;
+		bool parsed = parseJ3DModel(members[i].data, members[i].size, thread->workspace, benchmark->workspaceSize, &model);
+		thread->parseTime += getTimeSeconds() - start;
+
+		if (!parsed)
+		{
+			char path[256];
+			getGameFilePath(fileIndex, path, sizeof(path));
+			printf("unable to parse %s:%s\n", path, members[i].name);
+			thread->failedCount++;
+			continue;
+		}
+
+		thread->modelCount++;
+		thread->vertexCount += model.vertexCount;
+		thread->triangleCount += model.indexCount / 3;
+		thread->modelBytes += members[i].size;
+	}
+}
+
+int runModelBenchmark()
+{
+	struct modelBenchmarkContext* benchmark = calloc(1, sizeof(struct modelBenchmarkContext));
+	benchmark->workspaceSize = MODEL_WORKSPACE_SIZE;
+
+	double start = getTimeSeconds();
+	runParallel(gameFileCount, parseModelsJob, benchmark);
+	double wallTime = getTimeSeconds() - start;
+
+	struct modelBenchmarkThread total = { 0 };
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		struct modelBenchmarkThread* thread = &benchmark->threads[i];
+		total.decompressionTime += thread->decompressionTime;
+		total.parseTime += thread->parseTime;
+		total.modelCount += thread->modelCount;
+		total.failedCount += thread->failedCount;
+		total.vertexCount += thread->vertexCount;
+		total.triangleCount += thread->triangleCount;
+		total.modelBytes += thread->modelBytes;
+		trackedFree(thread->decompressionBuffer);
+		trackedFree(thread->workspace);
+	}
+
+	printf("models: %u (%llu bytes), failed: %u\n", total.modelCount, total.modelBytes, total.failedCount);
+	printf("vertices: %llu, triangles: %llu\n", total.vertexCount, total.triangleCount);
+	printf("wall: %.3f ms on %i threads\n", wallTime * 1000.0, getThreadCount());
+	printf("decompression: %.3f ms, parsing: %.3f ms (summed over threads)\n", total.decompressionTime * 1000.0, total.parseTime * 1000.0);
+	if (total.parseTime > 0.0)
+		printf("parsing: %.0f models/s, %.1f MB/s per thread\n", total.modelCount / total.parseTime, total.modelBytes / total.parseTime / (1024.0 * 1024.0));
+
+	free(benchmark);
+	return total.failedCount == 0 ? 0 : -1;
+}
+
+/*
+* texture decoding benchmark: TEX1 textures and .bti files go through the same loader and decoder, one file per job
+*/
+#define TEXTURE_SOURCE_TEX1 0
+#define TEXTURE_SOURCE_BTI 1
+
+struct textureBenchmarkThread
+{
+	uint8_t* decompressionBuffer;
+	uint8_t* pixels;
+	size_t pixelCapacity;
+	uint32_t failedCount;
+	uint32_t textureCount[2];
+	uint64_t textureBytes[2];
+	uint64_t pixelCount[2];
+	double decodeTime[2];
+};
+
+struct textureBenchmarkContext
+{
+	struct textureBenchmarkThread threads[MAX_THREADS];
+};
+
+static void benchmarkTexture(struct textureBenchmarkThread* thread, const struct btiTexture* texture, int source)
+{
+	size_t pixelSize = getDecodedTextureSize(texture->width, texture->height);
+	if (pixelSize > thread->pixelCapacity)
+	{
+		size_t capacity = max(pixelSize, thread->pixelCapacity * 2);
+		uint8_t* pixels = trackedRealloc(MEMORY_PIXELS, thread->pixels, capacity);
+		if (pixels == nullptr)
+			return;
+		thread->pixels = pixels;
+		thread->pixelCapacity = capacity;
+	}
+
+	struct decodedImage image;
+	double start = getTimeSeconds();
+	decodeBTITexture(texture, thread->pixels, &image);
+	thread->decodeTime[source] += getTimeSeconds() - start;
+
+	thread->textureCount[source]++;
+	thread->textureBytes[source] += texture->dataSize;
+	thread->pixelCount[source] += image.pixelCount;
+}
+
+static void decodeTexturesJob(int fileIndex, int threadIndex, void* context)
+{
+	struct textureBenchmarkContext* benchmark = context;
+	struct textureBenchmarkThread* thread = &benchmark->threads[threadIndex];
+
+	struct btiTexture texture;
+	if (gameFileHasExtension(fileIndex, ".bti"))
+	{
+		if (loadBTITexture(gameFileList[fileIndex].filePtr, gameFileList[fileIndex].fileSize, &texture))
+			benchmarkTexture(thread, &texture, TEXTURE_SOURCE_BTI);
+		else
+			thread->failedCount++;
+		return;
+	}
+
+	struct archiveMember members[1024];
+	int memberCount = listGameFileMembers(fileIndex, &thread->decompressionBuffer, members, countof(members));
+	for (int i = 0; i < memberCount; i++)
+	{
+		if (nameHasExtension(members[i].name, ".bti"))
+		{
+			if (loadBTITexture(members[i].data, members[i].size, &texture))
+				benchmarkTexture(thread, &texture, TEXTURE_SOURCE_BTI);
+			else
+				thread->failedCount++;
+			continue;
+		}
+
+		const struct TEX1* textures = isJ3DModel(members[i].data, members[i].size) ? (const struct TEX1*)findJ3DChunk(members[i].data, members[i].size, "TEX1") : nullptr;
+		if (textures == nullptr)
+			continue;
+
+		for (int texNum = 0; texNum < SwapEndian(textures->textureCount); texNum++)
+		{
+			if (loadTEX1Texture(textures, texNum, &texture))
+				benchmarkTexture(thread, &texture, TEXTURE_SOURCE_TEX1);
+			else
+				thread->failedCount++;
+		}
+	}
+}
+
+int runTextureBenchmark()
+{
+	struct textureBenchmarkContext* benchmark = calloc(1, sizeof(struct textureBenchmarkContext));
+
+	double start = getTimeSeconds();
+	runParallel(gameFileCount, decodeTexturesJob, benchmark);
+	double wallTime = getTimeSeconds() - start;
+
+	struct textureBenchmarkThread total = { 0 };
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		struct textureBenchmarkThread* thread = &benchmark->threads[i];
+		total.failedCount += thread->failedCount;
+		for (int source = 0; source < 2; source++)
+		{
+			total.textureCount[source] += thread->textureCount[source];
+			total.textureBytes[source] += thread->textureBytes[source];
+			total.pixelCount[source] += thread->pixelCount[source];
+			total.decodeTime[source] += thread->decodeTime[source];
+		}
+		trackedFree(thread->decompressionBuffer);
+		trackedFree(thread->pixels);
+	}
+
+	static const char* sourceNames[2] = { "TEX1", "bti" };
+	for (int source = 0; source < 2; source++)
+	{
+		printf("%s: %u textures (%llu bytes, %llu pixels)", sourceNames[source], total.textureCount[source], total.textureBytes[source], total.pixelCount[source]);
+		if (total.decodeTime[source] > 0.0)
+			printf(", %.3f ms, %.0f textures/s, %.1f Mpixels/s per thread", total.decodeTime[source] * 1000.0, total.textureCount[source] / total.decodeTime[source], total.pixelCount[source] / total.decodeTime[source] / 1e6);
+		printf("\n");
+	}
+	printf("failed: %u\n", total.failedCount);
+	printf("wall: %.3f ms on %i threads (including decompression)\n", wallTime * 1000.0, getThreadCount());
+
+	free(benchmark);
+	return total.failedCount == 0 ? 0 : -1;
+}
+
+/*
+* texture round trip: every model texture and .bti file decodeTexture reads is decoded, encoded back to its own format and decoded again.
+* every format but CMPR has to give the same texels back (the command fails otherwise), CMPR reports its error.
+* files go one at a time with the encoder on all cores, so the time of a file is what re-encoding its textures takes.
+*/
+struct roundTripFormat
+{
+	uint32_t textureCount;
+	uint32_t exactCount;
+	uint32_t maxError;
+	uint64_t texelCount;
+	uint64_t channelCount;
+	uint64_t squaredError;
+	double encodeTime;
+};
+
+struct textureRoundTrip
+{
+	uint8_t* decompressionBuffer;
+	uint8_t* original;
+	uint8_t* decoded;
+	uint8_t* encoded;
+	size_t pixelCapacity;
+	size_t encodedCapacity;
+	uint8_t quality;
+	uint32_t fileTextureCount;
+	double fileEncodeTime;
+	struct roundTripFormat formats[16];
+};
+
+static void roundTripTexture(struct textureRoundTrip* roundTrip, const struct btiTexture* texture)
+{
+	uint32_t width = texture->width;
+	uint32_t height = texture->height;
+	size_t pixelSize = getDecodedTextureSize(width, height);
+	//a texture whose buffers can't grow is skipped, the capacities only count what both pixel buffers hold
+	if (pixelSize > roundTrip->pixelCapacity)
+	{
+		size_t capacity = max(pixelSize, roundTrip->pixelCapacity * 2);
+		uint8_t* original = realloc(roundTrip->original, capacity);
+		if (original == nullptr)
+			return;
+		roundTrip->original = original;
+		uint8_t* decoded = realloc(roundTrip->decoded, capacity);
+		if (decoded == nullptr)
+			return;
+		roundTrip->decoded = decoded;
+		roundTrip->pixelCapacity = capacity;
+	}
+	if (texture->dataSize > roundTrip->encodedCapacity)
+	{
+		size_t capacity = max(texture->dataSize, roundTrip->encodedCapacity * 2);
+		uint8_t* encoded = realloc(roundTrip->encoded, capacity);
+		if (encoded == nullptr)
+			return;
+		roundTrip->encoded = encoded;
+		roundTrip->encodedCapacity = capacity;
+	}
+
+	decodeTexture(width, height, width * height, texture->data, roundTrip->original, texture->format);
+	double start = getTimeSeconds();
+	uint32_t size = encodeTexture(width, height, roundTrip->original, roundTrip->encoded, texture->format, roundTrip->quality, true);
+	double encodeTime = getTimeSeconds() - start;
+	if (size == 0)
+		return;
+	decodeTexture(width, height, width * height, roundTrip->encoded, roundTrip->decoded, texture->format);
+
+	//the color of a texel that is transparent in both doesn't count
+	struct roundTripFormat* stats = &roundTrip->formats[texture->format];
+	uint32_t maxError = 0;
+	for (uint32_t i = 0; i < width * height; i++)
+	{
+		const uint8_t* a = roundTrip->original + i * 4;
+		const uint8_t* b = roundTrip->decoded + i * 4;
+		for (int channel = a[3] == 0 && b[3] == 0 ? 3 : 0; channel < 4; channel++)
+		{
+			uint32_t error = abs(a[channel] - b[channel]);
+			maxError = max(maxError, error);
+			stats->squaredError += error * error;
+			stats->channelCount++;
+		}
+	}
+
+	stats->textureCount++;
+	stats->exactCount += maxError == 0;
+	stats->maxError = max(stats->maxError, maxError);
+	stats->texelCount += width * height;
+	stats->encodeTime += encodeTime;
+	roundTrip->fileTextureCount++;
+	roundTrip->fileEncodeTime += encodeTime;
+}
+
+int runTextureRoundTrip(uint8_t quality)
+{
+	struct textureRoundTrip* roundTrip = calloc(1, sizeof(struct textureRoundTrip));
+	roundTrip->quality = quality;
+
+	char slowestPath[256] = "";
+	double slowestTime = 0.0;
+	uint32_t slowestTextureCount = 0;
+	uint32_t failedCount = 0;
+	for (int fileIndex = 0; fileIndex < gameFileCount; fileIndex++)
+	{
+		roundTrip->fileTextureCount = 0;
+		roundTrip->fileEncodeTime = 0.0;
+
+		struct btiTexture texture;
+		if (gameFileHasExtension(fileIndex, ".bti"))
+		{
+			if (loadBTITexture(gameFileList[fileIndex].filePtr, gameFileList[fileIndex].fileSize, &texture))
+				roundTripTexture(roundTrip, &texture);
+			else
+				failedCount++;
+		}
+		else
+		{
+			struct archiveMember members[1024];
+			int memberCount = listGameFileMembers(fileIndex, &roundTrip->decompressionBuffer, members, countof(members));
+			for (int i = 0; i < memberCount; i++)
+			{
+				if (nameHasExtension(members[i].name, ".bti"))
+				{
+					if (loadBTITexture(members[i].data, members[i].size, &texture))
+						roundTripTexture(roundTrip, &texture);
+					else
+						failedCount++;
+					continue;
+				}
+
+				const struct TEX1* textures = isJ3DModel(members[i].data, members[i].size) ? (const struct TEX1*)findJ3DChunk(members[i].data, members[i].size, "TEX1") : nullptr;
+				if (textures == nullptr)
+					continue;
+
+				for (int texNum = 0; texNum < SwapEndian(textures->textureCount); texNum++)
+				{
+					if (loadTEX1Texture(textures, texNum, &texture))
+						roundTripTexture(roundTrip, &texture);
+					else
+						failedCount++;
+				}
+			}
+		}
+
+		if (roundTrip->fileEncodeTime > slowestTime)
+		{
+			slowestTime = roundTrip->fileEncodeTime;
+			slowestTextureCount = roundTrip->fileTextureCount;
+			getGameFilePath(fileIndex, slowestPath, sizeof(slowestPath));
+		}
+	}
+
+	struct roundTripFormat total = { 0 };
+	uint32_t inexactCount = 0;
+	for (int format = 0; format < 16; format++)
+	{
+		const struct roundTripFormat* stats = &roundTrip->formats[format];
+		if (stats->textureCount == 0)
+			continue;
+		if (format != GX_TF_CMPR)
+			inexactCount += stats->textureCount - stats->exactCount;
+		double meanSquaredError = stats->channelCount ? (double)stats->squaredError / stats->channelCount : 0.0;
+		printf("%s: %u textures (%llu texels), %u exact, max error %u", textureFormatNames[format], stats->textureCount, stats->texelCount, stats->exactCount, stats->maxError);
+		if (meanSquaredError > 0.0)
+			printf(", %.2f dB", 10.0 * log10(255.0 * 255.0 / meanSquaredError));
+		if (stats->encodeTime > 0.0)
+			printf(", encode %.3f ms, %.1f Mtexels/s", stats->encodeTime * 1000.0, stats->texelCount / stats->encodeTime / 1e6);
+		printf("\n");
+		total.textureCount += stats->textureCount;
+		total.texelCount += stats->texelCount;
+		total.encodeTime += stats->encodeTime;
+	}
+	printf("textures: %u (%llu texels) encoded in %.3f ms on %i threads, failed: %u\n", total.textureCount, total.texelCount, total.encodeTime * 1000.0, getThreadCount(), failedCount);
+	if (slowestTextureCount > 0)
+		printf("slowest file: %s, %u textures in %.3f ms\n", slowestPath, slowestTextureCount, slowestTime * 1000.0);
+
+	trackedFree(roundTrip->decompressionBuffer);
+	free(roundTrip->original);
+	free(roundTrip->decoded);
+	free(roundTrip->encoded);
+	free(roundTrip);
+	return failedCount == 0 && inexactCount == 0 ? 0 : -1;
+}
+
+/*
+* animation benchmark: every bck/bca/btk/brk in every archive is parsed and every track sampled, one file per job
+*/
+#define ANIMATION_WORKSPACE_SIZE (1024 * 1024 * 8)
+
+struct animationBenchmarkThread
+{
+	uint8_t* decompressionBuffer;
+	void* workspace;
+	double parseTime;
+	double sampleTime;
+	uint32_t animationCount[3];
+	uint32_t failedCount;
+	uint64_t trackCount;
+	uint64_t sampleCount;
+};
+
+struct animationBenchmarkContext
+{
+	struct animationBenchmarkThread threads[MAX_THREADS];
+};
+
+static void sampleAnimationsJob(int fileIndex, int threadIndex, void* context)
+{
+	struct animationBenchmarkContext* benchmark = context;
+	struct animationBenchmarkThread* thread = &benchmark->threads[threadIndex];
+
+	if (thread->workspace == nullptr)
+		thread->workspace = malloc(ANIMATION_WORKSPACE_SIZE);
+
+	struct archiveMember members[1024];
+	int memberCount = listGameFileMembers(fileIndex, &thread->decompressionBuffer, members, countof(members));
+	for (int i = 0; i < memberCount; i++)
+	{
+		if (!isJ3DAnimation(members[i].data, members[i].size))
+			continue;
+
+		double start = getTimeSeconds();
+		struct j3dAnimation animation;
+		bool parsed = parseJ3DAnimation(members[i].data, members[i].size, thread->workspace, ANIMATION_WORKSPACE_SIZE, &animation);
+		double parseEnd = getTimeSeconds();
+		thread->parseTime += parseEnd - start;
+
+		uint32_t trackCount = animation.targetCount * animation.tracksPerTarget;
+		bool sampled = parsed;
+		for (uint32_t track = 0; track < trackCount && sampled; track++)
+			sampled = getAnimationSamples(&animation, track) != nullptr;
+		thread->sampleTime += getTimeSeconds() - parseEnd;
+
+		if (!sampled)
+		{
+			char path[256];
+			getGameFilePath(fileIndex, path, sizeof(path));
+			printf("unable to %s %s:%s\n", parsed ? "sample" : "parse", path, members[i].name);
+			thread->failedCount++;
+			continue;
+		}
+
+		thread->animationCount[animation.type]++;
+		thread->trackCount += trackCount;
+		thread->sampleCount += (uint64_t)trackCount * max(animation.frameCount, 1);
+	}
+}
+
+int runAnimationBenchmark()
+{
+	struct animationBenchmarkContext* benchmark = calloc(1, sizeof(struct animationBenchmarkContext));
+
+	double start = getTimeSeconds();
+	runParallel(gameFileCount, sampleAnimationsJob, benchmark);
+	double wallTime = getTimeSeconds() - start;
+
+	struct animationBenchmarkThread total = { 0 };
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		struct animationBenchmarkThread* thread = &benchmark->threads[i];
+		total.parseTime += thread->parseTime;
+		total.sampleTime += thread->sampleTime;
+		for (int type = 0; type < 3; type++)
+			total.animationCount[type] += thread->animationCount[type];
+		total.failedCount += thread->failedCount;
+		total.trackCount += thread->trackCount;
+		total.sampleCount += thread->sampleCount;
+		trackedFree(thread->decompressionBuffer);
+		free(thread->workspace);
+	}
+
+	printf("animations: %u joint, %u texture srt, %u color, failed: %u\n", total.animationCount[ANIMATION_JOINT], total.animationCount[ANIMATION_TEXTURE_SRT], total.animationCount[ANIMATION_COLOR], total.failedCount);
+	printf("tracks: %llu, samples: %llu\n", total.trackCount, total.sampleCount);
+	printf("wall: %.3f ms on %i threads\n", wallTime * 1000.0, getThreadCount());
+	printf("parsing: %.3f ms, sampling: %.3f ms (summed over threads)\n", total.parseTime * 1000.0, total.sampleTime * 1000.0);
+	if (total.sampleTime > 0.0)
+		printf("sampling: %.1f Msamples/s per thread\n", total.sampleCount / total.sampleTime / 1e6);
+
+	free(benchmark);
+	return total.failedCount == 0 ? 0 : -1;
+}
+
+/*
+* skeleton benchmark: every model is parsed once, then its joint world matrices are evaluated over and over into the
+* model's own jointWorldMatrices, so the timed loop allocates nothing
+*/
+#define SKELETON_EVALUATIONS 100
+
+struct skeletonBenchmarkThread
+{
+	uint8_t* decompressionBuffer;
+	void* workspace;
+	double parseTime;
+	double evaluationTime;
+	uint32_t skeletonCount;
+	uint32_t failedCount;
+	uint64_t jointCount;
+	uint64_t nodeCount;
+	uint32_t maxDepth;
+};
+
+struct skeletonBenchmarkContext
+{
+	struct skeletonBenchmarkThread threads[MAX_THREADS];
+};
+
+static void evaluateSkeletonsJob(int fileIndex, int threadIndex, void* context)
+{
+	struct skeletonBenchmarkContext* benchmark = context;
+	struct skeletonBenchmarkThread* thread = &benchmark->threads[threadIndex];
+
+	if (thread->workspace == nullptr)
+		thread->workspace = trackedAlloc(MEMORY_MODELS, MODEL_WORKSPACE_SIZE);
+
+	struct archiveMember members[1024];
+	int memberCount = listGameFileMembers(fileIndex, &thread->decompressionBuffer, members, countof(members));
+	for (int i = 0; i < memberCount; i++)
+	{
+		if (!isJ3DModel(members[i].data, members[i].size))
+			continue;
+
+		double start = getTimeSeconds();
+		struct j3dModel model;
+		bool parsed = parseJ3DModel(members[i].data, members[i].size, thread->workspace, MODEL_WORKSPACE_SIZE, &model);
+		double parseEnd = getTimeSeconds();
+		thread->parseTime += parseEnd - start;
+
+		if (!parsed)
+		{
+			char path[256];
+			getGameFilePath(fileIndex, path, sizeof(path));
+			printf("unable to parse %s:%s\n", path, members[i].name);
+			thread->failedCount++;
+			continue;
+		}
+		if (model.jointCount == 0)
+			continue;
+
+		for (int evaluation = 0; evaluation < SKELETON_EVALUATIONS; evaluation++)
+			evaluateJointWorldMatrices(&model, model.jointScales, model.jointRotations, model.jointTranslations, model.jointWorldMatrices);
+		thread->evaluationTime += getTimeSeconds() - parseEnd;
+
+		//parents come first, so one pass gives every joint its depth
+		uint32_t depths[1024];
+		for (uint32_t j = 0; j < model.jointCount && model.jointCount <= countof(depths); j++)
+		{
+			uint16_t joint = model.hierarchyJoints[j];
+			int16_t parent = model.jointParents[joint];
+			depths[joint] = parent >= 0 ? depths[parent] + 1 : 0;
+			thread->maxDepth = max(thread->maxDepth, depths[joint]);
+		}
+
+		thread->skeletonCount++;
+		thread->jointCount += model.jointCount;
+		thread->nodeCount += model.nodeCount;
+	}
+}
+
+int runSkeletonBenchmark()
+{
+	struct skeletonBenchmarkContext* benchmark = calloc(1, sizeof(struct skeletonBenchmarkContext));
+
+	double start = getTimeSeconds();
+	runParallel(gameFileCount, evaluateSkeletonsJob, benchmark);
+	double wallTime = getTimeSeconds() - start;
+
+	struct skeletonBenchmarkThread total = { 0 };
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		struct skeletonBenchmarkThread* thread = &benchmark->threads[i];
+		total.parseTime += thread->parseTime;
+		total.evaluationTime += thread->evaluationTime;
+		total.skeletonCount += thread->skeletonCount;
+		total.failedCount += thread->failedCount;
+		total.jointCount += thread->jointCount;
+		total.nodeCount += thread->nodeCount;
+		total.maxDepth = max(total.maxDepth, thread->maxDepth);
+		trackedFree(thread->decompressionBuffer);
+		trackedFree(thread->workspace);
+	}
+
+	printf("skeletons: %u, joints: %llu, hierarchy nodes: %llu, deepest joint: %u, failed: %u\n", total.skeletonCount, total.jointCount, total.nodeCount, total.maxDepth, total.failedCount);
+	printf("wall: %.3f ms on %i threads\n", wallTime * 1000.0, getThreadCount());
+	printf("parsing: %.3f ms, %i evaluations each: %.3f ms (summed over threads)\n", total.parseTime * 1000.0, SKELETON_EVALUATIONS, total.evaluationTime * 1000.0);
+	if (total.evaluationTime > 0.0)
+		printf("evaluation: %.1f Mjoints/s per thread\n", total.jointCount * SKELETON_EVALUATIONS / total.evaluationTime / 1e6);
+
+	free(benchmark);
+	return total.failedCount == 0 ? 0 : -1;
+}
+
+/*
+* message extraction: every bmg file (loose or in an archive) is indexed and every message decoded to utf-8, one file per job
+*/
+#define BMG_WORKSPACE_SIZE (1024 * 1024)
+#define BMG_MESSAGE_BUFFER_SIZE (1024 * 64)
+
+struct messageBenchmarkThread
+{
+	uint8_t* decompressionBuffer;
+	void* workspace;
+	char* messageBuffer;
+	double decompressionTime;
+	double indexTime;
+	double decodeTime;
+	uint32_t fileCount;
+	uint32_t failedCount;
+	uint64_t messageCount;
+	uint64_t sourceBytes;
+	uint64_t decodedBytes;
+};
+
+struct messageBenchmarkContext
+{
+	struct messageBenchmarkThread threads[MAX_THREADS];
+};
+
+static void extractMessages(struct messageBenchmarkThread* thread, const void* data, uint32_t size)
+{
+	double start = getTimeSeconds();
+	struct bmgFile bmg;
+	bool parsed = parseBMGFile(data, size, thread->workspace, BMG_WORKSPACE_SIZE, &bmg);
+	double indexEnd = getTimeSeconds();
+	thread->indexTime += indexEnd - start;
+	if (!parsed)
+	{
+		thread->failedCount++;
+		return;
+	}
+
+	for (uint32_t i = 0; i < bmg.messageCount; i++)
+		thread->decodedBytes += decodeBMGMessage(&bmg, &bmg.messages[i], thread->messageBuffer, BMG_MESSAGE_BUFFER_SIZE);
+	thread->decodeTime += getTimeSeconds() - indexEnd;
+
+	thread->fileCount++;
+	thread->messageCount += bmg.messageCount;
+	thread->sourceBytes += size;
+}
+
+static void extractMessagesJob(int fileIndex, int threadIndex, void* context)
+{
+	struct messageBenchmarkContext* benchmark = context;
+	struct messageBenchmarkThread* thread = &benchmark->threads[threadIndex];
+	const struct gameFileInTree* gameFile = &gameFileList[fileIndex];
+
+	if (thread->workspace == nullptr)
+	{
+		thread->workspace = trackedAlloc(MEMORY_TEXT, BMG_WORKSPACE_SIZE);
+		thread->messageBuffer = malloc(BMG_MESSAGE_BUFFER_SIZE);
+	}
+
+	double decompressionStart = getTimeSeconds();
+	struct archiveMember members[1024];
+	int memberCount = listGameFileMembers(fileIndex, &thread->decompressionBuffer, members, countof(members));
+	if (isYaz0(gameFile->filePtr, gameFile->fileSize))
+		thread->decompressionTime += getTimeSeconds() - decompressionStart;
+
+	for (int i = 0; i < memberCount; i++)
+		if (isBMGFile(members[i].data, members[i].size))
+			extractMessages(thread, members[i].data, members[i].size);
+}
+
+int runMessageBenchmark()
+{
+	initShiftJisTable();
+	struct messageBenchmarkContext* benchmark = calloc(1, sizeof(struct messageBenchmarkContext));
+
+	double start = getTimeSeconds();
+	runParallel(gameFileCount, extractMessagesJob, benchmark);
+	double wallTime = getTimeSeconds() - start;
+
+	struct messageBenchmarkThread total = { 0 };
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		struct messageBenchmarkThread* thread = &benchmark->threads[i];
+		total.decompressionTime += thread->decompressionTime;
+		total.indexTime += thread->indexTime;
+		total.decodeTime += thread->decodeTime;
+		total.fileCount += thread->fileCount;
+		total.failedCount += thread->failedCount;
+		total.messageCount += thread->messageCount;
+		total.sourceBytes += thread->sourceBytes;
+		total.decodedBytes += thread->decodedBytes;
+		trackedFree(thread->decompressionBuffer);
+		trackedFree(thread->workspace);
+		free(thread->messageBuffer);
+	}
+
+	printf("bmg files: %u (%llu bytes), failed: %u\n", total.fileCount, total.sourceBytes, total.failedCount);
+	printf("messages: %llu (%llu bytes of utf-8)\n", total.messageCount, total.decodedBytes);
+	printf("wall: %.3f ms on %i threads\n", wallTime * 1000.0, getThreadCount());
+	printf("decompression: %.3f ms, indexing: %.3f ms, decoding: %.3f ms (summed over threads)\n", total.decompressionTime * 1000.0, total.indexTime * 1000.0, total.decodeTime * 1000.0);
+	if (total.indexTime + total.decodeTime > 0.0)
+		printf("extraction: %.0f messages/s, %.1f MB/s per thread\n", total.messageCount / (total.indexTime + total.decodeTime), total.sourceBytes / (total.indexTime + total.decodeTime) / (1024.0 * 1024.0));
+
+	free(benchmark);
+	return total.failedCount == 0 ? 0 : -1;
+}
+
+//prints every message of every bmg file, or only the messages with the given id
+int runMessageDump(bool filterById, uint32_t id)
+{
+	void* workspace = trackedAlloc(MEMORY_TEXT, BMG_WORKSPACE_SIZE);
+	char* messageBuffer = malloc(BMG_MESSAGE_BUFFER_SIZE);
+	uint8_t* decompressionBuffer = nullptr;
+	uint32_t matchCount = 0;
+
+	for (int fileIndex = 0; fileIndex < gameFileCount; fileIndex++)
+	{
+		struct archiveMember members[1024];
+		int memberCount = listGameFileMembers(fileIndex, &decompressionBuffer, members, countof(members));
+		for (int i = 0; i < memberCount; i++)
+		{
+			struct bmgFile bmg;
+			if (!isBMGFile(members[i].data, members[i].size) || !parseBMGFile(members[i].data, members[i].size, workspace, BMG_WORKSPACE_SIZE, &bmg))
+				continue;
+
+			char path[256];
+			getGameFilePath(fileIndex, path, sizeof(path));
+			const char* memberName = members[i].data == gameFileList[fileIndex].filePtr ? "" : members[i].name;
+
+			if (filterById)
+			{
+				const struct bmgMessage* message = findBMGMessage(&bmg, id);
+				if (message == nullptr)
+					continue;
+				decodeBMGMessage(&bmg, message, messageBuffer, BMG_MESSAGE_BUFFER_SIZE);
+				printf("%s%s%s %u: %s\n", path, memberName[0] ? ":" : "", memberName, message->id, messageBuffer);
+				matchCount++;
+				continue;
+			}
+
+			printf("%s%s%s (%u messages, %s)\n", path, memberName[0] ? ":" : "", memberName, bmg.messageCount, getBMGEncodingName(bmg.encoding));
+			for (uint32_t m = 0; m < bmg.messageCount; m++)
+			{
+				decodeBMGMessage(&bmg, &bmg.messages[m], messageBuffer, BMG_MESSAGE_BUFFER_SIZE);
+				printf("\t%u: %s\n", bmg.messages[m].id, messageBuffer);
+			}
+			matchCount += bmg.messageCount;
+		}
+	}
+
+	if (filterById && matchCount == 0)
+		printf("no message with id %u\n", id);
+
+	trackedFree(decompressionBuffer);
+	free(messageBuffer);
+	trackedFree(workspace);
+	return filterById && matchCount == 0 ? -1 : 0;
+}
+
+/*
+* writes rgba pixels (decodeTexture layout) as a 32 bit top-down bmp.
+* red and blue are swapped in place, the pixels are bgra afterwards
+*/
+bool writeBitmapFile(const char* path, uint32_t* pixels, uint32_t width, uint32_t height)
+{
+	for (uint32_t i = 0; i < width * height; i++)
+		pixels[i] = (pixels[i] & 0xFF00FF00) | ((pixels[i] & 0xFF) << 16) | ((pixels[i] >> 16) & 0xFF);
+
+	BITMAPFILEHEADER fileHeader = { 0 };
+	BITMAPINFOHEADER infoHeader = { 0 };
+	fileHeader.bfType = 'B' | ('M' << 8);
+	fileHeader.bfOffBits = sizeof(fileHeader) + sizeof(infoHeader);
+	fileHeader.bfSize = fileHeader.bfOffBits + width * height * 4;
+	infoHeader.biSize = sizeof(infoHeader);
+	infoHeader.biWidth = width;
+	infoHeader.biHeight = -(LONG)height;
+	infoHeader.biPlanes = 1;
+	infoHeader.biBitCount = 32;
+	infoHeader.biCompression = BI_RGB;
+	infoHeader.biSizeImage = width * height * 4;
+
+	HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	bool written =
+		writeFileData(file, &fileHeader, sizeof(fileHeader)) &&
+		writeFileData(file, &infoHeader, sizeof(infoHeader)) &&
+		writeFileData(file, pixels, (uint64_t)width * height * 4);
+	CloseHandle(file);
+	return written;
+}
+
+/*
+* model thumbnails: one file per job, every model in it is parsed, rendered single threaded and written as <directory>/<path>_<member>.bmp
+*/
+struct thumbnailThread
+{
+	uint8_t* decompressionBuffer;
+	void* modelWorkspace;
+	void* textureWorkspace;
+	void* renderWorkspace;
+	uint32_t thumbnailCount;
+	uint32_t failedCount;
+	uint64_t bytesWritten;
+	double renderTime;
+};
+
+struct thumbnailContext
+{
+	struct thumbnailThread threads[MAX_THREADS];
+	const char* directory;
+	uint32_t size;
+};
+
+#define THUMBNAIL_TEXTURE_WORKSPACE_SIZE (1024 * 1024 * 16)
+#define THUMBNAIL_RENDER_WORKSPACE_SIZE (1024 * 1024 * 16)
+
+static void renderThumbnailsJob(int fileIndex, int threadIndex, void* context)
+{
+	struct thumbnailContext* thumbnails = context;
+	struct thumbnailThread* thread = &thumbnails->threads[threadIndex];
+	const struct gameFileInTree* gameFile = &gameFileList[fileIndex];
+
+	struct archiveMember members[1024];
+	int memberCount = listGameFileMembers(fileIndex, &thread->decompressionBuffer, members, countof(members));
+
+	for (int i = 0; i < memberCount; i++)
+	{
+		if (!isJ3DModel(members[i].data, members[i].size))
+			continue;
+
+		if (thread->modelWorkspace == nullptr)
+		{
+			thread->modelWorkspace = trackedAlloc(MEMORY_MODELS, MODEL_WORKSPACE_SIZE);
+			thread->textureWorkspace = malloc(THUMBNAIL_TEXTURE_WORKSPACE_SIZE);
+			thread->renderWorkspace = malloc(THUMBNAIL_RENDER_WORKSPACE_SIZE);
+		}
+
+		double start = getTimeSeconds();
+
+		struct j3dModel model;
+		const struct decodedImage* textures[RASTER_MAX_TEXTURES];
+		struct decodedImage thumbnail;
+		bool rendered = false;
+		if (parseJ3DModel(members[i].data, members[i].size, thread->modelWorkspace, MODEL_WORKSPACE_SIZE, &model))
+		{
+			uint32_t textureCount = decodeModelTextures(&model, textures, countof(textures), thread->textureWorkspace, THUMBNAIL_TEXTURE_WORKSPACE_SIZE);
+			rendered = renderJ3DModel(&model, textures, textureCount, thumbnails->size, thumbnails->size, false, thread->renderWorkspace, THUMBNAIL_RENDER_WORKSPACE_SIZE, &thumbnail);
+		}
+
+		thread->renderTime += getTimeSeconds() - start;
+
+		char path[256];
+		getGameFilePath(fileIndex, path, sizeof(path));
+		if (!rendered)
+		{
+			printf("unable to render %s:%s\n", path, members[i].name);
+			thread->failedCount++;
+			continue;
+		}
+
+		char outputPath[MAX_PATH];
+		//loose model files are named after their path, archive members after the archive path and member name
+		int length = members[i].data == gameFile->filePtr ?
+			snprintf(outputPath, sizeof(outputPath), "%s/%s.bmp", thumbnails->directory, path[0] == '/' ? path + 1 : path) :
+			snprintf(outputPath, sizeof(outputPath), "%s/%s_%s.bmp", thumbnails->directory, path[0] == '/' ? path + 1 : path, members[i].name);
+		for (int c = (int)strlen(thumbnails->directory) + 1; c < length && c < sizeof(outputPath); c++)
+			if (outputPath[c] == '/' || outputPath[c] == '\\' || outputPath[c] == ':')
+				outputPath[c] = '_';
+
+		if (!writeBitmapFile(outputPath, (uint32_t*)thumbnail.pixels, thumbnail.width, thumbnail.height))
+		{
+			printf("unable to write %s\n", outputPath);
+			thread->failedCount++;
+			continue;
+		}
+
+		thread->thumbnailCount++;
+		thread->bytesWritten += sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + thumbnail.pixelCount * 4;
+	}
+}
+
+int runThumbnails(const char* directory, uint32_t size)
+{
+	if (size == 0 || size > 1024 || (size & 3) != 0)
+	{
+		printf("thumbnail size must be a multiple of 4 up to 1024\n");
+		return -1;
+	}
+
+	CreateDirectoryA(directory, nullptr);
+
+	struct thumbnailContext* thumbnails = calloc(1, sizeof(struct thumbnailContext));
+	thumbnails->directory = directory;
+	thumbnails->size = size;
+
+	double start = getTimeSeconds();
+	runParallel(gameFileCount, renderThumbnailsJob, thumbnails);
+	double wallTime = getTimeSeconds() - start;
+
+	struct thumbnailThread total = { 0 };
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		struct thumbnailThread* thread = &thumbnails->threads[i];
+		total.thumbnailCount += thread->thumbnailCount;
+		total.failedCount += thread->failedCount;
+		total.bytesWritten += thread->bytesWritten;
+		total.renderTime += thread->renderTime;
+		trackedFree(thread->decompressionBuffer);
+		trackedFree(thread->modelWorkspace);
+		free(thread->textureWorkspace);
+		free(thread->renderWorkspace);
+	}
+
+	printf("thumbnails: %u (%ux%u, %llu bytes), failed: %u\n", total.thumbnailCount, size, size, total.bytesWritten, total.failedCount);
+	printf("wall: %.3f ms on %i threads, %.0f thumbnails/s\n", wallTime * 1000.0, getThreadCount(), total.thumbnailCount / max(wallTime, 1e-9));
+	printf("parse + decode + render: %.3f ms (summed over threads)\n", total.renderTime * 1000.0);
+
+	free(thumbnails);
+	return total.failedCount == 0 ? 0 : -1;
+}
+/*
+* -gallery writes the atlas pages the texture gallery fills for every texture on the disc (or the files under a path),
+* with the same lister, mip level choice, filter and shelf packer, on one thread like the gallery's
+*/
+static bool writeGalleryPage(const char* directory, uint32_t page, struct textureAtlas* atlas)
+{
+	char path[MAX_PATH];
+	_snprintf_s(path, sizeof(path), _TRUNCATE, "%s/gallery%03u.bmp", directory, page);
+	bool written = writeBitmapFile(path, atlas->pixels, GALLERY_ATLAS_SIZE, atlas->usedHeight);
+	if (!written)
+		printf("unable to write %s\n", path);
+	memset(atlas->pixels, 0, (size_t)GALLERY_ATLAS_SIZE * atlas->usedHeight * 4);
+	clearTextureAtlas(atlas);
+	return written;
+}
+
+int runGalleryExport(const char* directory, const char* pathPrefix)
+{
+	CreateDirectoryA(directory, nullptr);
+
+	struct galleryWorker* worker = calloc(1, sizeof(struct galleryWorker));
+	struct textureAtlas* atlas = calloc(1, sizeof(struct textureAtlas));
+	if (worker != nullptr)
+		worker->listed = malloc(sizeof(struct galleryEntry) * GALLERY_MAX_FILE_TEXTURES);
+	if (atlas != nullptr)
+		atlas->pixels = calloc((size_t)GALLERY_ATLAS_SIZE * GALLERY_ATLAS_SIZE, sizeof(uint32_t));
+	if (worker == nullptr || worker->listed == nullptr || atlas == nullptr || atlas->pixels == nullptr)
+	{
+		printf("not enough memory for the gallery atlas\n");
+		if (worker != nullptr)
+			freeGalleryWorker(worker);
+		free(worker);
+		if (atlas != nullptr)
+			free(atlas->pixels);
+		free(atlas);
+		return -1;
+	}
+	worker->membersFile = -1;
+	struct galleryEntry* entries = nullptr;
+	uint32_t entryCount = 0;
+	uint32_t entryCapacity = 0;
+	uint32_t failedCount = 0;
+
+	double start = getTimeSeconds();
+	size_t prefixLength = pathPrefix != nullptr ? strlen(pathPrefix) : 0;
+	for (int f = 0; f < gameFileCount; f++)
+	{
+		char path[256];
+		if (prefixLength != 0 && (getGameFilePath(f, path, sizeof(path)), strncmp(path, pathPrefix, prefixLength) != 0))
+			continue;
+		uint32_t count = listGalleryTextures(worker, f);
+		if (count == 0)
+			continue;
+		//the file's textures count as failed if the entries can't grow
+		if (entryCount + count > entryCapacity)
+		{
+			uint32_t capacity = max(entryCapacity * 2, entryCount + count);
+			struct galleryEntry* grown = realloc(entries, capacity * sizeof(struct galleryEntry));
+			if (grown == nullptr)
+			{
+				failedCount += count;
+				continue;
+			}
+			entries = grown;
+			entryCapacity = capacity;
+		}
+		memcpy(entries + entryCount, worker->listed, count * sizeof(struct galleryEntry));
+		entryCount += count;
+	}
+	double listTime = getTimeSeconds() - start;
+
+	start = getTimeSeconds();
+	uint32_t thumbnailCount = 0;
+	uint32_t pageCount = 0;
+	bool written = true;
+	for (uint32_t i = 0; i < entryCount; i++)
+	{
+		uint32_t width, height;
+		const uint32_t* thumbnail = makeGalleryThumbnail(worker, &entries[i], &width, &height);
+		if (thumbnail == nullptr)
+		{
+			failedCount++;
+			continue;
+		}
+		if (!addGalleryThumbnail(atlas, &entries[i], thumbnail, width, height))
+		{
+			written &= writeGalleryPage(directory, pageCount++, atlas);
+			addGalleryThumbnail(atlas, &entries[i], thumbnail, width, height);
+		}
+		thumbnailCount++;
+	}
+	if (atlas->usedHeight != 0)
+		written &= writeGalleryPage(directory, pageCount++, atlas);
+	double thumbnailTime = getTimeSeconds() - start;
+
+	printf("textures: %u in %.3f ms, thumbnails: %u, failed: %u, atlas pages: %u (%ux%u)\n",
+		entryCount, listTime * 1000.0, thumbnailCount, failedCount, pageCount, GALLERY_ATLAS_SIZE, GALLERY_ATLAS_SIZE);
+	printf("thumbnails: %.3f ms, %.0f thumbnails/s (page writes included)\n", thumbnailTime * 1000.0, thumbnailCount / max(thumbnailTime, 1e-9));
+	printf("decoded %llu bytes of pixels, the base levels are %llu bytes\n", worker->decodedBytes, worker->baseLevelBytes);
+	printf("memory: atlas %zu bytes, largest decoded level %zu bytes, %u entries %zu bytes\n",
+		(size_t)GALLERY_ATLAS_SIZE * GALLERY_ATLAS_SIZE * 4, worker->pixelsSize, entryCount, (size_t)entryCount * sizeof(struct galleryEntry));
+
+	freeGalleryWorker(worker);
+	free(worker);
+	free(atlas->pixels);
+	free(atlas);
+	free(entries);
+	return written && failedCount == 0 ? 0 : -1;
+}
+
+
+/*
+* CMPR texture export: every CMPR texture of every model is transcoded to BC1 and written as <directory>/<path>_<member>_<texture>.dds (or .ktx2)
+*/
+struct textureExportThread
+{
+	uint8_t* decompressionBuffer;
+	uint8_t* fileBuffer;
+	uint32_t fileBufferSize;
+	uint32_t exportedCount;
+	uint32_t skippedCount;
+	uint32_t failedCount;
+	uint64_t inputBytes;
+	uint64_t outputBytes;
+	double transcodeTime;
+	struct cmprPrecisionStats precision;
+};
+
+struct textureExportContext
+{
+	struct textureExportThread threads[MAX_THREADS];
+	const char* directory;
+	bool ktx2;
+	bool measurePrecision;
+};
+
+static void exportModelTextures(struct textureExportContext* textureExport, struct textureExportThread* thread, int fileIndex, const struct archiveMember* member)
+{
+	const struct TEX1* textures = (const struct TEX1*)findJ3DChunk(member->data, member->size, "TEX1");
+	if (textures == nullptr)
+		return;
+
+	const void* names = getJ3DNameTable(textures, SwapEndian(textures->stringTableOffset));
+	for (int texNum = 0; texNum < SwapEndian(textures->textureCount); texNum++)
+	{
+		struct btiTexture loadedTexture;
+		const struct btiTexture* texture = &loadedTexture;
+		if (!loadTEX1Texture(textures, texNum, &loadedTexture) || texture->format != GX_TF_CMPR)
+		{
+			thread->skippedCount++;
+			continue;
+		}
+
+		uint32_t capacity = getBC1ContainerCapacity(texture);
+		if (capacity > thread->fileBufferSize)
+		{
+			uint32_t bufferSize = max(capacity, thread->fileBufferSize * 2);
+			uint8_t* fileBuffer = realloc(thread->fileBuffer, bufferSize);
+			if (fileBuffer == nullptr)
+			{
+				thread->failedCount++;
+				continue;
+			}
+			thread->fileBuffer = fileBuffer;
+			thread->fileBufferSize = bufferSize;
+		}
+
+		double start = getTimeSeconds();
+		uint32_t size = textureExport->ktx2 ? buildKTX2File(texture, thread->fileBuffer, thread->fileBufferSize) : buildDDSFile(texture, thread->fileBuffer, thread->fileBufferSize);
+		thread->transcodeTime += getTimeSeconds() - start;
+
+		uint32_t width = texture->width;
+		uint32_t height = texture->height;
+		if (textureExport->measurePrecision)
+			measureCMPRPrecision(texture->data, width, height, &thread->precision);
+
+		char path[256];
+		getGameFilePath(fileIndex, path, sizeof(path));
+		char outputPath[MAX_PATH];
+		int length = snprintf(outputPath, sizeof(outputPath), "%s/%s_%s_%s.%s", textureExport->directory, path[0] == '/' ? path + 1 : path, member->name, getJ3DName(names, texNum), textureExport->ktx2 ? "ktx2" : "dds");
+		for (int c = (int)strlen(textureExport->directory) + 1; c < length && c < sizeof(outputPath); c++)
+			if (outputPath[c] == '/' || outputPath[c] == '\\' || outputPath[c] == ':')
+				outputPath[c] = '_';
+
+		HANDLE file = size ? CreateFileA(outputPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) : INVALID_HANDLE_VALUE;
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			printf("unable to export %s\n", outputPath);
+			thread->failedCount++;
+			continue;
+		}
+		bool written = writeFileData(file, thread->fileBuffer, size);
+		CloseHandle(file);
+		if (!written)
+		{
+			thread->failedCount++;
+			continue;
+		}
+
+		thread->exportedCount++;
+		for (uint32_t level = 0; level < texture->levelCount; level++)
+			thread->inputBytes += getTextureDataSize(GX_TF_CMPR, max(width >> level, 1), max(height >> level, 1));
+		thread->outputBytes += size;
+	}
+}
+
+static void exportTexturesJob(int fileIndex, int threadIndex, void* context)
+{
+	struct textureExportContext* textureExport = context;
+	struct textureExportThread* thread = &textureExport->threads[threadIndex];
+
+	struct archiveMember members[1024];
+	int memberCount = listGameFileMembers(fileIndex, &thread->decompressionBuffer, members, countof(members));
+	for (int i = 0; i < memberCount; i++)
+		if (isJ3DModel(members[i].data, members[i].size))
+			exportModelTextures(textureExport, thread, fileIndex, &members[i]);
+}
+
+int runTextureExport(const char* directory, bool ktx2, bool measurePrecision)
+{
+	CreateDirectoryA(directory, nullptr);
+
+	struct textureExportContext* textureExport = calloc(1, sizeof(struct textureExportContext));
+	textureExport->directory = directory;
+	textureExport->ktx2 = ktx2;
+	textureExport->measurePrecision = measurePrecision;
+
+	double start = getTimeSeconds();
+	runParallel(gameFileCount, exportTexturesJob, textureExport);
+	double wallTime = getTimeSeconds() - start;
+
+	struct textureExportThread total = { 0 };
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		struct textureExportThread* thread = &textureExport->threads[i];
+		total.exportedCount += thread->exportedCount;
+		total.skippedCount += thread->skippedCount;
+		total.failedCount += thread->failedCount;
+		total.inputBytes += thread->inputBytes;
+		total.outputBytes += thread->outputBytes;
+		total.transcodeTime += thread->transcodeTime;
+		total.precision.blockCount += thread->precision.blockCount;
+		total.precision.blendedBlockCount += thread->precision.blendedBlockCount;
+		total.precision.transparentBlockCount += thread->precision.transparentBlockCount;
+		total.precision.errorSum += thread->precision.errorSum;
+		total.precision.maxError = max(total.precision.maxError, thread->precision.maxError);
+		trackedFree(thread->decompressionBuffer);
+		free(thread->fileBuffer);
+	}
+
+	printf("exported: %u CMPR textures (%llu bytes -> %llu bytes), not CMPR: %u, failed: %u\n", total.exportedCount, total.inputBytes, total.outputBytes, total.skippedCount, total.failedCount);
+	printf("wall: %.3f ms on %i threads\n", wallTime * 1000.0, getThreadCount());
+	if (total.transcodeTime > 0.0)
+		printf("transcoding: %.3f ms (summed over threads), %.1f MB/s per thread\n", total.transcodeTime * 1000.0, total.inputBytes / total.transcodeTime / (1024.0 * 1024.0));
+
+	if (measurePrecision)
+	{
+		printf("precision: %llu blocks, %llu blend 3/8 on GX but 1/3 in BC1 (max error %u, mean %.2f of 255), %llu have transparent texels (midpoint on GX, black in BC1)\n",
+			total.precision.blockCount,
+			total.precision.blendedBlockCount,
+			total.precision.maxError,
+			total.precision.blendedBlockCount ? (double)total.precision.errorSum / total.precision.blendedBlockCount : 0.0,
+			total.precision.transparentBlockCount);
+	}
+
+	free(textureExport);
+	return total.failedCount == 0 ? 0 : -1;
+}
+
+//<directory>/<name>.<extension>, with the disc path in name flattened so every export lands directly in directory
+static void getExportPath(const char* directory, const char* name, const char* extension, char* _Out_ path, size_t pathSize)
+{
+	int length = snprintf(path, pathSize, "%s/%s.%s", directory, name[0] == '/' ? name + 1 : name, extension);
+	for (int c = (int)strlen(directory) + 1; c < length && c < (int)pathSize; c++)
+		if (path[c] == '/' || path[c] == '\\' || path[c] == ':')
+			path[c] = '_';
+}
+
+/*
+* image export: every texture of every model plus every .bti file, loose or archived, is decoded and written as QOI (or PNG) to <directory>
+*/
+struct imageExportThread
+{
+	uint8_t* decompressionBuffer;
+	uint8_t* pixels;
+	size_t pixelCapacity;
+	struct imageEncoder encoder;
+	uint32_t exportedCount;
+	uint32_t failedCount;
+	uint64_t pixelCount;
+	uint64_t bytesWritten;
+	double decodeTime;
+	double encodeTime;
+};
+
+struct imageExportContext
+{
+	struct imageExportThread threads[MAX_THREADS];
+	const char* directory;
+	bool png;
+};
+
+static void exportImage(struct imageExportContext* imageExport, struct imageExportThread* thread, const struct btiTexture* texture, const char* name)
+{
+	size_t pixelSize = getDecodedTextureSize(texture->width, texture->height);
+	if (pixelSize > thread->pixelCapacity)
+	{
+		size_t capacity = max(pixelSize, thread->pixelCapacity * 2);
+		uint8_t* pixels = trackedRealloc(MEMORY_PIXELS, thread->pixels, capacity);
+		if (pixels == nullptr)
+			return;
+		thread->pixels = pixels;
+		thread->pixelCapacity = capacity;
+	}
+
+	struct decodedImage image;
+	double start = getTimeSeconds();
+	decodeBTITexture(texture, thread->pixels, &image);
+	double decodeEnd = getTimeSeconds();
+	size_t size = imageExport->png ? encodePNG(&image, &thread->encoder, false) : encodeQOIWithEncoder(&image, &thread->encoder);
+	thread->decodeTime += decodeEnd - start;
+	thread->encodeTime += getTimeSeconds() - decodeEnd;
+	if (size == 0)
+	{
+		thread->failedCount++;
+		return;
+	}
+
+	char outputPath[MAX_PATH];
+	getExportPath(imageExport->directory, name, imageExport->png ? "png" : "qoi", outputPath, sizeof(outputPath));
+
+	HANDLE file = CreateFileA(outputPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		printf("unable to export %s\n", outputPath);
+		thread->failedCount++;
+		return;
+	}
+	bool written = writeFileData(file, thread->encoder.output, size);
+	CloseHandle(file);
+	if (!written)
+	{
+		thread->failedCount++;
+		return;
+	}
+
+	thread->exportedCount++;
+	thread->pixelCount += image.pixelCount;
+	thread->bytesWritten += size;
+}
+
+static void exportImagesJob(int fileIndex, int threadIndex, void* context)
+{
+	struct imageExportContext* imageExport = context;
+	struct imageExportThread* thread = &imageExport->threads[threadIndex];
+
+	char path[256];
+	getGameFilePath(fileIndex, path, sizeof(path));
+
+	struct btiTexture texture;
+	if (gameFileHasExtension(fileIndex, ".bti"))
+	{
+		if (loadBTITexture(gameFileList[fileIndex].filePtr, gameFileList[fileIndex].fileSize, &texture))
+			exportImage(imageExport, thread, &texture, path);
+		else
+			thread->failedCount++;
+		return;
+	}
+
+	struct archiveMember members[1024];
+	int memberCount = listGameFileMembers(fileIndex, &thread->decompressionBuffer, members, countof(members));
+	for (int i = 0; i < memberCount; i++)
+	{
+		char name[512];
+		if (nameHasExtension(members[i].name, ".bti"))
+		{
+			snprintf(name, sizeof(name), "%s_%s", path, members[i].name);
+			if (loadBTITexture(members[i].data, members[i].size, &texture))
+				exportImage(imageExport, thread, &texture, name);
+			else
+				thread->failedCount++;
+			continue;
+		}
+
+		if (!isJ3DModel(members[i].data, members[i].size))
+			continue;
+
+		const struct TEX1* textures = (const struct TEX1*)findJ3DChunk(members[i].data, members[i].size, "TEX1");
+		if (textures == nullptr)
+			continue;
+
+		const void* names = getJ3DNameTable(textures, SwapEndian(textures->stringTableOffset));
+		for (int texNum = 0; texNum < SwapEndian(textures->textureCount); texNum++)
+		{
+			snprintf(name, sizeof(name), "%s_%s_%s", path, members[i].name, getJ3DName(names, texNum));
+			if (loadTEX1Texture(textures, texNum, &texture))
+				exportImage(imageExport, thread, &texture, name);
+			else
+				thread->failedCount++;
+		}
+	}
+}
+
+int runImageExport(const char* directory, bool png)
+{
+	CreateDirectoryA(directory, nullptr);
+	initDeflateTables();
+
+	struct imageExportContext* imageExport = calloc(1, sizeof(struct imageExportContext));
+	imageExport->directory = directory;
+	imageExport->png = png;
+
+	double start = getTimeSeconds();
+	runParallel(gameFileCount, exportImagesJob, imageExport);
+	double wallTime = getTimeSeconds() - start;
+
+	struct imageExportThread total = { 0 };
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		struct imageExportThread* thread = &imageExport->threads[i];
+		total.exportedCount += thread->exportedCount;
+		total.failedCount += thread->failedCount;
+		total.pixelCount += thread->pixelCount;
+		total.bytesWritten += thread->bytesWritten;
+		total.decodeTime += thread->decodeTime;
+		total.encodeTime += thread->encodeTime;
+		trackedFree(thread->decompressionBuffer);
+		trackedFree(thread->pixels);
+		freeImageEncoder(&thread->encoder);
+	}
+
+	printf("exported: %u images as %s (%llu pixels, %llu bytes written), failed: %u\n", total.exportedCount, png ? "png" : "qoi", total.pixelCount, total.bytesWritten, total.failedCount);
+	printf("wall: %.3f ms on %i threads, %.0f images/s\n", wallTime * 1000.0, getThreadCount(), total.exportedCount / max(wallTime, 1e-9));
+	if (total.encodeTime > 0.0)
+		printf("decode: %.3f ms, encode: %.3f ms (summed over threads), %.1f MB/s of rgba per thread\n", total.decodeTime * 1000.0, total.encodeTime * 1000.0, total.pixelCount * 4 / total.encodeTime / (1024.0 * 1024.0));
+
+	free(imageExport);
+	return total.failedCount == 0 ? 0 : -1;
+}
+
+/*
+* screen and effect textures: every .blo layout and .jpc particle file, loose or archived, is parsed for the textures it uses
+* and the screens are listed by texture memory. with a directory those textures are exported like -exporttextures, once per
+* archive, and nothing else in the archives is decoded
+*/
+#define SCREEN_WORKSPACE_SIZE (1024 * 1024 * 4)
+#define SCREEN_RECORD_MAX 4096
+#define SCREEN_RECORDS_LISTED 20
+
+struct screenRecord
+{
+	char path[320];
+	uint32_t textureMemorySize;
+	uint32_t textureCount;
+	uint32_t missingTextureCount;
+	uint32_t paneCount;
+	uint16_t width;
+	uint16_t height;
+};
+
+struct screenReportThread
+{
+	uint8_t* decompressionBuffer;
+	void* workspace;
+	double parseTime;
+	uint64_t parsedBytes;
+	uint32_t failedCount;
+	uint32_t screenCount;
+	uint32_t paneCount;
+	uint32_t maxDepth;
+	uint32_t screenTextureCount;
+	uint32_t missingTextureCount;
+	uint64_t screenTextureMemory;
+	uint32_t effectCount;
+	uint32_t emitterCount;
+	uint32_t effectTextureCount;
+	uint32_t textureSlotCount;
+	uint32_t unresolvedSlotCount;
+	uint64_t effectTextureMemory;
+};
+
+struct screenReportContext
+{
+	struct screenReportThread threads[MAX_THREADS];
+	struct imageExportContext* imageExport;//nullptr without a directory
+	struct screenRecord* screens;
+	volatile LONG screenCount;
+};
+
+static int compareScreenRecords(const void* a, const void* b)
+{
+	const struct screenRecord* screenA = a;
+	const struct screenRecord* screenB = b;
+	return screenA->textureMemorySize < screenB->textureMemorySize ? 1 : screenA->textureMemorySize > screenB->textureMemorySize ? -1 : 0;
+}
+
+static void reportScreensJob(int fileIndex, int threadIndex, void* context)
+{
+	struct screenReportContext* report = context;
+	struct screenReportThread* thread = &report->threads[threadIndex];
+
+	if (!gameFileHasExtension(fileIndex, ".szs") && !gameFileHasExtension(fileIndex, ".arc") &&
+		!gameFileHasExtension(fileIndex, ".blo") && !gameFileHasExtension(fileIndex, ".jpc"))
+		return;
+	if (thread->workspace == nullptr)
+		thread->workspace = malloc(SCREEN_WORKSPACE_SIZE);
+
+	char path[256];
+	getGameFilePath(fileIndex, path, sizeof(path));
+
+	struct archiveMember members[1024];
+	bool exported[countof(members)] = { 0 };
+	int memberCount = listGameFileMembers(fileIndex, &thread->decompressionBuffer, members, countof(members));
+	for (int i = 0; i < memberCount; i++)
+	{
+		bool screen = isBLOFile(members[i].data, members[i].size);
+		if (!screen && !isJPCFile(members[i].data, members[i].size))
+			continue;
+
+		double start = getTimeSeconds();
+		struct screenLayout layout;
+		struct jpcFile jpc;
+		bool parsed = screen ? parseBLO(members[i].data, members[i].size, thread->workspace, SCREEN_WORKSPACE_SIZE, &layout) :
+			parseJPC(members[i].data, members[i].size, thread->workspace, SCREEN_WORKSPACE_SIZE, &jpc);
+		if (parsed && screen)
+			resolveScreenTextures(&layout, members, memberCount);
+		thread->parseTime += getTimeSeconds() - start;
+		thread->parsedBytes += members[i].size;
+
+		if (!parsed)
+		{
+			printf("unable to parse %s:%s\n", path, members[i].name);
+			thread->failedCount++;
+			continue;
+		}
+
+		char name[512];
+		if (screen)
+		{
+			thread->screenCount++;
+			thread->paneCount += layout.paneCount;
+			thread->maxDepth = max(thread->maxDepth, layout.maxDepth);
+			thread->screenTextureCount += layout.textureCount;
+			thread->missingTextureCount += layout.missingTextureCount;
+			thread->screenTextureMemory += layout.textureMemorySize;
+
+			LONG slot = InterlockedIncrement(&report->screenCount) - 1;
+			if (slot < SCREEN_RECORD_MAX)
+			{
+				struct screenRecord* record = &report->screens[slot];
+				snprintf(record->path, sizeof(record->path), "%s:%s", path, members[i].name);
+				record->textureMemorySize = layout.textureMemorySize;
+				record->textureCount = layout.textureCount;
+				record->missingTextureCount = layout.missingTextureCount;
+				record->paneCount = layout.paneCount;
+				record->width = layout.width;
+				record->height = layout.height;
+			}
+
+			//the same names as -exporttextures gives archived .bti files
+			for (uint32_t t = 0; t < layout.textureCount && report->imageExport != nullptr; t++)
+			{
+				int member = layout.textures[t].member;
+				struct btiTexture texture;
+				if (member < 0 || exported[member] || !loadBTITexture(members[member].data, members[member].size, &texture))
+					continue;
+				exported[member] = true;
+				snprintf(name, sizeof(name), "%s_%s", path, members[member].name);
+				exportImage(report->imageExport, &report->imageExport->threads[threadIndex], &texture, name);
+			}
+		}
+		else
+		{
+			thread->effectCount++;
+			thread->emitterCount += jpc.emitterCount;
+			thread->effectTextureCount += jpc.textureCount;
+			thread->textureSlotCount += jpc.textureSlotCount;
+			thread->unresolvedSlotCount += jpc.unresolvedSlotCount;
+			for (uint32_t t = 0; t < jpc.textureCount; t++)
+			{
+				const struct jpcTexture* texture = &jpc.textures[t];
+				if (texture->texture.data == nullptr)
+				{
+					thread->failedCount++;
+					continue;
+				}
+				thread->effectTextureMemory += getTextureMemorySize(&texture->texture);
+				if (report->imageExport == nullptr)
+					continue;
+				snprintf(name, sizeof(name), "%s_%s_%s", path, members[i].name, texture->name);
+				exportImage(report->imageExport, &report->imageExport->threads[threadIndex], &texture->texture, name);
+			}
+		}
+	}
+}
+
+int runScreenReport(const char* directory)
+{
+	struct screenReportContext* report = calloc(1, sizeof(struct screenReportContext));
+	report->screens = malloc(sizeof(struct screenRecord) * SCREEN_RECORD_MAX);
+	if (directory != nullptr)
+	{
+		CreateDirectoryA(directory, nullptr);
+		initDeflateTables();
+		report->imageExport = calloc(1, sizeof(struct imageExportContext));
+		report->imageExport->directory = directory;
+	}
+
+	double start = getTimeSeconds();
+	runParallel(gameFileCount, reportScreensJob, report);
+	double wallTime = getTimeSeconds() - start;
+
+	struct screenReportThread total = { 0 };
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		struct screenReportThread* thread = &report->threads[i];
+		total.parseTime += thread->parseTime;
+		total.parsedBytes += thread->parsedBytes;
+		total.failedCount += thread->failedCount;
+		total.screenCount += thread->screenCount;
+		total.paneCount += thread->paneCount;
+		total.maxDepth = max(total.maxDepth, thread->maxDepth);
+		total.screenTextureCount += thread->screenTextureCount;
+		total.missingTextureCount += thread->missingTextureCount;
+		total.screenTextureMemory += thread->screenTextureMemory;
+		total.effectCount += thread->effectCount;
+		total.emitterCount += thread->emitterCount;
+		total.effectTextureCount += thread->effectTextureCount;
+		total.textureSlotCount += thread->textureSlotCount;
+		total.unresolvedSlotCount += thread->unresolvedSlotCount;
+		total.effectTextureMemory += thread->effectTextureMemory;
+		trackedFree(thread->decompressionBuffer);
+		free(thread->workspace);
+	}
+
+	printf("screens: %u, panes: %u (nested %u deep), textures: %u (%llu bytes), missing from their archive: %u\n",
+		total.screenCount, total.paneCount, total.maxDepth, total.screenTextureCount, total.screenTextureMemory, total.missingTextureCount);
+	printf("effects: %u, emitters: %u, textures: %u (%llu bytes), texture slots: %u, unresolved: %u\n",
+		total.effectCount, total.emitterCount, total.effectTextureCount, total.effectTextureMemory, total.textureSlotCount, total.unresolvedSlotCount);
+	printf("parsing: %.3f ms for %llu bytes (summed over threads), wall: %.3f ms on %i threads, failed: %u\n",
+		total.parseTime * 1000.0, total.parsedBytes, wallTime * 1000.0, getThreadCount(), total.failedCount);
+
+	uint32_t recordCount = min((uint32_t)report->screenCount, SCREEN_RECORD_MAX);
+	qsort(report->screens, recordCount, sizeof(struct screenRecord), compareScreenRecords);
+	if (recordCount > 0)
+		printf("largest screen texture budgets:\n");
+	for (uint32_t i = 0; i < recordCount && i < SCREEN_RECORDS_LISTED; i++)
+	{
+		const struct screenRecord* record = &report->screens[i];
+		printf("\t%u bytes, %u textures (%u missing), %u panes, %u x %u: %s\n",
+			record->textureMemorySize, record->textureCount, record->missingTextureCount, record->paneCount, record->width, record->height, record->path);
+	}
+
+	if (report->imageExport != nullptr)
+	{
+		struct imageExportThread exportTotal = { 0 };
+		for (int i = 0; i < MAX_THREADS; i++)
+		{
+			struct imageExportThread* thread = &report->imageExport->threads[i];
+			exportTotal.exportedCount += thread->exportedCount;
+			exportTotal.failedCount += thread->failedCount;
+			exportTotal.bytesWritten += thread->bytesWritten;
+			trackedFree(thread->pixels);
+			freeImageEncoder(&thread->encoder);
+		}
+		printf("exported: %u images as qoi (%llu bytes written), failed: %u\n", exportTotal.exportedCount, exportTotal.bytesWritten, exportTotal.failedCount);
+		total.failedCount += exportTotal.failedCount;
+		free(report->imageExport);
+	}
+
+	free(report->screens);
+	free(report);
+	return total.failedCount == 0 ? 0 : -1;
+}
+
+/*
+* memory report: what every file takes once it's opened. archives are decompressed and every texture, model, text and
+* message file in them is measured: decoded pixels (the base level as rgba, what the window decodes), the model workspace
+* parseJ3DModel uses and the text and message indices. the largest files are listed with the buffer sizes they need,
+* then every memory tag's current and peak bytes
+*/
+#define MEMORY_REPORT_TEXT_WORKSPACE_SIZE (1024 * 1024 * 8)
+
+struct memoryRecord
+{
+	int fileIndex;
+	uint32_t archiveSize;//decompressed, 0 if the file isn't yaz0
+	uint32_t textureCount;
+	uint32_t largestTextureBytes;
+	uint64_t pixelBytes;
+	uint32_t modelWorkspaceBytes;//the largest model's
+	uint32_t textIndexBytes;
+	uint64_t totalBytes;
+};
+
+struct memoryReportThread
+{
+	uint8_t* decompressionBuffer;
+	void* modelWorkspace;
+	void* textWorkspace;
+	uint32_t failedCount;
+};
+
+struct memoryReportContext
+{
+	struct memoryReportThread threads[MAX_THREADS];
+	struct memoryRecord* files;
+};
+
+static int compareMemoryRecords(const void* a, const void* b)
+{
+	const struct memoryRecord* recordA = a;
+	const struct memoryRecord* recordB = b;
+	return recordA->totalBytes < recordB->totalBytes ? 1 : recordA->totalBytes > recordB->totalBytes ? -1 : 0;
+}
+
+static void addTextureMemory(struct memoryRecord* record, const struct btiTexture* texture)
+{
+	uint32_t size = (uint32_t)getDecodedTextureSize(texture->width, texture->height);
+	record->textureCount++;
+	record->pixelBytes += size;
+	record->largestTextureBytes = max(record->largestTextureBytes, size);
+}
+
+static uint32_t getTextIndexSize(const struct parsedTextFile* parsed)
+{
+	return parsed->tokenCount * sizeof(struct textToken) + parsed->objectCount * sizeof(struct textObject) +
+		parsed->waypointCount * sizeof(struct textWaypoint) + parsed->linkCount * sizeof(uint16_t) +
+		parsed->parameterCount * sizeof(struct textParameter) + parsed->positionCount * sizeof(float) * 3;
+}
+
+static void measureMemoryJob(int fileIndex, int threadIndex, void* context)
+{
+	struct memoryReportContext* report = context;
+	struct memoryReportThread* thread = &report->threads[threadIndex];
+	struct memoryRecord* record = &report->files[fileIndex];
+
+	if (thread->modelWorkspace == nullptr)
+	{
+		thread->modelWorkspace = trackedAlloc(MEMORY_MODELS, MODEL_WORKSPACE_SIZE);
+		thread->textWorkspace = trackedAlloc(MEMORY_TEXT, MEMORY_REPORT_TEXT_WORKSPACE_SIZE);
+	}
+
+	record->fileIndex = fileIndex;
+	if (isYaz0(gameFileList[fileIndex].filePtr, gameFileList[fileIndex].fileSize))
+		record->archiveSize = getYaz0UncompressedSize(gameFileList[fileIndex].filePtr);
+
+	struct archiveMember members[1024];
+	int memberCount = listGameFileMembers(fileIndex, &thread->decompressionBuffer, members, countof(members));
+	for (int i = 0; i < memberCount; i++)
+	{
+		const struct archiveMember* member = &members[i];
+		struct btiTexture texture;
+		if (nameHasExtension(member->name, ".bti"))
+		{
+			if (loadBTITexture(member->data, member->size, &texture))
+				addTextureMemory(record, &texture);
+		}
+		else if (isJ3DModel(member->data, member->size))
+		{
+			struct j3dModel model;
+			if (!parseJ3DModel(member->data, member->size, thread->modelWorkspace, MODEL_WORKSPACE_SIZE, &model))
+			{
+				thread->failedCount++;
+				continue;
+			}
+			record->modelWorkspaceBytes = max(record->modelWorkspaceBytes, (uint32_t)model.workspaceUsed);
+			for (uint32_t t = 0; model.textures != nullptr && t < (uint16_t)SwapEndian(model.textures->textureCount); t++)
+				if (loadTEX1Texture(model.textures, t, &texture))
+					addTextureMemory(record, &texture);
+		}
+		else if (isJPCFile(member->data, member->size))
+		{
+			struct jpcFile jpc;
+			if (parseJPC(member->data, member->size, thread->modelWorkspace, MODEL_WORKSPACE_SIZE, &jpc))
+				for (uint32_t t = 0; t < jpc.textureCount; t++)
+					if (jpc.textures[t].texture.data != nullptr)
+						addTextureMemory(record, &jpc.textures[t].texture);
+		}
+		else if (isBMGFile(member->data, member->size))
+		{
+			struct bmgFile bmg;
+			if (parseBMGFile(member->data, member->size, thread->textWorkspace, MEMORY_REPORT_TEXT_WORKSPACE_SIZE, &bmg))
+				record->textIndexBytes += bmg.messageCount * sizeof(struct bmgMessage);
+		}
+		else if (nameHasExtension(member->name, ".txt") || nameHasExtension(member->name, ".ini"))
+		{
+			struct parsedTextFile parsed;
+			if (parseTextFile(member->data, member->size, member->name, thread->textWorkspace, MEMORY_REPORT_TEXT_WORKSPACE_SIZE, &parsed))
+				record->textIndexBytes += getTextIndexSize(&parsed);
+		}
+	}
+	record->totalBytes = record->archiveSize + record->pixelBytes + record->modelWorkspaceBytes + record->textIndexBytes;
+}
+
+//what each tag has allocated now and at most since the start
+void printMemoryUsage()
+{
+	printf("memory by tag: current, peak, allocations\n");
+	for (int tag = 0; tag < MEMORY_TAG_COUNT; tag++)
+		printf("\t%s: %lld, %lld, %lld\n", memoryTagNames[tag], memoryUsage[tag].currentBytes, memoryUsage[tag].peakBytes, memoryUsage[tag].allocationCount);
+}
+
+int runMemoryReport(int listCount)
+{
+	struct memoryReportContext* report = calloc(1, sizeof(struct memoryReportContext));
+	report->files = calloc(max(gameFileCount, 1), sizeof(struct memoryRecord));
+
+	double start = getTimeSeconds();
+	runParallel(gameFileCount, measureMemoryJob, report);
+	double wallTime = getTimeSeconds() - start;
+
+	uint32_t failedCount = 0;
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		struct memoryReportThread* thread = &report->threads[i];
+		failedCount += thread->failedCount;
+		trackedFree(thread->decompressionBuffer);
+		trackedFree(thread->modelWorkspace);
+		trackedFree(thread->textWorkspace);
+	}
+
+	//the largest of each is what a buffer holding any one file has to fit
+	uint64_t archiveBytes = 0;
+	uint64_t pixelBytes = 0;
+	uint64_t textIndexBytes = 0;
+	uint32_t textureCount = 0;
+	struct memoryRecord largest = { 0 };
+	for (int f = 0; f < gameFileCount; f++)
+	{
+		const struct memoryRecord* record = &report->files[f];
+		archiveBytes += record->archiveSize;
+		pixelBytes += record->pixelBytes;
+		textIndexBytes += record->textIndexBytes;
+		textureCount += record->textureCount;
+		largest.archiveSize = max(largest.archiveSize, record->archiveSize);
+		largest.largestTextureBytes = max(largest.largestTextureBytes, record->largestTextureBytes);
+		largest.pixelBytes = max(largest.pixelBytes, record->pixelBytes);
+		largest.modelWorkspaceBytes = max(largest.modelWorkspaceBytes, record->modelWorkspaceBytes);
+		largest.textIndexBytes = max(largest.textIndexBytes, record->textIndexBytes);
+	}
+
+	printf("files: %i, decompressed archives: %llu bytes, decoded textures: %llu bytes in %u textures, text and message indices: %llu bytes\n",
+		gameFileCount, archiveBytes, pixelBytes, textureCount, textIndexBytes);
+	printf("measured in %.3f ms on %i threads, failed: %u\n", wallTime * 1000.0, getThreadCount(), failedCount);
+
+	qsort(report->files, gameFileCount, sizeof(struct memoryRecord), compareMemoryRecords);
+	if (gameFileCount > 0 && listCount > 0)
+		printf("largest files by decoded size:\n");
+	for (int i = 0; i < gameFileCount && i < listCount && report->files[i].totalBytes > 0; i++)
+	{
+		const struct memoryRecord* record = &report->files[i];
+		char path[256];
+		getGameFilePath(record->fileIndex, path, sizeof(path));
+		printf("\t%llu bytes: %s (archive %u, %u textures %llu, model workspace %u, text %u)\n",
+			record->totalBytes, path, record->archiveSize, record->textureCount, record->pixelBytes, record->modelWorkspaceBytes, record->textIndexBytes);
+	}
+
+	//the window decodes one file at a time into these
+	printf("largest archive: %u bytes, largest texture: %u bytes decoded\n", largest.archiveSize, largest.largestTextureBytes);
+	printf("largest file's textures: %llu bytes of the %u byte decoded asset buffer%s\n",
+		largest.pixelBytes, DECODED_ASSET_DATA_SIZE, largest.pixelBytes > DECODED_ASSET_DATA_SIZE ? ", some don't fit" : "");
+	printf("largest model workspace: %u bytes of %u\n", largest.modelWorkspaceBytes, MODEL_WORKSPACE_SIZE);
+	printf("largest text or message index: %u bytes\n", largest.textIndexBytes);
+	printf("file index: %u entries, %llu bytes\n", gameFileCapacity, (uint64_t)gameFileCapacity * sizeof(struct gameFileInTree));
+	printMemoryUsage();
+
+	free(report->files);
+	free(report);
+	return failedCount == 0 ? 0 : -1;
+}
+
+/*
+* glTF export: every model is written as a .glb to <directory>.
+* the BIN chunk holds the model's vertex buffer, its index buffer, then the textures as png. the vertex and index arrays go
+* to the file straight from the parsed model (the accessors read struct j3dVertex interleaved), only the json and the pngs are built.
+* vertices are already skinned to the bind pose so the mesh isn't skinned, the joints are exported as a node tree next to it.
+* GX treats clockwise triangles as front facing and glTF counter-clockwise, so the indices are written with every triangle's
+* winding flipped and back culled (GX cull mode 2) materials stay single sided. glTF can't cull front faces, so cull mode 0
+* and 1 materials are double sided. materials that cull everything are left out.
+*/
+#define GLTF_ARRAY_BUFFER 34962
+#define GLTF_ELEMENT_ARRAY_BUFFER 34963
+#define GLTF_UNSIGNED_BYTE 5121
+#define GLTF_UNSIGNED_INT 5125
+#define GLTF_FLOAT 5126
+
+//grown on demand, never shrunk
+//failed is set when the text can't grow, it then keeps what fit and further appends are dropped
+struct textBuilder
+{
+	char* text;
+	size_t length;
+	size_t capacity;
+	bool failed;
+};
+
+static void appendText(struct textBuilder* builder, const char* format, ...)
+{
+	while (!builder->failed)
+	{
+		va_list arguments;
+		va_start(arguments, format);
+		int written = builder->text ? vsnprintf(builder->text + builder->length, builder->capacity - builder->length, format, arguments) : -1;
+		va_end(arguments);
+
+		if (written >= 0 && (size_t)written < builder->capacity - builder->length)
+		{
+			builder->length += written;
+			return;
+		}
+
+		size_t capacity = max(builder->capacity * 2, 4096);
+		char* text = realloc(builder->text, capacity);
+		if (text == nullptr)
+		{
+			builder->failed = true;
+			return;
+		}
+		builder->text = text;
+		builder->capacity = capacity;
+	}
+}
+
+//J3D names are ascii, anything else is escaped as latin-1 so the json stays valid utf-8
+static void appendJsonString(struct textBuilder* builder, const char* text)
+{
+	appendText(builder, "\"");
+	for (const uint8_t* c = (const uint8_t*)text; *c != 0; c++)
+	{
+		if (*c == '"' || *c == '\\')
+			appendText(builder, "\\%c", *c);
+		else if (*c < 0x20 || *c >= 0x80)
+			appendText(builder, "\\u%04x", *c);
+		else
+			appendText(builder, "%c", *c);
+	}
+	appendText(builder, "\"");
+}
+
+static inline float getFiniteFloat(float value)
+{
+	return isfinite(value) ? value : 0.0f;
+}
+
+struct gltfImage
+{
+	uint32_t offset;//into the images blob
+	uint32_t size;
+	int32_t textureIndex;//in the glTF file, -1 if the texture couldn't be decoded
+	uint8_t wrapS;
+	uint8_t wrapT;
+	bool alpha;
+};
+
+struct gltfExportThread
+{
+	uint8_t* decompressionBuffer;
+	void* workspace;
+	uint8_t* pixels;
+	size_t pixelCapacity;
+	struct imageEncoder encoder;
+	uint8_t* images;
+	size_t imageCapacity;
+	struct textBuilder json;
+
+	uint32_t exportedCount;
+	uint32_t failedCount;
+	uint64_t vertexCount;
+	uint64_t triangleCount;
+	uint64_t textureCount;
+	uint64_t bytesWritten;
+	size_t peakMemory;
+	uint64_t memorySum;
+	double parseTime;
+	double textureTime;
+	double writeTime;
+};
+
+struct gltfExportContext
+{
+	struct gltfExportThread threads[MAX_THREADS];
+	const char* directory;
+};
+
+//decodes every TEX1 texture to png in thread->images, each padded to 4 bytes. the records go in the free part of the workspace
+static uint32_t encodeGLTFImages(const struct j3dModel* model, struct gltfExportThread* thread, struct workspaceAllocator* allocator, struct gltfImage** _Out_ images, size_t* _Out_ imagesSize, size_t* _Out_ largestPixelBuffer)
+{
+	uint32_t textureCount = model->textures ? SwapEndian(model->textures->textureCount) : 0;
+	*images = workspaceAllocArray(allocator, struct gltfImage, textureCount);
+	*imagesSize = 0;
+	*largestPixelBuffer = 0;
+	if (allocator->failed)
+		return 0;
+
+	int32_t validCount = 0;
+	for (uint32_t t = 0; t < textureCount; t++)
+	{
+		struct gltfImage* image = &(*images)[t];
+		image->textureIndex = -1;
+
+		struct btiTexture texture;
+		if (!loadTEX1Texture(model->textures, t, &texture))
+			continue;
+
+		size_t pixelSize = getDecodedTextureSize(texture.width, texture.height);
+		if (pixelSize > thread->pixelCapacity)
+		{
+			size_t capacity = max(pixelSize, thread->pixelCapacity * 2);
+			uint8_t* pixels = trackedRealloc(MEMORY_PIXELS, thread->pixels, capacity);
+			if (pixels == nullptr)
+				continue;
+			thread->pixels = pixels;
+			thread->pixelCapacity = capacity;
+		}
+		*largestPixelBuffer = max(*largestPixelBuffer, pixelSize);
+
+		struct decodedImage decoded;
+		decodeBTITexture(&texture, thread->pixels, &decoded);
+		size_t size = encodePNG(&decoded, &thread->encoder, false);
+		if (size == 0)
+			continue;
+		size_t paddedSize = (size + 3) & ~(size_t)3;
+		if (*imagesSize + paddedSize > thread->imageCapacity)
+		{
+			size_t capacity = max(*imagesSize + paddedSize, thread->imageCapacity * 2);
+			uint8_t* grown = realloc(thread->images, capacity);
+			if (grown == nullptr)
+				continue;
+			thread->images = grown;
+			thread->imageCapacity = capacity;
+		}
+		memcpy(thread->images + *imagesSize, thread->encoder.output, size);
+		memset(thread->images + *imagesSize + size, 0, paddedSize - size);
+
+		//GX wrap modes are clamp, repeat and mirror, anything else is read as repeat
+		image->offset = (uint32_t)*imagesSize;
+		image->size = (uint32_t)size;
+		image->textureIndex = validCount++;
+		image->wrapS = (uint8_t)texture.header->wrapS <= 2 ? texture.header->wrapS : 1;
+		image->wrapT = (uint8_t)texture.header->wrapT <= 2 ? texture.header->wrapT : 1;
+		image->alpha = texture.header->alphaEnabled;
+		*imagesSize += paddedSize;
+	}
+	return textureCount;
+}
+
+//the glTF json for a model whose BIN chunk is vertices, indices, then images
+static void buildGLTFJson(const struct j3dModel* model, const char* name, const struct gltfImage* images, uint32_t imageCount, size_t imagesSize, struct textBuilder* json)
+{
+	static const uint16_t wrapModes[] = { 33071, 10497, 33648 };//clamp to edge, repeat, mirrored repeat
+
+	bool hasMesh = model->vertexCount != 0 && model->indexCount != 0;
+	size_t vertexBytes = hasMesh ? (size_t)model->vertexCount * sizeof(struct j3dVertex) : 0;
+	size_t indexBytes = hasMesh ? (size_t)model->indexCount * sizeof(uint32_t) : 0;
+	size_t binSize = vertexBytes + indexBytes + imagesSize;
+
+	json->length = 0;
+	json->failed = false;
+	appendText(json, "{\"asset\":{\"version\":\"2.0\",\"generator\":\"Pikmin2LevelViewer\"}");
+
+	if (binSize != 0)
+	{
+		appendText(json, ",\"buffers\":[{\"byteLength\":%zu}],\"bufferViews\":[", binSize);
+		uint32_t view = 0;
+		if (hasMesh)
+		{
+			appendText(json, "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu,\"byteStride\":%zu,\"target\":%u},", vertexBytes, sizeof(struct j3dVertex), GLTF_ARRAY_BUFFER);
+			appendText(json, "{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu,\"target\":%u},", vertexBytes, indexBytes, GLTF_ELEMENT_ARRAY_BUFFER);
+			view = 2;
+		}
+		for (uint32_t i = 0; i < imageCount; i++)
+			if (images[i].textureIndex >= 0)
+				appendText(json, "{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%u},", vertexBytes + indexBytes + images[i].offset, images[i].size);
+		json->length--;//trailing comma
+		appendText(json, "]");
+
+		bool hasImages = false;
+		for (uint32_t i = 0; i < imageCount; i++)
+			hasImages |= images[i].textureIndex >= 0;
+		if (hasImages)
+		{
+			const void* names = getJ3DNameTable(model->textures, SwapEndian(model->textures->stringTableOffset));
+			appendText(json, ",\"images\":[");
+			for (uint32_t i = 0; i < imageCount; i++)
+			{
+				if (images[i].textureIndex < 0)
+					continue;
+				appendText(json, "{\"bufferView\":%u,\"mimeType\":\"image/png\",\"name\":", view + images[i].textureIndex);
+				appendJsonString(json, getJ3DName(names, i));
+				appendText(json, "},");
+			}
+			json->length--;
+			appendText(json, "],\"samplers\":[");
+			for (uint32_t i = 0; i < imageCount; i++)
+				if (images[i].textureIndex >= 0)
+					appendText(json, "{\"wrapS\":%u,\"wrapT\":%u},", wrapModes[images[i].wrapS], wrapModes[images[i].wrapT]);
+			json->length--;
+			appendText(json, "],\"textures\":[");
+			for (uint32_t i = 0; i < imageCount; i++)
+				if (images[i].textureIndex >= 0)
+					appendText(json, "{\"source\":%i,\"sampler\":%i},", images[i].textureIndex, images[i].textureIndex);
+			json->length--;
+			appendText(json, "]");
+		}
+	}
+
+	if (model->materialCount != 0)
+	{
+		appendText(json, ",\"materials\":[");
+		for (uint32_t m = 0; m < model->materialCount; m++)
+		{
+			uint32_t color = model->materialColors[m];
+			appendText(json, "{\"name\":");
+			appendJsonString(json, model->materialNames[m]);
+			//writeGLTFIndices turns the winding around, so back culling is glTF's single sided default
+			if (model->materialCullModes[m] == 0 || model->materialCullModes[m] == 1)
+				appendText(json, ",\"doubleSided\":true");
+			appendText(json, ",\"pbrMetallicRoughness\":{\"baseColorFactor\":[%.6g,%.6g,%.6g,%.6g],\"metallicFactor\":0",
+				(color >> 24) / 255.0, ((color >> 16) & 0xFF) / 255.0, ((color >> 8) & 0xFF) / 255.0, (color & 0xFF) / 255.0);
+
+			int16_t texture = model->materialTextures[m * J3D_MAX_TEXTURES_PER_MATERIAL];
+			bool textured = texture >= 0 && (uint32_t)texture < imageCount && images[texture].textureIndex >= 0;
+			if (textured)
+				appendText(json, ",\"baseColorTexture\":{\"index\":%i}", images[texture].textureIndex);
+			appendText(json, "}");
+			//the game alpha tests rather than blends almost everything
+			if (textured && images[texture].alpha)
+				appendText(json, ",\"alphaMode\":\"MASK\"");
+			appendText(json, "},");
+		}
+		json->length--;
+		appendText(json, "]");
+	}
+
+	uint32_t primitiveCount = 0;
+	if (hasMesh)
+	{
+		float boundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		bool hasNormals = true;
+		for (uint32_t i = 0; i < model->vertexCount; i++)
+		{
+			const struct j3dVertex* vertex = &model->vertices[i];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				boundsMin[axis] = min(boundsMin[axis], getFiniteFloat(vertex->position[axis]));
+				boundsMax[axis] = max(boundsMax[axis], getFiniteFloat(vertex->position[axis]));
+			}
+			//models without normals leave them zero, glTF wants unit normals or none
+			hasNormals &= vertex->normal[0] != 0.0f || vertex->normal[1] != 0.0f || vertex->normal[2] != 0.0f;
+		}
+
+		appendText(json, ",\"accessors\":[");
+		appendText(json, "{\"bufferView\":0,\"byteOffset\":%zu,\"componentType\":%u,\"count\":%u,\"type\":\"VEC3\",\"min\":[%.9g,%.9g,%.9g],\"max\":[%.9g,%.9g,%.9g]},",
+			offsetof(struct j3dVertex, position), GLTF_FLOAT, model->vertexCount, boundsMin[0], boundsMin[1], boundsMin[2], boundsMax[0], boundsMax[1], boundsMax[2]);
+		appendText(json, "{\"bufferView\":0,\"byteOffset\":%zu,\"componentType\":%u,\"count\":%u,\"type\":\"VEC3\"},", offsetof(struct j3dVertex, normal), GLTF_FLOAT, model->vertexCount);
+		appendText(json, "{\"bufferView\":0,\"byteOffset\":%zu,\"componentType\":%u,\"normalized\":true,\"count\":%u,\"type\":\"VEC4\"},", offsetof(struct j3dVertex, color), GLTF_UNSIGNED_BYTE, model->vertexCount);
+		appendText(json, "{\"bufferView\":0,\"byteOffset\":%zu,\"componentType\":%u,\"count\":%u,\"type\":\"VEC2\"}", offsetof(struct j3dVertex, texCoord), GLTF_FLOAT, model->vertexCount);
+		for (uint32_t s = 0; s < model->shapeCount; s++)
+		{
+			int16_t material = model->shapeMaterials[s];
+			if (model->shapeIndexCount[s] == 0 || (material >= 0 && (uint32_t)material < model->materialCount && model->materialCullModes[material] == 3))
+				continue;
+			appendText(json, ",{\"bufferView\":1,\"byteOffset\":%zu,\"componentType\":%u,\"count\":%u,\"type\":\"SCALAR\"}", (size_t)model->shapeFirstIndex[s] * sizeof(uint32_t), GLTF_UNSIGNED_INT, model->shapeIndexCount[s]);
+			primitiveCount++;
+		}
+		appendText(json, "]");
+
+		if (primitiveCount != 0)
+		{
+			appendText(json, ",\"meshes\":[{\"primitives\":[");
+			uint32_t accessor = 4;
+			for (uint32_t s = 0; s < model->shapeCount; s++)
+			{
+				int16_t material = model->shapeMaterials[s];
+				bool validMaterial = material >= 0 && (uint32_t)material < model->materialCount;
+				if (model->shapeIndexCount[s] == 0 || (validMaterial && model->materialCullModes[material] == 3))
+					continue;
+				appendText(json, "%s{\"attributes\":{\"POSITION\":0,%s\"COLOR_0\":2,\"TEXCOORD_0\":3},\"indices\":%u", accessor == 4 ? "" : ",", hasNormals ? "\"NORMAL\":1," : "", accessor);
+				accessor++;
+				if (validMaterial)
+					appendText(json, ",\"material\":%i", material);
+				appendText(json, "}");
+			}
+			appendText(json, "]}]");
+		}
+	}
+
+	//joints keep their index as node index, the mesh node comes after them
+	if (model->jointCount != 0 || primitiveCount != 0)
+	{
+		appendText(json, ",\"nodes\":[");
+		for (uint32_t j = 0; j < model->jointCount; j++)
+		{
+			struct matrix34 local;
+			composeJointMatrix(&model->jointScales[j * 3], &model->jointRotations[j * 3], &model->jointTranslations[j * 3], &local);
+
+			appendText(json, "%s{\"name\":", j == 0 ? "" : ",");
+			appendJsonString(json, model->jointNames[j]);
+			appendText(json, ",\"matrix\":[");
+			for (int column = 0; column < 4; column++)
+				appendText(json, "%.9g,%.9g,%.9g,%s", getFiniteFloat(local.m[0][column]), getFiniteFloat(local.m[1][column]), getFiniteFloat(local.m[2][column]), column == 3 ? "1]" : "0,");
+
+			bool firstChild = true;
+			for (uint32_t child = 0; child < model->jointCount; child++)
+			{
+				if (model->jointParents[child] != (int16_t)j)
+					continue;
+				appendText(json, "%s%u", firstChild ? ",\"children\":[" : ",", child);
+				firstChild = false;
+			}
+			appendText(json, firstChild ? "}" : "]}");
+		}
+		if (primitiveCount != 0)
+		{
+			appendText(json, "%s{\"name\":", model->jointCount == 0 ? "" : ",");
+			appendJsonString(json, name);
+			appendText(json, ",\"mesh\":0}");
+		}
+
+		appendText(json, "],\"scenes\":[{\"nodes\":[");
+		bool firstRoot = true;
+		for (uint32_t j = 0; j < model->jointCount; j++)
+		{
+			if (model->jointParents[j] >= 0)
+				continue;
+			appendText(json, "%s%u", firstRoot ? "" : ",", j);
+			firstRoot = false;
+		}
+		if (primitiveCount != 0)
+			appendText(json, "%s%u", firstRoot ? "" : ",", model->jointCount);
+		appendText(json, "]}],\"scene\":0");
+	}
+
+	appendText(json, "}");
+}
+
+//GX front faces are clockwise and glTF's are counterclockwise, every triangle is written with its last two corners swapped
+static bool writeGLTFIndices(HANDLE file, const uint32_t* indices, uint32_t indexCount)
+{
+	uint32_t flipped[3 * 1024];
+	for (uint32_t first = 0; first < indexCount; first += countof(flipped))
+	{
+		uint32_t count = min(indexCount - first, (uint32_t)countof(flipped));
+		uint32_t i = 0;
+		for (; i + 3 <= count; i += 3)
+		{
+			flipped[i] = indices[first + i];
+			flipped[i + 1] = indices[first + i + 2];
+			flipped[i + 2] = indices[first + i + 1];
+		}
+		for (; i < count; i++)
+			flipped[i] = indices[first + i];
+		if (!writeFileData(file, flipped, count * sizeof(uint32_t)))
+			return false;
+	}
+	return true;
+}
+
+//returns the file size, 0 if it couldn't be written or the json didn't fit in memory
+static size_t writeGLB(const char* path, const struct j3dModel* model, const struct textBuilder* json, const uint8_t* images, size_t imagesSize)
+{
+	if (json->failed)
+		return 0;
+
+	bool hasMesh = model->vertexCount != 0 && model->indexCount != 0;
+	size_t vertexBytes = hasMesh ? (size_t)model->vertexCount * sizeof(struct j3dVertex) : 0;
+	size_t indexBytes = hasMesh ? (size_t)model->indexCount * sizeof(uint32_t) : 0;
+	uint32_t jsonSize = (uint32_t)((json->length + 3) & ~(size_t)3);
+	uint32_t binSize = (uint32_t)(vertexBytes + indexBytes + imagesSize);
+
+	uint32_t header[5] = {
+		0x46546C67,//glTF
+		2,
+		(uint32_t)(12 + 8 + jsonSize + (binSize ? 8 + binSize : 0)),
+		jsonSize,
+		0x4E4F534A,//JSON
+	};
+	uint32_t binHeader[2] = { binSize, 0x004E4942 };//BIN
+	static const char spaces[4] = { ' ', ' ', ' ', ' ' };
+
+	HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return 0;
+
+	bool written =
+		writeFileData(file, header, sizeof(header)) &&
+		writeFileData(file, json->text, json->length) &&
+		writeFileData(file, spaces, jsonSize - json->length);
+	if (written && binSize != 0)
+	{
+		written =
+			writeFileData(file, binHeader, sizeof(binHeader)) &&
+			writeFileData(file, model->vertices, vertexBytes) &&
+			writeGLTFIndices(file, model->indices, (uint32_t)(indexBytes / sizeof(uint32_t))) &&
+			writeFileData(file, images, imagesSize);
+	}
+	CloseHandle(file);
+	return written ? header[2] : 0;
+}
+
+static void exportGLTFJob(int fileIndex, int threadIndex, void* context)
+{
+	struct gltfExportContext* gltfExport = context;
+	struct gltfExportThread* thread = &gltfExport->threads[threadIndex];
+
+	if (thread->workspace == nullptr)
+		thread->workspace = trackedAlloc(MEMORY_MODELS, MODEL_WORKSPACE_SIZE);
+
+	char path[256];
+	getGameFilePath(fileIndex, path, sizeof(path));
+
+	struct archiveMember members[1024];
+	int memberCount = listGameFileMembers(fileIndex, &thread->decompressionBuffer, members, countof(members));
+	for (int i = 0; i < memberCount; i++)
+	{
+		if (!isJ3DModel(members[i].data, members[i].size))
+			continue;
+
+		//loose model files are named after their path, archive members after the archive path and member name
+		char name[512];
+		if (members[i].data == gameFileList[fileIndex].filePtr)
+			snprintf(name, sizeof(name), "%s", path);
+		else
+			snprintf(name, sizeof(name), "%s_%s", path, members[i].name);
+
+		double start = getTimeSeconds();
+		struct j3dModel model;
+		bool parsed = parseJ3DModel(members[i].data, members[i].size, thread->workspace, MODEL_WORKSPACE_SIZE, &model);
+		double parseEnd = getTimeSeconds();
+		thread->parseTime += parseEnd - start;
+
+		struct workspaceAllocator allocator;
+		struct gltfImage* images = nullptr;
+		size_t imagesSize = 0;
+		size_t largestPixelBuffer = 0;
+		uint32_t imageCount = 0;
+		if (parsed)
+		{
+			initWorkspaceAllocator(&allocator, OffsetPointer(thread->workspace, model.workspaceUsed), MODEL_WORKSPACE_SIZE - model.workspaceUsed);
+			imageCount = encodeGLTFImages(&model, thread, &allocator, &images, &imagesSize, &largestPixelBuffer);
+		}
+		double textureEnd = getTimeSeconds();
+		thread->textureTime += textureEnd - parseEnd;
+
+		char outputPath[MAX_PATH];
+		getExportPath(gltfExport->directory, name, "glb", outputPath, sizeof(outputPath));
+
+		size_t fileSize = 0;
+		if (parsed && !allocator.failed)
+		{
+			buildGLTFJson(&model, members[i].name, images, imageCount, imagesSize, &thread->json);
+			fileSize = writeGLB(outputPath, &model, &thread->json, thread->images, imagesSize);
+		}
+		thread->writeTime += getTimeSeconds() - textureEnd;
+
+		if (fileSize == 0)
+		{
+			printf("unable to export %s\n", outputPath);
+			thread->failedCount++;
+			continue;
+		}
+
+		//what this model needed at once: its parsed arrays, one decoded texture, the pngs and the json
+		size_t memory = (allocator.next - (uint8_t*)thread->workspace) + largestPixelBuffer + imagesSize + thread->json.length;
+		thread->peakMemory = max(thread->peakMemory, memory);
+		thread->memorySum += memory;
+
+		thread->exportedCount++;
+		thread->vertexCount += model.vertexCount;
+		thread->triangleCount += model.indexCount / 3;
+		for (uint32_t t = 0; t < imageCount; t++)
+			thread->textureCount += images[t].textureIndex >= 0;
+		thread->bytesWritten += fileSize;
+	}
+}
+
+int runGLTFExport(const char* directory)
+{
+	CreateDirectoryA(directory, nullptr);
+	initDeflateTables();
+
+	struct gltfExportContext* gltfExport = calloc(1, sizeof(struct gltfExportContext));
+	gltfExport->directory = directory;
+
+	double start = getTimeSeconds();
+	runParallel(gameFileCount, exportGLTFJob, gltfExport);
+	double wallTime = getTimeSeconds() - start;
+
+	struct gltfExportThread total = { 0 };
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		struct gltfExportThread* thread = &gltfExport->threads[i];
+		total.exportedCount += thread->exportedCount;
+		total.failedCount += thread->failedCount;
+		total.vertexCount += thread->vertexCount;
+		total.triangleCount += thread->triangleCount;
+		total.textureCount += thread->textureCount;
+		total.bytesWritten += thread->bytesWritten;
+		total.peakMemory = max(total.peakMemory, thread->peakMemory);
+		total.memorySum += thread->memorySum;
+		total.parseTime += thread->parseTime;
+		total.textureTime += thread->textureTime;
+		total.writeTime += thread->writeTime;
+		trackedFree(thread->decompressionBuffer);
+		trackedFree(thread->workspace);
+		trackedFree(thread->pixels);
+		free(thread->images);
+		free(thread->json.text);
+		freeImageEncoder(&thread->encoder);
+	}
+
+	printf("exported: %u models as glb (%llu vertices, %llu triangles, %llu textures, %llu bytes written), failed: %u\n", total.exportedCount, total.vertexCount, total.triangleCount, total.textureCount, total.bytesWritten, total.failedCount);
+	printf("wall: %.3f ms on %i threads, %.0f models/s, %.1f MB/s written\n", wallTime * 1000.0, getThreadCount(), total.exportedCount / max(wallTime, 1e-9), total.bytesWritten / max(wallTime, 1e-9) / (1024.0 * 1024.0));
+	printf("parsing: %.3f ms, textures: %.3f ms, json and writing: %.3f ms (summed over threads)\n", total.parseTime * 1000.0, total.textureTime * 1000.0, total.writeTime * 1000.0);
+	if (total.exportedCount != 0)
+		printf("memory per model: %.1f KB peak, %.1f KB mean\n", total.peakMemory / 1024.0, total.memorySum / 1024.0 / total.exportedCount);
+
+	free(gltfExport);
+	return total.failedCount == 0 ? 0 : -1;
+}
+
+/*
+* audio export: every .ast stream, .dsp file and wave bank wave is decoded to a 16 bit .wav in <directory>, without a
+* directory only the decoding is timed. the streams are listed up front so a bank's waves spread over every thread
+*/
+struct audioJob
+{
+	struct audioStream stream;
+	char name[256];
+};
+
+struct audioThread
+{
+	int16_t* samples;
+	size_t sampleCapacity;
+	uint32_t decodedCount;
+	uint32_t failedCount;
+	uint64_t sampleCount;//over every channel
+	uint64_t bytesWritten;
+	double decodeTime;
+	double writeTime;
+};
+
+struct audioContext
+{
+	struct audioThread threads[MAX_THREADS];
+	struct audioJob* jobs;
+	uint32_t jobCount;
+	uint32_t jobCapacity;
+	uint32_t skippedCount;
+	const char* directory;
+};
+
+//nullptr if the job list can't grow
+static struct audioJob* addAudioJob(struct audioContext* audio)
+{
+	if (audio->jobCount == audio->jobCapacity)
+	{
+		uint32_t capacity = max(audio->jobCapacity * 2, 256);
+		struct audioJob* jobs = realloc(audio->jobs, sizeof(struct audioJob) * capacity);
+		if (jobs == nullptr)
+			return nullptr;
+		audio->jobs = jobs;
+		audio->jobCapacity = capacity;
+	}
+	return &audio->jobs[audio->jobCount++];
+}
+
+//wave banks name their .aw files with at most a relative directory, file names are unique enough on the disc
+static int findGameFileByName(const char* path)
+{
+	const char* name = max(strrchr(path, '/'), strrchr(path, '\\'));
+	name = name ? name + 1 : path;
+	for (int i = 0; i < gameFileCount; i++)
+		if (_stricmp(gameFileList[i].fileName, name) == 0)
+			return i;
+	return -1;
+}
+
+static void listAudioJobs(struct audioContext* audio)
+{
+	for (int fileIndex = 0; fileIndex < gameFileCount; fileIndex++)
+	{
+		const void* data = gameFileList[fileIndex].filePtr;
+		uint32_t size = gameFileList[fileIndex].fileSize;
+		bool ast = gameFileHasExtension(fileIndex, ".ast");
+		if (ast || gameFileHasExtension(fileIndex, ".dsp"))
+		{
+			struct audioJob* job = addAudioJob(audio);
+			if (job == nullptr)
+				audio->skippedCount++;
+			else if (ast ? loadASTStream(data, size, &job->stream) : loadDSPStream(data, size, &job->stream))
+				getGameFilePath(fileIndex, job->name, sizeof(job->name));
+			else
+			{
+				audio->jobCount--;
+				audio->skippedCount++;
+			}
+			continue;
+		}
+
+		if (!gameFileHasExtension(fileIndex, ".baa") && !gameFileHasExtension(fileIndex, ".aaf"))
+			continue;
+
+		size_t offset = 0;
+		for (const struct wsysHeader* wsys = findWSYSChunk(data, size, &offset); wsys != nullptr; wsys = findWSYSChunk(data, size, &offset))
+		{
+			const struct wsysWaveGroup* group;
+			for (uint32_t g = 0; (group = getWSYSWaveGroup(wsys, g)) != nullptr; g++)
+			{
+				char archiveName[sizeof(group->archiveName) + 1];
+				memcpy(archiveName, group->archiveName, sizeof(group->archiveName));
+				archiveName[sizeof(group->archiveName)] = '\0';
+
+				uint32_t waveCount = SwapEndian(group->waveCount);
+				int archiveIndex = findGameFileByName(archiveName);
+				if (archiveIndex < 0)
+				{
+					audio->skippedCount += waveCount;
+					continue;
+				}
+
+				char archivePath[256];
+				getGameFilePath(archiveIndex, archivePath, sizeof(archivePath));
+				for (uint32_t w = 0; w < waveCount; w++)
+				{
+					const struct wsysWave* wave = getWSYSWave(wsys, group, w);
+					struct audioJob* job = addAudioJob(audio);
+					if (job == nullptr)
+						audio->skippedCount++;
+					else if (wave != nullptr && loadWSYSWave(wave, gameFileList[archiveIndex].filePtr, gameFileList[archiveIndex].fileSize, &job->stream))
+						snprintf(job->name, sizeof(job->name), "%s_%u_%04u", archivePath, SwapEndian(wsys->id), w);
+					else
+					{
+						audio->jobCount--;
+						audio->skippedCount++;
+					}
+				}
+			}
+		}
+	}
+}
+
+static void decodeAudioJob(int jobIndex, int threadIndex, void* context)
+{
+	struct audioContext* audio = context;
+	struct audioThread* thread = &audio->threads[threadIndex];
+	const struct audioJob* job = &audio->jobs[jobIndex];
+
+	size_t size = 44 + getDecodedAudioSize(&job->stream);
+	if (size > thread->sampleCapacity)
+	{
+		size_t capacity = max(size, thread->sampleCapacity * 2);
+		int16_t* samples = realloc(thread->samples, capacity);
+		if (samples == nullptr)
+		{
+			printf("not enough memory to decode %s\n", job->name);
+			thread->failedCount++;
+			return;
+		}
+		thread->samples = samples;
+		thread->sampleCapacity = capacity;
+	}
+
+	//the wav header goes in front of the samples so the file is one write
+	double start = getTimeSeconds();
+	uint32_t sampleCount = decodeAudioStream(&job->stream, thread->samples + 22);
+	double decodeEnd = getTimeSeconds();
+	thread->decodeTime += decodeEnd - start;
+
+	thread->decodedCount++;
+	thread->sampleCount += (uint64_t)sampleCount * job->stream.channelCount;
+	if (audio->directory == nullptr)
+		return;
+
+	getWAVHeader(job->stream.channelCount, job->stream.sampleRate, sampleCount, (uint8_t*)thread->samples);
+	DWORD fileSize = 44 + sampleCount * job->stream.channelCount * sizeof(int16_t);
+
+	char outputPath[MAX_PATH];
+	getExportPath(audio->directory, job->name, "wav", outputPath, sizeof(outputPath));
+	HANDLE file = CreateFileA(outputPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	bool written = file != INVALID_HANDLE_VALUE && writeFileData(file, thread->samples, fileSize);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	thread->writeTime += getTimeSeconds() - decodeEnd;
+
+	if (!written)
+	{
+		printf("unable to export %s\n", outputPath);
+		thread->failedCount++;
+		return;
+	}
+	thread->bytesWritten += fileSize;
+}
+
+int runAudioDecode(const char* directory)
+{
+	if (directory != nullptr)
+		CreateDirectoryA(directory, nullptr);
+
+	struct audioContext* audio = calloc(1, sizeof(struct audioContext));
+	audio->directory = directory;
+
+	double start = getTimeSeconds();
+	listAudioJobs(audio);
+	double listTime = getTimeSeconds() - start;
+	runParallel(audio->jobCount, decodeAudioJob, audio);
+	double wallTime = getTimeSeconds() - start;
+
+	struct audioThread total = { 0 };
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		struct audioThread* thread = &audio->threads[i];
+		total.decodedCount += thread->decodedCount;
+		total.failedCount += thread->failedCount;
+		total.sampleCount += thread->sampleCount;
+		total.bytesWritten += thread->bytesWritten;
+		total.decodeTime += thread->decodeTime;
+		total.writeTime += thread->writeTime;
+		free(thread->samples);
+	}
+
+	uint32_t streamCounts[3] = { 0 };
+	for (uint32_t i = 0; i < audio->jobCount; i++)
+		streamCounts[audio->jobs[i].stream.container]++;
+
+	printf("decoded: %u streams (%u ast, %u dsp, %u bank waves), skipped: %u (unknown format, 2 bit afc or missing .aw), failed: %u\n",
+		total.decodedCount, streamCounts[AUDIO_AST], streamCounts[AUDIO_DSP], streamCounts[AUDIO_WAVE], audio->skippedCount, total.failedCount);
+	printf("samples: %llu over every channel, %llu bytes written\n", total.sampleCount, total.bytesWritten);
+	printf("wall: %.3f ms on %i threads (%.3f ms listing), %.1f Msamples/s\n", wallTime * 1000.0, getThreadCount(), listTime * 1000.0, total.sampleCount / max(wallTime, 1e-9) / 1e6);
+	if (total.decodeTime > 0.0)
+		printf("decoding: %.3f ms, writing: %.3f ms (summed over threads), %.1f Msamples/s per thread\n", total.decodeTime * 1000.0, total.writeTime * 1000.0, total.sampleCount / total.decodeTime / 1e6);
+
+	free(audio->jobs);
+	free(audio);
+	return total.failedCount == 0 ? 0 : -1;
+}
+
+/*
+* writes every thread's trace ring as Chrome trace json, which chrome://tracing and ui.perfetto.dev open.
+* timestamps are microseconds since the earliest event
+*/
+bool writeTraceFile(const char* path)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	const double ticksToMicroseconds = 1e6 / (double)frequency.QuadPart;
+
+	uint32_t ringCount = min((uint32_t)traceRingCount, TRACE_MAX_THREADS);
+	int64_t origin = INT64_MAX;
+	uint64_t eventCount = 0;
+	uint64_t droppedCount = 0;
+	for (uint32_t r = 0; r < ringCount; r++)
+	{
+		const struct traceRing* ring = traceRings[r];
+		if (ring == nullptr)
+			continue;
+		uint64_t firstEvent = ring->eventCount > TRACE_RING_SIZE ? ring->eventCount - TRACE_RING_SIZE : 0;
+		for (uint64_t e = firstEvent; e < ring->eventCount; e++)
+			origin = min(origin, ring->events[e & (TRACE_RING_SIZE - 1)].start);
+		eventCount += ring->eventCount - firstEvent;
+		droppedCount += firstEvent;
+	}
+
+	struct textBuilder json = { 0 };
+	appendText(&json, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	appendText(&json, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Pikmin2LevelViewer\"}}");
+	for (uint32_t r = 0; r < ringCount; r++)
+	{
+		const struct traceRing* ring = traceRings[r];
+		if (ring == nullptr)
+			continue;
+
+		appendText(&json, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}", ring->threadIndex, ring->threadIndex);
+
+		uint64_t firstEvent = ring->eventCount > TRACE_RING_SIZE ? ring->eventCount - TRACE_RING_SIZE : 0;
+		for (uint64_t e = firstEvent; e < ring->eventCount; e++)
+		{
+			const struct traceEvent* event = &ring->events[e & (TRACE_RING_SIZE - 1)];
+			double timestamp = (event->start - origin) * ticksToMicroseconds;
+			if (event->type == TRACE_EVENT_SPAN)
+				appendText(&json, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", event->name, ring->threadIndex, timestamp, event->value * ticksToMicroseconds);
+			else
+				appendText(&json, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%lld}}", event->name, ring->threadIndex, timestamp, event->value);
+		}
+	}
+	appendText(&json, "\n]}\n");
+
+	HANDLE file = json.failed ? INVALID_HANDLE_VALUE : CreateFileA(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	bool written = file != INVALID_HANDLE_VALUE && writeFileData(file, json.text, json.length);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	free(json.text);
+
+	if (written)
+		printf("trace: %llu events from %u threads written to %s (%llu overwritten, %lld dropped with every ring taken)\n", eventCount, ringCount, path, droppedCount, droppedTraceEvents);
+	else
+		printf("unable to write the trace to %s\n", path);
+	return written;
+}
+
+/*
+* image diff
+* the files of two images are matched by path. a different size is a modification without reading either file, files of
+* the same size are compared in DIFF_CHUNK_SIZE chunks in parallel and a file stops being read once one chunk differs.
+* modified yaz0/RARC archives are opened on both sides and their members are matched by name the same way.
+*/
+#define DIFF_CHUNK_SIZE (1024 * 1024)
+#define DIFF_MAX_MEMBERS 1024
+
+#define DIFF_ADDED 0
+#define DIFF_REMOVED 1
+#define DIFF_MODIFIED 2
+#define DIFF_UNCHANGED 3
+
+struct diffFile
+{
+	char path[256];
+	const uint8_t* data;
+	uint32_t size;
+};
+
+struct diffPair
+{
+	const struct diffFile* before;
+	const struct diffFile* after;
+	volatile LONG changed;
+	uint8_t status;
+	//the member report of a modified archive
+	struct textBuilder members;
+	uint32_t memberCounts[3];
+};
+
+struct diffChunk
+{
+	uint32_t pair;
+	uint32_t offset;
+};
+
+struct imageDiff
+{
+	struct diffPair* pairs;
+	struct diffChunk* chunks;
+	uint32_t* archivePairs;
+	volatile LONG64 bytesCompared;
+	uint8_t* buffers[MAX_THREADS][2];
+};
+
+//maps a whole file read-only, returns nullptr if it can't be opened
+static const uint8_t* mapReadOnlyFile(const char* path, uint64_t* _Out_ size)
+{
+	*size = 0;
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER fileSize;
+	const uint8_t* view = nullptr;
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+	{
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr)
+		{
+			view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			//the view keeps the file open
+			CloseHandle(mapping);
+		}
+		*size = fileSize.QuadPart;
+	}
+	CloseHandle(file);
+	return view;
+}
+
+static int compareDiffFiles(const void* a, const void* b)
+{
+	return strcmp(((const struct diffFile*)a)->path, ((const struct diffFile*)b)->path);
+}
+
+//the paths of the indexed image, sorted
+static struct diffFile* collectDiffFiles()
+{
+	struct diffFile* files = malloc(sizeof(struct diffFile) * max(gameFileCount, 1));
+	for (int i = 0; i < gameFileCount; i++)
+	{
+		getGameFilePath(i, files[i].path, sizeof(files[i].path));
+		files[i].data = gameFileList[i].filePtr;
+		files[i].size = gameFileList[i].fileSize;
+	}
+	qsort(files, gameFileCount, sizeof(struct diffFile), compareDiffFiles);
+	return files;
+}
+
+static void compareDiffChunkJob(int chunkIndex, int threadIndex, void* context)
+{
+	struct imageDiff* diff = context;
+	const struct diffChunk* chunk = &diff->chunks[chunkIndex];
+	struct diffPair* pair = &diff->pairs[chunk->pair];
+
+	//an earlier chunk of the file already differs
+	if (pair->changed)
+		return;
+
+	uint32_t size = min(DIFF_CHUNK_SIZE, pair->before->size - chunk->offset);
+	if (memcmp(pair->before->data + chunk->offset, pair->after->data + chunk->offset, size) != 0)
+		InterlockedExchange(&pair->changed, 1);
+	InterlockedExchangeAdd64(&diff->bytesCompared, (LONG64)size * 2);
+}
+
+//the RARC inside a file, decompressed into the thread's buffer for that side if it's yaz0
+static const uint8_t* openDiffArchive(struct imageDiff* diff, int threadIndex, int side, const struct diffFile* file, uint32_t* _Out_ size)
+{
+	*size = file->size;
+	if (!isYaz0(file->data, file->size))
+		return isRarc(file->data, file->size) ? file->data : nullptr;
+
+	*size = getYaz0UncompressedSize(file->data);
+	//the size comes from the header, a bad one fails the allocation and the old buffer is kept
+	uint8_t* buffer = realloc(diff->buffers[threadIndex][side], max(*size, 1));
+	if (buffer == nullptr)
+		return nullptr;
+	diff->buffers[threadIndex][side] = buffer;
+	if (decompressYaz0File(file->data, file->size, diff->buffers[threadIndex][side]) != 0 || !isRarc(diff->buffers[threadIndex][side], *size))
+		return nullptr;
+	return diff->buffers[threadIndex][side];
+}
+
+static int compareArchiveMemberNames(const void* a, const void* b)
+{
+	return strcmp(((const struct archiveMember*)a)->name, ((const struct archiveMember*)b)->name);
+}
+
+static void diffArchiveMembersJob(int archiveIndex, int threadIndex, void* context)
+{
+	struct imageDiff* diff = context;
+	struct diffPair* pair = &diff->pairs[diff->archivePairs[archiveIndex]];
+
+	uint32_t beforeSize, afterSize;
+	const uint8_t* beforeArchive = openDiffArchive(diff, threadIndex, 0, pair->before, &beforeSize);
+	const uint8_t* afterArchive = openDiffArchive(diff, threadIndex, 1, pair->after, &afterSize);
+	if (beforeArchive == nullptr || afterArchive == nullptr)
+		return;
+
+	struct archiveMember* before = malloc(sizeof(struct archiveMember) * DIFF_MAX_MEMBERS * 2);
+	if (before == nullptr)
+		return;
+	struct archiveMember* after = before + DIFF_MAX_MEMBERS;
+	int beforeCount = listRarcMembers(beforeArchive, beforeSize, before, DIFF_MAX_MEMBERS);
+	int afterCount = listRarcMembers(afterArchive, afterSize, after, DIFF_MAX_MEMBERS);
+	qsort(before, beforeCount, sizeof(struct archiveMember), compareArchiveMemberNames);
+	qsort(after, afterCount, sizeof(struct archiveMember), compareArchiveMemberNames);
+
+	uint64_t compared = 0;
+	for (int b = 0, a = 0; b < beforeCount || a < afterCount;)
+	{
+		int order = b == beforeCount ? 1 : a == afterCount ? -1 : strcmp(before[b].name, after[a].name);
+		if (order < 0)
+		{
+			appendText(&pair->members, "\tremoved: %s (%u bytes)\n", before[b].name, before[b].size);
+			pair->memberCounts[DIFF_REMOVED]++;
+			b++;
+		}
+		else if (order > 0)
+		{
+			appendText(&pair->members, "\tadded: %s (%u bytes)\n", after[a].name, after[a].size);
+			pair->memberCounts[DIFF_ADDED]++;
+			a++;
+		}
+		else
+		{
+			if (before[b].size != after[a].size)
+				appendText(&pair->members, "\tmodified: %s (%u -> %u bytes)\n", before[b].name, before[b].size, after[a].size);
+			else
+			{
+				compared += (uint64_t)before[b].size * 2;
+				if (memcmp(before[b].data, after[a].data, before[b].size) == 0)
+				{
+					b++;
+					a++;
+					continue;
+				}
+				appendText(&pair->members, "\tmodified: %s (%u bytes)\n", before[b].name, before[b].size);
+			}
+			pair->memberCounts[DIFF_MODIFIED]++;
+			b++;
+			a++;
+		}
+	}
+	InterlockedExchangeAdd64(&diff->bytesCompared, (LONG64)compared);
+	free(before);
+}
+
+//compares the open image with otherPath
+int runImageDiff(const char* otherPath)
+{
+	double start = getTimeSeconds();
+	uint64_t otherSize;
+	const uint8_t* otherImage = mapReadOnlyFile(otherPath, &otherSize);
+	if (otherImage == nullptr)
+	{
+		printf("unable to open %s\n", otherPath);
+		return -1;
+	}
+
+	//the FST walk works on the open image, so the other one is swapped in for its index and then swapped back
+	struct diffFile* beforeFiles = collectDiffFiles();
+	uint32_t beforeCount = gameFileCount;
+	void* imageAddress = GameImageAddress;
+	uint64_t imageSize = GameImageSize;
+	GameImageAddress = (void*)otherImage;
+	GameImageSize = otherSize;
+	indexGameFiles(nullptr);
+	struct diffFile* afterFiles = collectDiffFiles();
+	uint32_t afterCount = gameFileCount;
+	GameImageAddress = imageAddress;
+	GameImageSize = imageSize;
+	indexGameFiles(nullptr);
+
+	struct imageDiff* diff = calloc(1, sizeof(struct imageDiff));
+	diff->pairs = calloc(beforeCount + afterCount, sizeof(struct diffPair));
+	uint32_t pairCount = 0;
+	uint32_t chunkCount = 0;
+	uint64_t totalBytes = 0;
+	for (uint32_t b = 0, a = 0; b < beforeCount || a < afterCount;)
+	{
+		int order = b == beforeCount ? 1 : a == afterCount ? -1 : strcmp(beforeFiles[b].path, afterFiles[a].path);
+		struct diffPair* pair = &diff->pairs[pairCount++];
+		pair->before = order <= 0 ? &beforeFiles[b++] : nullptr;
+		pair->after = order >= 0 ? &afterFiles[a++] : nullptr;
+		totalBytes += (pair->before ? pair->before->size : 0) + (pair->after ? pair->after->size : 0);
+
+		if (order != 0)
+			pair->status = order < 0 ? DIFF_REMOVED : DIFF_ADDED;
+		else if (pair->before->size != pair->after->size)
+			pair->changed = 1;
+		else
+			chunkCount += (pair->before->size + DIFF_CHUNK_SIZE - 1) / DIFF_CHUNK_SIZE;
+	}
+
+	//chunks of a file are consecutive, so the threads that find a difference first save the others the rest of it
+	diff->chunks = malloc(sizeof(struct diffChunk) * max(chunkCount, 1));
+	chunkCount = 0;
+	for (uint32_t p = 0; p < pairCount; p++)
+	{
+		const struct diffPair* pair = &diff->pairs[p];
+		if (pair->before == nullptr || pair->after == nullptr || pair->changed)
+			continue;
+		for (uint32_t offset = 0; offset < pair->before->size; offset += DIFF_CHUNK_SIZE)
+			diff->chunks[chunkCount++] = (struct diffChunk){ p, offset };
+	}
+	runParallel(chunkCount, compareDiffChunkJob, diff);
+
+	uint32_t fileCounts[4] = { 0 };
+	uint32_t archiveCount = 0;
+	diff->archivePairs = malloc(sizeof(uint32_t) * max(pairCount, 1));
+	for (uint32_t p = 0; p < pairCount; p++)
+	{
+		struct diffPair* pair = &diff->pairs[p];
+		if (pair->before != nullptr && pair->after != nullptr)
+			pair->status = pair->changed ? DIFF_MODIFIED : DIFF_UNCHANGED;
+		fileCounts[pair->status]++;
+
+		if (pair->status == DIFF_MODIFIED &&
+			(isYaz0(pair->before->data, pair->before->size) || isRarc(pair->before->data, pair->before->size)) &&
+			(isYaz0(pair->after->data, pair->after->size) || isRarc(pair->after->data, pair->after->size)))
+			diff->archivePairs[archiveCount++] = p;
+	}
+	runParallel(archiveCount, diffArchiveMembersJob, diff);
+	double seconds = getTimeSeconds() - start;
+
+	uint32_t memberCounts[3] = { 0 };
+	for (uint32_t p = 0; p < pairCount; p++)
+	{
+		struct diffPair* pair = &diff->pairs[p];
+		if (pair->status == DIFF_ADDED)
+			printf("added: %s (%u bytes)\n", pair->after->path, pair->after->size);
+		else if (pair->status == DIFF_REMOVED)
+			printf("removed: %s (%u bytes)\n", pair->before->path, pair->before->size);
+		else if (pair->status == DIFF_MODIFIED && pair->before->size != pair->after->size)
+			printf("modified: %s (%u -> %u bytes)\n", pair->before->path, pair->before->size, pair->after->size);
+		else if (pair->status == DIFF_MODIFIED)
+			printf("modified: %s (%u bytes)\n", pair->before->path, pair->before->size);
+
+		if (pair->members.text != nullptr)
+			fputs(pair->members.text, stdout);
+		if (pair->members.failed)
+			printf("\t(member list cut short, out of memory)\n");
+		for (int i = 0; i < 3; i++)
+			memberCounts[i] += pair->memberCounts[i];
+		free(pair->members.text);
+	}
+
+	printf("files: %u added, %u removed, %u modified, %u unchanged\n", fileCounts[DIFF_ADDED], fileCounts[DIFF_REMOVED], fileCounts[DIFF_MODIFIED], fileCounts[DIFF_UNCHANGED]);
+	printf("members of %u modified archives: %u added, %u removed, %u modified\n", archiveCount, memberCounts[DIFF_ADDED], memberCounts[DIFF_REMOVED], memberCounts[DIFF_MODIFIED]);
+	printf("compared %llu of %llu bytes in %.3f s\n", (uint64_t)diff->bytesCompared, totalBytes, seconds);
+
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		free(diff->buffers[i][0]);
+		free(diff->buffers[i][1]);
+	}
+	free(diff->archivePairs);
+	free(diff->chunks);
+	free(diff->pairs);
+	free(diff);
+	free(beforeFiles);
+	free(afterFiles);
+	UnmapViewOfFile(otherImage);
+	return fileCounts[DIFF_ADDED] + fileCounts[DIFF_REMOVED] + fileCounts[DIFF_MODIFIED] != 0 ? 1 : 0;
+}
+
+/*
+* image rebuild
+* replacement files are laid out against the parsed FST: one that fits in the space before the next file (or the end of
+* the image) keeps its offset, anything larger moves past the end of the image. only the FST entries change, so the FST
+* keeps its size and place. the output is the source image with the new FST and replacements written over it, streamed
+* in REBUILD_WRITE_SIZE pieces straight from the mapped files, or with -patch only the changed ranges written in place.
+*/
+#define REBUILD_WRITE_SIZE (1024 * 1024 * 16)
+#define REBUILD_FILE_ALIGNMENT 0x8000
+#define REBUILD_MAX_REPLACEMENTS 256
+
+struct rebuildRange
+{
+	uint64_t offset;
+	const uint8_t* data;//nullptr: zeros
+	uint64_t size;
+};
+
+struct rebuildReplacement
+{
+	int fileIndex;
+	uint32_t entryIndex;
+	const uint8_t* data;
+	uint64_t size;
+	uint64_t offset;
+};
+
+//WriteFile takes 32 bit sizes, large ranges go in pieces
+static bool writeFileRange(HANDLE file, const uint8_t* data, uint64_t size)
+{
+	static const uint8_t zeros[REBUILD_FILE_ALIGNMENT] = { 0 };
+	while (size > 0)
+	{
+		DWORD pieceSize = (DWORD)min(size, data ? REBUILD_WRITE_SIZE : sizeof(zeros));
+		DWORD written = 0;
+		if (!WriteFile(file, data ? data : zeros, pieceSize, &written, nullptr) || written != pieceSize)
+			return false;
+		data = data ? data + pieceSize : nullptr;
+		size -= pieceSize;
+	}
+	return true;
+}
+
+//true if path is a file with no bytes, mapReadOnlyFile has nothing to map for those
+static bool isEmptyFile(const char* path)
+{
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize;
+	bool empty = GetFileSizeEx(file, &fileSize) && fileSize.QuadPart == 0;
+	CloseHandle(file);
+	return empty;
+}
+
+/*
+* the areas of the image no file may run into: the disc header, bi2 and the apploader, the DOL and the FST.
+* images without an apploader (the synthetic ones) have the FST or the DOL right after bi2
+*/
+#define APPLOADER_OFFSET 0x2440
+
+struct apploaderHeader
+{
+	char date[16];
+	uint32_t entryPoint;
+	uint32_t size;
+	uint32_t trailerSize;
+	uint32_t padding;
+};
+
+static uint32_t getSystemAreas(uint64_t areas[3][2])
+{
+	const struct DiskHeader* header = GameImageAddress;
+	uint64_t dolOffset = SwapEndian(header->DOLOffset);
+	uint64_t fstOffset = SwapEndian(header->FSTOffset);
+
+	areas[0][0] = 0;
+	areas[0][1] = APPLOADER_OFFSET;
+	if (dolOffset != APPLOADER_OFFSET && fstOffset != APPLOADER_OFFSET && isRangeInside(APPLOADER_OFFSET, sizeof(struct apploaderHeader), GameImageSize))
+	{
+		const struct apploaderHeader* apploader = OffsetPointer((const struct apploaderHeader*)GameImageAddress, APPLOADER_OFFSET);
+		areas[0][1] += sizeof(struct apploaderHeader) + (uint64_t)SwapEndian(apploader->size) + SwapEndian(apploader->trailerSize);
+	}
+
+	//the DOL ends with its furthest section
+	struct dolImage dol;
+	uint64_t dolSize = sizeof(struct DOLHeader);
+	if (getGameDOL(&dol))
+		for (uint32_t i = 0; i < dol.sectionCount; i++)
+			dolSize = max(dolSize, (uint64_t)dol.sections[i].fileOffset + dol.sections[i].size);
+	areas[1][0] = dolOffset;
+	areas[1][1] = dolOffset + dolSize;
+
+	areas[2][0] = fstOffset;
+	areas[2][1] = fstOffset + SwapEndian(header->FSTSize);
+	return 3;
+}
+
+static int compareRebuildRanges(const void* a, const void* b)
+{
+	uint64_t offsetA = ((const struct rebuildRange*)a)->offset;
+	uint64_t offsetB = ((const struct rebuildRange*)b)->offset;
+	return offsetA < offsetB ? -1 : offsetA > offsetB ? 1 : 0;
+}
+
+/*
+* specs are "<path in the image>=<file>". outputPath nullptr patches the open image in place.
+* returns 0 on success
+*/
+int runRebuildImage(const char* outputPath, int specCount, char** specs)
+{
+	double start = getTimeSeconds();
+	const struct FileEntry* FST;
+	const char* stringTable;
+	uint32_t stringTableSize;
+	uint32_t entryCount = getFSTLayout(&FST, &stringTable, &stringTableSize);
+	if (entryCount == 0 || specCount > REBUILD_MAX_REPLACEMENTS)
+	{
+		printf(entryCount == 0 ? "the image has no usable FST\n" : "too many replacements\n");
+		return -1;
+	}
+	const struct DiskHeader* header = GameImageAddress;
+	uint32_t fstOffset = SwapEndian(header->FSTOffset);
+	uint32_t fstSize = SwapEndian(header->FSTSize);
+
+	//gameFileList is in FST order, so the n-th file entry is game file n
+	uint32_t* fileEntries = malloc(sizeof(uint32_t) * max(gameFileCount, 1));
+	for (uint32_t i = 1, x = 0; i < entryCount && x < (uint32_t)gameFileCount; i++)
+		if (FST[i].Flags != 1)
+			fileEntries[x++] = i;
+
+	struct rebuildReplacement replacements[REBUILD_MAX_REPLACEMENTS];
+	int replacementCount = 0;
+	int result = 0;
+	for (int s = 0; s < specCount && result == 0; s++)
+	{
+		char gamePath[256];
+		const char* separator = strchr(specs[s], '=');
+		if (separator == nullptr || separator - specs[s] >= (ptrdiff_t)sizeof(gamePath))
+		{
+			printf("expected <path in the image>=<file>: %s\n", specs[s]);
+			result = -1;
+			break;
+		}
+		memcpy(gamePath, specs[s], separator - specs[s]);
+		gamePath[separator - specs[s]] = 0;
+
+		struct rebuildReplacement* replacement = &replacements[replacementCount];
+		replacement->fileIndex = -1;
+		for (int i = 0; i < gameFileCount && replacement->fileIndex < 0; i++)
+		{
+			char path[256];
+			getGameFilePath(i, path, sizeof(path));
+			if (_stricmp(path, gamePath) == 0)
+				replacement->fileIndex = i;
+		}
+		for (int r = 0; r < replacementCount; r++)
+			if (replacements[r].fileIndex == replacement->fileIndex)
+				replacement->fileIndex = -2;
+		if (replacement->fileIndex < 0)
+		{
+			printf(replacement->fileIndex == -1 ? "%s isn't in the image\n" : "%s is replaced twice\n", gamePath);
+			result = -1;
+			break;
+		}
+
+		//an empty file can't be mapped, its data stays nullptr and nothing is written for it
+		replacement->data = mapReadOnlyFile(separator + 1, &replacement->size);
+		if ((replacement->data == nullptr && !isEmptyFile(separator + 1)) || replacement->size > UINT32_MAX)
+		{
+			printf("unable to read %s\n", separator + 1);
+			result = -1;
+			break;
+		}
+		replacement->entryIndex = fileEntries[replacement->fileIndex];
+		replacementCount++;
+	}
+
+	//layout: the room at a file's offset ends at the next file, the next system area or the end of the image
+	uint64_t systemAreas[3][2];
+	uint32_t systemAreaCount = getSystemAreas(systemAreas);
+	uint64_t imageEnd = GameImageSize;
+	uint64_t appendOffset = (GameImageSize + REBUILD_FILE_ALIGNMENT - 1) & ~(uint64_t)(REBUILD_FILE_ALIGNMENT - 1);
+	uint8_t* newFST = malloc(fstSize);
+	memcpy(newFST, FST, fstSize);
+	for (int r = 0; r < replacementCount && result == 0; r++)
+	{
+		struct rebuildReplacement* replacement = &replacements[r];
+		uint64_t offset = SwapEndian(FST[replacement->entryIndex].FileOffset);
+		uint64_t room = GameImageSize > offset ? GameImageSize - offset : 0;
+		for (uint32_t a = 0; a < systemAreaCount; a++)
+		{
+			if (systemAreas[a][0] > offset)
+				room = min(room, systemAreas[a][0] - offset);
+			else if (systemAreas[a][1] > offset)
+				room = 0;
+		}
+		for (int i = 0; i < gameFileCount; i++)
+		{
+			uint64_t otherOffset = SwapEndian(FST[fileEntries[i]].FileOffset);
+			if (otherOffset > offset && gameFileList[i].fileSize != 0)
+				room = min(room, otherOffset - offset);
+		}
+
+		bool moved = replacement->size > room;
+		replacement->offset = moved ? appendOffset : offset;
+		if (moved)
+			appendOffset = (appendOffset + replacement->size + REBUILD_FILE_ALIGNMENT - 1) & ~(uint64_t)(REBUILD_FILE_ALIGNMENT - 1);
+		if (replacement->offset + replacement->size > UINT32_MAX)
+		{
+			printf("the image would grow past 4 GB\n");
+			result = -1;
+			break;
+		}
+		imageEnd = max(imageEnd, replacement->offset + replacement->size);
+
+		struct FileEntry* entry = (struct FileEntry*)newFST + replacement->entryIndex;
+		entry->FileOffset = SwapEndian((uint32_t)replacement->offset);
+		entry->Unknown = SwapEndian((uint32_t)replacement->size);
+		printf("%s: %llu bytes, %s 0x%llX\n", specs[r], replacement->size, moved ? "moved to" : "kept at", replacement->offset);
+	}
+
+	//what gets written over the source image, in output order. in place the FST goes last, after the files are on disk,
+	//so a write that fails part way never leaves an FST that points at data that wasn't written
+	struct rebuildRange ranges[REBUILD_MAX_REPLACEMENTS + 1];
+	int rangeCount = 0;
+	for (int r = 0; r < replacementCount; r++)
+		ranges[rangeCount++] = (struct rebuildRange){ replacements[r].offset, replacements[r].data, replacements[r].size };
+	ranges[rangeCount++] = (struct rebuildRange){ fstOffset, newFST, fstSize };
+	if (outputPath != nullptr)
+		qsort(ranges, rangeCount, sizeof(struct rebuildRange), compareRebuildRanges);
+
+	HANDLE file = INVALID_HANDLE_VALUE;
+	if (result == 0)
+	{
+		//the image itself is still mapped, so it's shared for writing
+		file = outputPath ?
+			CreateFileA(outputPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) :
+			CreateFileA(GameImagePath, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			printf("unable to open %s for writing\n", outputPath ? outputPath : GameImagePath);
+			result = -1;
+		}
+	}
+
+	uint64_t bytesWritten = 0;
+	uint64_t cursor = 0;
+	for (int r = 0; r < rangeCount && result == 0; r++)
+	{
+		if (outputPath != nullptr)
+		{
+			//everything between the ranges comes from the source image, past its end it's padding
+			uint64_t copyEnd = min(ranges[r].offset, GameImageSize);
+			bool written = (cursor >= copyEnd || writeFileRange(file, (const uint8_t*)GameImageAddress + cursor, copyEnd - cursor)) &&
+				(max(cursor, copyEnd) >= ranges[r].offset || writeFileRange(file, nullptr, ranges[r].offset - max(cursor, copyEnd)));
+			bytesWritten += ranges[r].offset > cursor ? ranges[r].offset - cursor : 0;
+			if (!written)
+				result = -1;
+		}
+		else
+		{
+			LARGE_INTEGER position;
+			position.QuadPart = ranges[r].offset;
+			if ((r == rangeCount - 1 && !FlushFileBuffers(file)) || !SetFilePointerEx(file, position, nullptr, FILE_BEGIN))
+				result = -1;
+		}
+
+		if (result == 0 && !writeFileRange(file, ranges[r].data, ranges[r].size))
+			result = -1;
+		bytesWritten += ranges[r].size;
+		cursor = max(cursor, ranges[r].offset + ranges[r].size);
+	}
+	if (result == 0 && outputPath != nullptr && cursor < GameImageSize)
+	{
+		if (!writeFileRange(file, (const uint8_t*)GameImageAddress + cursor, GameImageSize - cursor))
+			result = -1;
+		bytesWritten += GameImageSize - cursor;
+	}
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+
+	if (result == 0)
+	{
+		double seconds = getTimeSeconds() - start;
+		printf("%s: %llu bytes, %llu written in %.3f s (%.1f MB/s)\n", outputPath ? outputPath : GameImagePath, imageEnd, bytesWritten, seconds, bytesWritten / max(seconds, 1e-9) / (1024.0 * 1024.0));
+
+		//the search index of a patched image would no longer match its files
+		if (outputPath == nullptr)
+		{
+			char indexPath[MAX_PATH];
+			getNgramIndexPath(indexPath, sizeof(indexPath));
+			DeleteFileA(indexPath);
+		}
+	}
+	else if (file != INVALID_HANDLE_VALUE)
+	{
+		printf("writing %s failed\n", outputPath ? outputPath : GameImagePath);
+	}
+
+	for (int r = 0; r < replacementCount; r++)
+		if (replacements[r].data != nullptr)
+			UnmapViewOfFile(replacements[r].data);
+	free(newFST);
+	free(fileEntries);
+	return result;
+}
+
+/*
+* DOL report
+* -dol lists the sections of the image's DOL and, with a CodeWarrior map, looks symbols up by name or address.
+* -benchdol times the map parse, address lookups and copying every data symbol out of the DOL
+*/
+#define DOL_BENCH_LOOKUPS (1024 * 1024)
+
+//returns the file as a zero terminated string, nullptr if it can't be read
+static char* readTextFile(const char* path)
+{
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	char* text = nullptr;
+	LARGE_INTEGER size;
+	DWORD bytesRead = 0;
+	if (GetFileSizeEx(file, &size) && size.QuadPart < 64 * 1024 * 1024)
+	{
+		text = malloc((size_t)size.QuadPart + 1);
+		if (ReadFile(file, text, (DWORD)size.QuadPart, &bytesRead, nullptr) && bytesRead == size.QuadPart)
+		{
+			text[bytesRead] = 0;
+		}
+		else
+		{
+			free(text);
+			text = nullptr;
+		}
+	}
+	CloseHandle(file);
+	return text;
+}
+
+//copies every symbol outside .text that is in the DOL's sections to tables, returns the bytes copied.
+//static symbols of different units can share a name, so they're walked by address rather than looked up by name
+static uint64_t extractDOLTables(const struct dolImage* dol, const struct symbolMap* map, uint8_t* tables, uint64_t tablesSize, uint32_t* _Out_ tableCount)
+{
+	uint64_t copied = 0;
+	*tableCount = 0;
+	for (uint32_t s = 0; s < map->count; s++)
+	{
+		const struct dolSymbol* symbol = &map->symbols[s];
+		if (strcmp(getSymbolSection(map, symbol), ".text") == 0)
+			continue;
+		const void* table = getDOLPointer(dol, symbol->address, symbol->size);
+		if (table != nullptr && copied + symbol->size <= tablesSize)
+		{
+			memcpy(tables + copied, table, symbol->size);
+			copied += symbol->size;
+			(*tableCount)++;
+		}
+	}
+	return copied;
+}
+
+static uint64_t getDOLDataSize(const struct dolImage* dol)
+{
+	uint64_t size = 0;
+	for (uint32_t s = 0; s < dol->sectionCount; s++)
+		if (dol->sections[s].index >= DOL_TEXT_SECTIONS)
+			size += dol->sections[s].size;
+	return size;
+}
+
+static bool loadSymbolMap(const char* path, struct symbolMap* _Out_ map, double* _Out_ parseTime)
+{
+	char* text = readTextFile(path);
+	if (text == nullptr)
+	{
+		printf("unable to read %s\n", path);
+		return false;
+	}
+	double start = getTimeSeconds();
+	bool parsed = parseSymbolMap(text, map);
+	*parseTime = getTimeSeconds() - start;
+	free(text);
+	if (!parsed)
+		printf("not enough memory to parse %s\n", path);
+	return parsed;
+}
+
+static void printDOLQuery(const struct dolImage* dol, const struct symbolMap* map, const char* query)
+{
+	if (strncmp(query, "0x", 2) == 0)
+	{
+		uint32_t address = strtoul(query, nullptr, 16);
+		const struct dolSymbol* symbol = findSymbolByAddress(map, address);
+		if (symbol != nullptr)
+			printf("0x%08x: %s+0x%x (%s)\n", address, getSymbolName(map, symbol), address - symbol->address, getSymbolSection(map, symbol));
+		else
+			printf("0x%08x: not in any symbol\n", address);
+		return;
+	}
 
+	const struct dolSymbol* symbol = findSymbolByName(map, query);
+	if (symbol == nullptr)
+	{
+		printf("%s: no such symbol\n", query);
+		return;
 	}
-	case WM_NOTIFY:
+	printf("%s: 0x%08x, 0x%x bytes in %s\n", query, symbol->address, symbol->size, getSymbolSection(map, symbol));
+
+	//the first words as the game sees them
+	const uint32_t* words = getDOLPointer(dol, symbol->address, symbol->size);
+	if (words == nullptr)
 	{
-		LPNMHDR lpnmh = (LPNMHDR)lParam;
-		if (lpnmh->code == TVN_SELCHANGED)
+		printf("\tnot in the DOL's sections (bss or a bad map)\n");
+		return;
+	}
+	printf("\t");
+	for (uint32_t i = 0; i < min(symbol->size / 4, 8); i++)
+		printf("%08x ", SwapEndian(words[i]));
+	printf(symbol->size > 32 ? "...\n" : "\n");
+}
+
+int runDOLReport(const char* mapPath, int queryCount, char** queries)
+{
+	struct dolImage dol;
+	if (!getGameDOL(&dol))
+	{
+		printf("no valid DOL in the image\n");
+		return -1;
+	}
+
+	printf("DOL at 0x%08x: entry point 0x%08x, bss 0x%08x-0x%08x\n", SwapEndian(((const struct DiskHeader*)GameImageAddress)->DOLOffset),
+		dol.entryPoint, dol.bssAddress, dol.bssAddress + dol.bssSize);
+	for (uint32_t s = 0; s < dol.sectionCount; s++)
+	{
+		const struct dolSection* section = &dol.sections[s];
+		bool text = section->index < DOL_TEXT_SECTIONS;
+		printf("\t%s%-2u 0x%08x-0x%08x  file offset 0x%08x\n", text ? "text" : "data", text ? section->index : section->index - DOL_TEXT_SECTIONS,
+			section->address, section->address + section->size, section->fileOffset);
+	}
+	if (mapPath == nullptr)
+		return 0;
+
+	struct symbolMap map;
+	double parseTime;
+	if (!loadSymbolMap(mapPath, &map, &parseTime))
+		return -1;
+	printf("%u symbols from %s in %.3f ms\n", map.count, mapPath, parseTime * 1000.0);
+
+	for (int i = 0; i < queryCount; i++)
+		printDOLQuery(&dol, &map, queries[i]);
+	freeSymbolMap(&map);
+	return 0;
+}
+
+int runDOLBenchmark(const char* mapPath)
+{
+	struct dolImage dol;
+	if (!getGameDOL(&dol))
+	{
+		printf("no valid DOL in the image\n");
+		return -1;
+	}
+	struct symbolMap map;
+	double parseTime;
+	if (!loadSymbolMap(mapPath, &map, &parseTime))
+		return -1;
+	if (map.count == 0)
+	{
+		printf("no symbols in %s\n", mapPath);
+		freeSymbolMap(&map);
+		return -1;
+	}
+
+	//addresses spread over every symbol, cycled until there are enough of them
+	double start = getTimeSeconds();
+	uint32_t found = 0;
+	for (uint32_t i = 0; i < DOL_BENCH_LOOKUPS; i++)
+	{
+		const struct dolSymbol* symbol = &map.symbols[i % map.count];
+		found += findSymbolByAddress(&map, symbol->address + symbol->size / 2) != nullptr;
+	}
+	double lookupTime = getTimeSeconds() - start;
+
+	uint64_t dataSize = getDOLDataSize(&dol);
+	uint8_t* tables = malloc(max(dataSize, 1));
+	uint32_t tableCount;
+	start = getTimeSeconds();
+	uint64_t copied = extractDOLTables(&dol, &map, tables, dataSize, &tableCount);
+	double extractTime = getTimeSeconds() - start;
+	free(tables);
+
+	printf("symbols: %u, parsed in %.3f ms\n", map.count, parseTime * 1000.0);
+	printf("address lookups: %u (%u found) in %.3f ms, %.1f M/s\n", DOL_BENCH_LOOKUPS, found, lookupTime * 1000.0, DOL_BENCH_LOOKUPS / lookupTime / 1e6);
+	printf("tables: %u, %llu bytes copied in %.3f ms, %.1f MB/s\n", tableCount, copied, extractTime * 1000.0, copied / max(extractTime, 1e-9) / 1e6);
+	freeSymbolMap(&map);
+	return 0;
+}
+
+/*
+* synthetic disc images
+* a stand-in for the retail image on machines that can't have it: the same DiskHeader/FST layout, yaz0 compressed RARC
+* archives holding a model with a TEX1 texture in every GX format, generator/route text files, and a DOL with function
+* and table symbols described by a CodeWarrior map.
+* everything comes from the seed, the same seed always gives the same bytes
+*/
+#define SYNTHETIC_ARCHIVES 32
+#define SYNTHETIC_TEXT_FILES 64
+#define SYNTHETIC_FST_OFFSET 0x2440
+#define SYNTHETIC_DATA_ALIGNMENT 0x8000
+#define SYNTHETIC_DOL_FUNCTIONS 2048
+#define SYNTHETIC_DOL_TABLES 512
+#define GAMECUBE_DISC_MAGIC 0xC2339F3D
+
+static const uint8_t syntheticTextureFormats[] = { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x8, 0x9, 0xA, 0xE };
+
+struct rarcNode
+{
+	char type[4];
+	uint32_t nameOffset;
+	uint16_t nameHash;
+	uint16_t fileEntryCount;
+	uint32_t firstFileEntry;
+};
+
+//xorshift64*, the state must not be 0
+static inline uint32_t nextSyntheticRandom(uint64_t* state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return (uint32_t)((*state * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+//the hash RARC entries and J3D name tables store next to each name
+static uint16_t getNameHash(const char* name)
+{
+	uint16_t hash = 0;
+	for (; *name != 0; name++)
+		hash = (uint16_t)(hash * 3 + (uint8_t)*name);
+	return hash;
+}
+
+static uint32_t getSyntheticPaletteCount(uint8_t format)
+{
+	return format == 0x8 ? 16 : (format == 0x9 || format == 0xA) ? 256 : 0;
+}
+
+/*
+* a bmd with an empty INF1 hierarchy and one side x side texture per GX format.
+* texel bytes are a ramp plus noiseMask worth of noise, which sets how well the archive compresses
+*/
+static uint8_t* buildSyntheticModel(uint64_t* random, uint32_t side, uint8_t noiseMask, uint32_t* _Out_ modelSize)
+{
+	const uint32_t textureCount = countof(syntheticTextureFormats);
+
+	uint32_t tex1Size = 0x20 + textureCount * sizeof(struct BTI);
+	for (uint32_t t = 0; t < textureCount; t++)
+		tex1Size += ((getTextureDataSize(syntheticTextureFormats[t], side, side) + 31) & ~31) + ((getSyntheticPaletteCount(syntheticTextureFormats[t]) * 2 + 31) & ~31);
+	uint32_t nameTableOffset = tex1Size;
+	uint32_t nameTableSize = 4 + textureCount * 4;
+	for (uint32_t t = 0; t < textureCount; t++)
+		nameTableSize += (uint32_t)strlen(textureFormatNames[syntheticTextureFormats[t]]) + 1;
+	tex1Size += (nameTableSize + 31) & ~31;
+
+	const uint32_t inf1Size = 0x20;
+	uint32_t fileSize = sizeof(struct J3DFileHeader) + inf1Size + tex1Size;
+	uint8_t* file = calloc(1, fileSize);
+
+	struct J3DFileHeader* header = (struct J3DFileHeader*)file;
+	memcpy(&header->J3DVersion, "J3D2", 4);
+	memcpy(&header->fileVersion, "bmd3", 4);
+	uint32_t swappedSize = SwapEndian(fileSize);
+	memcpy(header->unknown1, &swappedSize, 4);
+	header->blockCount = SwapEndian(2u);
+	memcpy(header->unknown2, "SVR3", 4);
+	memset(header->unknown2 + 4, 0xFF, 12);
+
+	//the hierarchy is a single 0x00 end node, already zeroed
+	struct INF1* inf1 = OffsetPointer((struct INF1*)file, sizeof(struct J3DFileHeader));
+	memcpy(inf1->chunkType, "INF1", 4);
+	inf1->size = SwapEndian((int32_t)inf1Size);
+	inf1->padding = -1;
+	inf1->matrixGroupCount = SwapEndian(1);
+	inf1->hierarchyDataOffset = SwapEndian(0x18);
+
+	struct TEX1* tex1 = OffsetPointer((struct TEX1*)inf1, inf1Size);
+	memcpy(tex1->chunkType, "TEX1", 4);
+	tex1->size = SwapEndian((int32_t)tex1Size);
+	tex1->textureCount = SwapEndian((uint16_t)textureCount);
+	tex1->padding = 0xFFFF;
+	tex1->textureHeaderOffset = SwapEndian(0x20);
+	tex1->stringTableOffset = SwapEndian((int32_t)nameTableOffset);
+
+	struct BTI* headers = OffsetPointer((struct BTI*)tex1, 0x20);
+	uint32_t dataOffset = 0x20 + textureCount * sizeof(struct BTI);
+	for (uint32_t t = 0; t < textureCount; t++)
+	{
+		uint8_t format = syntheticTextureFormats[t];
+		uint32_t dataSize = getTextureDataSize(format, side, side);
+		uint32_t paletteCount = getSyntheticPaletteCount(format);
+		uint32_t headerOffset = 0x20 + t * sizeof(struct BTI);
+
+		struct BTI* bti = &headers[t];
+		bti->format = format;
+		bti->alphaEnabled = format == 0x2 || format == 0x3 || format == 0x5 || format == 0x6;
+		bti->width = SwapEndian((int16_t)side);
+		bti->height = SwapEndian((int16_t)side);
+		bti->wrapS = 1;
+		bti->wrapT = 1;
+		bti->GXMinFilter = 1;
+		bti->GXMaxFilter = 1;
+		bti->mipCount = 1;
+		bti->textureDataOffset = SwapEndian((int32_t)(dataOffset - headerOffset));
+
+		uint8_t* data = OffsetPointer((uint8_t*)tex1, dataOffset);
+		for (uint32_t i = 0; i < dataSize; i++)
+			data[i] = (uint8_t)((i >> 4) + (nextSyntheticRandom(random) & noiseMask));
+		dataOffset += (dataSize + 31) & ~31;
+
+		if (paletteCount != 0)
 		{
-			//printf("selection changed ");
+			//RGB5A3 entries
+			bti->palettesEnabled = true;
+			bti->palletteFormat = 2;
+			bti->palletteCount = SwapEndian((int16_t)paletteCount);
+			bti->palletteOffset = SwapEndian((int32_t)(dataOffset - headerOffset));
+			uint16_t* palette = OffsetPointer((uint16_t*)tex1, dataOffset);
+			for (uint32_t i = 0; i < paletteCount; i++)
+				palette[i] = SwapEndian((uint16_t)nextSyntheticRandom(random));
+			dataOffset += (paletteCount * 2 + 31) & ~31;
+		}
+	}
 
+	uint8_t* nameTable = OffsetPointer((uint8_t*)tex1, nameTableOffset);
+	*(uint16_t*)nameTable = SwapEndian((uint16_t)textureCount);
+	*(uint16_t*)(nameTable + 2) = 0xFFFF;
+	uint32_t nameOffset = 4 + textureCount * 4;
+	for (uint32_t t = 0; t < textureCount; t++)
+	{
+		const char* name = textureFormatNames[syntheticTextureFormats[t]];
+		*(uint16_t*)(nameTable + 4 + t * 4) = SwapEndian(getNameHash(name));
+		*(uint16_t*)(nameTable + 6 + t * 4) = SwapEndian((uint16_t)nameOffset);
+		memcpy(nameTable + nameOffset, name, strlen(name) + 1);
+		nameOffset += (uint32_t)strlen(name) + 1;
+	}
 
-			LPNMTREEVIEWW lpnm = (LPNMTREEVIEWW)lParam;
+	*modelSize = fileSize;
+	return file;
+}
 
-			HWND hTreeView = lpnm->hdr.hwndFrom;
-			HTREEITEM hSelected = lpnm->itemNew.hItem;
+/*
+* screens and effects go in every fourth archive: a blo whose panes use icon.bti from the archive, and a jpc with two
+* emitters sharing its own two textures. the textures are 16 x 16 RGB5A3 ramps
+*/
+#define SYNTHETIC_ICON_SIDE 16
 
-			TCHAR buffer[64];
-			TVITEMW tvi;
+static uint32_t writeSyntheticIcon(uint8_t* _Out_ out, uint32_t shade)
+{
+	struct BTI* bti = (struct BTI*)out;
+	uint32_t dataSize = getTextureDataSize(0x5, SYNTHETIC_ICON_SIDE, SYNTHETIC_ICON_SIDE);
+	memset(bti, 0, sizeof(struct BTI));
+	bti->format = 0x5;
+	bti->alphaEnabled = true;
+	bti->width = SwapEndian((int16_t)SYNTHETIC_ICON_SIDE);
+	bti->height = SwapEndian((int16_t)SYNTHETIC_ICON_SIDE);
+	bti->GXMinFilter = 1;
+	bti->GXMaxFilter = 1;
+	bti->mipCount = 1;
+	bti->textureDataOffset = SwapEndian((int32_t)sizeof(struct BTI));
+	for (uint32_t i = 0; i < dataSize; i++)
+		out[sizeof(struct BTI) + i] = (uint8_t)(i * shade >> 3);
+	return sizeof(struct BTI) + dataSize;
+}
 
-			tvi.mask = TVIF_TEXT;
-			tvi.hItem = hSelected;
-			tvi.pszText = buffer;
-			tvi.cchTextMax = sizeof(buffer) / sizeof(buffer[0]);
+//a block of bodySize zeroes, then the reference string for name if there is one, padded to 4 bytes
+static uint32_t writeSyntheticBlock(uint8_t* _Out_ out, const char* magic, uint32_t bodySize, const char* name)
+{
+	struct jsystemBlock* block = (struct jsystemBlock*)out;
+	uint32_t size = sizeof(struct jsystemBlock) + bodySize;
+	memcpy(block->magic, magic, 4);
+	if (name != nullptr)
+	{
+		out[size++] = 2;
+		out[size++] = (uint8_t)strlen(name);
+		memcpy(out + size, name, strlen(name));
+		size += (uint32_t)strlen(name);
+	}
+	size = (size + 3) & ~3;
+	block->size = SwapEndian(size);
+	return size;
+}
 
-			SendMessageW(hTreeView, TVM_GETITEM, 0, (LPARAM)&tvi);
+static uint8_t* buildSyntheticScreen(uint32_t* _Out_ screenSize)
+{
+	uint8_t* file = calloc(1, 1024);
+	struct bloHeader* header = (struct bloHeader*)file;
+	memcpy(header->magic, "SCRNblo1", 8);
+
+	uint32_t size = sizeof(struct bloHeader);
+	struct bloInfo* info = OffsetPointer((struct bloInfo*)file, size);
+	size += writeSyntheticBlock(file + size, "INF1", 0x10, nullptr);
+	info->width = SwapEndian((uint16_t)640);
+	info->height = SwapEndian((uint16_t)480);
+	size += writeSyntheticBlock(file + size, "PAN1", 0x28, nullptr);
+	size += writeSyntheticBlock(file + size, "BGN1", 0, nullptr);
+	size += writeSyntheticBlock(file + size, "PIC1", 0x28, "timg/icon.bti");
+	size += writeSyntheticBlock(file + size, "PAN1", 0x28, nullptr);
+	size += writeSyntheticBlock(file + size, "BGN1", 0, nullptr);
+	size += writeSyntheticBlock(file + size, "PIC1", 0x28, "icon.bti");
+	size += writeSyntheticBlock(file + size, "END1", 0, nullptr);
+	size += writeSyntheticBlock(file + size, "END1", 0, nullptr);
+	size += writeSyntheticBlock(file + size, "EXT1", 0, nullptr);
+
+	header->fileSize = SwapEndian(size);
+	header->blockCount = SwapEndian(10u);
+	*screenSize = size;
+	return file;
+}
 
-			//wprintf(L"selected item: %s\n", tvi.pszText);
+static uint8_t* buildSyntheticEffect(uint32_t* _Out_ effectSize)
+{
+	static const uint16_t slots[2][2] = { { 0, 1 }, { 1 } };
+	static const uint8_t slotCounts[2] = { 2, 1 };
 
-			const wchar_t* extensionType = wcsrchr(tvi.pszText, L'.');
+	uint8_t* file = calloc(1, 4096);
+	struct jpcHeader* header = (struct jpcHeader*)file;
+	memcpy(header->magic, "JPAC2-10", 8);
+	header->resourceCount = SwapEndian((uint16_t)2);
+	header->textureCount = SwapEndian((uint16_t)2);
+
+	uint32_t size = sizeof(struct jpcHeader);
+	for (uint32_t r = 0; r < 2; r++)
+	{
+		struct jpaResourceHeader* resource = OffsetPointer((struct jpaResourceHeader*)file, size);
+		resource->resourceId = SwapEndian((uint16_t)r);
+		resource->blockCount = SwapEndian((uint16_t)3);
+		resource->textureSlotCount = slotCounts[r];
+		size += sizeof(struct jpaResourceHeader);
+
+		uint32_t emitterFlags = SwapEndian(0x100u << r);
+		memcpy(file + size + sizeof(struct jsystemBlock), &emitterFlags, 4);
+		size += writeSyntheticBlock(file + size, "BEM1", 0x78, nullptr);
+		size += writeSyntheticBlock(file + size, "BSP1", 0x38, nullptr);
+		for (uint32_t s = 0; s < slotCounts[r]; s++)
+		{
+			uint16_t slot = SwapEndian(slots[r][s]);
+			memcpy(file + size + sizeof(struct jsystemBlock) + s * 2, &slot, 2);
+		}
+		size += writeSyntheticBlock(file + size, "TDB1", slotCounts[r] * 2, nullptr);
+	}
+
+	size = (size + 31) & ~31;
+	header->textureTableOffset = SwapEndian(size);
+	for (uint32_t t = 0; t < 2; t++)
+	{
+		struct jpaTextureBlock* texture = OffsetPointer((struct jpaTextureBlock*)file, size);
+		snprintf(texture->name, sizeof(texture->name), "effect%u", t);
+		size += writeSyntheticBlock(file + size, "TEX1", sizeof(struct jpaTextureBlock) - sizeof(struct jsystemBlock) + writeSyntheticIcon(OffsetPointer(file, size + sizeof(struct jpaTextureBlock)), 3 + t), nullptr);
+	}
+
+	*effectSize = size;
+	return file;
+}
+
+//a RARC with one root directory holding the members, the layout listRarcMembers reads
+static uint8_t* buildSyntheticArchive(const struct archiveMember* members, int memberCount, uint32_t* _Out_ archiveSize)
+{
+	uint32_t entryCount = memberCount + 2;
+	uint32_t stringTableSize = sizeof(".\0..\0root");
+	for (int m = 0; m < memberCount; m++)
+		stringTableSize += (uint32_t)strlen(members[m].name) + 1;
+	uint32_t dataSize = 0;
+	for (int m = 0; m < memberCount; m++)
+		dataSize += (members[m].size + 31) & ~31;
+
+	//offsets from the info block
+	uint32_t nodeOffset = sizeof(struct rarcInfo);
+	uint32_t entryOffset = nodeOffset + ((sizeof(struct rarcNode) + 31) & ~31);
+	uint32_t stringTableOffset = entryOffset + ((entryCount * sizeof(struct rarcFileEntry) + 31) & ~31);
+	uint32_t fileDataOffset = stringTableOffset + ((stringTableSize + 31) & ~31);
+	uint32_t size = sizeof(struct rarcHeader) + fileDataOffset + dataSize;
+
+	uint8_t* archive = calloc(1, size);
+	struct rarcHeader* header = (struct rarcHeader*)archive;
+	memcpy(header->magic, "RARC", 4);
+	header->fileSize = SwapEndian(size);
+	header->headerSize = SwapEndian((uint32_t)sizeof(struct rarcHeader));
+	header->fileDataOffset = SwapEndian(fileDataOffset);
+	header->fileDataLength = SwapEndian(dataSize);
+	header->unknown[0] = SwapEndian(dataSize);
+
+	struct rarcInfo* info = OffsetPointer((struct rarcInfo*)archive, sizeof(struct rarcHeader));
+	info->nodeCount = SwapEndian(1u);
+	info->nodeOffset = SwapEndian(nodeOffset);
+	info->fileEntryCount = SwapEndian(entryCount);
+	info->fileEntryOffset = SwapEndian(entryOffset);
+	info->stringTableSize = SwapEndian((stringTableSize + 31) & ~31);
+	info->stringTableOffset = SwapEndian(stringTableOffset);
+	info->fileCount = SwapEndian((uint16_t)memberCount);
+	info->syncFileIds = 1;
+
+	char* strings = OffsetPointer((char*)info, stringTableOffset);
+	memcpy(strings, ".\0..\0root", sizeof(".\0..\0root"));
+	uint32_t nameOffset = sizeof(".\0..\0root");
+
+	struct rarcNode* node = OffsetPointer((struct rarcNode*)info, nodeOffset);
+	memcpy(node->type, "ROOT", 4);
+	node->nameOffset = SwapEndian(5u);
+	node->nameHash = SwapEndian(getNameHash("root"));
+	node->fileEntryCount = SwapEndian((uint16_t)entryCount);
+
+	struct rarcFileEntry* entries = OffsetPointer((struct rarcFileEntry*)info, entryOffset);
+	uint32_t memberOffset = 0;
+	for (int m = 0; m < memberCount; m++)
+	{
+		entries[m].id = SwapEndian((uint16_t)m);
+		entries[m].nameHash = SwapEndian(getNameHash(members[m].name));
+		entries[m].flags = 0x11;
+		entries[m].nameOffset = SwapEndian((uint16_t)nameOffset);
+		entries[m].dataOffset = SwapEndian(memberOffset);
+		entries[m].dataSize = SwapEndian(members[m].size);
+
+		memcpy(strings + nameOffset, members[m].name, strlen(members[m].name) + 1);
+		nameOffset += (uint32_t)strlen(members[m].name) + 1;
+		memcpy(OffsetPointer((uint8_t*)info, fileDataOffset + memberOffset), members[m].data, members[m].size);
+		memberOffset += (members[m].size + 31) & ~31;
+	}
+
+	//"." and ".." point back at the root node
+	for (int d = 0; d < 2; d++)
+	{
+		struct rarcFileEntry* entry = &entries[memberCount + d];
+		entry->id = 0xFFFF;
+		entry->nameHash = SwapEndian(getNameHash(d == 0 ? "." : ".."));
+		entry->flags = 0x02;
+		entry->nameOffset = SwapEndian((uint16_t)(d * 2));
+		entry->dataOffset = d == 0 ? 0 : 0xFFFFFFFF;
+		entry->dataSize = SwapEndian(0x10u);
+	}
+
+	*archiveSize = size;
+	return archive;
+}
+
+static void buildSyntheticGenerator(uint64_t* random, struct textBuilder* text)
+{
+	static const char* objectTypes[] = { "item", "teki", "pelplant", "gate", "onyon" };
+	uint32_t objectCount = 16 + nextSyntheticRandom(random) % 64;
+	appendText(text, "# generator\n%u\t# object count\n", objectCount);
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		appendText(text, "{\n\tv0.3\t# version\n\t0\t# reserved\n\t{%s}\t# type\n", objectTypes[nextSyntheticRandom(random) % countof(objectTypes)]);
+		appendText(text, "\t%.2f %.2f %.2f\t# pos\n\t0 0 0\t# offset\n", (int32_t)nextSyntheticRandom(random) / 1048576.0, (nextSyntheticRandom(random) % 4096) / 16.0, (int32_t)nextSyntheticRandom(random) / 1048576.0);
+		appendText(text, "\t{rate} %u %u\t# spawn rate\n}\n", nextSyntheticRandom(random) % 100, nextSyntheticRandom(random) % 8);
+	}
+}
+
+static void buildSyntheticRoute(uint64_t* random, struct textBuilder* text)
+{
+	uint32_t waypointCount = 16 + nextSyntheticRandom(random) % 48;
+	appendText(text, "# route\n%u\t# waypoint count\n", waypointCount);
+	for (uint32_t i = 0; i < waypointCount; i++)
+	{
+		bool twoWay = nextSyntheticRandom(random) & 1;
+		appendText(text, "# waypoint %u\n{\n\t%u\t# index\n\t%u\t# numLinks\n", i, i, twoWay ? 2 : 1);
+		appendText(text, "\t%u\t# link 0\n", (i + 1) % waypointCount);
+		if (twoWay)
+			appendText(text, "\t%u\t# link 1\n", (i + waypointCount - 1) % waypointCount);
+		appendText(text, "\t%.2f %.2f %.2f\t# pos\n\t%.1f\t# r\n}\n", (int32_t)nextSyntheticRandom(random) / 1048576.0, 0.0, (int32_t)nextSyntheticRandom(random) / 1048576.0, 5.0 + nextSyntheticRandom(random) % 40);
+	}
+}
+
+struct syntheticFile
+{
+	char name[32];
+	uint8_t* data;
+	uint32_t size;
+};
+
+//a text section of random words and two data sections of tables, map (if not nullptr) gets the symbols of all three
+static uint8_t* buildSyntheticDOL(uint64_t* random, struct textBuilder* map, uint32_t* _Out_ size)
+{
+	static const char* sectionNames[] = { ".text", ".data", ".rodata" };
+	static const char* symbolFormats[] = { "syntheticFunction%04u", "syntheticTable%04u", "syntheticConstants%04u" };
+	static const uint32_t symbolCounts[] = { SYNTHETIC_DOL_FUNCTIONS, SYNTHETIC_DOL_TABLES, SYNTHETIC_DOL_TABLES / 4 };
+	static const uint32_t addresses[] = { 0x80003100, 0x80400000, 0x80500000 };
+	static const uint32_t headerIndices[] = { 0, DOL_TEXT_SECTIONS, DOL_TEXT_SECTIONS + 1 };
+
+	//functions are 16 to 1024 bytes, tables 8 to 2048
+	uint32_t* symbolSizes[countof(sectionNames)];
+	uint32_t sectionSizes[countof(sectionNames)] = { 0 };
+	uint32_t fileSize = sizeof(struct DOLHeader);
+	for (uint32_t s = 0; s < countof(sectionNames); s++)
+	{
+		symbolSizes[s] = malloc(sizeof(uint32_t) * symbolCounts[s]);
+		for (uint32_t i = 0; i < symbolCounts[s]; i++)
+		{
+			symbolSizes[s][i] = s == 0 ? 16 + nextSyntheticRandom(random) % 64 * 16 : 8 + nextSyntheticRandom(random) % 256 * 8;
+			sectionSizes[s] += symbolSizes[s][i];
+		}
+		fileSize += (sectionSizes[s] + 31) & ~31;
+	}
+
+	uint8_t* dol = calloc(1, fileSize);
+	struct DOLHeader* header = (struct DOLHeader*)dol;
+	uint32_t offset = sizeof(struct DOLHeader);
+	for (uint32_t s = 0; s < countof(sectionNames); s++)
+	{
+		header->offsets[headerIndices[s]] = SwapEndian(offset);
+		header->addresses[headerIndices[s]] = SwapEndian(addresses[s]);
+		header->sizes[headerIndices[s]] = SwapEndian(sectionSizes[s]);
+		for (uint32_t i = 0; i < sectionSizes[s]; i += 4)
+			*(uint32_t*)(dol + offset + i) = nextSyntheticRandom(random);
 
-			for (int i = 0; i < 5000; i++)
+		if (map != nullptr)
+		{
+			appendText(map, "%s section layout\n  Starting        Virtual\n  address  Size   address\n  -----------------------\n", sectionNames[s]);
+			appendText(map, "  00000000 %06x %08x  4 %s \tsynthetic.a synthetic.o \n", sectionSizes[s], addresses[s], sectionNames[s]);
+			uint32_t symbolOffset = 0;
+			for (uint32_t i = 0; i < symbolCounts[s]; i++)
 			{
-				if (gameFileList[i].treeItem == hSelected)
-				{
-					selectedFileIndex = i;
+				char name[32];
+				_snprintf_s(name, sizeof(name), _TRUNCATE, symbolFormats[s], i);
+				appendText(map, "  %08x %06x %08x  4 %s \tsynthetic.a synthetic.o \n", symbolOffset, symbolSizes[s][i], addresses[s] + symbolOffset, name);
+				symbolOffset += symbolSizes[s][i];
+			}
+			appendText(map, "\n\n");
+		}
+		offset += (sectionSizes[s] + 31) & ~31;
+		free(symbolSizes[s]);
+	}
+	header->entryPoint = SwapEndian(addresses[0]);
 
-					if (wcscmp(extensionType, L".szs") == 0)
-					{
-						printf("dealing with a compressed szs file!\n");
+	if (map != nullptr)
+	{
+		appendText(map, "Memory map:\n                   Starting Size     File\n                   address           Offset\n");
+		for (uint32_t s = 0; s < countof(sectionNames); s++)
+			appendText(map, "%19s %08x %08x %08x\n", sectionNames[s], addresses[s], sectionSizes[s], SwapEndian(header->offsets[headerIndices[s]]));
+	}
 
-						struct yaz0Header
-						{
-							char magic[4];
-							uint32_t uncompressedSize;
-							uint32_t reserved1;
-							uint32_t reserved2;
-						};
+	*size = fileSize;
+	return dol;
+}
 
+/*
+* FST: root, user, user/Abe with the text files, user/Kando with the archives. the DOL sits between the FST and the files,
+* symbolMap (if not nullptr) gets its map.
+* every archive is decompressed again and compared, so a broken compressor fails here instead of in a benchmark.
+* returns a malloc'ed image, nullptr if that check fails or a text file or the map didn't fit in memory
+*/
+uint8_t* generateSyntheticImage(uint64_t seed, uint32_t archiveCount, uint32_t textFileCount, struct textBuilder* symbolMap, uint64_t* _Out_ imageSize)
+{
+	archiveCount = max(archiveCount, 1);
+	textFileCount = max(textFileCount, 1);
+	uint64_t random = seed * 0x9E3779B97F4A7C15ull | 1;
 
-						const struct yaz0Header* header = gameFileList[selectedFileIndex].filePtr;
+	uint32_t fileCount = textFileCount + archiveCount;
+	struct syntheticFile* files = calloc(fileCount, sizeof(struct syntheticFile));
+	bool textBuilt = true;
 
-						printf("magic: ");
-						WriteConsoleA(ConsoleHandle, &header->magic, 4, nullptr, nullptr);
-						printf("\nuncompressed size: %i\n", SwapEndian(header->uncompressedSize));
+	for (uint32_t i = 0; i < textFileCount; i++)
+	{
+		struct textBuilder text = { 0 };
+		if (i & 1)
+			buildSyntheticRoute(&random, &text);
+		else
+			buildSyntheticGenerator(&random, &text);
+		_snprintf_s(files[i].name, sizeof(files[i].name), _TRUNCATE, (i & 1) ? "route%03u.txt" : "gen%03u.txt", i / 2);
+		files[i].data = (uint8_t*)text.text;
+		files[i].size = (uint32_t)text.length;
+		textBuilt &= !text.failed;
+	}
 
+	uint32_t* hashTable = malloc(sizeof(uint32_t) << YAZ0_HASH_BITS);
+	uint32_t* chain = malloc(sizeof(uint32_t) * YAZ0_WINDOW_SIZE);
+	bool roundTripped = true;
+	for (uint32_t i = 0; i < archiveCount; i++)
+	{
+		uint32_t side = 32 << (nextSyntheticRandom(&random) % 3);
+		uint8_t noiseMask = (uint8_t)((1 << (nextSyntheticRandom(&random) % 5)) - 1);
 
+		struct archiveMember members[4] = { { "model.bmd" }, { "screen.blo" }, { "effect.jpc" }, { "icon.bti" } };
+		members[0].data = buildSyntheticModel(&random, side, noiseMask, &members[0].size);
+		int memberCount = 1;
+		if (i % 4 == 0)
+		{
+			uint8_t* icon = malloc(sizeof(struct BTI) + getTextureDataSize(0x5, SYNTHETIC_ICON_SIDE, SYNTHETIC_ICON_SIDE));
+			members[1].data = buildSyntheticScreen(&members[1].size);
+			members[2].data = buildSyntheticEffect(&members[2].size);
+			members[3].data = icon;
+			members[3].size = writeSyntheticIcon(icon, 5);
+			memberCount = 4;
+		}
+		uint32_t archiveSize;
+		uint8_t* archive = buildSyntheticArchive(members, memberCount, &archiveSize);
+
+		struct syntheticFile* file = &files[textFileCount + i];
+		_snprintf_s(file->name, sizeof(file->name), _TRUNCATE, "arc%03u.szs", i);
+		file->data = malloc(getYaz0Bound(archiveSize));
+		file->size = (uint32_t)encodeYaz0(archive, archiveSize, hashTable, chain, file->data);
+
+		uint8_t* check = malloc(archiveSize);
+		roundTripped &= decompressYaz0File(file->data, file->size, check) == 0 && memcmp(check, archive, archiveSize) == 0;
+		free(check);
+		free(archive);
+		for (int m = 0; m < memberCount; m++)
+			free((void*)members[m].data);
+	}
+	free(hashTable);
+	free(chain);
+
+	uint32_t dolSize;
+	uint8_t* dol = buildSyntheticDOL(&random, symbolMap, &dolSize);
+
+	static const char* directoryNames[] = { "user", "Abe", "Kando" };
+	uint32_t entryCount = 1 + countof(directoryNames) + fileCount;
+	uint32_t stringTableSize = 0;
+	for (uint32_t d = 0; d < countof(directoryNames); d++)
+		stringTableSize += (uint32_t)strlen(directoryNames[d]) + 1;
+	for (uint32_t i = 0; i < fileCount; i++)
+		stringTableSize += (uint32_t)strlen(files[i].name) + 1;
+	uint32_t fstSize = entryCount * sizeof(struct FileEntry) + stringTableSize;
+
+	uint64_t dolOffset = (SYNTHETIC_FST_OFFSET + fstSize + SYNTHETIC_DATA_ALIGNMENT - 1) & ~(uint64_t)(SYNTHETIC_DATA_ALIGNMENT - 1);
+	uint64_t dataStart = (dolOffset + dolSize + SYNTHETIC_DATA_ALIGNMENT - 1) & ~(uint64_t)(SYNTHETIC_DATA_ALIGNMENT - 1);
+	uint64_t size = dataStart;
+	for (uint32_t i = 0; i < fileCount; i++)
+		size += (files[i].size + 31) & ~31;
+
+	textBuilt &= symbolMap == nullptr || !symbolMap->failed;
+	uint8_t* image = roundTripped && textBuilt ? calloc(1, size) : nullptr;
+	if (image != nullptr)
+	{
+		struct DiskHeader* header = (struct DiskHeader*)image;
+		memcpy(&header->GameCode, "GPVE", 4);
+		memcpy(&header->MakerCode, "01", 2);
+		header->Magic = SwapEndian((uint32_t)GAMECUBE_DISC_MAGIC);
+		_snprintf_s(header->GameName, sizeof(header->GameName), _TRUNCATE, "synthetic image, seed %llu", seed);
+		header->DOLOffset = SwapEndian((uint32_t)dolOffset);
+		memcpy(image + dolOffset, dol, dolSize);
+		header->FSTOffset = SwapEndian((uint32_t)SYNTHETIC_FST_OFFSET);
+		header->FSTSize = SwapEndian(fstSize);
+		header->MaxFSTSize = SwapEndian(fstSize);
+
+		struct FileEntry* fst = OffsetPointer((struct FileEntry*)image, SYNTHETIC_FST_OFFSET);
+		char* strings = OffsetPointer((char*)fst, entryCount * sizeof(struct FileEntry));
+		uint32_t nameOffset = 0;
+		uint32_t entry = 0;
+
+		//directories: FileOffset is the parent entry, Unknown the entry after the last child
+		#define ADD_FST_ENTRY(flags, name, offset, next) do { \
+			fst[entry].Flags = (flags); \
+			fst[entry].FileNameOffsetp1 = (uint8_t)(nameOffset >> 16); \
+			fst[entry].FileNameOffsetp2 = (uint8_t)(nameOffset >> 8); \
+			fst[entry].FileNameOffsetp3 = (uint8_t)nameOffset; \
+			fst[entry].FileOffset = SwapEndian((uint32_t)(offset)); \
+			fst[entry].Unknown = SwapEndian((uint32_t)(next)); \
+			if ((name) != nullptr) { memcpy(strings + nameOffset, (name), strlen(name) + 1); nameOffset += (uint32_t)strlen(name) + 1; } \
+			entry++; } while (0)
+
+		uint64_t fileOffset = dataStart;
+		ADD_FST_ENTRY(1, (const char*)nullptr, 0, entryCount);
+		ADD_FST_ENTRY(1, directoryNames[0], 0, entryCount);
+		ADD_FST_ENTRY(1, directoryNames[1], 1, 3 + textFileCount);
+		for (uint32_t i = 0; i < fileCount; i++)
+		{
+			if (i == textFileCount)
+				ADD_FST_ENTRY(1, directoryNames[2], 1, entryCount);
+			memcpy(image + fileOffset, files[i].data, files[i].size);
+			ADD_FST_ENTRY(0, files[i].name, fileOffset, files[i].size);
+			fileOffset += (files[i].size + 31) & ~31;
+		}
+		#undef ADD_FST_ENTRY
+	}
 
-						const uint8_t* src = OffsetPointer(gameFileList[selectedFileIndex].filePtr, sizeof(struct yaz0Header));// pointer to start of source
-						const uint8_t* src_end = OffsetPointer(src, gameFileList[selectedFileIndex].fileSize - sizeof(struct yaz0Header));// pointer to end of source (last byte +1)
-						//todo: malloc is temporary
-						uint8_t* dest = malloc(SwapEndian(header->uncompressedSize));// pointer to start of destination
-						memset(dest, 0, SwapEndian(header->uncompressedSize));
-						uint8_t* dest_end = OffsetPointer(dest, SwapEndian(header->uncompressedSize));// pointer to end of destination (last byte +1)
+	for (uint32_t i = 0; i < fileCount; i++)
+		free(files[i].data);
+	free(files);
+	free(dol);
 
-						int decompressionStatus = DecompressYAZ(
-							src,//data
-							gameFileList[selectedFileIndex].fileSize - sizeof(struct yaz0Header),//data size
-							dest,//dest buf
-							SwapEndian(header->uncompressedSize),
-							nullptr,//write status
-							0,//yaz version (pikmin 2 uses yaz0)
-							true,
-							nullptr
-							);
+	*imageSize = image != nullptr ? size : 0;
+	return image;
+}
 
-						printf("decompression status: %i\n", decompressionStatus);
+int runWriteSyntheticImage(const char* path, uint64_t seed)
+{
+	double start = getTimeSeconds();
+	uint64_t imageSize;
+	struct textBuilder symbolMap = { 0 };
+	uint8_t* image = generateSyntheticImage(seed, SYNTHETIC_ARCHIVES, SYNTHETIC_TEXT_FILES, &symbolMap, &imageSize);
+	if (image == nullptr)
+	{
+		printf("yaz0 round trip or text generation failed, no image written\n");
+		free(symbolMap.text);
+		return -1;
+	}
 
-						//for (int j = 180; j < 512; j++)
-						//for (int j = 192; j < 512; j++)
-						//for (int j = 224; j < 512; j++)
-						//{
-						//	printf("%c", dest[j]);
-						//}
+	HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	bool written = file != INVALID_HANDLE_VALUE && writeFileData(file, image, imageSize);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	free(image);
+
+	//the DOL's symbols go next to the image, for -dol and -benchdol
+	char mapPath[MAX_PATH];
+	_snprintf_s(mapPath, sizeof(mapPath), _TRUNCATE, "%s.map", path);
+	file = written ? CreateFileA(mapPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) : INVALID_HANDLE_VALUE;
+	written = file != INVALID_HANDLE_VALUE && writeFileData(file, symbolMap.text, symbolMap.length);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	free(symbolMap.text);
+
+	if (!written)
+	{
+		printf("unable to write %s\n", path);
+		return -1;
+	}
+	printf("synthetic image (seed %llu): %llu bytes written to %s, symbols to %s in %.1f ms\n", seed, imageSize, path, mapPath, (getTimeSeconds() - start) * 1000.0);
+	return 0;
+}
 
-						//printf("\n");
+/*
+* benchmark suite
+* runs the FST walk, DecompressYAZ, decodeTexture (per format), CMPR encoding and the DOL symbol stages over a synthetic image, single threaded so the figures
+* are comparable between runs. every stage runs once to warm up, then SUITE_ITERATIONS timed times.
+* medians are compared with the baseline file, a stage more than threshold percent slower fails the suite
+*/
+#define SUITE_ITERATIONS 101
+#define SUITE_SEED 1
+#define SUITE_NOISE_FLOOR 0.01//ms, slowdowns smaller than this are timer noise and never fail the suite
 
-						//todo: sort different files by type, but for now just assume its always bmd
+struct suiteStage
+{
+	char name[32];
+	uint64_t bytes;//processed per iteration
+	double samples[SUITE_ITERATIONS];//ms
+	double median;
+	double p99;
+};
 
-						{
-							struct J3DFileHeader {
-								uint32_t J3DVersion;
-								uint32_t fileVersion;
-								uint8_t unknown1[4];
-								uint32_t blockCount;
-								uint8_t unknown2[16];
-							};
+static int compareSuiteSamples(const void* a, const void* b)
+{
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
 
-							//todo: temporary hardcoded offset
-							const struct J3DFileHeader* bmdFileHeader = OffsetPointer(dest, 192);
+static void finishSuiteStage(struct suiteStage* stage)
+{
+	qsort(stage->samples, SUITE_ITERATIONS, sizeof(double), compareSuiteSamples);
+	stage->median = stage->samples[SUITE_ITERATIONS / 2];
+	//nearest rank
+	stage->p99 = stage->samples[(SUITE_ITERATIONS * 99 + 99) / 100 - 1];
+}
 
-							printf("block count: %i\n", SwapEndian(bmdFileHeader->blockCount));
+//returns the baseline median for name, or a negative number
+static double findBaselineMedian(const char* baseline, const char* name)
+{
+	size_t nameLength = strlen(name);
+	for (const char* line = baseline; line != nullptr && *line != 0; line = strchr(line, '\n'), line = line ? line + 1 : nullptr)
+	{
+		if (*line != '#' && strncmp(line, name, nameLength) == 0 && (line[nameLength] == ' ' || line[nameLength] == '\t'))
+			return strtod(line + nameLength, nullptr);
+	}
+	return -1.0;
+}
 
-							const void* bmdFile = OffsetPointer(bmdFileHeader, sizeof(struct J3DFileHeader));
-							decodedAssetCount = 0;
+int runBenchmarkSuite(const char* baselinePath, double threshold)
+{
+	uint64_t imageSize;
+	struct textBuilder symbolMapText = { 0 };
+	uint8_t* image = generateSyntheticImage(SUITE_SEED, SYNTHETIC_ARCHIVES, SYNTHETIC_TEXT_FILES, &symbolMapText, &imageSize);
+	if (image == nullptr)
+	{
+		printf("yaz0 round trip or text generation failed\n");
+		free(symbolMapText.text);
+		return -1;
+	}
+	GameImageAddress = image;
+	GameImageSize = imageSize;
+	GameImagePath = "synthetic";
+	indexGameFiles(nullptr);
+
+	//every archive is decompressed up front once so the texture stages don't depend on the yaz0 one
+	uint8_t** archives = calloc(gameFileCount, sizeof(uint8_t*));
+	struct btiTexture* textures = malloc(sizeof(struct btiTexture) * SYNTHETIC_ARCHIVES * countof(syntheticTextureFormats));
+	uint32_t textureCount = 0;
+	uint64_t compressedBytes = 0;
+	uint64_t decompressedBytes = 0;
+	size_t maxDecodedSize = 0;
+	for (int f = 0; f < gameFileCount; f++)
+	{
+		if (!isYaz0(gameFileList[f].filePtr, gameFileList[f].fileSize))
+			continue;
+		uint32_t size = getYaz0UncompressedSize(gameFileList[f].filePtr);
+		archives[f] = malloc(size);
+		decompressYaz0File(gameFileList[f].filePtr, gameFileList[f].fileSize, archives[f]);
+		compressedBytes += gameFileList[f].fileSize;
+		decompressedBytes += size;
+
+		struct archiveMember members[4];
+		int memberCount = listRarcMembers(archives[f], size, members, countof(members));
+		for (int m = 0; m < memberCount; m++)
+		{
+			const struct TEX1* tex1 = isJ3DModel(members[m].data, members[m].size) ? (const struct TEX1*)findJ3DChunk(members[m].data, members[m].size, "TEX1") : nullptr;
+			for (uint32_t t = 0; tex1 != nullptr && t < (uint16_t)SwapEndian(tex1->textureCount); t++)
+			{
+				if (loadTEX1Texture(tex1, t, &textures[textureCount]))
+				{
+					maxDecodedSize = max(maxDecodedSize, getDecodedTextureSize(textures[textureCount].width, textures[textureCount].height));
+					textureCount++;
+				}
+			}
+		}
+	}
+	uint8_t* pixels = malloc(max(maxDecodedSize, 1));
 
-							void* decodedAssetFreeZone = decodedAssetData;
+	struct suiteStage* stages = calloc(6 + countof(syntheticTextureFormats), sizeof(struct suiteStage));
+	uint32_t stageCount = 0;
 
+	struct suiteStage* stage = &stages[stageCount++];
+	_snprintf_s(stage->name, sizeof(stage->name), _TRUNCATE, "indexGameFiles");
+	stage->bytes = SwapEndian(((const struct DiskHeader*)GameImageAddress)->FSTSize);
+	for (int i = -1; i < SUITE_ITERATIONS; i++)
+	{
+		double start = getTimeSeconds();
+		indexGameFiles(nullptr);
+		if (i >= 0)
+			stage->samples[i] = (getTimeSeconds() - start) * 1000.0;
+	}
 
-							//iterate over bmd sections
-							struct bmdSection
-							{
-								char chunkType[4];
-								int32_t size;
-							};
-							const struct bmdSection* currentSection = bmdFile;
+	stage = &stages[stageCount++];
+	_snprintf_s(stage->name, sizeof(stage->name), _TRUNCATE, "DecompressYAZ");
+	stage->bytes = decompressedBytes;
+	for (int i = -1; i < SUITE_ITERATIONS; i++)
+	{
+		double start = getTimeSeconds();
+		for (int f = 0; f < gameFileCount; f++)
+			if (archives[f] != nullptr)
+				decompressYaz0File(gameFileList[f].filePtr, gameFileList[f].fileSize, archives[f]);
+		if (i >= 0)
+			stage->samples[i] = (getTimeSeconds() - start) * 1000.0;
+	}
 
-							for (int i = 0; i < SwapEndian(bmdFileHeader->blockCount); i++)
-							{
-								printf("chunk type: %c%c%c%c\n",
-									currentSection->chunkType[0],
-									currentSection->chunkType[1],
-									currentSection->chunkType[2],
-									currentSection->chunkType[3]
-								);
+	for (uint32_t format = 0; format < countof(syntheticTextureFormats); format++)
+	{
+		stage = &stages[stageCount++];
+		_snprintf_s(stage->name, sizeof(stage->name), _TRUNCATE, "decodeTexture/%s", textureFormatNames[syntheticTextureFormats[format]]);
+		for (uint32_t t = 0; t < textureCount; t++)
+			if (textures[t].format == syntheticTextureFormats[format])
+				stage->bytes += textures[t].dataSize;
 
-								if (
-									currentSection->chunkType[0] == 'I' &&
-									currentSection->chunkType[1] == 'N' &&
-									currentSection->chunkType[2] == 'F' &&
-									currentSection->chunkType[3] == '1'
-									)
-								{
-									struct INF1
-									{
-										char chunkType[4];
-										int32_t size;
-										int16_t miscFlags;
-										int16_t padding;
-										int32_t matrixGroupCount;
-										int32_t vertexCount;
-										int32_t hierarchyDataOffset;
-									};
+		for (int i = -1; i < SUITE_ITERATIONS; i++)
+		{
+			double start = getTimeSeconds();
+			for (uint32_t t = 0; t < textureCount; t++)
+				if (textures[t].format == syntheticTextureFormats[format])
+					decodeTexture(textures[t].width, textures[t].height, textures[t].width * textures[t].height, textures[t].data, pixels, textures[t].format);
+			if (i >= 0)
+				stage->samples[i] = (getTimeSeconds() - start) * 1000.0;
+		}
+	}
 
-									const struct INF1* header = currentSection;
+	//the CMPR textures decoded once, then encoded back at the default quality
+	size_t cmprPixelsSize = 0;
+	uint32_t maxCMPRSize = 0;
+	for (uint32_t t = 0; t < textureCount; t++)
+	{
+		if (textures[t].format != GX_TF_CMPR)
+			continue;
+		cmprPixelsSize += getDecodedTextureSize(textures[t].width, textures[t].height);
+		maxCMPRSize = max(maxCMPRSize, textures[t].dataSize);
+	}
+	uint8_t* cmprPixels = malloc(max(cmprPixelsSize, 1));
+	uint8_t* cmprData = malloc(max(maxCMPRSize, 1));
+	uint8_t* decoded = cmprPixels;
+	for (uint32_t t = 0; t < textureCount; t++)
+	{
+		if (textures[t].format != GX_TF_CMPR)
+			continue;
+		decodeTexture(textures[t].width, textures[t].height, textures[t].width * textures[t].height, textures[t].data, decoded, GX_TF_CMPR);
+		decoded += getDecodedTextureSize(textures[t].width, textures[t].height);
+	}
+	stage = &stages[stageCount++];
+	_snprintf_s(stage->name, sizeof(stage->name), _TRUNCATE, "encodeTexture/CMPR");
+	for (int i = -1; i < SUITE_ITERATIONS; i++)
+	{
+		double start = getTimeSeconds();
+		decoded = cmprPixels;
+		stage->bytes = 0;
+		for (uint32_t t = 0; t < textureCount; t++)
+		{
+			if (textures[t].format != GX_TF_CMPR)
+				continue;
+			encodeTexture(textures[t].width, textures[t].height, decoded, cmprData, GX_TF_CMPR, CMPR_QUALITY_NORMAL, false);
+			decoded += getDecodedTextureSize(textures[t].width, textures[t].height);
+			stage->bytes += (uint64_t)textures[t].width * textures[t].height * 4;
+		}
+		if (i >= 0)
+			stage->samples[i] = (getTimeSeconds() - start) * 1000.0;
+	}
+	free(cmprPixels);
+	free(cmprData);
+
+	struct symbolMap symbolMap;
+	bool symbolsParsed = true;
+	stage = &stages[stageCount++];
+	_snprintf_s(stage->name, sizeof(stage->name), _TRUNCATE, "parseSymbolMap");
+	stage->bytes = symbolMapText.length;
+	for (int i = -1; i < SUITE_ITERATIONS; i++)
+	{
+		double start = getTimeSeconds();
+		symbolsParsed &= parseSymbolMap(symbolMapText.text, &symbolMap);
+		if (i >= 0)
+			stage->samples[i] = (getTimeSeconds() - start) * 1000.0;
+		if (i + 1 < SUITE_ITERATIONS)
+			freeSymbolMap(&symbolMap);
+	}
 
-									printf("size: %i\n", SwapEndian(header->size));
+	//one lookup into the middle of every symbol
+	stage = &stages[stageCount++];
+	_snprintf_s(stage->name, sizeof(stage->name), _TRUNCATE, "findSymbolByAddress");
+	for (int i = -1; i < SUITE_ITERATIONS; i++)
+	{
+		double start = getTimeSeconds();
+		uint32_t found = 0;
+		for (uint32_t s = 0; s < symbolMap.count; s++)
+			found += findSymbolByAddress(&symbolMap, symbolMap.symbols[s].address + symbolMap.symbols[s].size / 2) != nullptr;
+		if (i >= 0)
+			stage->samples[i] = (getTimeSeconds() - start) * 1000.0;
+		stage->bytes = found * sizeof(struct dolSymbol);
+	}
 
-									printf("vertex count: %i\n", SwapEndian(header->vertexCount));
+	//every data symbol looked up by name and copied out of the DOL
+	struct dolImage dol;
+	getGameDOL(&dol);
+	uint64_t dataSize = getDOLDataSize(&dol);
+	uint8_t* tables = malloc(max(dataSize, 1));
+	stage = &stages[stageCount++];
+	_snprintf_s(stage->name, sizeof(stage->name), _TRUNCATE, "extractDOLTables");
+	for (int i = -1; i < SUITE_ITERATIONS; i++)
+	{
+		double start = getTimeSeconds();
+		uint32_t tableCount;
+		stage->bytes = extractDOLTables(&dol, &symbolMap, tables, dataSize, &tableCount);
+		if (i >= 0)
+			stage->samples[i] = (getTimeSeconds() - start) * 1000.0;
+	}
+	free(tables);
+	freeSymbolMap(&symbolMap);
+	free(symbolMapText.text);
+
+	char* baseline = baselinePath != nullptr ? readTextFile(baselinePath) : nullptr;
+	printf("synthetic image: %d files, %llu bytes, %u textures, yaz0 %.2fx (%llu -> %llu bytes)\n",
+		gameFileCount, GameImageSize, textureCount, (double)decompressedBytes / max(compressedBytes, 1), compressedBytes, decompressedBytes);
+	printf("%u iterations per stage, single threaded\n\n", SUITE_ITERATIONS);
+	printf("%-24s %10s %10s %10s %10s %8s\n", "stage", "median ms", "p99 ms", "MB/s", "baseline", "change");
+
+	uint32_t regressions = 0;
+	struct textBuilder newBaseline = { 0 };
+	appendText(&newBaseline, "# stage median_ms p99_ms, written by -benchsuite (%u iterations)\n", SUITE_ITERATIONS);
+	for (uint32_t s = 0; s < stageCount; s++)
+	{
+		stage = &stages[s];
+		finishSuiteStage(stage);
+		appendText(&newBaseline, "%s %.6f %.6f\n", stage->name, stage->median, stage->p99);
 
-									printf("hierarchy data offset: %i\n", SwapEndian(header->hierarchyDataOffset));
+		printf("%-24s %10.4f %10.4f %10.1f", stage->name, stage->median, stage->p99, stage->median > 0.0 ? stage->bytes / (stage->median * 1000.0) : 0.0);
+		double baselineMedian = baseline != nullptr ? findBaselineMedian(baseline, stage->name) : -1.0;
+		if (baselineMedian > 0.0)
+		{
+			double change = (stage->median / baselineMedian - 1.0) * 100.0;
+			bool regressed = change > threshold && stage->median - baselineMedian > SUITE_NOISE_FLOOR;
+			regressions += regressed;
+			printf(" %10.4f %+7.1f%%%s\n", baselineMedian, change, regressed ? "  REGRESSION" : "");
+		}
+		else
+		{
+			printf(" %10s %8s\n", "-", "-");
+		}
+	}
 
-									struct hierarchyNode
-									{
-										short NodeType;
-										short Data;
-									};
+	int result = 0;
+	if (baselinePath != nullptr && baseline == nullptr)
+	{
+		HANDLE file = newBaseline.failed ? INVALID_HANDLE_VALUE : CreateFileA(baselinePath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		bool written = file != INVALID_HANDLE_VALUE && writeFileData(file, newBaseline.text, newBaseline.length);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		printf(written ? "\nno baseline yet, written to %s\n" : "\nunable to write the baseline to %s\n", baselinePath);
+	}
+	else if (baseline != nullptr)
+	{
+		printf("\n%u of %u stages more than %.1f%% slower than %s\n", regressions, stageCount, threshold, baselinePath);
+		result = regressions != 0 ? 1 : 0;
+	}
+	if (!symbolsParsed)
+	{
+		printf("the symbol map didn't fit in memory, its stages timed an empty map\n");
+		result = -1;
+	}
 
-									const struct hierarchyNode* bmdHierarchy = OffsetPointer(bmdFile, SwapEndian(header->hierarchyDataOffset));
+	free(newBaseline.text);
+	free(baseline);
+	free(stages);
+	free(pixels);
+	free(textures);
+	for (int f = 0; f < gameFileCount; f++)
+		free(archives[f]);
+	free(archives);
+	free(image);
+	return result;
+}
 
-									int hierarchyNodeDepth = 0;
-									for (int hierarchyNodeIndex = 0; bmdHierarchy[hierarchyNodeIndex].NodeType != 0x00; hierarchyNodeIndex++)
-									{
-										for (int i = 0; i < hierarchyNodeDepth; i++)
-											printf("\t");
+/*
+* fuzzing
+* fuzzOneInput runs one reader over one input: the disc header and FST walk, yaz0, RARC, J3D models, BTI textures, JPC
+* particle files and BLO screens.
+* -fuzz mutates the files of a generated image and feeds them through it in process, a run is reproduced by its seed.
+* building with FUZZER_ENTRY (and /fsanitize=fuzzer on MSVC or clang-cl) exports the same function to libFuzzer instead.
+*/
+#define FUZZ_IMAGE 0
+#define FUZZ_YAZ0 1
+#define FUZZ_RARC 2
+#define FUZZ_J3D 3
+#define FUZZ_BTI 4
+#define FUZZ_JPC 5
+#define FUZZ_BLO 6
+#define FUZZ_TARGET_COUNT 7
+#define FUZZ_MAX_OUTPUT (1024 * 1024 * 16)
+#define FUZZ_MAX_MEMBERS 256
+
+static const char* fuzzTargetNames[FUZZ_TARGET_COUNT] = { "image", "yaz0", "rarc", "j3d", "bti", "jpc", "blo" };
+static uint8_t* fuzzOutput;
+static struct archiveMember* fuzzMembers;
+
+//main isn't run under libFuzzer, so the buffers the readers write to are created on the first input
+static void initFuzzBuffers()
+{
+	if (fuzzOutput != nullptr)
+		return;
+	fuzzOutput = malloc(FUZZ_MAX_OUTPUT);
+	fuzzMembers = malloc(sizeof(struct archiveMember) * FUZZ_MAX_MEMBERS);
+	if (modelWorkspace == nullptr)
+		modelWorkspace = trackedAlloc(MEMORY_MODELS, MODEL_WORKSPACE_SIZE);
+}
 
-										switch (SwapEndian(bmdHierarchy[hierarchyNodeIndex].NodeType))
-										{
-										case 0x00:
-											break;
-										case 0x01:
-											printf("new node\n");;
-											hierarchyNodeDepth++;
-											break;
-										case 0x02:
-											printf("end of node\n");
-											hierarchyNodeDepth--;
-											break;
-										case 0x10:
-											printf("joint (0x%X)\n", SwapEndian(SwapEndian(bmdHierarchy[hierarchyNodeIndex].Data)));
-											break;
-										case 0x11:
-											printf("material (0x%X)\n", SwapEndian(SwapEndian(bmdHierarchy[hierarchyNodeIndex].Data)));
-											break;
-										case 0x12:
-											printf("shape (0x%X)\n", SwapEndian(SwapEndian(bmdHierarchy[hierarchyNodeIndex].Data)));
-											break;
-										default:
-											DebugBreak();
-											break;
-										}
-									}
+static void fuzzTexture(const struct btiTexture* texture)
+{
+	if (getDecodedTextureSize(texture->width, texture->height) > FUZZ_MAX_OUTPUT)
+		return;
+	struct decodedImage image;
+	decodeBTITexture(texture, fuzzOutput, &image);
+}
 
-									printf("end of hierarchy\n");
-								}
-								else if (
-									currentSection->chunkType[0] == 'V' &&
-									currentSection->chunkType[1] == 'T' &&
-									currentSection->chunkType[2] == 'X' &&
-									currentSection->chunkType[3] == '1')
-								{
-									printf("reading VTX1\n");
-								}
-								else if (
-									currentSection->chunkType[0] == 'E' &&
-									currentSection->chunkType[1] == 'V' &&
-									currentSection->chunkType[2] == 'P' &&
-									currentSection->chunkType[3] == '1')
-								{
-									printf("reading EVP1\n");
-								}
-								else if (
-									currentSection->chunkType[0] == 'D' &&
-									currentSection->chunkType[1] == 'R' &&
-									currentSection->chunkType[2] == 'W' &&
-									currentSection->chunkType[3] == '1')
-								{
-									printf("reading DRW1\n");
-								}
-								else if (
-									currentSection->chunkType[0] == 'J' &&
-									currentSection->chunkType[1] == 'N' &&
-									currentSection->chunkType[2] == 'T' &&
-									currentSection->chunkType[3] == '1')
-								{
-									printf("reading JNT1\n");
-								}
-								else if (
-									currentSection->chunkType[0] == 'S' &&
-									currentSection->chunkType[1] == 'H' &&
-									currentSection->chunkType[2] == 'P' &&
-									currentSection->chunkType[3] == '1')
-								{
-									printf("reading SHP1\n");
-								}
-								else if (
-									currentSection->chunkType[0] == 'M' &&
-									currentSection->chunkType[1] == 'A' &&
-									currentSection->chunkType[2] == 'T' &&
-									currentSection->chunkType[3] == '3')
-								{
-									printf("reading MAT3\n");
-								}
-								else if (
-									currentSection->chunkType[0] == 'T' &&
-									currentSection->chunkType[1] == 'E' &&
-									currentSection->chunkType[2] == 'X' &&
-									currentSection->chunkType[3] == '1')
-								{
-									printf("reading TEX1\n");
+static void fuzzModel(const void* data, uint32_t size)
+{
+	struct j3dModel model;
+	if (!parseJ3DModel(data, size, modelWorkspace, MODEL_WORKSPACE_SIZE, &model) || model.textures == nullptr)
+		return;
 
-									struct TEX1
-									{
-										char chunkType[4];
-										int32_t size;
-										uint16_t textureCount;
-										uint16_t padding;
-										int32_t textureHeaderOffset;
-										int32_t stringTableOffset;
-									};
+	const void* names = getJ3DNameTable(model.textures, SwapEndian(model.textures->stringTableOffset));
+	for (uint32_t t = 0; t < (uint16_t)SwapEndian(model.textures->textureCount); t++)
+	{
+		struct btiTexture texture;
+		getJ3DName(names, t);
+		if (loadTEX1Texture(model.textures, t, &texture))
+			fuzzTexture(&texture);
+	}
+}
 
+static void fuzzEffect(const void* data, uint32_t size)
+{
+	struct jpcFile jpc;
+	if (!parseJPC(data, size, modelWorkspace, MODEL_WORKSPACE_SIZE, &jpc))
+		return;
+	for (uint32_t t = 0; t < jpc.textureCount; t++)
+		if (jpc.textures[t].texture.data != nullptr)
+			fuzzTexture(&jpc.textures[t].texture);
+}
 
-									const struct TEX1* header = currentSection;
+static void fuzzScreen(const void* data, uint32_t size, const struct archiveMember* members, int memberCount)
+{
+	struct screenLayout screen;
+	if (parseBLO(data, size, modelWorkspace, MODEL_WORKSPACE_SIZE, &screen))
+		resolveScreenTextures(&screen, members, memberCount);
+}
 
+int fuzzOneInput(int target, const uint8_t* data, size_t size)
+{
+	initFuzzBuffers();
+	if (size > UINT32_MAX)
+		return 0;
 
-									printf("texture count: %i\n", SwapEndian(header->textureCount));
+	if (target == FUZZ_IMAGE)
+	{
+		GameImageAddress = (void*)data;
+		GameImageSize = size;
+		indexGameFiles(nullptr);
+		char path[256];
+		for (int i = 0; i < gameFileCount; i++)
+			getGameFilePath(i, path, sizeof(path));
+	}
+	else if (target == FUZZ_YAZ0)
+	{
+		if (!isYaz0(data, (uint32_t)size))
+			return 0;
+		struct yaz0Stats stats = { 0 };
+		analyzeYaz0Stream(data, (uint32_t)size, &stats);
+		if (getYaz0UncompressedSize(data) <= FUZZ_MAX_OUTPUT)
+			decompressYaz0File(data, (uint32_t)size, fuzzOutput);
+	}
+	else if (target == FUZZ_RARC)
+	{
+		if (!isRarc(data, (uint32_t)size))
+			return 0;
+		int memberCount = listRarcMembers(data, (uint32_t)size, fuzzMembers, FUZZ_MAX_MEMBERS);
+		for (int i = 0; i < memberCount; i++)
+		{
+			if (nameHasExtension(fuzzMembers[i].name, ".bmd") || nameHasExtension(fuzzMembers[i].name, ".bdl"))
+				fuzzModel(fuzzMembers[i].data, fuzzMembers[i].size);
+			else if (nameHasExtension(fuzzMembers[i].name, ".blo"))
+				fuzzScreen(fuzzMembers[i].data, fuzzMembers[i].size, fuzzMembers, memberCount);
+		}
+	}
+	else if (target == FUZZ_J3D)
+	{
+		fuzzModel(data, (uint32_t)size);
+	}
+	else if (target == FUZZ_BTI)
+	{
+		struct btiTexture texture;
+		if (loadBTITexture(data, size, &texture))
+			fuzzTexture(&texture);
+	}
+	else if (target == FUZZ_JPC)
+	{
+		fuzzEffect(data, (uint32_t)size);
+	}
+	else if (target == FUZZ_BLO)
+	{
+		fuzzScreen(data, (uint32_t)size, nullptr, 0);
+	}
+	return 0;
+}
 
-									struct BTI
-									{
-										int8_t format;
-										bool alphaEnabled;
-										int16_t width;
-										int16_t height;
-										int8_t wrapS;
-										int8_t wrapT;
-										bool palettesEnabled;
-										int8_t palletteFormat;
-										int16_t palletteCount;
-										int32_t palletteOffset;
-										bool mipsEnabled;
-										bool doEdgeLOD;
-										bool biasClamp;
-										int8_t maxAnisotropy;
-										int8_t GXMinFilter;
-										int8_t GXMaxFilter;
-										int8_t MinLOD;
-										int8_t MaxLOD;
-										int8_t mipCount;
-										int8_t unknown;
-										int16_t LODBias;
-										int32_t textureDataOffset;
-									};
-
-									const struct BTI* BTIHeaderTable = OffsetPointer(header, SwapEndian(header->textureHeaderOffset));
+#ifdef FUZZER_ENTRY
+//the first byte picks the reader, the rest is its input
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	if (size == 0)
+		return 0;
+	return fuzzOneInput(data[0] % FUZZ_TARGET_COUNT, data + 1, size - 1);
+}
+#endif
 
-									for (int texNum = 0; texNum < SwapEndian(header->textureCount); texNum++)
-									{
-										printf("texture format: 0x%X\n", + BTIHeaderTable[texNum].format);
-										printf("texture size: %i x %i\n", SwapEndian(BTIHeaderTable[texNum].width), SwapEndian(BTIHeaderTable[texNum].height));
-										printf("offset in file: 0x%X\n", SwapEndian(BTIHeaderTable[texNum].textureDataOffset));
+struct fuzzSeed
+{
+	int target;
+	const uint8_t* data;
+	uint32_t size;
+};
 
-										struct decodedImage* imageHeader = decodedAssetFreeZone;
-										decodedAssetFreeZone = OffsetPointer(decodedAssetFreeZone, sizeof(struct decodedImage));
+//the values most likely to break a size or offset check
+static const uint32_t fuzzInterestingValues[] = { 0, 1, 0x7F, 0x80, 0xFF, 0x7FFF, 0x8000, 0xFFFF, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF };
 
-										imageHeader->width = SwapEndian(BTIHeaderTable[texNum].width);
-										imageHeader->height = SwapEndian(BTIHeaderTable[texNum].height);
-										imageHeader->pixelCount = SwapEndian(BTIHeaderTable[texNum].width) * SwapEndian(BTIHeaderTable[texNum].height);
+//a few byte flips, interesting values over aligned words and a random truncation, the bytes that change are what the readers trust
+static uint32_t mutateFuzzInput(uint64_t* random, const struct fuzzSeed* seed, uint8_t* _Out_ input)
+{
+	memcpy(input, seed->data, seed->size);
+	uint32_t size = seed->size;
+	uint32_t mutationCount = 1 + nextSyntheticRandom(random) % 8;
+	for (uint32_t m = 0; m < mutationCount && size >= 4; m++)
+	{
+		uint32_t kind = nextSyntheticRandom(random) % 8;
+		uint32_t offset = nextSyntheticRandom(random) % size;
+		if (kind < 4)
+			input[offset] ^= 1 << (kind * 2 + (nextSyntheticRandom(random) & 1));
+		else if (kind < 6)
+			input[offset] = (uint8_t)nextSyntheticRandom(random);
+		else if (kind == 6)
+		{
+			uint32_t value = SwapEndian(fuzzInterestingValues[nextSyntheticRandom(random) % countof(fuzzInterestingValues)]);
+			memcpy(input + min(offset & ~3u, size - 4), &value, 4);
+		}
+		else
+			size = max(offset, 4);
+	}
+	return size;
+}
 
-										imageHeader->pixels = decodedAssetFreeZone;
-										decodedAssetFreeZone += imageHeader->pixelCount * 4;
-										decodeTexture(imageHeader->width, imageHeader->height, imageHeader->pixelCount, OffsetPointer(&BTIHeaderTable[texNum], SwapEndian(BTIHeaderTable[texNum].textureDataOffset)), imageHeader->pixels, BTIHeaderTable->format);
+/*
+* a bmd whose SHP1 has one shape, remapped to a second one past the shape count. the second shape's packets, matrix
+* data and descriptor list are all out of range, synthetic models have no SHP1 to mutate into this
+*/
+static uint8_t* buildShapeRemapFuzzSeed(uint32_t* _Out_ size)
+{
+	const uint32_t inf1Size = 0x20;
+	const uint32_t shp1Size = 0xC0;
+	*size = sizeof(struct J3DFileHeader) + inf1Size + shp1Size;
+	uint8_t* file = calloc(1, *size);
+	if (file == nullptr)
+		return nullptr;
+
+	struct J3DFileHeader* header = (struct J3DFileHeader*)file;
+	memcpy(&header->J3DVersion, "J3D2", 4);
+	memcpy(&header->fileVersion, "bmd3", 4);
+	uint32_t swappedSize = SwapEndian(*size);
+	memcpy(header->unknown1, &swappedSize, 4);
+	header->blockCount = SwapEndian(2u);
+
+	//a single 0x00 end node
+	struct INF1* inf1 = OffsetPointer((struct INF1*)file, sizeof(struct J3DFileHeader));
+	memcpy(inf1->chunkType, "INF1", 4);
+	inf1->size = SwapEndian((int32_t)inf1Size);
+	inf1->hierarchyDataOffset = SwapEndian(0x18);
+
+	//shapes at 0x30, remap at 0x80, descriptors at 0x84, matrix table at 0x8C, display list at 0x90, matrix data at 0xB0, packet at 0xB8
+	struct SHP1* shp1 = OffsetPointer((struct SHP1*)inf1, inf1Size);
+	memcpy(shp1->chunkType, "SHP1", 4);
+	shp1->size = SwapEndian((int32_t)shp1Size);
+	shp1->shapeCount = SwapEndian((uint16_t)1);
+	shp1->shapeDataOffset = SwapEndian(0x30u);
+	shp1->remapOffset = SwapEndian(0x80u);
+	shp1->vertexDescriptorOffset = SwapEndian(0x84u);
+	shp1->matrixTableOffset = SwapEndian(0x8Cu);
+	shp1->displayListOffset = SwapEndian(0x90u);
+	shp1->matrixDataOffset = SwapEndian(0xB0u);
+	shp1->packetOffset = SwapEndian(0xB8u);
+
+	struct shapeData* shapes = OffsetPointer((struct shapeData*)shp1, 0x30);
+	shapes[0].packetCount = SwapEndian((uint16_t)1);
+	shapes[1].packetCount = SwapEndian((uint16_t)0xFFFF);
+	shapes[1].vertexDescriptorOffset = SwapEndian((uint16_t)0x7FF0);
+	shapes[1].firstMatrixData = SwapEndian((uint16_t)0x7FFF);
+	shapes[1].firstPacket = SwapEndian((uint16_t)0x7FFF);
+	*(uint16_t*)OffsetPointer(shp1, 0x80) = SwapEndian((uint16_t)1);
+
+	struct vertexDescriptor* descriptor = OffsetPointer((struct vertexDescriptor*)shp1, 0x84);
+	descriptor->attribute = SwapEndian((uint32_t)GX_VA_NULL);
+	struct shapeMatrixData* matrixData = OffsetPointer((struct shapeMatrixData*)shp1, 0xB0);
+	matrixData->matrixCount = SwapEndian((uint16_t)1);
+	struct shapePacket* packet = OffsetPointer((struct shapePacket*)shp1, 0xB8);
+	packet->displayListSize = SwapEndian(0x20u);
+	return file;
+}
 
+int runFuzzer(uint32_t iterations, uint64_t seedValue)
+{
+	uint64_t imageSize;
+	uint8_t* image = generateSyntheticImage(seedValue, SYNTHETIC_ARCHIVES / 4, SYNTHETIC_TEXT_FILES / 4, nullptr, &imageSize);
+	if (image == nullptr)
+	{
+		printf("yaz0 round trip or text generation failed\n");
+		return -1;
+	}
+	GameImageAddress = image;
+	GameImageSize = imageSize;
+	GameImagePath = "synthetic";
+	initFuzzBuffers();
+	indexGameFiles(nullptr);
+
+	//the seeds: the disc header and FST, every .szs, the archive inside it, its models and their textures as bti files,
+	//its particle files and its screens, and a model whose shape remap points past the shape count
+	uint32_t maxSeeds = 2 + gameFileCount * (2 + FUZZ_MAX_MEMBERS);
+	struct fuzzSeed* seeds = malloc(sizeof(struct fuzzSeed) * maxSeeds);
+	uint8_t** archives = calloc(gameFileCount, sizeof(uint8_t*));
+	uint32_t seedCount = 0;
+	uint32_t maxSeedSize = 0;
+
+	const struct DiskHeader* header = GameImageAddress;
+	seeds[seedCount++] = (struct fuzzSeed){ FUZZ_IMAGE, image, SwapEndian(header->FSTOffset) + SwapEndian(header->FSTSize) };
+	uint32_t remapSeedSize;
+	uint8_t* remapSeed = buildShapeRemapFuzzSeed(&remapSeedSize);
+	if (remapSeed != nullptr)
+		seeds[seedCount++] = (struct fuzzSeed){ FUZZ_J3D, remapSeed, remapSeedSize };
+	int fileCount = gameFileCount;
+	for (int f = 0; f < fileCount; f++)
+	{
+		const uint8_t* file = gameFileList[f].filePtr;
+		uint32_t fileSize = gameFileList[f].fileSize;
+		if (!isYaz0(file, fileSize))
+			continue;
+		seeds[seedCount++] = (struct fuzzSeed){ FUZZ_YAZ0, file, fileSize };
+
+		uint32_t archiveSize = getYaz0UncompressedSize(file);
+		archives[f] = malloc(archiveSize);
+		if (decompressYaz0File(file, fileSize, archives[f]) != 0 || !isRarc(archives[f], archiveSize))
+			continue;
+		seeds[seedCount++] = (struct fuzzSeed){ FUZZ_RARC, archives[f], archiveSize };
+
+		struct archiveMember members[FUZZ_MAX_MEMBERS / 2];
+		int memberCount = listRarcMembers(archives[f], archiveSize, members, countof(members));
+		for (int i = 0; i < memberCount && seedCount < maxSeeds; i++)
+		{
+			if (isJPCFile(members[i].data, members[i].size))
+				seeds[seedCount++] = (struct fuzzSeed){ FUZZ_JPC, members[i].data, members[i].size };
+			else if (isBLOFile(members[i].data, members[i].size))
+				seeds[seedCount++] = (struct fuzzSeed){ FUZZ_BLO, members[i].data, members[i].size };
+			if (!nameHasExtension(members[i].name, ".bmd") && !nameHasExtension(members[i].name, ".bdl"))
+				continue;
+			seeds[seedCount++] = (struct fuzzSeed){ FUZZ_J3D, members[i].data, members[i].size };
+
+			const struct TEX1* textures = findJ3DChunk(members[i].data, members[i].size, "TEX1");
+			for (uint32_t t = 0; textures != nullptr && t < (uint16_t)SwapEndian(textures->textureCount) && seedCount < maxSeeds; t++)
+			{
+				struct btiTexture texture;
+				if (!loadTEX1Texture(textures, t, &texture))
+					continue;
+				uint32_t offset = (uint32_t)((const uint8_t*)texture.header - (const uint8_t*)textures);
+				seeds[seedCount++] = (struct fuzzSeed){ FUZZ_BTI, (const uint8_t*)texture.header, SwapEndian(textures->size) - offset };
+			}
+		}
+	}
+	//seed indices grouped by target, a target without seeds gets no inputs
+	uint32_t* targetSeeds = malloc(sizeof(uint32_t) * max(seedCount, 1));
+	uint32_t targetFirstSeed[FUZZ_TARGET_COUNT + 1] = { 0 };
+	for (uint32_t i = 0; i < seedCount; i++)
+	{
+		maxSeedSize = max(maxSeedSize, seeds[i].size);
+		targetFirstSeed[seeds[i].target + 1]++;
+	}
+	for (int t = 0; t < FUZZ_TARGET_COUNT; t++)
+		targetFirstSeed[t + 1] += targetFirstSeed[t];
+	uint32_t targetFill[FUZZ_TARGET_COUNT];
+	memcpy(targetFill, targetFirstSeed, sizeof(targetFill));
+	for (uint32_t i = 0; i < seedCount; i++)
+		targetSeeds[targetFill[seeds[i].target]++] = i;
+	int targets[FUZZ_TARGET_COUNT];
+	int targetCount = 0;
+	for (int t = 0; t < FUZZ_TARGET_COUNT; t++)
+		if (targetFirstSeed[t + 1] > targetFirstSeed[t])
+			targets[targetCount++] = t;
+
+	//the image target replaces the image, so its seed is copied out first
+	uint8_t* input = malloc(maxSeedSize);
+	uint8_t* imageSeed = malloc(seeds[0].size);
+	memcpy(imageSeed, seeds[0].data, seeds[0].size);
+	seeds[0].data = imageSeed;
+
+	uint32_t runs[FUZZ_TARGET_COUNT] = { 0 };
+	uint64_t bytes = 0;
+	uint64_t random = seedValue ? seedValue : 1;
+	double start = getTimeSeconds();
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		//every reader gets the same share of inputs however many seeds it has
+		int target = targets[nextSyntheticRandom(&random) % targetCount];
+		uint32_t targetSeedCount = targetFirstSeed[target + 1] - targetFirstSeed[target];
+		const struct fuzzSeed* seed = &seeds[targetSeeds[targetFirstSeed[target] + nextSyntheticRandom(&random) % targetSeedCount]];
+		uint32_t size = mutateFuzzInput(&random, seed, input);
+		fuzzOneInput(seed->target, input, size);
+		runs[seed->target]++;
+		bytes += size;
+	}
+	double seconds = getTimeSeconds() - start;
+
+	printf("%u seeds, %u iterations in %.2f s (%.1f MB/s), seed %llu\n", seedCount, iterations, seconds, bytes / max(seconds, 1e-9) / (1024.0 * 1024.0), seedValue);
+	for (int t = 0; t < FUZZ_TARGET_COUNT; t++)
+		printf("%s: %u inputs\n", fuzzTargetNames[t], runs[t]);
+
+	for (int f = 0; f < fileCount; f++)
+		free(archives[f]);
+	free(archives);
+	free(remapSeed);
+	free(targetSeeds);
+	free(seeds);
+	free(input);
+	free(imageSeed);
+	free(image);
+	return 0;
+}
 
-										decodedAssetTable[decodedAssetCount].assetType = ASSET_TYPE_TEXTURE;
-										decodedAssetTable[decodedAssetCount].assetPtr = imageHeader;
-										decodedAssetCount++;
-									}
-								}
-								else
-								{
-									DebugBreak();
-								}
+int runTextBenchmark()
+{
+	size_t workspaceSize = 1024 * 1024 * 64;
+	void* workspace = trackedAlloc(MEMORY_TEXT, workspaceSize);
 
+	uint32_t fileCount = 0;
+	uint64_t byteCount = 0;
+	uint64_t tokenCount = 0;
+	uint64_t recordCount = 0;
 
-								currentSection = OffsetPointer(currentSection, SwapEndian(currentSection->size));
-							}
-						}
-					}
-					else if (wcscmp(extensionType, L".txt") == 0)
-					{
-						displayedFileType = 1;
+	const int iterations = 5;
+	double times[5];
 
-						//new ver
-						decodedAssetCount = 1;
-						decodedAssetTable[0].assetType = ASSET_TYPE_TEXT;
-						decodedAssetTable[0].assetPtr = gameFileList[selectedFileIndex].filePtr;
+	for (int iteration = 0; iteration < iterations; iteration++)
+	{
+		fileCount = 0;
+		byteCount = 0;
+		tokenCount = 0;
+		recordCount = 0;
 
-					}
-					else if (wcscmp(extensionType, L".ini") == 0)
-					{
-						displayedFileType = 2;
+		double start = getTimeSeconds();
+		for (int i = 0; i < gameFileCount; i++)
+		{
+			if (!gameFileHasExtension(i, ".txt") && !gameFileHasExtension(i, ".ini"))
+				continue;
 
-						//new ver
-						decodedAssetCount = 1;
-						decodedAssetTable[0].assetType = ASSET_TYPE_TEXT;
-						decodedAssetTable[0].assetPtr = gameFileList[selectedFileIndex].filePtr;
-					}
-					else
-					{
-						displayedFileType = 0;
-					}
-					break;
-				}
+			struct parsedTextFile parsed;
+			if (!parseTextFile(gameFileList[i].filePtr, gameFileList[i].fileSize, gameFileList[i].fileName, workspace, workspaceSize, &parsed))
+			{
+				char path[256];
+				getGameFilePath(i, path, sizeof(path));
+				printf("unable to parse %s\n", path);
+				continue;
 			}
 
-			InvalidateRect(hFileView, nullptr, TRUE);
-			UpdateWindow(hFileView);
+			fileCount++;
+			byteCount += gameFileList[i].fileSize;
+			tokenCount += parsed.tokenCount;
+			recordCount += parsed.objectCount + parsed.waypointCount + parsed.parameterCount;
 		}
-		break;
-	}
-	case WM_DESTROY:
-		PostQuitMessage(0);
-		break;
-	default:
-		return DefWindowProc(hwnd, msg, wParam, lParam);
+		times[iteration] = getTimeSeconds() - start;
 	}
+
+	//insertion sort, there are only a few samples
+	for (int i = 1; i < iterations; i++)
+		for (int j = i; j > 0 && times[j - 1] > times[j]; j--)
+		{
+			double temp = times[j];
+			times[j] = times[j - 1];
+			times[j - 1] = temp;
+		}
+
+	double median = times[iterations / 2];
+	printf("text files: %u (%llu bytes)\n", fileCount, byteCount);
+	printf("tokens: %llu, records: %llu\n", tokenCount, recordCount);
+	printf("median: %.3f ms (%.1f MB/s), best: %.3f ms\n", median * 1000.0, byteCount / median / (1024.0 * 1024.0), times[0] * 1000.0);
+
+	trackedFree(workspace);
 	return 0;
 }
 
+int runConsoleCommand(int argc, char** argv)
+{
+	if (strcmp(argv[0], "-benchtext") == 0)
+	{
+		return runTextBenchmark();
+	}
+	else if (strcmp(argv[0], "-benchmodels") == 0)
+	{
+		return runModelBenchmark();
+	}
+	else if (strcmp(argv[0], "-benchtextures") == 0)
+	{
+		return runTextureBenchmark();
+	}
+	else if (strcmp(argv[0], "-texroundtrip") == 0)
+	{
+		return runTextureRoundTrip(argc > 1 ? (uint8_t)min(max(atoi(argv[1]), 0), CMPR_QUALITY_BEST) : CMPR_QUALITY_NORMAL);
+	}
+	else if (strcmp(argv[0], "-benchmessages") == 0)
+	{
+		return runMessageBenchmark();
+	}
+	else if (strcmp(argv[0], "-messages") == 0)
+	{
+		return runMessageDump(argc > 1, argc > 1 ? strtoul(argv[1], nullptr, 0) : 0);
+	}
+	else if (strcmp(argv[0], "-benchanimations") == 0)
+	{
+		return runAnimationBenchmark();
+	}
+	else if (strcmp(argv[0], "-benchskeletons") == 0)
+	{
+		return runSkeletonBenchmark();
+	}
+	else if (strcmp(argv[0], "-thumbnails") == 0 && argc > 1)
+	{
+		return runThumbnails(argv[1], argc > 2 ? atoi(argv[2]) : 128);
+	}
+	else if (strcmp(argv[0], "-gallery") == 0 && argc > 1)
+	{
+		return runGalleryExport(argv[1], argc > 2 ? argv[2] : nullptr);
+	}
+	else if (strcmp(argv[0], "-exportdds") == 0 && argc > 1)
+	{
+		bool ktx2 = false;
+		bool measurePrecision = false;
+		for (int i = 2; i < argc; i++)
+		{
+			ktx2 |= strcmp(argv[i], "-ktx2") == 0;
+			measurePrecision |= strcmp(argv[i], "-precision") == 0;
+		}
+		return runTextureExport(argv[1], ktx2, measurePrecision);
+	}
+	else if (strcmp(argv[0], "-exporttextures") == 0 && argc > 1)
+	{
+		return runImageExport(argv[1], argc > 2 && strcmp(argv[2], "-png") == 0);
+	}
+	else if (strcmp(argv[0], "-screens") == 0)
+	{
+		return runScreenReport(argc > 1 ? argv[1] : nullptr);
+	}
+	else if (strcmp(argv[0], "-exportgltf") == 0 && argc > 1)
+	{
+		return runGLTFExport(argv[1]);
+	}
+	else if (strcmp(argv[0], "-exportaudio") == 0 && argc > 1)
+	{
+		return runAudioDecode(argv[1]);
+	}
+	else if (strcmp(argv[0], "-benchaudio") == 0)
+	{
+		return runAudioDecode(nullptr);
+	}
+	else if (strcmp(argv[0], "-search") == 0 && argc > 1)
+	{
+		return runSearch((const uint8_t*)argv[1], strlen(argv[1]));
+	}
+	else if (strcmp(argv[0], "-searchhex") == 0 && argc > 1)
+	{
+		uint8_t pattern[256];
+		int patternLength = parseHexPattern(argv[1], pattern, sizeof(pattern));
+		if (patternLength <= 0)
+		{
+			printf("invalid hex pattern: %s\n", argv[1]);
+			return -1;
+		}
+		return runSearch(pattern, patternLength);
+	}
+	else if (strcmp(argv[0], "-buildindex") == 0)
+	{
+		return runBuildNgramIndex();
+	}
+	else if (strcmp(argv[0], "-dedup") == 0)
+	{
+		return runDuplicateReport(argc > 1 ? atoi(argv[1]) : 20);
+	}
+	else if (strcmp(argv[0], "-memory") == 0)
+	{
+		return runMemoryReport(argc > 1 ? atoi(argv[1]) : 20);
+	}
+	else if (strcmp(argv[0], "-yaz0stats") == 0)
+	{
+		return runYaz0Analysis(argc > 1 ? atoi(argv[1]) : 20);
+	}
+	else if (strcmp(argv[0], "-diff") == 0 && argc > 1)
+	{
+		return runImageDiff(argv[1]);
+	}
+	else if (strcmp(argv[0], "-rebuild") == 0 && argc > 2)
+	{
+		return runRebuildImage(argv[1], argc - 2, argv + 2);
+	}
+	else if (strcmp(argv[0], "-patch") == 0 && argc > 1)
+	{
+		return runRebuildImage(nullptr, argc - 1, argv + 1);
+	}
+	else if (strcmp(argv[0], "-dol") == 0)
+	{
+		return runDOLReport(argc > 1 ? argv[1] : nullptr, max(argc - 2, 0), argc > 2 ? argv + 2 : nullptr);
+	}
+	else if (strcmp(argv[0], "-benchdol") == 0 && argc > 1)
+	{
+		return runDOLBenchmark(argv[1]);
+	}
+	else
+	{
+		printf(
+			"usage: Pikmin2LevelViewer.exe <image.iso> [-trace <file.json>] [command]\n"
+			"       Pikmin2LevelViewer.exe -synthetic <out.iso> [seed]\twrite a generated test image\n"
+			"       Pikmin2LevelViewer.exe -benchsuite [baseline.txt] [threshold %%]\ttime the FST walk, yaz0, texture decoding, CMPR encoding and DOL\n"
+			"\t\tsymbols on a generated image, fail if a median is more than threshold (10) percent slower than the baseline,\n"
+			"\t\ta missing baseline file is written instead\n"
+			"       Pikmin2LevelViewer.exe -fuzz [iterations] [seed]\tfeed mutated files of a generated image to the disc, yaz0,\n"
+			"\t\trarc, j3d, bti, jpc and blo readers, 100000 iterations by default\n"
+			"commands:\n"
+			"\t-benchtext\tparse every .txt/.ini file and report the timing\n"
+			"\t-benchmodels\tdecompress every archive and parse every model in it\n"
+			"\t-benchtextures\tdecode every model texture and .bti file\n"
+			"\t-texroundtrip [quality]\tdecode, re-encode and decode every texture, report the error and encode time,\n"
+			"\t\tCMPR quality 0 (fast) to 2 (best), 1 by default\n"
+			"\t-benchanimations\tparse every bck/bca/btk/brk and sample every track\n"
+			"\t-benchskeletons\tflatten every model's hierarchy and evaluate its joint matrices\n"
+			"\t-benchmessages\tindex every bmg file and decode every message to utf-8\n"
+			"\t-benchaudio\tdecode every ast, dsp and wave bank wave and report samples/s\n"
+			"\t-messages [id]\tprint every message, or the messages with that id (0x for hex)\n"
+			"\t-thumbnails <directory> [size]\trender every model to a bmp, 128x128 by default\n"
+			"\t-gallery <directory> [path prefix]\twrite the texture gallery's atlas pages for every texture (under the prefix)\n"
+			"\t-exportdds <directory> [-ktx2] [-precision]\ttranscode every CMPR model texture to BC1 dds (or ktx2),\n"
+			"\t\t-precision also reports how far a BC1 decode is from the GX 3/8 blend\n"
+			"\t-exporttextures <directory> [-png]\tdecode every model texture and .bti file to qoi (or png)\n"
+			"\t-screens [directory]\tparse every .blo screen and .jpc effect, list the screens by texture memory, with a directory\n"
+			"\t\texport the textures they use to qoi\n"
+			"\t-exportgltf <directory>\twrite every model as a glb with its textures and joints\n"
+			"\t-exportaudio <directory>\tdecode every ast, dsp and wave bank wave to a 16 bit wav\n"
+			"\t-search <text>\tfind every file containing text, yaz0 files are searched decompressed\n"
+			"\t-searchhex <hex>\tsame as -search with a byte pattern (\"dead beef\")\n"
+			"\t-buildindex\twrite <image>.ngram, later searches skip files that can't match\n"
+			"\t-dedup [n]\thash every file, archive member and texture and list the n largest duplicate groups\n"
+			"\t-memory [n]\tmeasure what every file takes decoded, list the n largest and the peak bytes per memory tag\n"
+			"\t-yaz0stats [n]\tmatch length/distance and literal run histograms of every szs, list the n files recompression saves most on\n"
+			"\t-diff <other.iso>\tlist the files added, removed and modified in other.iso, and the changed members of\n"
+			"\t\tmodified archives\n"
+			"\t-rebuild <out.iso> <path>=<file>...\twrite a copy of the image with those files replaced, files that\n"
+			"\t\tstill fit keep their offset, larger ones move to the end\n"
+			"\t-patch <path>=<file>...\tthe same, written into the image in place\n"
+			"\t-dol [symbols.map] [symbol|0xaddress]...\tlist the DOL sections, look symbols up by name or address\n"
+			"\t-benchdol <symbols.map>\ttime the map parse, address lookups and copying every data symbol out of the DOL\n"
+		);
+		return -1;
+	}
+}
 
-int main()
+//libFuzzer brings its own main
+#ifndef FUZZER_ENTRY
+int main(int argc, char** argv)
 {
 	ConsoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
 
-	//todo: temporary!
-	gameFileList = malloc(1024 * 1024 * 24);
-	decodedAssetTable = malloc(sizeof(struct decodedAsset) * 32);//maximum 32 assets per file?
+	decodedAssetTable = malloc(sizeof(struct decodedAsset) * DECODED_ASSET_TABLE_SIZE);//maximum 32 assets per file?
 	//todo: use dynamically allocated array instead
-	decodedAssetData = malloc(1024 * 1024 * 24);
-	OPENFILENAME ofn = { 0 };
-	WCHAR szFile[260] = { 0 };
-
-	ofn.lStructSize = sizeof(ofn);
-	ofn.hwndOwner = nullptr;
-	ofn.lpstrFile = szFile;
-	ofn.nMaxFile = sizeof(szFile);
-	ofn.lpstrFilter = L"Pikmin 2\0*.iso\0";
-	ofn.nFilterIndex = 1;
-	ofn.lpstrFileTitle = nullptr;
-	ofn.nMaxFileTitle = 0;
-	ofn.lpstrInitialDir = nullptr;
-	ofn.Flags = OFN_PATHMUSTEXIST | OFN_FILEMUSTEXIST;
-
-	THROW_ON_FALSE(GetOpenFileNameW(&ofn));
-
-	HANDLE file = CreateFileW(
-		szFile,
-		GENERIC_READ,
-		0,
-		nullptr,
-		OPEN_ALWAYS,
-		FILE_ATTRIBUTE_NORMAL,
-		nullptr);
+	decodedAssetData = trackedAlloc(MEMORY_PIXELS, DECODED_ASSET_DATA_SIZE);
+	modelWorkspace = trackedAlloc(MEMORY_MODELS, MODEL_WORKSPACE_SIZE);
+	initBlobCache(&decodedTextureCache, 256);
+
+	//these build their own image instead of opening one
+	if (argc > 2 && strcmp(argv[1], "-synthetic") == 0)
+		return runWriteSyntheticImage(argv[2], argc > 3 ? strtoull(argv[3], nullptr, 0) : SUITE_SEED);
+	if (argc > 1 && strcmp(argv[1], "-benchsuite") == 0)
+		return runBenchmarkSuite(argc > 2 ? argv[2] : nullptr, argc > 3 ? atof(argv[3]) : 10.0);
+	if (argc > 1 && strcmp(argv[1], "-fuzz") == 0)
+		return runFuzzer(argc > 2 ? strtoul(argv[2], nullptr, 0) : 100000, argc > 3 ? strtoull(argv[3], nullptr, 0) : SUITE_SEED);
+
+	HANDLE file;
+
+	if (argc > 1)
+	{
+		GameImagePath = argv[1];
+		//-patch writes to the image while it's mapped
+		file = CreateFileA(
+			argv[1],
+			GENERIC_READ,
+			FILE_SHARE_READ | FILE_SHARE_WRITE,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL,
+			nullptr);
+	}
+	else
+	{
+		OPENFILENAME ofn = { 0 };
+		WCHAR szFile[260] = { 0 };
+
+		ofn.lStructSize = sizeof(ofn);
+		ofn.hwndOwner = nullptr;
+		ofn.lpstrFile = szFile;
+		ofn.nMaxFile = sizeof(szFile);
+		ofn.lpstrFilter = L"Pikmin 2\0*.iso\0";
+		ofn.nFilterIndex = 1;
+		ofn.lpstrFileTitle = nullptr;
+		ofn.nMaxFileTitle = 0;
+		ofn.lpstrInitialDir = nullptr;
+		ofn.Flags = OFN_PATHMUSTEXIST | OFN_FILEMUSTEXIST;
+
+		THROW_ON_FALSE(GetOpenFileNameW(&ofn));
+
+		file = CreateFileW(
+			szFile,
+			GENERIC_READ,
+			0,
+			nullptr,
+			OPEN_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL,
+			nullptr);
+	}
 	VALIDATE_HANDLE(file);
 
+	LARGE_INTEGER fileSize;
+	THROW_ON_FALSE(GetFileSizeEx(file, &fileSize));
+	GameImageSize = fileSize.QuadPart;
+
 	HANDLE hMapFile = CreateFileMappingW(
 		file,
 		nullptr,
@@ -1252,6 +15024,26 @@ int main()
 	GameImageAddress = MapViewOfFile(hMapFile, FILE_MAP_READ, 0, 0, 0);
 	__assume(GameImageAddress != nullptr);
 
+	//-trace <file.json> right after the image path records spans for the command, or the whole window session, and writes them at the end
+	const char* tracePath = nullptr;
+	int commandIndex = 2;
+	if (argc > 3 && strcmp(argv[2], "-trace") == 0)
+	{
+		tracePath = argv[3];
+		tracingEnabled = true;
+		commandIndex = 4;
+	}
+
+	//anything after the image path is a console command, no window is created
+	if (argc > commandIndex)
+	{
+		indexGameFiles(nullptr);
+		int result = runConsoleCommand(argc - commandIndex, argv + commandIndex);
+		if (tracePath != nullptr)
+			writeTraceFile(tracePath);
+		return result;
+	}
+
 
 	WNDCLASSW wc = { 0 };
 
@@ -1274,4 +15066,8 @@ int main()
 		TranslateMessage(&msg);
 		DispatchMessageW(&msg);
 	}
+
+	if (tracePath != nullptr)
+		writeTraceFile(tracePath);
 }
+#endif